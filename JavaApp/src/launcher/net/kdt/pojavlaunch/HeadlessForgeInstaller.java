@@ -0,0 +1,380 @@
+package net.kdt.pojavlaunch;
+
+import com.google.gson.Gson;
+import com.google.gson.GsonBuilder;
+import com.google.gson.JsonObject;
+import com.google.gson.JsonParser;
+import java.io.ByteArrayOutputStream;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.lang.reflect.InvocationTargetException;
+import java.lang.reflect.Method;
+import java.net.URL;
+import java.net.URLClassLoader;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Enumeration;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+import java.util.jar.JarEntry;
+import java.util.jar.JarFile;
+import net.kdt.pojavlaunch.value.DependentLibrary;
+import net.kdt.pojavlaunch.value.ForgeInstallProfile;
+
+/**
+ * Installs a Forge or NeoForge client the way the installer's GUI would,
+ * without AWT: writes the version JSON, unpacks the bundled maven files and
+ * runs the processors from install_profile.json in this JVM.
+ *
+ * Libraries are expected to be downloaded already, anything still missing
+ * is fetched here, so this also runs on a desktop JVM:
+ * java -cp launcher.jar:gson.jar net.kdt.pojavlaunch.HeadlessForgeInstaller installer.jar gameDir
+ *
+ * install() returns the launcher profile for the new version. In the app it
+ * is added through the launcher's profile list, which keeps
+ * launcher_profiles.json in memory and would overwrite an entry written
+ * here; only main() writes it to the file.
+ */
+public class HeadlessForgeInstaller {
+    private static final Gson GSON = new GsonBuilder().setPrettyPrinting().create();
+
+    private final JarFile installer;
+    private final File installerFile, gameDir, libraryDir;
+    private final Map<String, String> data = new HashMap<>();
+    private ForgeInstallProfile profile;
+    private File tempDir;
+
+    public HeadlessForgeInstaller(File installerFile, File gameDir) throws IOException {
+        this.installerFile = installerFile;
+        this.installer = new JarFile(installerFile);
+        this.gameDir = gameDir;
+        this.libraryDir = new File(gameDir, "libraries");
+    }
+
+    public static void main(String[] args) throws Throwable {
+        if (args.length < 2) {
+            System.err.println("Usage: HeadlessForgeInstaller <installer.jar> <game directory>");
+            System.exit(2);
+        }
+        File gameDir = new File(args[1]);
+        addLauncherProfile(gameDir, new HeadlessForgeInstaller(new File(args[0]), gameDir).install());
+    }
+
+    public JsonObject install() throws Exception {
+        long startTime = System.currentTimeMillis();
+        try {
+            profile = GSON.fromJson(readEntry("install_profile.json"), ForgeInstallProfile.class);
+            if (profile.processors == null || profile.json == null) {
+                throw new IOException("Unsupported installer: install_profile.json has no processors");
+            }
+            System.out.println("[ForgeInstaller] Installing " + profile.version + " for Minecraft " + profile.minecraft);
+
+            String versionJson = readEntry(profile.json);
+            DependentLibrary[] versionLibraries = GSON.fromJson(versionJson, JMinecraftVersionList.Version.class).libraries;
+            Tools.write(new File(gameDir, "versions/" + profile.version + "/" + profile.version + ".json").getPath(), versionJson);
+
+            extractMavenFiles();
+            checkLibraries(profile.libraries);
+            checkLibraries(versionLibraries);
+            setupData();
+
+            int index = 0;
+            for (ForgeInstallProfile.Processor processor : profile.processors) {
+                index++;
+                if (processor.sides != null && !Arrays.asList(processor.sides).contains("client")) {
+                    continue;
+                }
+                runProcessor(processor, index, profile.processors.length);
+            }
+
+            System.out.println("[ForgeInstaller] Installed " + profile.version + " in "
+                + (System.currentTimeMillis() - startTime) / 1000 + "s");
+            return launcherProfile();
+        } finally {
+            installer.close();
+            if (tempDir != null) {
+                deleteRecursive(tempDir);
+            }
+        }
+    }
+
+    private String readEntry(String name) throws IOException {
+        JarEntry entry = installer.getJarEntry(name.startsWith("/") ? name.substring(1) : name);
+        if (entry == null) {
+            throw new IOException("Installer has no " + name);
+        }
+        try (InputStream stream = installer.getInputStream(entry)) {
+            return new String(readAll(stream), StandardCharsets.UTF_8);
+        }
+    }
+
+    // Libraries that have no URL ship inside the installer
+    private void extractMavenFiles() throws IOException {
+        Enumeration<JarEntry> entries = installer.entries();
+        while (entries.hasMoreElements()) {
+            JarEntry entry = entries.nextElement();
+            if (entry.isDirectory() || !entry.getName().startsWith("maven/")) continue;
+            File file = new File(libraryDir, entry.getName().substring(6));
+            extract(entry, file);
+        }
+    }
+
+    private void extract(JarEntry entry, File file) throws IOException {
+        file.getParentFile().mkdirs();
+        try (InputStream in = installer.getInputStream(entry); OutputStream out = new FileOutputStream(file)) {
+            Tools.copy(in, out);
+        }
+    }
+
+    private void checkLibraries(DependentLibrary[] libraries) throws IOException {
+        if (libraries == null) return;
+        for (DependentLibrary library : libraries) {
+            if (library.downloads == null || library.downloads.artifact == null) continue;
+            String url = library.downloads.artifact.url;
+            File file = new File(libraryDir, library.downloads.artifact.path);
+            if (url == null || url.isEmpty() || file.exists()) {
+                // Either in place or made by a processor
+                continue;
+            }
+            System.out.println("[ForgeInstaller] Downloading " + library.name);
+            file.getParentFile().mkdirs();
+            try (InputStream in = new URL(url).openStream(); OutputStream out = new FileOutputStream(file)) {
+                Tools.copy(in, out);
+            }
+            String sha1 = library.downloads.artifact.sha1;
+            if (sha1 != null && !sha1.isEmpty() && !sha1.equals(sha1(file))) {
+                file.delete();
+                throw new IOException("SHA1 mismatch for " + library.name);
+            }
+        }
+    }
+
+    private void setupData() throws IOException {
+        File minecraftJar = new File(gameDir, "versions/" + profile.minecraft + "/" + profile.minecraft + ".jar");
+        if (!minecraftJar.exists()) {
+            // The launcher keeps the client next to the version that inherits it
+            File clientJar = new File(gameDir, "versions/" + profile.version + "/" + profile.version + ".jar");
+            if (!clientJar.exists()) {
+                throw new IOException("Minecraft " + profile.minecraft + " client jar is missing");
+            }
+            minecraftJar.getParentFile().mkdirs();
+            try (InputStream in = new FileInputStream(clientJar); OutputStream out = new FileOutputStream(minecraftJar)) {
+                Tools.copy(in, out);
+            }
+        }
+        data.put("SIDE", "client");
+        data.put("MINECRAFT_JAR", minecraftJar.getAbsolutePath());
+        data.put("MINECRAFT_VERSION", profile.minecraft);
+        data.put("ROOT", gameDir.getAbsolutePath());
+        data.put("INSTALLER", installerFile.getAbsolutePath());
+        data.put("LIBRARY_DIR", libraryDir.getAbsolutePath());
+
+        if (profile.data == null) return;
+        for (Map.Entry<String, ForgeInstallProfile.SidedValue> entry : profile.data.entrySet()) {
+            String value = entry.getValue().client;
+            if (value == null) continue;
+            if (value.startsWith("[") && value.endsWith("]")) {
+                value = artifactFile(value.substring(1, value.length() - 1)).getAbsolutePath();
+            } else if (value.startsWith("'") && value.endsWith("'")) {
+                value = value.substring(1, value.length() - 1);
+            } else if (value.startsWith("/")) {
+                // A file inside the installer, e.g. the binary patches
+                if (tempDir == null) {
+                    tempDir = Files.createTempDirectory("forge_installer").toFile();
+                }
+                JarEntry jarEntry = installer.getJarEntry(value.substring(1));
+                if (jarEntry == null) {
+                    throw new IOException("Installer has no " + value);
+                }
+                File file = new File(tempDir, value.substring(1));
+                extract(jarEntry, file);
+                value = file.getAbsolutePath();
+            }
+            data.put(entry.getKey(), value);
+        }
+    }
+
+    // "{KEY}" anywhere in the string is data, a whole "[artifact]" is a library
+    // path and a whole "'text'" is literal
+    private String resolve(String value) throws IOException {
+        if (value.startsWith("[") && value.endsWith("]")) {
+            return artifactFile(value.substring(1, value.length() - 1)).getAbsolutePath();
+        } else if (value.length() >= 2 && value.startsWith("'") && value.endsWith("'")) {
+            return value.substring(1, value.length() - 1);
+        }
+        StringBuilder result = new StringBuilder();
+        for (int i = 0; i < value.length(); i++) {
+            char c = value.charAt(i);
+            if (c == '\\' && i + 1 < value.length()) {
+                result.append(value.charAt(++i));
+            } else if (c == '{') {
+                int end = value.indexOf('}', i);
+                if (end < 0) {
+                    throw new IOException("Unterminated key in " + value);
+                }
+                String key = value.substring(i + 1, end);
+                String replacement = data.get(key);
+                if (replacement == null) {
+                    throw new IOException("Unknown installer data key " + key);
+                }
+                result.append(replacement);
+                i = end;
+            } else {
+                result.append(c);
+            }
+        }
+        return result.toString();
+    }
+
+    private void runProcessor(ForgeInstallProfile.Processor processor, int index, int count) throws Exception {
+        Map<String, String> outputs = new HashMap<>();
+        if (processor.outputs != null) {
+            for (Map.Entry<String, String> entry : processor.outputs.entrySet()) {
+                outputs.put(resolve(entry.getKey()), resolve(entry.getValue()));
+            }
+        }
+        if (!outputs.isEmpty() && outputsMatch(outputs)) {
+            System.out.println("[ForgeInstaller] Processor " + index + "/" + count + " " + processor.jar + ": up to date");
+            return;
+        }
+        System.out.println("[ForgeInstaller] Processor " + index + "/" + count + " " + processor.jar);
+        long startTime = System.currentTimeMillis();
+
+        File jar = artifactFile(processor.jar);
+        List<URL> classpath = new ArrayList<>();
+        classpath.add(jar.toURI().toURL());
+        if (processor.classpath != null) {
+            for (String artifact : processor.classpath) {
+                classpath.add(artifactFile(artifact).toURI().toURL());
+            }
+        }
+        String mainClass;
+        try (JarFile jarFile = new JarFile(jar)) {
+            mainClass = jarFile.getManifest().getMainAttributes().getValue("Main-Class");
+        }
+        if (mainClass == null) {
+            throw new IOException(processor.jar + " has no Main-Class");
+        }
+        String[] args = new String[processor.args == null ? 0 : processor.args.length];
+        for (int i = 0; i < args.length; i++) {
+            args[i] = resolve(processor.args[i]);
+        }
+
+        // Isolated from the launcher's classes, like in the installer
+        ClassLoader parent = ClassLoader.getSystemClassLoader().getParent();
+        ClassLoader previous = Thread.currentThread().getContextClassLoader();
+        try (URLClassLoader loader = new URLClassLoader(classpath.toArray(new URL[0]), parent)) {
+            Thread.currentThread().setContextClassLoader(loader);
+            Method main = Class.forName(mainClass, true, loader).getMethod("main", String[].class);
+            main.invoke(null, (Object) args);
+        } catch (InvocationTargetException e) {
+            throw new IOException("Processor " + processor.jar + " failed", e.getCause());
+        } finally {
+            Thread.currentThread().setContextClassLoader(previous);
+        }
+
+        for (Map.Entry<String, String> output : outputs.entrySet()) {
+            File file = new File(output.getKey());
+            if (!file.exists()) {
+                throw new IOException("Processor " + processor.jar + " did not create " + file);
+            }
+            String sha1 = sha1(file);
+            if (!sha1.equals(output.getValue())) {
+                file.delete();
+                throw new IOException("Processor " + processor.jar + " output " + file.getName()
+                    + " has SHA1 " + sha1 + ", expected " + output.getValue());
+            }
+        }
+        System.out.println("[ForgeInstaller] Processor " + index + "/" + count + " took "
+            + (System.currentTimeMillis() - startTime) + "ms");
+    }
+
+    private boolean outputsMatch(Map<String, String> outputs) throws IOException {
+        for (Map.Entry<String, String> output : outputs.entrySet()) {
+            File file = new File(output.getKey());
+            if (!file.exists() || !sha1(file).equals(output.getValue())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Same entry the official installer adds, so the version shows up as a profile.
+    // The icon is the installer's data URL, the launcher moves it into its icon store.
+    private JsonObject launcherProfile() {
+        JsonObject entry = new JsonObject();
+        entry.addProperty("name", profile.profile != null ? profile.profile : profile.version);
+        entry.addProperty("type", "custom");
+        entry.addProperty("lastVersionId", profile.version);
+        if (profile.icon != null) {
+            entry.addProperty("icon", profile.icon);
+        }
+        return entry;
+    }
+
+    private static void addLauncherProfile(File gameDir, JsonObject entry) throws IOException {
+        File file = new File(gameDir, "launcher_profiles.json");
+        JsonObject root = file.exists() ? JsonParser.parseString(Tools.read(file.getPath())).getAsJsonObject() : new JsonObject();
+        if (!root.has("profiles")) {
+            root.add("profiles", new JsonObject());
+        }
+        root.getAsJsonObject("profiles").add(entry.get("name").getAsString(), entry);
+        Tools.write(file.getPath(), GSON.toJson(root));
+    }
+
+    // "group:artifact:version[:classifier][@extension]" in the libraries directory
+    private File artifactFile(String name) {
+        String extension = "jar";
+        int at = name.indexOf('@');
+        if (at >= 0) {
+            extension = name.substring(at + 1);
+            name = name.substring(0, at);
+        }
+        String[] parts = name.split(":");
+        String fileName = parts[1] + "-" + parts[2] + (parts.length > 3 ? "-" + parts[3] : "") + "." + extension;
+        return new File(libraryDir, parts[0].replace('.', '/') + "/" + parts[1] + "/" + parts[2] + "/" + fileName);
+    }
+
+    private static String sha1(File file) throws IOException {
+        try (InputStream in = new FileInputStream(file)) {
+            MessageDigest digest = MessageDigest.getInstance("SHA-1");
+            byte[] buffer = new byte[65536];
+            int length;
+            while ((length = in.read(buffer)) != -1) {
+                digest.update(buffer, 0, length);
+            }
+            StringBuilder hex = new StringBuilder();
+            for (byte b : digest.digest()) {
+                hex.append(String.format("%02x", b));
+            }
+            return hex.toString();
+        } catch (NoSuchAlgorithmException e) {
+            throw new IOException(e);
+        }
+    }
+
+    private static byte[] readAll(InputStream in) throws IOException {
+        ByteArrayOutputStream out = new ByteArrayOutputStream();
+        Tools.copy(in, out);
+        return out.toByteArray();
+    }
+
+    private static void deleteRecursive(File file) {
+        File[] children = file.listFiles();
+        if (children != null) {
+            for (File child : children) {
+                deleteRecursive(child);
+            }
+        }
+        file.delete();
+    }
+}
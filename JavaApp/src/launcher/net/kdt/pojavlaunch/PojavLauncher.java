@@ -1,5 +1,6 @@
 package net.kdt.pojavlaunch;
 
+import com.google.gson.JsonObject;
 import java.beans.Beans;
 import java.io.*;
 import java.lang.reflect.Field;
@@ -49,6 +50,10 @@ public class PojavLauncher {
 
         if (args[0].equals("-jar")) {
             UIKit.callback_JavaGUIViewController_launchJarFile(args[1], Arrays.copyOfRange(args, 2, args.length));
+        } else if (args[0].equals("-installForge")) {
+            JsonObject profile = new HeadlessForgeInstaller(new File(args[1]), new File(args[2])).install();
+            UIKit.addLauncherProfile(profile.get("name").getAsString(), profile.get("lastVersionId").getAsString(),
+                profile.has("icon") ? profile.get("icon").getAsString() : null);
         } else {
             launchMinecraft(args);
         }
@@ -84,7 +89,8 @@ public class PojavLauncher {
             }
         }
 
-        System.setProperty("org.lwjgl.vulkan.libname", "libMoltenVK.dylib");
+        // Wraps libMoltenVK.dylib to persist the pipeline cache across sessions
+        System.setProperty("org.lwjgl.vulkan.libname", "libvkpipelinecache.dylib");
 
         MinecraftAccount account = MinecraftAccount.load(args[0]);
         JMinecraftVersionList.Version version = Tools.getVersionInfo(args[1]);
@@ -26,9 +26,13 @@ import java.net.URLClassLoader;
 import java.nio.charset.Charset;
 import java.util.ArrayList;
 import java.util.Arrays;
+import java.util.HashSet;
+import java.util.LinkedHashSet;
 import java.util.List;
 import java.util.Map;
+import java.util.Set;
 import net.kdt.pojavlaunch.uikit.UIKit;
+import net.kdt.pojavlaunch.utils.ClasspathResolver;
 import net.kdt.pojavlaunch.utils.JSONUtils;
 import net.kdt.pojavlaunch.value.DependentLibrary;
 import net.kdt.pojavlaunch.value.MinecraftAccount;
@@ -296,101 +300,87 @@ createLibraryInfo(libItem);
     }
 
     public static String[] generateLibClasspath(JMinecraftVersionList.Version info) {
-        List<String> libDir = new ArrayList<String>();
-
         preProcessLibraries(info.libraries);
-        for (DependentLibrary libItem : info.libraries) {
+        // Chains merged by getVersionInfo are resolved already, this catches duplicates within a single version
+        DependentLibrary[] libraries = ClasspathResolver.resolve(info.libraries, info.id);
+        Set<String> libDir = new LinkedHashSet<String>();
+        for (DependentLibrary libItem : libraries) {
             if (libItem._skip) continue;
-            String fullPath = Tools.DIR_HOME_LIBRARY + "/" + artifactToPath(libItem);
-            if (!libDir.contains(fullPath)) {
-                libDir.add(fullPath);
-            }
+            libDir.add(Tools.DIR_HOME_LIBRARY + "/" + artifactToPath(libItem));
         }
         return libDir.toArray(new String[0]);
     }
 
     public static JMinecraftVersionList.Version getVersionInfo(String versionName) {
         try {
-            JMinecraftVersionList.Version customVer = Tools.GLOBAL_GSON.fromJson(read(DIR_HOME_VERSION + "/" + versionName + "/" + versionName + ".json"), JMinecraftVersionList.Version.class);
-            if (customVer.inheritsFrom == null || customVer.inheritsFrom.equals(customVer.id)) {
-                return customVer;
-            } else {
-                JMinecraftVersionList.Version inheritsVer = Tools.GLOBAL_GSON.fromJson(read(DIR_HOME_VERSION + "/" + customVer.inheritsFrom + "/" + customVer.inheritsFrom + ".json"), JMinecraftVersionList.Version.class);
-                inheritsVer.inheritsFrom = inheritsVer.id;
-                
-                insertSafety(inheritsVer, customVer,
-                             "assetIndex", "assets", "id",
-                             "mainClass", "minecraftArguments",
-                             "releaseTime", "time", "type"
-                             );
-
-                // Go through the libraries, remove the ones overridden by the custom version
-                List<DependentLibrary> inheritLibraryList = new ArrayList<>(Arrays.asList(inheritsVer.libraries));
-                outer_loop:
-                for(DependentLibrary library : customVer.libraries){
-                    // Clean libraries overridden by the custom version
-                    String libName = library.name.substring(0, library.name.lastIndexOf(":"));
-
-                    for(DependentLibrary inheritLibrary : inheritLibraryList) {
-                        String inheritLibName = inheritLibrary.name.substring(0, inheritLibrary.name.lastIndexOf(":"));
-
-                        if(libName.equals(inheritLibName)){
-                            System.out.println("Library " + libName + ": Replaced version " +
-                                    libName.substring(libName.lastIndexOf(":") + 1) + " with " +
-                                    inheritLibName.substring(inheritLibName.lastIndexOf(":") + 1));
-
-                            // Remove the library , superseded by the overriding libs
-                            inheritLibraryList.remove(inheritLibrary);
-                            continue outer_loop;
-                        }
-                    }
-                }
+            // Walk up to the version everything inherits from, e.g. NeoForge -> vanilla
+            List<JMinecraftVersionList.Version> chain = new ArrayList<>();
+            Set<String> visited = new HashSet<>();
+            for (String name = versionName; name != null && visited.add(name);) {
+                JMinecraftVersionList.Version version = Tools.GLOBAL_GSON.fromJson(read(DIR_HOME_VERSION + "/" + name + "/" + name + ".json"), JMinecraftVersionList.Version.class);
+                chain.add(version);
+                name = version.inheritsFrom;
+            }
+            JMinecraftVersionList.Version inheritsVer = chain.get(chain.size() - 1);
+            if (chain.size() == 1) {
+                return inheritsVer;
+            }
+            inheritsVer.inheritsFrom = inheritsVer.id;
 
-                // Fuse libraries
-                inheritLibraryList.addAll(Arrays.asList(customVer.libraries));
-                inheritsVer.libraries = inheritLibraryList.toArray(new DependentLibrary[0]);
-                preProcessLibraries(inheritsVer.libraries);
-
-                // Inheriting Minecraft 1.13+ with append custom args
-                if (inheritsVer.arguments != null && customVer.arguments != null) {
-                    List totalArgList = new ArrayList();
-                    totalArgList.addAll(Arrays.asList(inheritsVer.arguments.game));
-                    
-                    int nskip = 0;
-                    for (int i = 0; i < customVer.arguments.game.length; i++) {
-                        if (nskip > 0) {
-                            nskip--;
-                            continue;
-                        }
-                        
-                        Object perCustomArg = customVer.arguments.game[i];
+            DependentLibrary[] libraries = ClasspathResolver.resolveChain(chain);
+            for (int i = chain.size() - 2; i >= 0; i--) {
+                inheritVersion(inheritsVer, chain.get(i));
+            }
+            inheritsVer.libraries = libraries;
+            preProcessLibraries(inheritsVer.libraries);
+            return inheritsVer;
+        } catch (Exception e) {
+            throw new RuntimeException(e);
+        }
+    }
+
+    // Applies customVer on top of the version it inherits from, except for libraries
+    private static void inheritVersion(JMinecraftVersionList.Version inheritsVer, JMinecraftVersionList.Version customVer) {
+        insertSafety(inheritsVer, customVer,
+                     "assetIndex", "assets", "id",
+                     "mainClass", "minecraftArguments",
+                     "releaseTime", "time", "type"
+                     );
+
+        // Inheriting Minecraft 1.13+ with append custom args
+        if (inheritsVer.arguments != null && customVer.arguments != null) {
+            List totalArgList = new ArrayList();
+            totalArgList.addAll(Arrays.asList(inheritsVer.arguments.game));
+            
+            int nskip = 0;
+            for (int i = 0; i < customVer.arguments.game.length; i++) {
+                if (nskip > 0) {
+                    nskip--;
+                    continue;
+                }
+                
+                Object perCustomArg = customVer.arguments.game[i];
+                if (perCustomArg instanceof String) {
+                    String perCustomArgStr = (String) perCustomArg;
+                    // Check if there is a duplicate argument on combine
+                    if (perCustomArgStr.startsWith("--") && totalArgList.contains(perCustomArgStr)) {
+                        perCustomArg = customVer.arguments.game[i + 1];
                         if (perCustomArg instanceof String) {
-                            String perCustomArgStr = (String) perCustomArg;
-                            // Check if there is a duplicate argument on combine
-                            if (perCustomArgStr.startsWith("--") && totalArgList.contains(perCustomArgStr)) {
-                                perCustomArg = customVer.arguments.game[i + 1];
-                                if (perCustomArg instanceof String) {
-                                    perCustomArgStr = (String) perCustomArg;
-                                    // If the next is argument value, skip it
-                                    if (!perCustomArgStr.startsWith("--")) {
-                                        nskip++;
-                                    }
-                                }
-                            } else {
-                                totalArgList.add(perCustomArgStr);
+                            perCustomArgStr = (String) perCustomArg;
+                            // If the next is argument value, skip it
+                            if (!perCustomArgStr.startsWith("--")) {
+                                nskip++;
                             }
-                        } else if (!totalArgList.contains(perCustomArg)) {
-                            totalArgList.add(perCustomArg);
                         }
+                    } else {
+                        totalArgList.add(perCustomArgStr);
                     }
-
-                    inheritsVer.arguments.game = totalArgList.toArray(new Object[0]);
+                } else if (!totalArgList.contains(perCustomArg)) {
+                    totalArgList.add(perCustomArg);
                 }
-
-                return inheritsVer;
             }
-        } catch (Exception e) {
-            throw new RuntimeException(e);
+
+            inheritsVer.arguments.game = totalArgList.toArray(new Object[0]);
         }
     }
 
@@ -69,5 +69,8 @@ public class UIKit {
 
     public static native void showError(String title, String message, boolean exitIfOk);
 
+    // Adds or replaces the profile in the launcher's list and saves it before returning
+    public static native void addLauncherProfile(String name, String lastVersionId, String icon);
+
     private static native void updateMCGuiScale(int scale);
 } 
@@ -0,0 +1,195 @@
+package net.kdt.pojavlaunch.utils;
+
+import java.util.*;
+import net.kdt.pojavlaunch.JMinecraftVersionList;
+import net.kdt.pojavlaunch.value.DependentLibrary;
+
+/**
+ * Picks one library per coordinate (group:artifact[:classifier][@extension])
+ * across an inheritance chain, in time linear to the number of libraries.
+ *
+ * Policy, applied as versions are added from the base (vanilla) to the most
+ * derived one:
+ * - A version overrides what it inherits. If it lists a coordinate its parent
+ *   already has, its own entry wins even if the version number is lower,
+ *   since the mod loader was built against it. The entry moves to the
+ *   position it has in the derived version, like before.
+ * - Within a single version JSON, the highest version of a coordinate wins
+ *   and keeps the position of the first entry.
+ * Every library that loses is reported on stdout.
+ */
+public class ClasspathResolver {
+    private static class Entry {
+        final DependentLibrary library;
+        final String source;
+        final int level;
+
+        Entry(DependentLibrary library, String source, int level) {
+            this.library = library;
+            this.source = source;
+            this.level = level;
+        }
+    }
+
+    private final LinkedHashMap<String, Entry> entries = new LinkedHashMap<>();
+    private final List<String> dropped = new ArrayList<>();
+    private int level;
+
+    /** Adds the libraries of the next version in the chain, starting with the base one */
+    public void add(DependentLibrary[] libraries, String source) {
+        if (libraries == null) return;
+        level++;
+        for (DependentLibrary library : libraries) {
+            if (library == null || library.name == null) continue;
+            String coordinate = coordinateOf(library.name);
+            Entry entry = new Entry(library, source, level);
+            Entry existing = entries.get(coordinate);
+            if (existing == null) {
+                entries.put(coordinate, entry);
+            } else if (existing.level < level) {
+                drop(existing, entry, "overridden by");
+                entries.remove(coordinate);
+                entries.put(coordinate, entry);
+            } else if (compareVersions(versionOf(library.name), versionOf(existing.library.name)) > 0) {
+                drop(existing, entry, "superseded by");
+                entries.put(coordinate, entry);
+            } else {
+                drop(entry, existing, "superseded by");
+            }
+        }
+    }
+
+    private void drop(Entry loser, Entry winner, String reason) {
+        String message = "Library " + coordinateOf(loser.library.name) + ": dropped "
+            + versionOf(loser.library.name) + " (" + loser.source + "), " + reason + " "
+            + versionOf(winner.library.name) + " (" + winner.source + ")";
+        dropped.add(message);
+        System.out.println(message);
+    }
+
+    public DependentLibrary[] getLibraries() {
+        DependentLibrary[] libraries = new DependentLibrary[entries.size()];
+        int i = 0;
+        for (Entry entry : entries.values()) {
+            libraries[i++] = entry.library;
+        }
+        return libraries;
+    }
+
+    /** One line per library that lost, in the order they were resolved */
+    public List<String> getDropped() {
+        return dropped;
+    }
+
+    /** Resolves a chain listed from the most derived version down to its base, as getVersionInfo walks it */
+    public static DependentLibrary[] resolveChain(List<JMinecraftVersionList.Version> chain) {
+        ClasspathResolver resolver = new ClasspathResolver();
+        for (int i = chain.size() - 1; i >= 0; i--) {
+            resolver.add(chain.get(i).libraries, chain.get(i).id);
+        }
+        return resolver.getLibraries();
+    }
+
+    public static DependentLibrary[] resolve(DependentLibrary[] libraries, String source) {
+        ClasspathResolver resolver = new ClasspathResolver();
+        resolver.add(libraries, source);
+        return resolver.getLibraries();
+    }
+
+    // "group:artifact:version[:classifier][@extension]" without the version
+    public static String coordinateOf(String name) {
+        String extension = "";
+        int at = name.indexOf('@');
+        if (at >= 0) {
+            extension = name.substring(at);
+            name = name.substring(0, at);
+        }
+        String[] parts = name.split(":");
+        if (parts.length < 3) {
+            return name + extension;
+        }
+        StringBuilder coordinate = new StringBuilder(parts[0]).append(':').append(parts[1]);
+        for (int i = 3; i < parts.length; i++) {
+            coordinate.append(':').append(parts[i]);
+        }
+        // jar is the default, "@jar" names the same artifact
+        if (!extension.equals("@jar")) {
+            coordinate.append(extension);
+        }
+        return coordinate.toString();
+    }
+
+    public static String versionOf(String name) {
+        int at = name.indexOf('@');
+        String[] parts = (at >= 0 ? name.substring(0, at) : name).split(":");
+        return parts.length >= 3 ? parts[2] : "";
+    }
+
+    private static final List<String> QUALIFIERS = Arrays.asList("alpha", "a", "beta", "b", "milestone", "m", "rc", "cr", "snapshot");
+
+    // Known pre-release qualifiers in order, then anything else alphabetically
+    private static int qualifierRank(String token) {
+        int index = QUALIFIERS.indexOf(token);
+        if (index < 0) return QUALIFIERS.size() + 1;
+        return index == QUALIFIERS.size() - 1 ? index : index / 2;
+    }
+
+    private static List<String> tokenize(String version) {
+        List<String> tokens = new ArrayList<>();
+        int start = 0;
+        for (int i = 0; i <= version.length(); i++) {
+            boolean end = i == version.length();
+            char c = end ? 0 : version.charAt(i);
+            if (end || c == '.' || c == '-' || c == '_' || c == '+') {
+                if (i > start) tokens.add(version.substring(start, i));
+                start = i + 1;
+            } else if (i > start && Character.isDigit(c) != Character.isDigit(version.charAt(i - 1))) {
+                // "1.0rc1" is 1, 0, rc, 1
+                tokens.add(version.substring(start, i));
+                start = i;
+            }
+        }
+        return tokens;
+    }
+
+    private static boolean isNumber(String token) {
+        return !token.isEmpty() && Character.isDigit(token.charAt(0));
+    }
+
+    // Compares digits as numbers of any length, ignoring leading zeros
+    private static int compareNumbers(String a, String b) {
+        a = a.replaceFirst("^0+(?=.)", "");
+        b = b.replaceFirst("^0+(?=.)", "");
+        if (a.length() != b.length()) return a.length() - b.length();
+        return a.compareTo(b);
+    }
+
+    /**
+     * Maven-like ordering: numeric parts compare as numbers and a number beats
+     * a qualifier, so
+     * 1.0-alpha < 1.0-beta < 1.0-rc1 < 1.0-SNAPSHOT < 1.0 < 1.0.1.
+     */
+    public static int compareVersions(String a, String b) {
+        List<String> x = tokenize(a.toLowerCase(Locale.ROOT));
+        List<String> y = tokenize(b.toLowerCase(Locale.ROOT));
+        for (int i = 0; i < Math.max(x.size(), y.size()); i++) {
+            // A missing part is 0 next to a number and a release next to a qualifier
+            String p = i < x.size() ? x.get(i) : null, q = i < y.size() ? y.get(i) : null;
+            if (p == null) p = isNumber(q) ? "0" : "";
+            if (q == null) q = isNumber(p) ? "0" : "";
+            int result;
+            if (p.isEmpty() || q.isEmpty()) {
+                result = p.isEmpty() ? 1 : -1;
+            } else if (isNumber(p) && isNumber(q)) {
+                result = compareNumbers(p, q);
+            } else if (isNumber(p) != isNumber(q)) {
+                result = isNumber(p) ? 1 : -1;
+            } else {
+                result = qualifierRank(p) - qualifierRank(q);
+                if (result == 0) result = p.compareTo(q);
+            }
+            if (result != 0) return result;
+        }
+        return 0;
+    }
+}
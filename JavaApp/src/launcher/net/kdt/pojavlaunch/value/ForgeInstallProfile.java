@@ -1,5 +1,6 @@
 package net.kdt.pojavlaunch.value;
 
+import java.util.Map;
 import net.kdt.pojavlaunch.*;
 
 public class ForgeInstallProfile {
@@ -21,4 +22,25 @@ public class ForgeInstallProfile {
     public String json;
     public String path;
     public String minecraft; // target Minecraft version
+
+    // ----- 1.13+ Forge and NeoForge, installed by running processors -----
+    public int spec;
+    public String profile; // launcher profile name
+    public String icon;
+    public Map<String, SidedValue> data;
+    public Processor[] processors;
+    public DependentLibrary[] libraries; // needed by the processors, not the game
+
+    public static class SidedValue {
+        public String client;
+        public String server;
+    }
+
+    public static class Processor {
+        public String[] sides; // both if null
+        public String jar;
+        public String[] classpath;
+        public String[] args;
+        public Map<String, String> outputs; // file -> SHA1, both may be {KEY} or [artifact]
+    }
 }
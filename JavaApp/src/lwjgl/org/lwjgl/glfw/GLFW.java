@@ -596,6 +596,7 @@ public class GLFW
         public static final long
         Init = apiGetFunctionAddress(GLFW, "pojavInit"),
         CreateContext = apiGetFunctionAddress(GLFW, "pojavCreateContext"),
+        DestroyContext = apiGetFunctionAddress(GLFW, "pojavDestroyContext"),
         GetCurrentContext = apiGetFunctionAddress(GLFW, "pojavGetCurrentContext"),
         //DetachOnCurrentThread = apiGetFunctionAddress(GLFW, "pojavDetachOnCurrentThread"),
         MakeContextCurrent = apiGetFunctionAddress(GLFW, "pojavMakeCurrent"),
@@ -986,7 +987,10 @@ public class GLFW
         win.windowAttribs.put(GLFW_VISIBLE, 1);
 
         mGLFWWindowMap.put(ptr, win);
-        mainContext = ptr;
+        if (share == 0) {
+            // Shared windows are offscreen worker contexts
+            mainContext = ptr;
+        }
         return ptr;
         //Return our context
     }
@@ -996,6 +1000,7 @@ public class GLFW
         try {
             internalGetWindow(window);
             mGLFWWindowMap.remove(window);
+            invokePV(window, Functions.DestroyContext);
         } catch (IllegalArgumentException e) {
             System.out.println("GLFW: Warning: failed to remove window " + window);
             e.printStackTrace();
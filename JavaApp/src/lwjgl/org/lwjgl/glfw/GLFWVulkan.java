@@ -202,6 +202,25 @@ public class GLFWVulkan {
         return VK10.vkGetInstanceProcAddr(instance, procname);
     }
 
+    // --- [ glfwGetPipelineCacheAmethyst ] ---
+
+    /**
+     * Returns the launcher's persistent pipeline cache for {@code device}, or {@code VK_NULL_HANDLE} if the device does not have one.
+     *
+     * <p>Pipelines created without a cache already use it implicitly. It is kept alive and saved to the instance directory until the device is
+     * destroyed, so callers must not destroy it.</p>
+     *
+     * @param device the logical device
+     */
+    @NativeType("VkPipelineCache")
+    public static long glfwGetPipelineCacheAmethyst(VkDevice device) {
+        long __functionAddress = VK.getFunctionProvider().getFunctionAddress("amethyst_vkGetPipelineCache");
+        if (__functionAddress == NULL) {
+            return VK10.VK_NULL_HANDLE;
+        }
+        return invokePJ(device.address(), __functionAddress);
+    }
+
     // --- [ glfwGetPhysicalDevicePresentationSupport ] ---
 
     /**
@@ -0,0 +1,202 @@
+package net.kdt.profiler;
+
+import java.io.*;
+import java.lang.instrument.Instrumentation;
+import java.lang.management.ManagementFactory;
+import java.lang.management.ThreadInfo;
+import java.lang.management.ThreadMXBean;
+import java.text.SimpleDateFormat;
+import java.util.*;
+
+/**
+ * Periodically samples the stacks of the game's busiest threads and writes them
+ * as collapsed stacks ("thread;frame;frame count" per line), which flamegraph.pl,
+ * speedscope and similar tools read directly.
+ *
+ * Java stacks can only be walked at a safepoint, so every sample pauses the VM
+ * briefly, whatever API takes it. All named threads are therefore read with a
+ * single ThreadMXBean.getThreadInfo call per tick: one safepoint per interval
+ * rather than one per thread, as Thread.getStackTrace would cost. The sampler
+ * also measures itself and backs off when it takes more than its time budget.
+ *
+ * Arguments: interval=&lt;ms&gt;,out=&lt;directory&gt;,threads=&lt;name prefix&gt;|&lt;name prefix&gt;
+ */
+public class SamplingProfilerAgent implements Runnable {
+    private static final int MAX_DEPTH = 128;
+    private static final long FLUSH_INTERVAL_MS = 30000;
+    private static final long THREAD_REFRESH_MS = 1000;
+    // Fraction of wall time the sampler may spend before it halves its rate
+    private static final double OVERHEAD_BUDGET = 0.01;
+    private static final int MAX_INTERVAL_MS = 1000;
+
+    private final String[] threadPrefixes;
+    private final File outputFile;
+    private final Map<String, int[]> stacks = new HashMap<>();
+    private final StringBuilder builder = new StringBuilder(4096);
+    private final ThreadMXBean threadBean = ManagementFactory.getThreadMXBean();
+    private long[] targetIds = new long[0];
+    private long lastThreadRefresh;
+    private int intervalMs;
+    private long sampleCount, sampleNanos;
+
+    private SamplingProfilerAgent(int intervalMs, File outputFile, String[] threadPrefixes) {
+        this.intervalMs = intervalMs;
+        this.outputFile = outputFile;
+        this.threadPrefixes = threadPrefixes;
+    }
+
+    public static void premain(String args, Instrumentation instrumentation) {
+        int interval = 20;
+        String out = System.getProperty("user.dir") + "/profiler";
+        String threads = "Render thread|Client thread|Server thread|main";
+        for (String arg : (args == null ? "" : args).split(",")) {
+            int split = arg.indexOf('=');
+            if (split < 0) continue;
+            String key = arg.substring(0, split), value = arg.substring(split + 1);
+            if (key.equals("interval")) {
+                interval = Math.max(1, Integer.parseInt(value));
+            } else if (key.equals("out")) {
+                out = value;
+            } else if (key.equals("threads")) {
+                threads = value;
+            }
+        }
+
+        File dir = new File(out);
+        dir.mkdirs();
+        String name = new SimpleDateFormat("yyyy-MM-dd_HH.mm.ss").format(new Date()) + ".collapsed";
+        SamplingProfilerAgent agent = new SamplingProfilerAgent(interval, new File(dir, name), threads.split("\\|"));
+        System.out.println("SamplingProfilerAgent: sampling every " + interval + "ms into " + agent.outputFile);
+
+        Thread sampler = new Thread(agent, "Profiler sampler");
+        sampler.setDaemon(true);
+        sampler.setPriority(Thread.MAX_PRIORITY);
+        sampler.start();
+        Runtime.getRuntime().addShutdownHook(new Thread(() -> {
+            synchronized (agent) {
+                agent.flush();
+            }
+            System.out.println(agent.summary());
+        }, "Profiler shutdown"));
+    }
+
+    @Override
+    public void run() {
+        long lastFlush = System.currentTimeMillis();
+        long windowStart = System.nanoTime(), windowSampleNanos = 0;
+        while (true) {
+            try {
+                Thread.sleep(intervalMs);
+            } catch (InterruptedException e) {
+                return;
+            }
+
+            long start = System.nanoTime();
+            synchronized (this) {
+                sample();
+            }
+            long end = System.nanoTime();
+            sampleNanos += end - start;
+            windowSampleNanos += end - start;
+
+            // Re-evaluate the cost every second of wall time
+            if (end - windowStart >= 1000000000L) {
+                double overhead = (double) windowSampleNanos / (end - windowStart);
+                if (overhead > OVERHEAD_BUDGET && intervalMs < MAX_INTERVAL_MS) {
+                    intervalMs = Math.min(intervalMs * 2, MAX_INTERVAL_MS);
+                    System.out.printf("SamplingProfilerAgent: sampling took %.1f%% of wall time, interval is now %dms%n",
+                        overhead * 100, intervalMs);
+                }
+                windowStart = end;
+                windowSampleNanos = 0;
+            }
+
+            if (System.currentTimeMillis() - lastFlush >= FLUSH_INTERVAL_MS) {
+                synchronized (this) {
+                    flush();
+                }
+                lastFlush = System.currentTimeMillis();
+            }
+        }
+    }
+
+    private void refreshTargets() {
+        ThreadGroup root = Thread.currentThread().getThreadGroup();
+        while (root.getParent() != null) {
+            root = root.getParent();
+        }
+        Thread[] threads = new Thread[root.activeCount() + 16];
+        int count = root.enumerate(threads, true);
+        long[] matched = new long[count];
+        int matchedCount = 0;
+        for (int i = 0; i < count; i++) {
+            for (String prefix : threadPrefixes) {
+                if (threads[i].getName().startsWith(prefix)) {
+                    matched[matchedCount++] = threads[i].getId();
+                    break;
+                }
+            }
+        }
+        targetIds = Arrays.copyOf(matched, matchedCount);
+    }
+
+    private void sample() {
+        long now = System.currentTimeMillis();
+        if (now - lastThreadRefresh >= THREAD_REFRESH_MS) {
+            refreshTargets();
+            lastThreadRefresh = now;
+        }
+
+        if (targetIds.length == 0) return;
+        // One extra frame tells a truncated stack apart from one that fits
+        for (ThreadInfo info : threadBean.getThreadInfo(targetIds, MAX_DEPTH + 1)) {
+            // Exited since the last refresh; blocked and waiting threads aren't
+            // using the CPU, keep the profile on-CPU
+            if (info == null || info.getThreadState() != Thread.State.RUNNABLE) continue;
+            StackTraceElement[] frames = info.getStackTrace();
+            if (frames.length == 0) continue;
+
+            builder.setLength(0);
+            builder.append(info.getThreadName().replace(';', '_'));
+            if (frames.length > MAX_DEPTH) {
+                builder.append(";[truncated]");
+            }
+            // Collapsed stacks go from the root to the leaf
+            for (int i = Math.min(frames.length, MAX_DEPTH) - 1; i >= 0; i--) {
+                builder.append(';').append(frames[i].getClassName()).append('.').append(frames[i].getMethodName());
+            }
+            String key = builder.toString();
+            int[] counter = stacks.get(key);
+            if (counter == null) {
+                stacks.put(key, new int[]{1});
+            } else {
+                counter[0]++;
+            }
+            sampleCount++;
+        }
+    }
+
+    private void flush() {
+        if (stacks.isEmpty()) return;
+        File tmp = new File(outputFile.getPath() + ".tmp");
+        try (Writer writer = new BufferedWriter(new FileWriter(tmp))) {
+            for (Map.Entry<String, int[]> entry : stacks.entrySet()) {
+                writer.write(entry.getKey());
+                writer.write(' ');
+                writer.write(Integer.toString(entry.getValue()[0]));
+                writer.write('\n');
+            }
+        } catch (IOException e) {
+            e.printStackTrace();
+            return;
+        }
+        if (!tmp.renameTo(outputFile)) {
+            System.out.println("SamplingProfilerAgent: could not write " + outputFile);
+        }
+    }
+
+    private String summary() {
+        return String.format("SamplingProfilerAgent: %d samples, %d unique stacks, %.1fms spent sampling, written to %s",
+            sampleCount, stacks.size(), sampleNanos / 1e6, outputFile);
+    }
+}
@@ -0,0 +1,40 @@
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@interface DirectoryEntry : NSObject
+@property(nonatomic, readonly) NSString *name;
+@property(nonatomic, readonly) unsigned long long size;
+@property(nonatomic, readonly) NSDate *modificationDate;
+@property(nonatomic, readonly) BOOL isDirectory;
+@end
+
+@interface DirectoryChange : NSObject
+@property(nonatomic, readonly) NSString *path;
+@property(nonatomic, readonly) NSArray<DirectoryEntry *> *added, *removed, *modified;
+@end
+
+typedef void(^DirectoryChangeHandler)(DirectoryChange *change);
+
+// Keeps an in-memory listing of each directory asked for and updates it from
+// kqueue (inotify on Linux) events, so screens read the listing or subscribe
+// to changes instead of rescanning the folder every time they appear. Bursts
+// of events are coalesced into a single rescan, unless the listing is asked
+// for in between, which rescans right away.
+@interface DirectoryWatcher : NSObject
+
++ (instancetype)sharedWatcher;
+
+// Sorted by name, empty if the directory doesn't exist
+- (NSArray<DirectoryEntry *> *)entriesAtPath:(NSString *)path;
+// Handlers run on the main queue, only for actual changes
+- (id)addObserverForPath:(NSString *)path handler:(DirectoryChangeHandler)handler;
+// Stops watching the path once its last observer is removed
+- (void)removeObserver:(id)observer;
+// Stops watching a path that was only listed, closing its descriptors. Does
+// nothing while observers remain; a later listing starts over.
+- (void)unwatchPath:(NSString *)path;
+
+@end
+
+NS_ASSUME_NONNULL_END
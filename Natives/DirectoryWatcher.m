@@ -0,0 +1,238 @@
+#import "DirectoryWatcher.h"
+#include "dir_snapshot.h"
+#include "dir_watch.h"
+
+// Coalesces a burst of events, e.g. a modpack being extracted
+#define RESCAN_DELAY_MS 100
+
+@interface DirectoryEntry()
+- (instancetype)initWithEntry:(const dir_entry_t *)entry;
+@end
+
+@implementation DirectoryEntry
+
+- (instancetype)initWithEntry:(const dir_entry_t *)entry {
+    self = [super init];
+    _name = @(entry->name);
+    _size = entry->size;
+    _modificationDate = [NSDate dateWithTimeIntervalSince1970:entry->mtime / 1e9];
+    _isDirectory = entry->isDirectory;
+    return self;
+}
+
+@end
+
+@interface DirectoryChange()
+@property(nonatomic) NSString *path;
+@property(nonatomic) NSMutableArray<DirectoryEntry *> *added, *removed, *modified;
+@end
+
+@implementation DirectoryChange
+@end
+
+@interface DirectoryObserver : NSObject
+@property(nonatomic) NSString *path;
+@property(nonatomic, copy) DirectoryChangeHandler handler;
+@end
+
+@implementation DirectoryObserver
+@end
+
+@interface WatchedDirectory : NSObject {
+@public
+    dir_snapshot_t snapshot;
+}
+@property(nonatomic) NSString *path;
+// NULL while the directory doesn't exist
+@property(nonatomic) dir_watch_t *watch;
+// Reads the watch, owns and closes it when cancelled
+@property(nonatomic) dispatch_source_t source;
+// Built from the snapshot on first request
+@property(nonatomic) NSArray<DirectoryEntry *> *entries;
+@property(nonatomic) NSMutableArray<DirectoryObserver *> *observers;
+@property(nonatomic) BOOL rescanPending;
+@end
+
+@implementation WatchedDirectory
+@end
+
+static void collectChange(void *context, dir_change_t type, const dir_entry_t *entry) {
+    DirectoryChange *change = (__bridge DirectoryChange *)context;
+    DirectoryEntry *object = [[DirectoryEntry alloc] initWithEntry:entry];
+    switch (type) {
+        case DIR_CHANGE_ADDED: [change.added addObject:object]; break;
+        case DIR_CHANGE_REMOVED: [change.removed addObject:object]; break;
+        case DIR_CHANGE_MODIFIED: [change.modified addObject:object]; break;
+    }
+}
+
+@interface DirectoryWatcher()
+@property(nonatomic) dispatch_queue_t queue;
+@property(nonatomic) NSMutableDictionary<NSString *, WatchedDirectory *> *directories;
+@end
+
+@implementation DirectoryWatcher
+
++ (instancetype)sharedWatcher {
+    static DirectoryWatcher *watcher;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        watcher = [DirectoryWatcher new];
+    });
+    return watcher;
+}
+
+- (instancetype)init {
+    self = [super init];
+    self.queue = dispatch_queue_create("DirectoryWatcher", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+    self.directories = [NSMutableDictionary new];
+    return self;
+}
+
+#pragma mark - Watching
+
+- (WatchedDirectory *)directoryForPath:(NSString *)path {
+    path = path.stringByStandardizingPath;
+    WatchedDirectory *dir = self.directories[path];
+    if (!dir) {
+        dir = [WatchedDirectory new];
+        dir.path = path;
+        dir.observers = [NSMutableArray new];
+        self.directories[path] = dir;
+    }
+    if (!dir.watch) {
+        [self openDirectory:dir];
+        return dir;
+    }
+    // Callers must never see a listing older than an event already queued,
+    // whether or not it was delivered yet
+    int flags = dir_watch_read(dir.watch);
+    if (flags & DIR_WATCH_GONE) {
+        [self closeDirectory:dir];
+        [self rescanDirectory:dir];
+    } else if (flags || dir.rescanPending) {
+        [self rescanDirectory:dir];
+    }
+    return dir;
+}
+
+- (void)openDirectory:(WatchedDirectory *)dir {
+    dir_watch_t *watch = dir_watch_open(dir.path.fileSystemRepresentation);
+    if (!watch) return;
+
+    dispatch_source_t source = dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, dir_watch_fd(watch), 0, self.queue);
+    __weak WatchedDirectory *weakDir = dir;
+    dispatch_source_set_event_handler(source, ^{
+        WatchedDirectory *dir = weakDir;
+        if (!dir || dir.watch != watch) return;
+        int flags = dir_watch_read(watch);
+        if (flags & DIR_WATCH_GONE) {
+            // The directory itself went away, report everything as removed and wait for it to come back
+            [self closeDirectory:dir];
+            [self rescanDirectory:dir];
+            return;
+        }
+        if (flags && !dir.rescanPending) {
+            dir.rescanPending = YES;
+            dispatch_after(dispatch_time(DISPATCH_TIME_NOW, RESCAN_DELAY_MS * NSEC_PER_MSEC), self.queue, ^{
+                if (dir.rescanPending) {
+                    [self rescanDirectory:dir];
+                }
+            });
+        }
+    });
+    dispatch_source_set_cancel_handler(source, ^{
+        dir_watch_close(watch);
+    });
+    dir.watch = watch;
+    dir.source = source;
+    dispatch_resume(source);
+    // Also picks up whatever changed while it wasn't watched
+    [self rescanDirectory:dir];
+}
+
+- (void)closeDirectory:(WatchedDirectory *)dir {
+    if (!dir.source) return;
+    dispatch_source_cancel(dir.source);
+    dir.source = nil;
+    dir.watch = NULL;
+}
+
+- (void)rescanDirectory:(WatchedDirectory *)dir {
+    dir.rescanPending = NO;
+    dir_snapshot_t next = {0};
+    if (dir.watch) {
+        dir_snapshot_scan(dir.path.fileSystemRepresentation, &dir->snapshot, &next);
+    }
+
+    DirectoryChange *change = [DirectoryChange new];
+    change.path = dir.path;
+    change.added = [NSMutableArray new];
+    change.removed = [NSMutableArray new];
+    change.modified = [NSMutableArray new];
+    size_t count = dir_snapshot_diff(&dir->snapshot, &next, collectChange, (__bridge void *)change);
+    dir_snapshot_free(&dir->snapshot);
+    dir->snapshot = next;
+    if (count == 0) return;
+
+    dir.entries = nil;
+    NSArray<DirectoryObserver *> *observers = dir.observers.copy;
+    if (observers.count == 0) return;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        for (DirectoryObserver *observer in observers) {
+            observer.handler(change);
+        }
+    });
+}
+
+#pragma mark - Public
+
+- (NSArray<DirectoryEntry *> *)entriesAtPath:(NSString *)path {
+    __block NSArray<DirectoryEntry *> *entries;
+    dispatch_sync(self.queue, ^{
+        WatchedDirectory *dir = [self directoryForPath:path];
+        if (!dir.entries) {
+            NSMutableArray *list = [NSMutableArray arrayWithCapacity:dir->snapshot.count];
+            for (size_t i = 0; i < dir->snapshot.count; i++) {
+                [list addObject:[[DirectoryEntry alloc] initWithEntry:&dir->snapshot.entries[i]]];
+            }
+            dir.entries = list;
+        }
+        entries = dir.entries;
+    });
+    return entries;
+}
+
+- (id)addObserverForPath:(NSString *)path handler:(DirectoryChangeHandler)handler {
+    DirectoryObserver *observer = [DirectoryObserver new];
+    observer.path = path.stringByStandardizingPath;
+    observer.handler = handler;
+    dispatch_sync(self.queue, ^{
+        [[self directoryForPath:path].observers addObject:observer];
+    });
+    return observer;
+}
+
+- (void)removeObserver:(DirectoryObserver *)observer {
+    if (!observer) return;
+    dispatch_sync(self.queue, ^{
+        WatchedDirectory *dir = self.directories[observer.path];
+        [dir.observers removeObjectIdenticalTo:observer];
+        [self releaseDirectoryIfUnobserved:dir];
+    });
+}
+
+- (void)unwatchPath:(NSString *)path {
+    dispatch_sync(self.queue, ^{
+        [self releaseDirectoryIfUnobserved:self.directories[path.stringByStandardizingPath]];
+    });
+}
+
+- (void)releaseDirectoryIfUnobserved:(WatchedDirectory *)dir {
+    if (!dir || dir.observers.count > 0) return;
+    [self closeDirectory:dir];
+    dir_snapshot_free(&dir->snapshot);
+    [self.directories removeObjectForKey:dir.path];
+}
+
+@end
@@ -1,9 +1,11 @@
+#import "DirectoryWatcher.h"
 #import "FileListViewController.h"
 
 @interface FileListViewController () {
 }
 
 @property(nonatomic) NSMutableArray *fileList;
+@property(nonatomic) id directoryObserver;
 
 @end
 
@@ -19,20 +21,45 @@
     }
 
     // List files
-    NSFileManager *fm = [NSFileManager defaultManager];
-    NSArray *files = [fm contentsOfDirectoryAtPath:self.listPath error:nil];
-    for(NSString *file in files) {
-        NSString *path = [self.listPath stringByAppendingPathComponent:file];
-        BOOL isDir = NO;
-        [fm fileExistsAtPath:path isDirectory:(&isDir)];
-        if(!isDir && [file hasSuffix:@".json"]) {
-            [self.fileList addObject:[file stringByDeletingPathExtension]];
+    for (DirectoryEntry *entry in [DirectoryWatcher.sharedWatcher entriesAtPath:self.listPath]) {
+        if (!entry.isDirectory && [entry.name hasSuffix:@".json"]) {
+            [self.fileList addObject:[entry.name stringByDeletingPathExtension]];
         }
     }
 
+    __weak FileListViewController *weakSelf = self;
+    self.directoryObserver = [DirectoryWatcher.sharedWatcher addObserverForPath:self.listPath handler:^(DirectoryChange *change) {
+        [weakSelf applyDirectoryChange:change];
+    }];
+
     [self.tableView setSeparatorStyle:UITableViewCellSeparatorStyleSingleLine];
 }
 
+- (void)dealloc {
+    [DirectoryWatcher.sharedWatcher removeObserver:self.directoryObserver];
+}
+
+- (void)applyDirectoryChange:(DirectoryChange *)change {
+    BOOL changed = NO;
+    for (DirectoryEntry *entry in change.removed) {
+        NSString *name = entry.name.stringByDeletingPathExtension;
+        if ([entry.name hasSuffix:@".json"] && [self.fileList containsObject:name]) {
+            [self.fileList removeObject:name];
+            changed = YES;
+        }
+    }
+    for (DirectoryEntry *entry in change.added) {
+        NSString *name = entry.name.stringByDeletingPathExtension;
+        if (!entry.isDirectory && [entry.name hasSuffix:@".json"] && ![self.fileList containsObject:name]) {
+            [self.fileList addObject:name];
+            changed = YES;
+        }
+    }
+    if (changed) {
+        [self.tableView reloadData];
+    }
+}
+
 - (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section
 {
     return self.fileList.count;
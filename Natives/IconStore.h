@@ -0,0 +1,43 @@
+#import <UIKit/UIKit.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Thumbnail edge lengths in pixels, each stored icon is written once per size
+typedef NS_ENUM(NSUInteger, IconStoreSize) {
+    IconStoreSizeSmall = 64,
+    IconStoreSizeLarge = 128
+};
+
+// Profile and mod icons keyed by the SHA-1 of their source bytes. Each distinct
+// icon is decoded and downscaled once to every IconStoreSize, the thumbnails
+// stay in $POJAV_HOME/icons and decoded ones are kept in memory. Profiles keep
+// their "icon" as the launcher writes it (usually a "data:" URL), so
+// launcher_profiles.json stays readable by other launchers; the store is
+// only a cache in front of it.
+@interface IconStore : NSObject
+
+@property(nonatomic, readonly) NSString *storePath;
+
++ (instancetype)sharedStore;
+- (instancetype)initWithStorePath:(NSString *)storePath;
+
+// Returns the hash, or nil if the data is not a decodable image. Safe to call from any thread.
+- (nullable NSString *)storeImageData:(NSData *)data;
+- (nullable NSString *)storeImageAtPath:(NSString *)path;
+- (nullable UIImage *)imageForHash:(NSString *)hash size:(IconStoreSize)size;
+
+// Hash of a profile "icon" value, stored first if it is a data URL seen for
+// the first time; nil for remote URLs and anything undecodable. Also takes
+// the "iconstore:<hash>" references earlier versions wrote into profiles.
+- (nullable NSString *)hashForIcon:(nullable NSString *)icon;
+// Turns such a reference back into a data URL, returns any other value unchanged
+- (nullable NSString *)portableIconString:(nullable NSString *)icon;
+// The image file as a "data:image/png;base64," URL, for a new profile's "icon"
++ (nullable NSString *)dataURLForImageAtPath:(NSString *)path;
+
+// Shows a profile "icon" value: data URLs and references come from the store, remote URLs are fetched as before
+- (void)setIcon:(nullable NSString *)icon onImageView:(UIImageView *)imageView placeholder:(nullable UIImage *)placeholder;
+
+@end
+
+NS_ASSUME_NONNULL_END
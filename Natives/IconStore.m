@@ -0,0 +1,222 @@
+#import <ImageIO/ImageIO.h>
+#import <objc/runtime.h>
+#import "IconStore.h"
+#import "UIKit+AFNetworking.h"
+#include "icon_store.h"
+
+static const IconStoreSize IconStoreAllSizes[] = {IconStoreSizeSmall, IconStoreSizeLarge};
+static char IconStoreWantedIconKey;
+
+@interface IconStore()
+@property(nonatomic) NSCache<NSString *, UIImage *> *memoryCache;
+// Data URL -> hash, so a profile list doesn't decode every icon again
+@property(nonatomic) NSCache<NSString *, NSString *> *hashCache;
+@property(nonatomic) dispatch_queue_t loadQueue;
+@end
+
+@implementation IconStore
+
++ (instancetype)sharedStore {
+    static IconStore *store;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        store = [[IconStore alloc] initWithStorePath:[NSString stringWithFormat:@"%s/icons", getenv("POJAV_HOME")]];
+    });
+    return store;
+}
+
+- (instancetype)initWithStorePath:(NSString *)storePath {
+    self = [super init];
+    _storePath = storePath;
+    _memoryCache = [NSCache new];
+    // Thumbnails are at most 128x128, this keeps a few hundred of them decoded
+    _memoryCache.totalCostLimit = 16 * 1024 * 1024;
+    _hashCache = [NSCache new];
+    _loadQueue = dispatch_queue_create("IconStore", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_CONCURRENT, QOS_CLASS_USER_INITIATED, 0));
+    [NSFileManager.defaultManager createDirectoryAtPath:storePath withIntermediateDirectories:YES attributes:nil error:nil];
+    return self;
+}
+
+#pragma mark - Storing
+
+- (NSString *)pathForHash:(NSString *)hash size:(IconStoreSize)size {
+    char path[PATH_MAX];
+    if (!icon_store_path(self.storePath.fileSystemRepresentation, hash.UTF8String, (unsigned)size, path, sizeof(path))) {
+        return nil;
+    }
+    return @(path);
+}
+
+- (NSString *)storeImageData:(NSData *)data {
+    if (data.length == 0) return nil;
+
+    char hashHex[SHA1_HEX_LENGTH + 1];
+    sha1_hex(data.bytes, data.length, hashHex);
+    NSString *hash = @(hashHex);
+
+    // The largest size is written last, so its presence means the icon is complete
+    NSFileManager *fm = NSFileManager.defaultManager;
+    if ([fm fileExistsAtPath:[self pathForHash:hash size:IconStoreSizeLarge]]) {
+        return hash;
+    }
+
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)data, NULL);
+    if (!source) return nil;
+    if (CGImageSourceGetCount(source) == 0) {
+        CFRelease(source);
+        return nil;
+    }
+    [fm createDirectoryAtPath:[self pathForHash:hash size:IconStoreSizeSmall].stringByDeletingLastPathComponent
+        withIntermediateDirectories:YES attributes:nil error:nil];
+
+    BOOL success = YES;
+    for (int i = 0; i < sizeof(IconStoreAllSizes) / sizeof(IconStoreAllSizes[0]) && success; i++) {
+        // ImageIO decodes straight to the target size and never upscales
+        CGImageRef thumbnail = CGImageSourceCreateThumbnailAtIndex(source, 0, (__bridge CFDictionaryRef)@{
+            (id)kCGImageSourceCreateThumbnailFromImageAlways: @YES,
+            (id)kCGImageSourceCreateThumbnailWithTransform: @YES,
+            (id)kCGImageSourceThumbnailMaxPixelSize: @(IconStoreAllSizes[i])
+        });
+        if (!thumbnail) {
+            success = NO;
+            break;
+        }
+        NSMutableData *png = [NSMutableData data];
+        CGImageDestinationRef dest = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)png, CFSTR("public.png"), 1, NULL);
+        CGImageDestinationAddImage(dest, thumbnail, NULL);
+        success = CGImageDestinationFinalize(dest) &&
+            [png writeToFile:[self pathForHash:hash size:IconStoreAllSizes[i]] atomically:YES];
+        CFRelease(dest);
+        CGImageRelease(thumbnail);
+    }
+    CFRelease(source);
+
+    if (!success) {
+        NSLog(@"[IconStore] Failed to store icon %@", hash);
+        return nil;
+    }
+    return hash;
+}
+
+- (NSString *)storeImageAtPath:(NSString *)path {
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:nil];
+    return data ? [self storeImageData:data] : nil;
+}
+
+#pragma mark - Loading
+
+- (UIImage *)imageForHash:(NSString *)hash size:(IconStoreSize)size {
+    if (hash.length != SHA1_HEX_LENGTH) return nil;
+    NSString *key = [NSString stringWithFormat:@"%@/%lu", hash, (unsigned long)size];
+    UIImage *image = [self.memoryCache objectForKey:key];
+    if (image) return image;
+
+    NSURL *url = [NSURL fileURLWithPath:[self pathForHash:hash size:size]];
+    CGImageSourceRef source = CGImageSourceCreateWithURL((__bridge CFURLRef)url, NULL);
+    if (!source) return nil;
+    // Decode now rather than on the main thread at first draw
+    CGImageRef cgImage = CGImageSourceCreateImageAtIndex(source, 0, (__bridge CFDictionaryRef)@{
+        (id)kCGImageSourceShouldCacheImmediately: @YES
+    });
+    CFRelease(source);
+    if (!cgImage) return nil;
+
+    image = [UIImage imageWithCGImage:cgImage];
+    [self.memoryCache setObject:image forKey:key
+        cost:CGImageGetBytesPerRow(cgImage) * CGImageGetHeight(cgImage)];
+    CGImageRelease(cgImage);
+    return image;
+}
+
+#pragma mark - Profile icons
+
+- (NSString *)hashForIcon:(NSString *)icon {
+    if (![icon isKindOfClass:NSString.class]) return nil;
+    char hash[SHA1_HEX_LENGTH + 1];
+    if (icon_store_reference_hash(icon.UTF8String, hash)) {
+        return @(hash);
+    }
+    if (![icon hasPrefix:@"data:"]) return nil;
+    NSString *cached = [self.hashCache objectForKey:icon];
+    if (cached) return cached;
+
+    size_t length;
+    uint8_t *bytes = icon_store_decode_data_url(icon.UTF8String, &length);
+    if (!bytes) return nil;
+    NSString *stored = [self storeImageData:[NSData dataWithBytesNoCopy:bytes length:length freeWhenDone:YES]];
+    if (stored) {
+        [self.hashCache setObject:stored forKey:icon];
+    }
+    return stored;
+}
+
+- (NSString *)portableIconString:(NSString *)icon {
+    char hash[SHA1_HEX_LENGTH + 1];
+    if (![icon isKindOfClass:NSString.class] || !icon_store_reference_hash(icon.UTF8String, hash)) {
+        return icon;
+    }
+    // Only the thumbnails were kept, the larger one stands in for the original
+    NSData *png = [NSData dataWithContentsOfFile:[self pathForHash:@(hash) size:IconStoreSizeLarge]];
+    if (!png) {
+        return nil;
+    }
+    char *url = icon_store_png_data_url(png.bytes, png.length);
+    NSString *dataURL = @(url);
+    free(url);
+    [self.hashCache setObject:@(hash) forKey:dataURL];
+    return dataURL;
+}
+
++ (NSString *)dataURLForImageAtPath:(NSString *)path {
+    NSData *data = [NSData dataWithContentsOfFile:path];
+    if (!data) return nil;
+    char *url = icon_store_png_data_url(data.bytes, data.length);
+    NSString *dataURL = @(url);
+    free(url);
+    return dataURL;
+}
+
+- (void)setIcon:(NSString *)icon onImageView:(UIImageView *)imageView placeholder:(UIImage *)placeholder {
+    BOOL local = [icon isKindOfClass:NSString.class] &&
+        ([icon hasPrefix:@"data:"] || [icon hasPrefix:@ICON_STORE_REFERENCE_PREFIX]);
+    objc_setAssociatedObject(imageView, &IconStoreWantedIconKey, local ? icon : nil, OBJC_ASSOCIATION_COPY_NONATOMIC);
+    if (!local) {
+        [imageView setImageWithURL:[NSURL URLWithString:icon] placeholderImage:placeholder];
+        return;
+    }
+    // A reused cell may still have a remote icon on the way
+    [imageView cancelImageDownloadTask];
+
+    CGFloat pointSize = placeholder ? placeholder.size.width : 40;
+    IconStoreSize size = pointSize * UIScreen.mainScreen.scale > IconStoreSizeSmall ?
+        IconStoreSizeLarge : IconStoreSizeSmall;
+    // Match the placeholder's point size so the cell layout doesn't jump
+    UIImage *(^fit)(UIImage *) = ^UIImage *(UIImage *image) {
+        CGFloat scale = MAX(image.size.width, image.size.height) / pointSize;
+        return [UIImage imageWithCGImage:image.CGImage scale:scale orientation:UIImageOrientationUp];
+    };
+
+    // Known icons are usually decoded already
+    char reference[SHA1_HEX_LENGTH + 1];
+    NSString *hash = icon_store_reference_hash(icon.UTF8String, reference) ? @(reference) : [self.hashCache objectForKey:icon];
+    UIImage *cached = hash ? [self.memoryCache objectForKey:[NSString stringWithFormat:@"%@/%lu", hash, (unsigned long)size]] : nil;
+    if (cached) {
+        imageView.image = fit(cached);
+        return;
+    }
+    imageView.image = placeholder;
+    dispatch_async(self.loadQueue, ^{
+        // The first time a data URL is seen it gets decoded and stored here
+        NSString *iconHash = [self hashForIcon:icon];
+        UIImage *image = iconHash ? [self imageForHash:iconHash size:size] : nil;
+        if (!image) return;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            if ([objc_getAssociatedObject(imageView, &IconStoreWantedIconKey) isEqualToString:icon]) {
+                imageView.image = fit(image);
+                [imageView.superview setNeedsLayout];
+            }
+        });
+    });
+}
+
+@end
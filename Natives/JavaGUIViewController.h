@@ -6,6 +6,8 @@
 
 @interface JavaGUIViewController : UIViewController
 @property(nonatomic) NSString* filepath;
+// Installs the Forge/NeoForge installer at filepath without running its GUI
+@property(nonatomic) BOOL headless;
 @property(nonatomic, readonly) int requiredJavaVersion;
 
 - (void)setHitEnterAfterWindowShown:(BOOL)hitEnter;
@@ -231,6 +231,11 @@ void AWTInputBridge_sendKey(int keycode) {
     [self setNeedsUpdateOfHomeIndicatorAutoHidden];
     virtualMouseEnabled = getPrefBool(@"control.virtmouse_enable");
 
+    if (self.headless) {
+        [self launchHeadlessInstaller];
+        return;
+    }
+
     CGRect screenBounds = self.view.bounds;
     CGFloat screenScale = UIScreen.mainScreen.scale * getPrefFloat(@"video.resolution") / 100.0;
     windowWidth = roundf(screenBounds.size.width * screenScale);
@@ -318,6 +323,20 @@ dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
     });
 }
 
+// Nothing to draw or click, the log is all there is to show
+- (void)launchHeadlessInstaller {
+    self.logOutputView = [[PLLogOutputView alloc] initWithFrame:self.view.frame];
+    self.logOutputView.autoresizingMask = UIViewAutoresizingFlexibleHeight | UIViewAutoresizingFlexibleWidth;
+    [self.view addSubview:self.logOutputView];
+    [self.logOutputView actionToggleLogOutput];
+
+    NSArray *args = @[@"-installForge", self.filepath, @(getenv("POJAV_GAME_DIR"))];
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        launchJVM(nil, args, 0, 0, _requiredJavaVersion);
+        _requiredJavaVersion = 0;
+    });
+}
+
 - (void)loadCustomControls {
     NSMutableDictionary *dict = [[NSMutableDictionary alloc] init];
     dict[@"version"] = @(4);
@@ -17,4 +17,6 @@ typedef jint JLI_Launch_func(int argc, const char ** argv, /* main argc, argc */
 );
 JLI_Launch_func *pJLI_Launch;
 
+// launchTarget is a version NSDictionary to play, a jar path to run, or an
+// NSArray of arguments for a headless launcher task
 int launchJVM(NSString *username, id launchTarget, int width, int height, int minVersion);
@@ -9,6 +9,10 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include "ctxbridges/renderer_probe.h"
+#include "gc_log.h"
+#include "memory_governor.h"
+#include "stall_watchdog.h"
 #include "utils.h"
 
 #import "ios_uikit_bridge.h"
@@ -99,6 +103,26 @@ void init_loadCustomJvmFlags(int* argc, const char** argv) {
     }
 }
 
+// Summarizes the GC log of the previous session before the JVM overwrites it
+void collectGCLogStats(NSString *gameDir) {
+    NSString *logPath = [gameDir stringByAppendingPathComponent:@"logs/gc.log"];
+    // The JVM doesn't create the log's directory
+    [NSFileManager.defaultManager createDirectoryAtPath:logPath.stringByDeletingLastPathComponent
+        withIntermediateDirectories:YES attributes:nil error:nil];
+    struct stat st;
+    gclog_stats_t stats;
+    if (stat(logPath.UTF8String, &st) != 0 || !gclog_parse(logPath.UTF8String, &stats)) {
+        return;
+    }
+    NSString *statsPath = [gameDir stringByAppendingPathComponent:@"gc_stats.jsonl"];
+    gclog_append_session(statsPath.UTF8String, &stats, st.st_mtime);
+    NSLog(@"[JavaLauncher] Last session: %d GC pauses (p50 %.1fms, p99 %.1fms, max %.1fms), "
+        "%.1f MB/s allocated, %.0f MB live after GC, %d safepoints (p99 %.2fms to reach)",
+        stats.pauseCount, stats.pauseP50Ms, stats.pauseP99Ms, stats.pauseMaxMs,
+        stats.allocRateMBps, stats.heapAfterAvgMB, stats.safepointCount, stats.ttspP99Ms);
+    unlink(logPath.UTF8String);
+}
+
 int launchJVM(NSString *username, id launchTarget, int width, int height, int minVersion) {
     NSLog(@"[JavaLauncher] Beginning JVM launch");
 
@@ -117,7 +141,7 @@ int launchJVM(NSString *username, id launchTarget, int width, int height, int mi
     init_loadDefaultEnv();
     init_loadCustomEnv();
 
-    BOOL launchJar = NO;
+    BOOL launchJar = NO, headless = NO;
     NSString *gameDir;
     NSString *defaultJRETag;
     if ([launchTarget isKindOfClass:NSDictionary.class]) {
@@ -141,6 +165,10 @@ int launchJVM(NSString *username, id launchTarget, int width, int height, int mi
         NSString *renderer = [PLProfiles resolveKeyForCurrentProfile:@"renderer"];
         NSLog(@"[JavaLauncher] RENDERER is set to %@\n", renderer);
         setenv("AMETHYST_RENDERER", renderer.UTF8String, 1);
+        if ([renderer isEqualToString:@"auto"]) {
+            // Measure the renderers while the JVM starts, the game asks for one later
+            renderer_probe_start();
+        }
         // Setup gameDir
         gameDir = [NSString stringWithFormat:@"%s/instances/%@/%@",
             getenv("POJAV_HOME"), getPrefObject(@"general.game_directory"),
@@ -150,6 +178,8 @@ int launchJVM(NSString *username, id launchTarget, int width, int height, int mi
         defaultJRETag = @"execute_jar";
         gameDir = @(getenv("POJAV_GAME_DIR"));
         launchJar = YES;
+        // Arguments for a launcher task that runs without AWT, e.g. -installForge <jar> <dir>
+        headless = [launchTarget isKindOfClass:NSArray.class];
     }
     NSLog(@"[JavaLauncher] Looking for Java %d or later", minVersion);
     NSString *javaHome = getSelectedJavaHome(defaultJRETag, minVersion);
@@ -158,7 +188,7 @@ int launchJVM(NSString *username, id launchTarget, int width, int height, int mi
         UIKit_returnToSplitView();
         BOOL isExecuteJar = [defaultJRETag isEqualToString:@"execute_jar"];
         showDialog(localize(@"Error", nil), [NSString stringWithFormat:localize(@"java.error.missing_runtime", nil),
-            isExecuteJar ? [launchTarget lastPathComponent] : PLProfiles.current.selectedProfile[@"lastVersionId"], minVersion]);
+            isExecuteJar ? [(headless ? launchTarget[1] : launchTarget) lastPathComponent] : PLProfiles.current.selectedProfile[@"lastVersionId"], minVersion]);
         return 1;
     } else if ([javaHome hasPrefix:@(getenv("POJAV_HOME"))]) {
         // Symlink libawt_xawt.dylib
@@ -171,16 +201,36 @@ int launchJVM(NSString *username, id launchTarget, int width, int height, int mi
         }
     }
 
+    // Read and written by libvkpipelinecache.dylib when the game renders with Vulkan
+    setenv("AMETHYST_VK_PIPELINE_CACHE", [gameDir stringByAppendingPathComponent:@"vk_pipeline_cache.bin"].UTF8String, 1);
+
     setenv("JAVA_HOME", javaHome.UTF8String, 1);
     NSLog(@"[JavaLauncher] JAVA_HOME has been set to %@", javaHome);
+    // The selected runtime may be newer than the minimum, and flags differ between versions
+    int javaVersion = gclog_java_version(javaHome.UTF8String);
+    if (javaVersion == 0) {
+        javaVersion = minVersion;
+    }
 
-    int allocmem;
+    memgov_sizing_t sizing;
     if (getPrefBool(@"java.auto_ram")) {
-        CGFloat autoRatio = getEntitlementValue(@"com.apple.private.memorystatus") ? 0.4 : 0.25;
-        allocmem = roundf((NSProcessInfo.processInfo.physicalMemory >> 20) * autoRatio);
+        memgov_input_t input = {
+            .physicalMB = (int)(NSProcessInfo.processInfo.physicalMemory >> 20),
+            .maxRatio = getEntitlementValue(@"com.apple.private.memorystatus") ? 0.4 : 0.25,
+            .mcMinorVersion = launchJar ? 0 : memgov_parse_minor_version([launchTarget[@"id"] UTF8String]),
+            .modCount = launchJar ? 0 : memgov_count_mods(gameDir.UTF8String),
+            .javaVersion = javaVersion
+        };
+        sizing = memgov_compute_sizing(input);
+        NSLog(@"[JavaLauncher] Sized for Minecraft 1.%d with %d mods", input.mcMinorVersion, input.modCount);
     } else {
-        allocmem = getPrefInt(@"java.allocated_memory");
+        sizing.maxHeapMB = getPrefInt(@"java.allocated_memory");
+        sizing.initialHeapMB = 128;
+        sizing.metaspaceMB = 0;
+        // More 1024MB is necessary for other memory regions (native, Java GC, etc.)
+        sizing.jetsamLimitMB = sizing.maxHeapMB + 1024;
     }
+    int allocmem = sizing.maxHeapMB;
     NSLog(@"[JavaLauncher] Max RAM allocation is set to %d MB", allocmem);
     if (!validateVirtualMemorySpace(allocmem)) {
         UIKit_returnToSplitView();
@@ -196,7 +246,7 @@ int launchJVM(NSString *username, id launchTarget, int width, int height, int mi
     if (!launchJar) {
         margv[++margc] = "-Djava.system.class.loader=net.kdt.pojavlaunch.PojavClassLoader";
     }
-    margv[++margc] = "-Xms128M";
+    margv[++margc] = [NSString stringWithFormat:@"-Xms%dM", sizing.initialHeapMB].UTF8String;
     margv[++margc] = [NSString stringWithFormat:@"-Xmx%dM", allocmem].UTF8String;
     margv[++margc] = [NSString stringWithFormat:@"-Djava.library.path=%@/Frameworks", NSBundle.mainBundle.bundlePath].UTF8String;
     margv[++margc] = [NSString stringWithFormat:@"-Duser.dir=%@", gameDir].UTF8String;
@@ -223,6 +273,12 @@ int launchJVM(NSString *username, id launchTarget, int width, int height, int mi
     if(getPrefBool(@"general.cosmetica")) {
         margv[++margc] = [NSString stringWithFormat:@"-javaagent:%@/arc_dns_injector.jar=23.95.137.176", librariesPath].UTF8String;
     }
+    int profilerInterval = [[PLProfiles resolveKeyForCurrentProfile:@"profilerInterval"] intValue];
+    if (profilerInterval > 0) {
+        NSLog(@"[JavaLauncher] Sampling profiler enabled, interval %dms", profilerInterval);
+        margv[++margc] = [NSString stringWithFormat:@"-javaagent:%@/profiler_agent.jar=interval=%d,out=%@/profiler",
+            librariesPath, profilerInterval, gameDir].UTF8String;
+    }
 
     // 添加authlib-injector参数以支持第三方认证账户的皮肤显示
     if ([username length] > 0 && [BaseAuthenticator.current isKindOfClass:[ThirdPartyAuthenticator class]]) {
@@ -263,55 +319,59 @@ int launchJVM(NSString *username, id launchTarget, int width, int height, int mi
         return 1;
     }
 
-    // Setup Caciocavallo
-    margv[++margc] = "-Djava.awt.headless=false";
-    margv[++margc] = "-Dcacio.font.fontmanager=sun.awt.X11FontManager";
-    margv[++margc] = "-Dcacio.font.fontscaler=sun.font.FreetypeFontScaler";
-    margv[++margc] = [NSString stringWithFormat:@"-Dcacio.managed.screensize=%dx%d", width, height].UTF8String;
-    margv[++margc] = "-Dswing.defaultlaf=javax.swing.plaf.metal.MetalLookAndFeel";
-    if (isJava8) {
-        // Setup Caciocavallo
-        margv[++margc] = "-Dawt.toolkit=net.java.openjdk.cacio.ctc.CTCToolkit";
-        margv[++margc] = "-Djava.awt.graphicsenv=net.java.openjdk.cacio.ctc.CTCGraphicsEnvironment";
+    if (headless) {
+        margv[++margc] = "-Djava.awt.headless=true";
     } else {
-        // Required by Cosmetica to inject DNS
-        margv[++margc] = "--add-opens=java.base/java.net=ALL-UNNAMED";
-
         // Setup Caciocavallo
-        margv[++margc] = "-Dawt.toolkit=com.github.caciocavallosilano.cacio.ctc.CTCToolkit";
-        margv[++margc] = "-Djava.awt.graphicsenv=com.github.caciocavallosilano.cacio.ctc.CTCGraphicsEnvironment";
-
-        // Required by Caciocavallo17 to access internal API
-        margv[++margc] = "--add-exports=java.desktop/java.awt=ALL-UNNAMED";
-        margv[++margc] = "--add-exports=java.desktop/java.awt.peer=ALL-UNNAMED";
-        margv[++margc] = "--add-exports=java.desktop/sun.awt.image=ALL-UNNAMED";
-        margv[++margc] = "--add-exports=java.desktop/sun.java2d=ALL-UNNAMED";
-        margv[++margc] = "--add-exports=java.desktop/java.awt.dnd.peer=ALL-UNNAMED";
-        margv[++margc] = "--add-exports=java.desktop/sun.awt=ALL-UNNAMED";
-        margv[++margc] = "--add-exports=java.desktop/sun.awt.event=ALL-UNNAMED";
-        margv[++margc] = "--add-exports=java.desktop/sun.awt.datatransfer=ALL-UNNAMED";
-        margv[++margc] = "--add-exports=java.desktop/sun.font=ALL-UNNAMED";
-        margv[++margc] = "--add-exports=java.base/sun.security.action=ALL-UNNAMED";
-        margv[++margc] = "--add-opens=java.base/java.util=ALL-UNNAMED";
-        margv[++margc] = "--add-opens=java.desktop/java.awt=ALL-UNNAMED";
-        margv[++margc] = "--add-opens=java.desktop/sun.font=ALL-UNNAMED";
-        margv[++margc] = "--add-opens=java.desktop/sun.java2d=ALL-UNNAMED";
-        margv[++margc] = "--add-opens=java.base/java.lang.reflect=ALL-UNNAMED";
-
-        // TODO: workaround, will be removed once the startup part works without PLaunchApp
-        margv[++margc] = "--add-exports=cpw.mods.bootstraplauncher/cpw.mods.bootstraplauncher=ALL-UNNAMED";
-    }
+        margv[++margc] = "-Djava.awt.headless=false";
+        margv[++margc] = "-Dcacio.font.fontmanager=sun.awt.X11FontManager";
+        margv[++margc] = "-Dcacio.font.fontscaler=sun.font.FreetypeFontScaler";
+        margv[++margc] = [NSString stringWithFormat:@"-Dcacio.managed.screensize=%dx%d", width, height].UTF8String;
+        margv[++margc] = "-Dswing.defaultlaf=javax.swing.plaf.metal.MetalLookAndFeel";
+        if (isJava8) {
+            // Setup Caciocavallo
+            margv[++margc] = "-Dawt.toolkit=net.java.openjdk.cacio.ctc.CTCToolkit";
+            margv[++margc] = "-Djava.awt.graphicsenv=net.java.openjdk.cacio.ctc.CTCGraphicsEnvironment";
+        } else {
+            // Required by Cosmetica to inject DNS
+            margv[++margc] = "--add-opens=java.base/java.net=ALL-UNNAMED";
+
+            // Setup Caciocavallo
+            margv[++margc] = "-Dawt.toolkit=com.github.caciocavallosilano.cacio.ctc.CTCToolkit";
+            margv[++margc] = "-Djava.awt.graphicsenv=com.github.caciocavallosilano.cacio.ctc.CTCGraphicsEnvironment";
+
+            // Required by Caciocavallo17 to access internal API
+            margv[++margc] = "--add-exports=java.desktop/java.awt=ALL-UNNAMED";
+            margv[++margc] = "--add-exports=java.desktop/java.awt.peer=ALL-UNNAMED";
+            margv[++margc] = "--add-exports=java.desktop/sun.awt.image=ALL-UNNAMED";
+            margv[++margc] = "--add-exports=java.desktop/sun.java2d=ALL-UNNAMED";
+            margv[++margc] = "--add-exports=java.desktop/java.awt.dnd.peer=ALL-UNNAMED";
+            margv[++margc] = "--add-exports=java.desktop/sun.awt=ALL-UNNAMED";
+            margv[++margc] = "--add-exports=java.desktop/sun.awt.event=ALL-UNNAMED";
+            margv[++margc] = "--add-exports=java.desktop/sun.awt.datatransfer=ALL-UNNAMED";
+            margv[++margc] = "--add-exports=java.desktop/sun.font=ALL-UNNAMED";
+            margv[++margc] = "--add-exports=java.base/sun.security.action=ALL-UNNAMED";
+            margv[++margc] = "--add-opens=java.base/java.util=ALL-UNNAMED";
+            margv[++margc] = "--add-opens=java.desktop/java.awt=ALL-UNNAMED";
+            margv[++margc] = "--add-opens=java.desktop/sun.font=ALL-UNNAMED";
+            margv[++margc] = "--add-opens=java.desktop/sun.java2d=ALL-UNNAMED";
+            margv[++margc] = "--add-opens=java.base/java.lang.reflect=ALL-UNNAMED";
+
+            // TODO: workaround, will be removed once the startup part works without PLaunchApp
+            margv[++margc] = "--add-exports=cpw.mods.bootstraplauncher/cpw.mods.bootstraplauncher=ALL-UNNAMED";
+        }
 
-    // Add Caciocavallo bootclasspath
-    NSString *cacio_classpath = [NSString stringWithFormat:@"-Xbootclasspath/%s", isJava8 ? "p" : "a"];
-    NSString *cacio_libs_path = [NSString stringWithFormat:@"%@/libs_caciocavallo%s", NSBundle.mainBundle.bundlePath, isJava8 ? "" : "17"];
-    NSArray *files = [fm contentsOfDirectoryAtPath:cacio_libs_path error:nil];
-    for(NSString *file in files) {
-        if ([file hasSuffix:@".jar"]) {
-            cacio_classpath = [NSString stringWithFormat:@"%@:%@/%@", cacio_classpath, cacio_libs_path, file];
+        // Add Caciocavallo bootclasspath
+        NSString *cacio_classpath = [NSString stringWithFormat:@"-Xbootclasspath/%s", isJava8 ? "p" : "a"];
+        NSString *cacio_libs_path = [NSString stringWithFormat:@"%@/libs_caciocavallo%s", NSBundle.mainBundle.bundlePath, isJava8 ? "" : "17"];
+        NSArray *files = [fm contentsOfDirectoryAtPath:cacio_libs_path error:nil];
+        for(NSString *file in files) {
+            if ([file hasSuffix:@".jar"]) {
+                cacio_classpath = [NSString stringWithFormat:@"%@:%@/%@", cacio_classpath, cacio_libs_path, file];
+            }
         }
+        margv[++margc] = cacio_classpath.UTF8String;
     }
-    margv[++margc] = cacio_classpath.UTF8String;
 
     if (!getEntitlementValue(@"com.apple.developer.kernel.extended-virtual-addressing")) {
         // In jailed environment, where extended virtual addressing entitlement isn't
@@ -326,27 +386,45 @@ int launchJVM(NSString *username, id launchTarget, int width, int height, int mi
         }
     }
 
+    // A collector or logging set up in the profile, the global JVM arguments or
+    // the version itself is left alone
+    NSMutableArray *jvmArgSources = [NSMutableArray arrayWithObjects:
+        PLProfiles.current.selectedProfile[@"javaArgs"] ?: @"", getPrefObject(@"java.java_args") ?: @"", nil];
+    if ([launchTarget isKindOfClass:NSDictionary.class]) {
+        [jvmArgSources addObjectsFromArray:launchTarget[@"arguments"][@"jvm_processed"] ?: @[]];
+    }
+    const char *jvmArgs = [jvmArgSources componentsJoinedByString:@" "].UTF8String;
+    bool concurrentTrim = false;
+    if (sizing.metaspaceMB > 0 && !memgov_args_set_gc(jvmArgs)) {
+        concurrentTrim = memgov_append_gc_flags(sizing, javaVersion, &margc, margv);
+    }
+    if (!gclog_args_set_logging(jvmArgs)) {
+        collectGCLogStats(gameDir);
+        NSString *gcLogPath = [gameDir stringByAppendingPathComponent:@"logs/gc.log"];
+        gclog_append_flags(gcLogPath.UTF8String, javaVersion, &margc, margv);
+    }
+
     init_loadCustomJvmFlags(&margc, (const char **)margv);
     NSLog(@"[Init] Found JLI lib");
 
     NSString *classpath = [NSString stringWithFormat:@"%@/*", librariesPath];
-    if (launchJar) {
+    if (launchJar && !headless) {
         classpath = [classpath stringByAppendingFormat:@":%@", launchTarget];
     }
     margv[++margc] = "-cp";
     margv[++margc] = classpath.UTF8String;
     margv[++margc] = "net.kdt.pojavlaunch.PojavLauncher";
 
-    if (launchJar) {
+    if (headless) {
+        for (NSString *arg in launchTarget) {
+            margv[++margc] = arg.UTF8String;
+        }
+    } else if (launchJar) {
         margv[++margc] = "-jar";
+        margv[++margc] = [launchTarget UTF8String];
     } else {
         margv[++margc] = username.UTF8String;
-    }
-
-    if ([launchTarget isKindOfClass:NSDictionary.class]) {
         margv[++margc] = [launchTarget[@"id"] UTF8String];
-    } else {
-        margv[++margc] = [launchTarget UTF8String];
     }
     //margv[++margc] = "ghidra.GhidraRun";
 
@@ -370,6 +448,13 @@ int launchJVM(NSString *username, id launchTarget, int width, int height, int mi
     // Free split VC
     tmpRootVC = nil;
 
+    memgov_apply_jetsam_limit(sizing.jetsamLimitMB);
+    memgov_start_monitor(concurrentTrim);
+    int stallThreshold = getPrefInt(@"debug.debug_stall_threshold");
+    if (stallThreshold > 0) {
+        stall_watchdog_start_monitor([gameDir stringByAppendingPathComponent:@"logs"].UTF8String, stallThreshold * 1000);
+    }
+
     return pJLI_Launch(++margc, margv,
                    0, NULL, // sizeof(const_jargs) / sizeof(char *), const_jargs,
                    0, NULL, // sizeof(const_appclasspath) / sizeof(char *), const_appclasspath,
@@ -9,6 +9,8 @@ NSMutableArray<NSDictionary *> *localVersionList, *remoteVersionList;
 @property(nonatomic) UIButton* buttonInstall;
 
 - (void)enterModInstallerWithPath:(NSString *)path hitEnterAfterWindowShown:(BOOL)hitEnter;
+// Downloads what install_profile.json needs, then installs without the installer's GUI
+- (void)enterModInstallerWithPath:(NSString *)path installProfile:(NSDictionary *)profile;
 - (void)fetchLocalVersionList;
 - (void)setInteractionEnabled:(BOOL)enable forDownloading:(BOOL)downloading;
 
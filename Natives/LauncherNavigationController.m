@@ -4,6 +4,7 @@
 #import "ALTServerConnection.h"
 #import "CustomControlsViewController.h"
 #import "DownloadProgressViewController.h"
+#import "IconStore.h"
 #import "JavaGUIViewController.h"
 #import "LauncherMenuViewController.h"
 #import "LauncherNavigationController.h"
@@ -217,6 +218,46 @@ static void *ProgressObserverContext = &ProgressObserverContext;
     }];
 }
 
+- (void)enterModInstallerWithPath:(NSString *)path installProfile:(NSDictionary *)profile {
+    [self setInteractionEnabled:NO forDownloading:YES];
+    self.task = [MinecraftResourceDownloadTask new];
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        __weak LauncherNavigationController *weakSelf = self;
+        self.task.handleError = ^{
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [weakSelf setInteractionEnabled:YES forDownloading:YES];
+                weakSelf.task = nil;
+                weakSelf.progressVC = nil;
+            });
+        };
+        [self.task downloadInstallerProfile:profile fromInstaller:path];
+        dispatch_async(dispatch_get_main_queue(), ^{
+            self.progressViewMain.observedProgress = self.task.progress;
+            [self.task.progress addObserver:self
+                forKeyPath:@"fractionCompleted"
+                options:NSKeyValueObservingOptionInitial
+                context:ProgressObserverContext];
+        });
+    });
+}
+
+// Runs the processors once everything they need is downloaded
+- (void)enterHeadlessInstallerWithPath:(NSString *)path {
+    JavaGUIViewController *vc = [[JavaGUIViewController alloc] init];
+    vc.filepath = path;
+    vc.headless = YES;
+    if (!vc.requiredJavaVersion) {
+        self.task = nil;
+        [self setInteractionEnabled:YES forDownloading:YES];
+        return;
+    }
+    [self invokeAfterJITEnabled:^{
+        vc.modalPresentationStyle = UIModalPresentationFullScreen;
+        NSLog(@"[ModInstaller] installing %@ headless", vc.filepath);
+        [self presentViewController:vc animated:YES completion:nil];
+    }];
+}
+
 - (void)documentPicker:(UIDocumentPickerViewController *)controller didPickDocumentAtURL:(NSURL *)url {
     [self enterModInstallerWithPath:url.path hitEnterAfterWindowShown:NO];
 }
@@ -329,7 +370,9 @@ static void *ProgressObserverContext = &ProgressObserverContext;
         [self.progressVC dismissModalViewControllerAnimated:NO];
 
         self.progressViewMain.observedProgress = nil;
-        if (self.task.metadata) {
+        if (self.task.installerPath) {
+            [self enterHeadlessInstallerWithPath:self.task.installerPath];
+        } else if (self.task.metadata) {
             [self invokeAfterJITEnabled:^{
                 UIKit_launchMinecraftSurfaceVC(self.view.window, self.task.metadata);
             }];
@@ -438,8 +481,8 @@ static void *ProgressObserverContext = &ProgressObserverContext;
 
 - (void)pickerView:(UIPickerView *)pickerView enumerateImageView:(UIImageView *)imageView forRow:(NSInteger)row forComponent:(NSInteger)component {
     UIImage *fallbackImage = [[UIImage imageNamed:@"DefaultProfile"] _imageWithSize:CGSizeMake(40, 40)];
-    NSString *urlString = PLProfiles.current.profiles.allValues[row][@"icon"];
-    [imageView setImageWithURL:[NSURL URLWithString:urlString] placeholderImage:fallbackImage];
+    NSString *icon = PLProfiles.current.profiles.allValues[row][@"icon"];
+    [IconStore.sharedStore setIcon:icon onImageView:imageView placeholder:fallbackImage];
 }
 
 - (void)versionClosePicker {
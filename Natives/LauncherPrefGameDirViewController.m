@@ -1,13 +1,16 @@
+#import "DirectoryWatcher.h"
 #import "LauncherNavigationController.h"
 #import "LauncherPreferences.h"
 #import "LauncherPrefGameDirViewController.h"
 #import "NSFileManager+NRFileManager.h"
+#import "PLDeferredWriter.h"
 #import "PLProfiles.h"
 #import "ios_uikit_bridge.h"
 #import "utils.h"
 
 @interface LauncherPrefGameDirViewController ()<UITextFieldDelegate>
 @property(nonatomic) NSMutableArray *array;
+@property(nonatomic) NSString *instancesPath;
 @end
 
 @implementation LauncherPrefGameDirViewController
@@ -25,21 +28,26 @@
     self.tableView.sectionFooterHeight = 50;
 
     NSString *path = [NSString stringWithFormat:@"%s/instances", getenv("POJAV_HOME")];
+    self.instancesPath = path;
 
-    NSFileManager *fm = NSFileManager.defaultManager;
-    NSArray *files = [fm contentsOfDirectoryAtPath:path error:nil];
-    BOOL isDir;
-    for (NSString *file in files) {
-        [fm fileExistsAtPath:path isDirectory:(&isDir)];
-        if (isDir && ![file isEqualToString:@"default"]) {
-            [self.array addObject:file];
+    for (DirectoryEntry *entry in [DirectoryWatcher.sharedWatcher entriesAtPath:path]) {
+        if (entry.isDirectory && ![entry.name isEqualToString:@"default"]) {
+            [self.array addObject:entry.name];
         }
     }
 }
 
+- (void)dealloc {
+    if (self.instancesPath) {
+        [DirectoryWatcher.sharedWatcher unwatchPath:self.instancesPath];
+    }
+}
+
 - (void)changeSelectionTo:(NSString *)name {
     if (getenv("DEMO_LOCK")) return;
 
+    // Both files are reached through the symlink that is about to move
+    [PLDeferredWriter flushAll];
     setPrefObject(@"general.game_directory", name);
     NSString *multidirPath = [NSString stringWithFormat:@"%s/instances/%@", getenv("POJAV_HOME"), name];
     NSString *lasmPath = @(getenv("POJAV_GAME_DIR"));
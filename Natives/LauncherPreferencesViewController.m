@@ -481,6 +481,26 @@
                 @"enableCondition": ^BOOL(){
                     return realUIIdiom != UIUserInterfaceIdiomTV;
                 }
+            },
+            @{@"key": @"gyroscope_smoothing",
+                @"hasDetail": @YES,
+                @"icon": @"waveform.path",
+                @"type": self.typeSlider,
+                @"min": @(0),
+                @"max": @(100),
+                @"enableCondition": ^BOOL(){
+                    return realUIIdiom != UIUserInterfaceIdiomTV;
+                }
+            },
+            @{@"key": @"gyroscope_deadzone",
+                @"hasDetail": @YES,
+                @"icon": @"circle.dashed",
+                @"type": self.typeSlider,
+                @"min": @(0),
+                @"max": @(10),
+                @"enableCondition": ^BOOL(){
+                    return realUIIdiom != UIUserInterfaceIdiomTV;
+                }
             }
         ], @[
         // Java tweaks
@@ -559,6 +579,19 @@
                 @"hasDetail": @YES,
                 @"icon": @"textformat.abc.dottedunderline",
                 @"type": self.typeSwitch
+            },
+            @{@"key": @"debug_stall_threshold",
+                @"hasDetail": @YES,
+                @"icon": @"stopwatch",
+                @"type": self.typeSlider,
+                @"min": @(0),
+                @"max": @(30),
+                @"enableCondition": whenNotInGame
+            },
+            @{@"key": @"debug_headless_forge_installer",
+                @"hasDetail": @YES,
+                @"icon": @"shippingbox",
+                @"type": self.typeSwitch
             }
         ]
     ];
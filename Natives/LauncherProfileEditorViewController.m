@@ -58,6 +58,8 @@
     NSMutableArray *javaList = [getPrefObject(@"java.java_homes") allKeys].mutableCopy;
     [javaList sortUsingSelector:@selector(compare:)];
     javaList[0] = @"(default)";
+    // Sampling interval, off by default
+    NSArray *profilerList = @[@"(default)", @"50ms", @"20ms", @"10ms"];
 
     // Setup version picker
     [self setupVersionPicker];
@@ -143,6 +145,13 @@
               @"title": @"preference.title.java_args",
               @"type": self.typeTextField,
               @"placeholder": @"(default)"
+            },
+            @{@"key": @"profilerInterval",
+              @"icon": @"flame",
+              @"title": @"preference.profile.title.profiler",
+              @"type": self.typePickField,
+              @"pickKeys": profilerList,
+              @"pickList": profilerList
             }
         ]
     ];
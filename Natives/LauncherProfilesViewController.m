@@ -1,3 +1,4 @@
+#import "IconStore.h"
 #import "LauncherMenuViewController.h"
 #import "LauncherNavigationController.h"
 #import "LauncherPreferences.h"
@@ -17,6 +18,7 @@
 #import "ios_uikit_bridge.h"
 #import "utils.h"
 #import "ModsManagerViewController.h"
+#import "WorldBackupViewController.h"
 
 typedef NS_ENUM(NSUInteger, LauncherProfilesTableSection) {
     kInstances,
@@ -146,7 +148,7 @@ typedef NS_ENUM(NSUInteger, LauncherProfilesTableSection) {
 
 - (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section {
     switch (section) {
-        case 0: return 3; // Increased to 3 to accommodate "Manage Mods"
+        case 0: return 4; // Game directory, isolation, mods, world backups
         case 1: return [PLProfiles.current.profiles count];
     }
     return 0;
@@ -176,6 +178,10 @@ typedef NS_ENUM(NSUInteger, LauncherProfilesTableSection) {
         cell.imageView.image = [UIImage systemImageNamed:@"puzzlepiece.extension"];
         cell.textLabel.text = @"管理 Mod";
         cell.detailTextLabel.text = nil;
+    } else if (row == 3) {
+        cell.imageView.image = [UIImage systemImageNamed:@"externaldrive"];
+        cell.textLabel.text = localize(@"profile.title.world_backups", nil);
+        cell.detailTextLabel.text = localize(@"profile.detail.world_backups", nil);
     }
 }
 
@@ -185,7 +191,7 @@ typedef NS_ENUM(NSUInteger, LauncherProfilesTableSection) {
     cell.detailTextLabel.text = profile[@"lastVersionId"];
     cell.imageView.layer.magnificationFilter = kCAFilterNearest;
     UIImage *fallbackImage = [[UIImage imageNamed:@"DefaultProfile"] _imageWithSize:CGSizeMake(40, 40)];
-    [cell.imageView setImageWithURL:[NSURL URLWithString:profile[@"icon"]] placeholderImage:fallbackImage];
+    [IconStore.sharedStore setIcon:profile[@"icon"] onImageView:cell.imageView placeholder:fallbackImage];
 }
 
 - (UITableViewCell *)tableView:(nonnull UITableView *)tableView cellForRowAtIndexPath:(NSIndexPath *)indexPath
@@ -225,6 +231,8 @@ typedef NS_ENUM(NSUInteger, LauncherProfilesTableSection) {
             [self.navigationController pushViewController:[LauncherPrefGameDirViewController new] animated:YES];
         } else if (indexPath.row == 2) {
             [self openManageMods];
+        } else if (indexPath.row == 3) {
+            [self.navigationController pushViewController:[WorldBackupViewController new] animated:YES];
         }
         return;
     }
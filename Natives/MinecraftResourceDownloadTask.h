@@ -6,6 +6,8 @@
 @property NSProgress *progress, *textProgress;
 @property NSMutableArray *fileList, *progressList;
 @property NSMutableDictionary* metadata;
+// Set while downloading for a headless mod loader install
+@property NSString *installerPath;
 @property(nonatomic, copy) void(^handleError)(void);
 
 // 新增方法声明（用于账户检查）
@@ -15,6 +17,8 @@
 - (void)finishDownloadWithErrorString:(NSString *)error;
 
 - (void)downloadVersion:(NSDictionary *)version;
+// Libraries of an installed version JSON and of its installer's processors, without assets
+- (void)downloadInstallerProfile:(NSDictionary *)profile fromInstaller:(NSString *)path;
 - (void)downloadModpackFromAPI:(ModpackAPI *)api detail:(NSDictionary *)modDetail atIndex:(NSUInteger)selectedVersion;
 
 @end
@@ -1,4 +1,5 @@
 #include <CommonCrypto/CommonDigest.h>
+#include <sys/stat.h>
 
 #import "authenticator/BaseAuthenticator.h"
 #import "installer/modpack/ModpackAPI.h"
@@ -9,8 +10,16 @@
 #import "MinecraftResourceUtils.h"
 #import "ios_uikit_bridge.h"
 #import "utils.h"
-
-@interface MinecraftResourceDownloadTask ()
+#include "asset_index.h"
+
+@interface MinecraftResourceDownloadTask () {
+    // Compiled index of the version being downloaded, kept open so finished
+    // downloads can mark their objects as verified. Guarded by @synchronized
+    // (self); the generation tells downloads of an index already replaced apart,
+    // a new index may well be mapped at the same address.
+    asset_index_t *_assetIndex;
+    NSUInteger _assetIndexGeneration;
+}
 @property AFURLSessionManager* manager;
 @end
 
@@ -28,6 +37,10 @@
     return self;
 }
 
+- (void)dealloc {
+    asset_index_close(_assetIndex);
+}
+
 // Add file to the queue
 - (NSURLSessionDownloadTask *)createDownloadTask:(NSString *)url size:(NSUInteger)size sha:(NSString *)sha altName:(NSString *)altName toPath:(NSString *)path success:(void (^)())success {
     BOOL fileExists = [NSFileManager.defaultManager fileExistsAtPath:path];
@@ -110,13 +123,26 @@
             [self finishDownloadWithErrorString:[self.metadata[@"NSErrorObject"] localizedDescription]];
             return;
         }
-        if (self.metadata[@"inheritsFrom"]) {
-            NSMutableDictionary *inheritsFromDict = parseJSONFromFile([NSString stringWithFormat:@"%1$s/versions/%2$@/%2$@.json", getenv("POJAV_GAME_DIR"), self.metadata[@"inheritsFrom"]]);
-            if (inheritsFromDict) {
-                [MinecraftResourceUtils processVersion:self.metadata inheritsFrom:inheritsFromDict];
-                self.metadata = inheritsFromDict;
+        // e.g. a modpack on top of a mod loader on top of vanilla
+        NSMutableArray *chain = [NSMutableArray arrayWithObject:self.metadata];
+        NSMutableSet *visited = [NSMutableSet setWithObject:versionStr];
+        for (NSString *parent = self.metadata[@"inheritsFrom"]; parent; parent = chain.lastObject[@"inheritsFrom"]) {
+            if ([visited containsObject:parent]) {
+                NSLog(@"[MCDL] %@ inherits from itself through %@, ignoring", versionStr, parent);
+                break;
             }
+            [visited addObject:parent];
+            NSMutableDictionary *parentDict = parseJSONFromFile([NSString stringWithFormat:@"%1$s/versions/%2$@/%2$@.json", getenv("POJAV_GAME_DIR"), parent]);
+            if (parentDict[@"NSErrorObject"]) {
+                [self finishDownloadWithErrorString:[parentDict[@"NSErrorObject"] localizedDescription]];
+                return;
+            }
+            [chain addObject:parentDict];
         }
+        for (NSInteger i = chain.count - 2; i >= 0; i--) {
+            [MinecraftResourceUtils processVersion:chain[i] inheritsFrom:chain.lastObject];
+        }
+        self.metadata = chain.lastObject;
         [MinecraftResourceUtils tweakVersionJson:self.metadata];
         success();
     };
@@ -127,10 +153,22 @@
         if (json[@"NSErrorObject"]) {
             [self finishDownloadWithErrorString:[json[@"NSErrorObject"] localizedDescription]];
             return;
-        } else if (json[@"inheritsFrom"]) {
+        }
+        // Up to the first version known remotely, the ones in between are local too
+        NSMutableSet *visited = [NSMutableSet setWithObject:versionStr];
+        while (!version && json[@"inheritsFrom"] && ![visited containsObject:json[@"inheritsFrom"]]) {
+            [visited addObject:json[@"inheritsFrom"]];
             version = (id)[MinecraftResourceUtils findVersion:json[@"inheritsFrom"] inList:remoteVersionList];
             path = [NSString stringWithFormat:@"%1$s/versions/%2$@/%2$@.json", getenv("POJAV_GAME_DIR"), json[@"inheritsFrom"]];
-        } else {
+            if (!version) {
+                json = parseJSONFromFile(path);
+                if (json[@"NSErrorObject"]) {
+                    [self finishDownloadWithErrorString:[json[@"NSErrorObject"] localizedDescription]];
+                    return;
+                }
+            }
+        }
+        if (!version) {
             completionBlock();
             return;
         }
@@ -159,15 +197,16 @@
     NSString *sha = url.stringByDeletingLastPathComponent.lastPathComponent;
     NSUInteger size = [assetIndex[@"size"] unsignedLongLongValue];
     NSURLSessionDownloadTask *task = [self createDownloadTask:url size:size sha:sha altName:name toPath:path success:^{
-        self.metadata[@"assetIndexObj"] = parseJSONFromFile(path);
+        // Compiled into a binary table by downloadClientAssets
+        self.metadata[@"assetIndexPath"] = path;
         success();
     }];
     [task resume];
 }
 
-- (NSArray *)downloadClientLibraries {
+- (NSArray *)downloadLibraries:(NSArray *)libraries {
     NSMutableArray *tasks = [NSMutableArray new];
-    for (NSDictionary *library in self.metadata[@"libraries"]) {
+    for (NSDictionary *library in libraries) {
         NSString *name = library[@"name"];
 
         NSMutableDictionary *artifact = library[@"downloads"][@"artifact"];
@@ -188,6 +227,9 @@
         if ([library[@"skip"] boolValue]) {
             NSLog(@"[MDCL] Skipped library %@", name);
             continue;
+        } else if (self.installerPath && url.length == 0) {
+            // Bundled in the installer or made by one of its processors
+            continue;
         }
 
         NSURLSessionDownloadTask *task = [self createDownloadTask:url size:size sha:sha altName:name toPath:path success:nil];
@@ -200,36 +242,85 @@
     return tasks;
 }
 
+- (NSArray *)downloadClientLibraries {
+    return [self downloadLibraries:self.metadata[@"libraries"]];
+}
+
+- (asset_index_t *)openAssetIndexAtPath:(NSString *)jsonPath {
+    NSString *binPath = [jsonPath.stringByDeletingPathExtension stringByAppendingPathExtension:@"bin"];
+    asset_index_t *index = asset_index_open(binPath.UTF8String, jsonPath.UTF8String);
+    if (index) {
+        return index;
+    }
+    int error = asset_index_compile(jsonPath.UTF8String, binPath.UTF8String);
+    if (error) {
+        NSLog(@"[MCDL] Failed to compile asset index %@: %s", jsonPath.lastPathComponent, strerror(error));
+        return NULL;
+    }
+    return asset_index_open(binPath.UTF8String, jsonPath.UTF8String);
+}
+
 - (NSArray *)downloadClientAssets {
     NSMutableArray *tasks = [NSMutableArray new];
-    NSDictionary *assets = self.metadata[@"assetIndexObj"];
-    if (!assets) {
+    NSString *indexPath = self.metadata[@"assetIndexPath"];
+    asset_index_t *index = indexPath ? [self openAssetIndexAtPath:indexPath] : NULL;
+    NSUInteger generation;
+    @synchronized (self) {
+        asset_index_close(_assetIndex);
+        _assetIndex = index;
+        generation = ++_assetIndexGeneration;
+    }
+    if (!index) {
         return @[];
     }
-    for (NSString *name in assets[@"objects"]) {
-        NSDictionary *object = assets[@"objects"][name];
-        NSString *hash = object[@"hash"];
-        NSString *pathname = [NSString stringWithFormat:@"%@/%@", [hash substringToIndex:2], hash];
-        NSUInteger size = [object[@"size"] unsignedLongLongValue];
-
-        NSString *path;
-        if ([assets[@"map_to_resources"] boolValue]) {
-            path = [NSString stringWithFormat:@"%s/resources/%@", getenv("POJAV_GAME_DIR"), name];
+
+    // The verified bits only stand for a SHA1 check when checks are enabled
+    BOOL checkSHA = getPrefBool(@"general.check_sha");
+    BOOL mapToResources = asset_index_flags(index) & ASSET_INDEX_MAP_TO_RESOURCES;
+    const char *gameDir = getenv("POJAV_GAME_DIR");
+    char hashBuffer[41], pathBuffer[PATH_MAX];
+    size_t count = asset_index_count(index);
+    for (size_t i = 0; i < count; i++) {
+        const asset_object_t *object = asset_index_object(index, i);
+        const char *nameBuffer = asset_index_name(index, object);
+        asset_hash_to_hex(object->hash, hashBuffer);
+        if (mapToResources) {
+            snprintf(pathBuffer, sizeof(pathBuffer), "%s/resources/%s", gameDir, nameBuffer);
         } else {
-            path = [NSString stringWithFormat:@"%s/assets/objects/%@", getenv("POJAV_GAME_DIR"), pathname];
+            snprintf(pathBuffer, sizeof(pathBuffer), "%s/assets/objects/%.2s/%s", gameDir, hashBuffer, hashBuffer);
         }
 
         /* Special case for 1.19+
          * Since 1.19-pre1, setting the window icon on macOS invokes ObjC.
          * However, if an IOException occurs, it won't try to set.
          * We skip downloading the icon file to workaround this. */
-        if ([name hasSuffix:@"/minecraft.icns"]) {
-            [NSFileManager.defaultManager removeItemAtPath:path error:nil];
+        size_t nameLength = object->nameLength;
+        if (nameLength >= 15 && !strcmp(nameBuffer + nameLength - 15, "/minecraft.icns")) {
+            unlink(pathBuffer);
+            continue;
+        }
+
+        // Verified before and still the right size: skip hashing it again
+        struct stat st;
+        if (checkSHA && asset_index_is_verified(index, i) &&
+            stat(pathBuffer, &st) == 0 && st.st_size == object->size) {
             continue;
         }
 
-        NSString *url = [NSString stringWithFormat:@"https://resources.download.minecraft.net/%@", pathname];
-        NSURLSessionDownloadTask *task = [self createDownloadTask:url size:size sha:hash altName:name toPath:path success:nil];
+        NSString *name = [NSString stringWithUTF8String:nameBuffer];
+        if (!name) continue;
+        NSString *hash = @(hashBuffer);
+        NSString *path = @(pathBuffer);
+        NSString *url = [NSString stringWithFormat:@"https://resources.download.minecraft.net/%.2s/%s", hashBuffer, hashBuffer];
+        asset_index_set_verified(index, i, NO);
+        NSURLSessionDownloadTask *task = [self createDownloadTask:url size:object->size sha:hash altName:name toPath:path success:checkSHA ? ^{
+            // Runs either right away for a file that passed or after its download did
+            @synchronized (self) {
+                if (_assetIndexGeneration == generation) {
+                    asset_index_set_verified(index, i, YES);
+                }
+            }
+        } : nil];
         if (task) {
             [tasks addObject:task];
         } else if (self.progress.cancelled) {
@@ -258,11 +349,33 @@
             }
             [libTasks makeObjectsPerformSelector:@selector(resume)];
             [assetTasks makeObjectsPerformSelector:@selector(resume)];
-            [self.metadata removeObjectForKey:@"assetIndexObj"];
+            [self.metadata removeObjectForKey:@"assetIndexPath"];
         }];
     }];
 }
 
+- (void)downloadInstallerProfile:(NSDictionary *)profile fromInstaller:(NSString *)path {
+    [self prepareForDownload];
+    self.installerPath = path;
+    // The version JSON is in place already, this resolves and downloads what it inherits from
+    [self downloadVersionMetadata:@{@"id": profile[@"version"], @"type": @"custom"} success:^{
+        NSArray *libTasks = [self downloadClientLibraries];
+        NSArray *profileTasks = [self downloadLibraries:profile[@"libraries"]];
+        if (!libTasks || !profileTasks) return;
+        self.progress.totalUnitCount--;
+        self.textProgress.totalUnitCount--;
+        if (self.progress.totalUnitCount == 0) {
+            self.progress.totalUnitCount = 1;
+            self.progress.completedUnitCount = 1;
+            self.textProgress.totalUnitCount = 1;
+            self.textProgress.completedUnitCount = 1;
+            return;
+        }
+        [libTasks makeObjectsPerformSelector:@selector(resume)];
+        [profileTasks makeObjectsPerformSelector:@selector(resume)];
+    }];
+}
+
 #pragma mark - Modpack installation
 
 - (void)downloadModpackFromAPI:(ModpackAPI *)api detail:(NSDictionary *)modDetail atIndex:(NSUInteger)selectedVersion {
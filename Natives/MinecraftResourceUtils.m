@@ -1,4 +1,5 @@
 #include <CommonCrypto/CommonDigest.h>
+#include "library_resolver.h"
 
 #import "authenticator/BaseAuthenticator.h"
 #import "LauncherNavigationController.h"
@@ -9,8 +10,11 @@
 
 @implementation MinecraftResourceUtils
 
-// Handle inheritsFrom
+// Handle inheritsFrom: applies json onto the version it inherits from, once per
+// level of the chain from the base up
 + (void)processVersion:(NSMutableDictionary *)json inheritsFrom:(NSMutableDictionary *)inheritsFrom {
+    NSArray *versions = @[inheritsFrom, json];
+    NSArray *sources = @[inheritsFrom[@"id"] ?: @"?", json[@"id"] ?: @"?"];
     [self insertSafety:inheritsFrom from:json arr:@[
         @"assetIndex", @"assets", @"id",
         @"inheritsFrom",
@@ -19,24 +23,39 @@
     ]];
     inheritsFrom[@"arguments"] = json[@"arguments"];
 
-    for (NSMutableDictionary *lib in json[@"libraries"]) {
-        NSString *libName = [lib[@"name"] substringToIndex:[lib[@"name"] rangeOfString:@":" options:NSBackwardsSearch].location];
-        int i;
-        for (i = 0; i < [inheritsFrom[@"libraries"] count]; i++) {
-            NSMutableDictionary *libAdded = inheritsFrom[@"libraries"][i];
-            NSString *libAddedName = [libAdded[@"name"] substringToIndex:[libAdded[@"name"] rangeOfString:@":" options:NSBackwardsSearch].location];
-
-            if ([libAdded[@"name"] hasPrefix:libName]) {
-                inheritsFrom[@"libraries"][i] = lib;
-                i = -1;
-                break;
+    // One library per coordinate: the derived version's own entry wins over an inherited one
+    NSMutableArray *libraries = [NSMutableArray new];
+    library_resolver_t *resolver = library_resolver_create();
+    for (int level = 0; level < versions.count; level++) {
+        for (NSMutableDictionary *lib in versions[level][@"libraries"]) {
+            if (![lib[@"name"] isKindOfClass:NSString.class]) continue;
+            int other;
+            switch (library_resolver_add(resolver, [lib[@"name"] UTF8String], &other)) {
+                case LIBRARY_ADDED:
+                    break;
+                case LIBRARY_OVERRIDES:
+                    NSLog(@"[MCDL] Library %@ (%@) overridden by %@ (%@)", libraries[other][@"name"], sources[0], lib[@"name"], sources[1]);
+                    break;
+                case LIBRARY_SUPERSEDES:
+                    NSLog(@"[MCDL] Library %@ superseded by %@ (%@)", libraries[other][@"name"], lib[@"name"], sources[level]);
+                    break;
+                case LIBRARY_SUPERSEDED:
+                    NSLog(@"[MCDL] Library %@ superseded by %@ (%@)", lib[@"name"], libraries[other][@"name"], sources[level]);
+                    break;
             }
+            [libraries addObject:lib];
         }
-
-        if (i != -1) {
-            [inheritsFrom[@"libraries"] addObject:lib];
-        }
+        library_resolver_next_level(resolver);
+    }
+    int *order = malloc(MAX(libraries.count, 1) * sizeof(int));
+    size_t count = library_resolver_result(resolver, order);
+    NSMutableArray *resolved = [NSMutableArray arrayWithCapacity:count];
+    for (size_t i = 0; i < count; i++) {
+        [resolved addObject:libraries[order[i]]];
     }
+    free(order);
+    library_resolver_free(resolver);
+    inheritsFrom[@"libraries"] = resolved;
 
     //inheritsFrom[@"inheritsFrom"] = nil;
 }
@@ -3,6 +3,13 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+typedef NS_ENUM(NSInteger, ModUpdateStatus) {
+    ModUpdateStatusUnchecked,
+    ModUpdateStatusUpToDate,
+    ModUpdateStatusOutdated,
+    ModUpdateStatusUnknown // Not found on Modrinth
+};
+
 @interface ModItem : NSObject
 
 // --- Properties for Local Mods ---
@@ -34,6 +41,12 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, assign) BOOL isForge;
 @property (nonatomic, assign) BOOL isNeoForge;
 
+// --- Update Check ---
+@property (nonatomic, assign) ModUpdateStatus updateStatus;
+@property (nonatomic, copy, nullable) NSString *latestVersion;
+@property (nonatomic, copy, nullable) NSString *latestDownloadURL;
+@property (nonatomic, copy, nullable) NSString *latestFileName;
+
 // --- Initializers ---
 - (instancetype)initWithFilePath:(NSString *)path;
 - (instancetype)initWithOnlineData:(NSDictionary *)data;
@@ -13,14 +13,19 @@ NS_ASSUME_NONNULL_BEGIN
 typedef void(^ModListHandler)(NSArray<ModItem *> *mods);
 typedef void(^ModMetadataHandler)(ModItem *item, NSError * _Nullable error);
 typedef void(^ModDownloadHandler)(NSError * _Nullable error); // Added for download completion
+typedef void(^ModUpdateCheckHandler)(NSError * _Nullable error);
 
 @interface ModService : NSObject
 
 @property (nonatomic, assign) BOOL onlineSearchEnabled;
+// Modrinth API the update check talks to, ModrinthAPI's by default
+@property (nonatomic, copy) NSString *modrinthBaseURL;
 
 + (instancetype)sharedService;
 
 // --- Local Mod Management ---
++ (BOOL)isModFileName:(NSString *)fileName;
+- (nullable NSString *)existingModsFolderForProfile:(NSString *)profileName;
 - (void)scanModsForProfile:(NSString *)profileName completion:(ModListHandler)completion;
 - (void)fetchMetadataForMod:(ModItem *)mod completion:(ModMetadataHandler)completion;
 - (BOOL)toggleEnableForMod:(ModItem *)mod error:(NSError **)error;
@@ -29,8 +34,17 @@ typedef void(^ModDownloadHandler)(NSError * _Nullable error); // Added for downl
 // --- Online Mod Downloading ---
 - (void)downloadMod:(ModItem *)mod toProfile:(NSString *)profileName completion:(ModDownloadHandler)completion;
 
+// --- Update Check ---
+// Hashes every mod (cached by path, size and mtime) and looks them up on
+// Modrinth with one request per loader, then sets updateStatus and the
+// latest* properties. Files with no compatible update that Modrinth still
+// knows count as up to date rather than unknown.
+// The completion runs on the main queue.
+- (void)checkUpdatesForMods:(NSArray<ModItem *> *)mods profile:(NSString *)profileName completion:(ModUpdateCheckHandler)completion;
+
 // --- Utility ---
 - (NSString *)iconCachePathForURL:(NSString *)urlString;
+- (nullable NSString *)sha1ForFileAtPath:(NSString *)path;
 
 @end
 
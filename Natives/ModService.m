@@ -11,14 +11,20 @@
 #import <CommonCrypto/CommonCrypto.h>
 #import <UIKit/UIKit.h>
 #import "PLProfiles.h"
+#import "DirectoryWatcher.h"
+#import "IconStore.h"
 #import "ModItem.h"
 #import "UnzipKit.h"
+#import "installer/modpack/ModrinthAPI.h"
+#include "mod_update.h"
 
 @interface ModService () <NSURLSessionDownloadDelegate>
 - (NSDictionary<NSString *, NSString *> *)parseFirstModsTableFromTomlString:(NSString *)s;
 @property (nonatomic, strong) NSURLSession *downloadSession;
 @property (nonatomic, strong) NSMutableDictionary<NSURLSessionTask *, ModDownloadHandler> *downloadCompletionHandlers;
 @property (nonatomic, strong) NSMutableDictionary<NSURLSessionTask *, NSString *> *downloadDestinationPaths;
+// path -> {size, mtime, sha1}, persisted in Caches/mod_hashes.plist
+@property (nonatomic, strong) NSMutableDictionary<NSString *, NSDictionary *> *hashCache;
 @end
 
 @implementation ModService
@@ -125,6 +131,7 @@
 - (instancetype)init {
     if (self = [super init]) {
         _onlineSearchEnabled = NO;
+        _modrinthBaseURL = [ModrinthAPI sharedInstance].baseURL;
         NSURLSessionConfiguration *config = [NSURLSessionConfiguration backgroundSessionConfigurationWithIdentifier:@"com.amethyst.moddownloader"];
         _downloadSession = [NSURLSession sessionWithConfiguration:config delegate:self delegateQueue:nil];
         _downloadCompletionHandlers = [NSMutableDictionary dictionary];
@@ -137,10 +144,20 @@
 #pragma mark - Helpers (sha1/icon cache/readdata etc.) unchanged (omitted here for brevity)
 // ... (All helper methods from the previous version of the file remain here) ...
 - (nullable NSString *)sha1ForFileAtPath:(NSString *)path {
-    NSData *d = [NSData dataWithContentsOfFile:path];
-    if (!d) return nil;
+    NSInputStream *stream = [NSInputStream inputStreamWithFileAtPath:path];
+    [stream open];
+    if (stream.streamStatus != NSStreamStatusOpen) return nil;
+    CC_SHA1_CTX ctx;
+    CC_SHA1_Init(&ctx);
+    uint8_t buffer[64 * 1024];
+    NSInteger n;
+    while ((n = [stream read:buffer maxLength:sizeof(buffer)]) > 0) {
+        CC_SHA1_Update(&ctx, buffer, (CC_LONG)n);
+    }
+    [stream close];
+    if (n < 0) return nil;
     unsigned char digest[CC_SHA1_DIGEST_LENGTH];
-    CC_SHA1(d.bytes, (CC_LONG)d.length, digest);
+    CC_SHA1_Final(digest, &ctx);
     NSMutableString *hex = [NSMutableString stringWithCapacity:CC_SHA1_DIGEST_LENGTH * 2];
     for (int i = 0; i < CC_SHA1_DIGEST_LENGTH; i++) {
         [hex appendFormat:@"%02x", digest[i]];
@@ -148,6 +165,41 @@
     return [hex copy];
 }
 
+- (NSString *)hashCachePath {
+    NSString *cacheDir = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+    return [cacheDir stringByAppendingPathComponent:@"mod_hashes.plist"];
+}
+
+// Only rehashes files whose size or modification time changed
+- (nullable NSString *)cachedSHA1ForFileAtPath:(NSString *)path {
+    NSDictionary *attrs = [[NSFileManager defaultManager] attributesOfItemAtPath:path error:nil];
+    if (!attrs) return nil;
+    // Milliseconds as a number, plists would round a date down to whole seconds
+    NSNumber *mtime = @((long long)(attrs.fileModificationDate.timeIntervalSince1970 * 1000));
+    @synchronized (self) {
+        if (!self.hashCache) {
+            self.hashCache = [NSMutableDictionary dictionaryWithContentsOfFile:[self hashCachePath]] ?: [NSMutableDictionary dictionary];
+        }
+        NSDictionary *entry = self.hashCache[path];
+        if ([entry[@"size"] isEqual:@(attrs.fileSize)] && [entry[@"mtime"] isEqual:mtime]) {
+            return entry[@"sha1"];
+        }
+    }
+    NSString *sha1 = [self sha1ForFileAtPath:path];
+    if (!sha1) return nil;
+    @synchronized (self) {
+        self.hashCache[path] = @{@"size": @(attrs.fileSize), @"mtime": mtime, @"sha1": sha1};
+    }
+    return sha1;
+}
+
+// Jar icons are often far larger than the cell, decode and downscale each one only once
+- (UIImage *)thumbnailForIconData:(NSData *)data {
+    IconStore *store = IconStore.sharedStore;
+    NSString *hash = [store storeImageData:data];
+    return hash ? [store imageForHash:hash size:IconStoreSizeLarge] : nil;
+}
+
 - (NSString *)iconCachePathForURL:(NSString *)urlString {
     if (!urlString) return nil;
     NSString *cacheDir = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
@@ -207,6 +259,11 @@
     return nil;
 }
 
++ (BOOL)isModFileName:(NSString *)fileName {
+    NSString *lower = fileName.lowercaseString;
+    return [lower hasSuffix:@".jar"] || [lower hasSuffix:@".jar.disabled"];
+}
+
 - (void)scanModsForProfile:(NSString *)profileName completion:(ModListHandler)completion {
     dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
         NSString *modsFolder = [self existingModsFolderForProfile:profileName];
@@ -219,11 +276,12 @@
             return;
         }
 
-        NSArray<NSString *> *contents = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:modsFolder error:nil];
+        NSArray<DirectoryEntry *> *contents = [DirectoryWatcher.sharedWatcher entriesAtPath:modsFolder];
         dispatch_group_t group = dispatch_group_create();
 
-        for (NSString *fileName in contents) {
-            if ([fileName.lowercaseString hasSuffix:@".jar"] || [fileName.lowercaseString hasSuffix:@".jar.disabled"]) {
+        for (DirectoryEntry *entry in contents) {
+            NSString *fileName = entry.name;
+            if ([ModService isModFileName:fileName]) {
                 NSString *fullPath = [modsFolder stringByAppendingPathComponent:fileName];
                 ModItem *mod = [[ModItem alloc] initWithFilePath:fullPath];
                 [items addObject:mod];
@@ -275,7 +333,7 @@
                     NSString *iconPath = json[@"icon"];
                     if ([iconPath isKindOfClass:[NSString class]]) {
                         NSData *iconData = [self readFileFromJar:mod.filePath entryName:iconPath];
-                        if (iconData) mod.icon = [[UIImage alloc] initWithData:iconData];
+                        if (iconData) mod.icon = [self thumbnailForIconData:iconData];
                     }
                     if (completion) completion(mod, nil);
                     return;
@@ -329,7 +387,7 @@
                         NSString *logoFile = modInfo[@"logoFile"];
                         if (logoFile.length > 0) {
                             NSData *logoData = [self readFileFromJar:mod.filePath entryName:logoFile];
-                            if (logoData) mod.icon = [[UIImage alloc] initWithData:logoData];
+                            if (logoData) mod.icon = [self thumbnailForIconData:logoData];
                         }
                         if (completion) completion(mod, nil);
                         return;
@@ -412,6 +470,90 @@
     [task resume];
 }
 
+#pragma mark - Update Check
+
+// "fabric-loader-0.15.11-1.20.1" and "1.20.1-forge-47.2.0" both give 1.20.1
+- (nullable NSString *)minecraftVersionForProfile:(NSString *)profileName {
+    NSString *versionId = PLProfiles.current.profiles[profileName][@"lastVersionId"];
+    if (![versionId isKindOfClass:[NSString class]]) return nil;
+    NSRegularExpression *regex = [NSRegularExpression regularExpressionWithPattern:@"(?<![0-9.])1\\.[0-9]+(\\.[0-9]+)?(?![0-9.])" options:0 error:nil];
+    NSTextCheckingResult *match = [regex firstMatchInString:versionId options:0 range:NSMakeRange(0, versionId.length)];
+    return match ? [versionId substringWithRange:match.range] : nil;
+}
+
+// Jars are only ever built for the loader whose metadata they carry
+- (nullable NSString *)modrinthLoaderForMod:(ModItem *)mod {
+    if (mod.isNeoForge) return @"neoforge";
+    if (mod.isForge) return @"forge";
+    if (mod.isFabric) return @"fabric";
+    return nil;
+}
+
+// Sends mod_update's JSON bodies through the API client, which wants them parsed
+static char *modServicePost(void *context, const char *endpoint, const char *body, size_t *length) {
+    ModrinthAPI *api = (__bridge ModrinthAPI *)context;
+    NSDictionary *request = [NSJSONSerialization JSONObjectWithData:[NSData dataWithBytesNoCopy:(void *)body length:strlen(body) freeWhenDone:NO] options:0 error:nil];
+    id response = request ? [api postEndpoint:@(endpoint) body:request] : nil;
+    if (![response isKindOfClass:NSDictionary.class]) {
+        return NULL;
+    }
+    NSData *data = [NSJSONSerialization dataWithJSONObject:response options:0 error:nil];
+    if (!data) {
+        return NULL;
+    }
+    char *copy = malloc(data.length + 1);
+    memcpy(copy, data.bytes, data.length);
+    copy[data.length] = '\0';
+    *length = data.length;
+    return copy;
+}
+
+- (void)checkUpdatesForMods:(NSArray<ModItem *> *)mods profile:(NSString *)profileName completion:(ModUpdateCheckHandler)completion {
+    NSString *baseURL = self.modrinthBaseURL;
+    dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+        // Hash in parallel, jars are read once and then served from the cache
+        dispatch_apply(mods.count, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t i) {
+            mods[i].fileSHA1 = [self cachedSHA1ForFileAtPath:mods[i].filePath];
+        });
+        @synchronized (self) {
+            [self.hashCache writeToFile:[self hashCachePath] atomically:YES];
+        }
+
+        mod_update_entry_t *entries = calloc(MAX(mods.count, 1), sizeof(mod_update_entry_t));
+        for (NSUInteger i = 0; i < mods.count; i++) {
+            entries[i].sha1 = mods[i].fileSHA1.UTF8String;
+            entries[i].loader = [self modrinthLoaderForMod:mods[i]].UTF8String;
+        }
+        NSString *gameVersion = [self minecraftVersionForProfile:profileName];
+        ModrinthAPI *api = [[ModrinthAPI alloc] initWithURL:baseURL];
+        if (!mod_update_check(entries, mods.count, gameVersion.UTF8String, modServicePost, (__bridge void *)api)) {
+            free(entries);
+            dispatch_async(dispatch_get_main_queue(), ^{
+                if (completion) completion(api.lastError ?: [NSError errorWithDomain:@"ModServiceError" code:3 userInfo:@{NSLocalizedDescriptionKey:@"检查更新失败。"}]);
+            });
+            return;
+        }
+
+        dispatch_async(dispatch_get_main_queue(), ^{
+            for (NSUInteger i = 0; i < mods.count; i++) {
+                ModItem *mod = mods[i];
+                mod_update_entry_t *entry = &entries[i];
+                mod.updateStatus = entry->status == MOD_UPDATE_OUTDATED ? ModUpdateStatusOutdated :
+                    entry->status == MOD_UPDATE_UP_TO_DATE ? ModUpdateStatusUpToDate : ModUpdateStatusUnknown;
+                if (entry->status == MOD_UPDATE_UNKNOWN) continue;
+                mod.latestVersion = entry->latestVersion ? @(entry->latestVersion) : nil;
+                if (entry->downloadURL) mod.latestDownloadURL = @(entry->downloadURL);
+                if (entry->fileName) mod.latestFileName = @(entry->fileName);
+                // Jars without a version in their metadata show the one Modrinth knows
+                if (entry->status == MOD_UPDATE_UP_TO_DATE && mod.version.length == 0) mod.version = mod.latestVersion;
+                mod_update_entry_free(entry);
+            }
+            free(entries);
+            if (completion) completion(nil);
+        });
+    });
+}
+
 #pragma mark - NSURLSessionDownloadDelegate
 
 - (void)URLSession:(NSURLSession *)session downloadTask:(NSURLSessionDownloadTask *)downloadTask didFinishDownloadingToURL:(NSURL *)location {
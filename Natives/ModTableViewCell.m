@@ -223,6 +223,16 @@
         _modVersionLabel.hidden = YES;
     }
 
+    // Update check results
+    _modVersionLabel.textColor = [UIColor secondaryLabelColor];
+    if (mod.updateStatus == ModUpdateStatusOutdated) {
+        _modVersionLabel.text = [NSString stringWithFormat:@"%@ → %@", _modVersionLabel.text ?: @"", mod.latestVersion ?: @"?"];
+        _modVersionLabel.textColor = [UIColor systemOrangeColor];
+        _modVersionLabel.hidden = NO;
+    } else if (mod.updateStatus == ModUpdateStatusUnknown) {
+        _modVersionLabel.textColor = [UIColor tertiaryLabelColor];
+    }
+
     if (mod.gameVersion && mod.gameVersion.length > 0) {
         _gameVersionLabel.text = [NSString stringWithFormat:@"MC %@", mod.gameVersion];
         _gameVersionLabel.hidden = NO;
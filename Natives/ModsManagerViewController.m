@@ -1,3 +1,4 @@
+#import "DirectoryWatcher.h"
 #import "ModsManagerViewController.h"
 #import "ModTableViewCell.h"
 #import "ModService.h"
@@ -13,8 +14,11 @@
 @property (nonatomic, strong) UIActivityIndicatorView *activityIndicator;
 @property (nonatomic, strong) UILabel *emptyLabel;
 @property (nonatomic, strong) UIBarButtonItem *refreshButton;
+@property (nonatomic, strong) UIBarButtonItem *checkUpdatesButton;
 @property (nonatomic, strong) NSMutableArray<ModItem *> *localMods;
 @property (nonatomic, strong) NSMutableArray<ModItem *> *filteredLocalMods;
+@property (nonatomic, strong) NSString *watchedModsFolder;
+@property (nonatomic, strong) id modsFolderObserver;
 
 @end
 
@@ -67,6 +71,7 @@
     self.emptyLabel.hidden = YES;
     [self.view addSubview:self.emptyLabel];
     self.refreshButton = [[UIBarButtonItem alloc] initWithBarButtonSystemItem:UIBarButtonSystemItemRefresh target:self action:@selector(handleRefresh:)];
+    self.checkUpdatesButton = [[UIBarButtonItem alloc] initWithImage:[UIImage systemImageNamed:@"arrow.down.circle"] style:UIBarButtonItemStylePlain target:self action:@selector(checkForUpdates)];
     [self updateNavigationButtons];
     [NSLayoutConstraint activateConstraints:@[
         [self.modeSwitcher.topAnchor constraintEqualToAnchor:self.view.safeAreaLayoutGuide.topAnchor constant:8],
@@ -114,7 +119,7 @@
 
 - (void)updateNavigationButtons {
     if (self.currentMode == ModsManagerModeLocal) {
-        self.navigationItem.rightBarButtonItems = @[self.refreshButton];
+        self.navigationItem.rightBarButtonItems = @[self.refreshButton, self.checkUpdatesButton];
     } else {
         self.navigationItem.rightBarButtonItems = nil;
     }
@@ -153,6 +158,7 @@
 
     [self setLoading:YES];
     NSString *profile = self.profileName ?: @"default";
+    [self watchModsFolderOfProfile:profile];
     [[ModService sharedService] scanModsForProfile:profile completion:^(NSArray<ModItem *> *mods) {
         dispatch_async(dispatch_get_main_queue(), ^{
             [self.localMods removeAllObjects];
@@ -163,6 +169,108 @@
     }];
 }
 
+- (void)dealloc {
+    [DirectoryWatcher.sharedWatcher removeObserver:self.modsFolderObserver];
+}
+
+- (void)watchModsFolderOfProfile:(NSString *)profile {
+    NSString *modsFolder = [[ModService sharedService] existingModsFolderForProfile:profile];
+    if (!modsFolder || [modsFolder isEqualToString:self.watchedModsFolder]) return;
+
+    [DirectoryWatcher.sharedWatcher removeObserver:self.modsFolderObserver];
+    self.watchedModsFolder = modsFolder;
+    __weak ModsManagerViewController *weakSelf = self;
+    self.modsFolderObserver = [DirectoryWatcher.sharedWatcher addObserverForPath:modsFolder handler:^(DirectoryChange *change) {
+        [weakSelf applyModsFolderChange:change];
+    }];
+}
+
+// Files added, removed or replaced behind our back (Files app, downloads), only those are parsed again
+- (void)applyModsFolderChange:(DirectoryChange *)change {
+    NSMutableSet<NSString *> *stale = [NSMutableSet set];
+    for (DirectoryEntry *entry in [change.removed arrayByAddingObjectsFromArray:change.modified]) {
+        [stale addObject:entry.name];
+    }
+    NSIndexSet *staleIndexes = [self.localMods indexesOfObjectsPassingTest:^BOOL(ModItem *mod, NSUInteger idx, BOOL *stop) {
+        return [stale containsObject:mod.fileName];
+    }];
+    [self.localMods removeObjectsAtIndexes:staleIndexes];
+
+    NSMutableSet<NSString *> *known = [NSMutableSet set];
+    for (ModItem *mod in self.localMods) {
+        [known addObject:mod.fileName];
+    }
+    NSMutableArray<ModItem *> *newMods = [NSMutableArray array];
+    for (DirectoryEntry *entry in [change.added arrayByAddingObjectsFromArray:change.modified]) {
+        // Renames done by toggling are already reflected in the model
+        if (entry.isDirectory || ![ModService isModFileName:entry.name] || [known containsObject:entry.name]) continue;
+        [newMods addObject:[[ModItem alloc] initWithFilePath:[change.path stringByAppendingPathComponent:entry.name]]];
+    }
+    if (staleIndexes.count == 0 && newMods.count == 0) return;
+
+    dispatch_group_t group = dispatch_group_create();
+    for (ModItem *mod in newMods) {
+        dispatch_group_enter(group);
+        [[ModService sharedService] fetchMetadataForMod:mod completion:^(ModItem *populatedMod, NSError *error) {
+            dispatch_group_leave(group);
+        }];
+    }
+    dispatch_group_notify(group, dispatch_get_main_queue(), ^{
+        // A full rescan may have finished in the meantime
+        NSArray *fileNames = [self.localMods valueForKey:@"fileName"];
+        for (ModItem *mod in newMods) {
+            if (![fileNames containsObject:mod.fileName]) {
+                [self.localMods addObject:mod];
+            }
+        }
+        [self.localMods sortUsingComparator:^NSComparisonResult(ModItem *obj1, ModItem *obj2) {
+            NSString *name1 = obj1.displayName ?: obj1.fileName;
+            NSString *name2 = obj2.displayName ?: obj2.fileName;
+            return [name1 localizedCaseInsensitiveCompare:name2];
+        }];
+        if (self.currentMode == ModsManagerModeLocal) {
+            [self filterLocalMods];
+        }
+    });
+}
+
+- (void)checkForUpdates {
+    if (self.currentMode != ModsManagerModeLocal || self.localMods.count == 0) return;
+
+    [self setLoading:YES];
+    self.checkUpdatesButton.enabled = NO;
+    NSArray<ModItem *> *mods = [self.localMods copy];
+    [[ModService sharedService] checkUpdatesForMods:mods profile:self.profileName ?: @"default" completion:^(NSError * _Nullable error) {
+        [self setLoading:NO];
+        self.checkUpdatesButton.enabled = YES;
+        if (error) {
+            [self showSimpleAlertWithTitle:@"检查更新失败" message:error.localizedDescription];
+            return;
+        }
+        NSUInteger outdated = 0, unknown = 0;
+        for (ModItem *mod in mods) {
+            if (mod.updateStatus == ModUpdateStatusOutdated) outdated++;
+            else if (mod.updateStatus == ModUpdateStatusUnknown) unknown++;
+        }
+        [self.tableView reloadData];
+        [self showSimpleAlertWithTitle:@"检查更新" message:[NSString stringWithFormat:@"%lu 个 Mod 有可用更新，%lu 个未在 Modrinth 上找到。\n点击有更新的 Mod 即可更新。", (unsigned long)outdated, (unsigned long)unknown]];
+    }];
+}
+
+- (void)updateMod:(ModItem *)mod {
+    UIAlertController *alert = [UIAlertController alertControllerWithTitle:mod.displayName
+        message:[NSString stringWithFormat:@"更新到 %@？", mod.latestVersion] preferredStyle:UIAlertControllerStyleAlert];
+    [alert addAction:[UIAlertAction actionWithTitle:@"取消" style:UIAlertActionStyleCancel handler:nil]];
+    [alert addAction:[UIAlertAction actionWithTitle:@"更新" style:UIAlertActionStyleDefault handler:^(UIAlertAction * _Nonnull action) {
+        ModItem *update = [ModItem new];
+        update.displayName = mod.displayName;
+        update.selectedVersionDownloadURL = mod.latestDownloadURL;
+        update.fileName = mod.latestFileName;
+        [self startDownloadForItem:update replacingMod:mod];
+    }]];
+    [self presentViewController:alert animated:YES completion:nil];
+}
+
 - (void)performOnlineSearch {
     NSString *searchText = self.searchBar.text;
     if (searchText.length == 0) return;
@@ -341,10 +449,10 @@
     itemToDownload.selectedVersionDownloadURL = primaryFile[@"url"];
     itemToDownload.fileName = primaryFile[@"filename"];
 
-    [self startDownloadForItem:itemToDownload];
+    [self startDownloadForItem:itemToDownload replacingMod:nil];
 }
 
-- (void)startDownloadForItem:(ModItem *)item {
+- (void)startDownloadForItem:(ModItem *)item replacingMod:(ModItem *)oldMod {
     // Show a temporary "downloading" alert
     UIAlertController *downloadingAlert = [UIAlertController alertControllerWithTitle:@"正在下载"
                                                                               message:[NSString stringWithFormat:@"%@...", item.displayName]
@@ -369,6 +477,10 @@
                 if (error) {
                     [self showSimpleAlertWithTitle:@"下载失败" message:error.localizedDescription];
                 } else {
+                    // The new jar has a different name, drop the one it replaces
+                    if (oldMod && ![oldMod.fileName isEqualToString:item.fileName]) {
+                        [[ModService sharedService] deleteMod:oldMod error:nil];
+                    }
                     UIAlertController *successAlert = [UIAlertController alertControllerWithTitle:@"下载成功"
                                                                                           message:[NSString stringWithFormat:@"%@ 已成功安装。", item.displayName]
                                                                                    preferredStyle:UIAlertControllerStyleAlert];
@@ -395,6 +507,12 @@
     if (self.currentMode == ModsManagerModeOnline) {
         // Handle online search item selection if necessary (e.g., show details)
         [tableView deselectRowAtIndexPath:indexPath animated:YES];
+        return;
+    }
+    [tableView deselectRowAtIndexPath:indexPath animated:YES];
+    ModItem *mod = self.filteredLocalMods[indexPath.row];
+    if (mod.updateStatus == ModUpdateStatusOutdated && mod.latestDownloadURL.length > 0) {
+        [self updateMod:mod];
     }
 }
 
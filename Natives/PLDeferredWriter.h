@@ -0,0 +1,33 @@
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Writes a whole file some time after its contents last changed, instead of on
+// every change. Bursts of changes (a slider being dragged) end up as a single
+// write, at most maxDelay after the first one. Each write still replaces the
+// file atomically, so a crash leaves either the previous or the latest
+// contents. Pending writes are flushed when the app goes to the background.
+// Use from the main thread, like the dictionaries being serialized.
+@interface PLDeferredWriter : NSObject
+
+@property(nonatomic, readonly) NSString *path;
+@property(nonatomic) NSTimeInterval delay, maxDelay;
+// Writes that actually hit the disk. Identical contents are skipped, unless
+// the file changed on disk since the last write (e.g. the Forge installer
+// rewrote launcher_profiles.json).
+@property(nonatomic, readonly) NSUInteger writeCount;
+
+- (instancetype)initWithPath:(NSString *)path serializer:(NSData * _Nullable (^)(void))serializer;
+
+- (void)setNeedsWrite;
+// Writes now if anything is pending and waits for it, before the file is read
+// back or the JVM is started
+- (void)flush;
+// Drops what is pending and waits for writes already queued, before the file
+// is deleted
+- (void)cancel;
++ (void)flushAll;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,127 @@
+#import <UIKit/UIKit.h>
+#import "PLDeferredWriter.h"
+#include "deferred_write.h"
+
+@interface PLDeferredWriter()
+@property(nonatomic, copy) NSData *(^serializer)(void);
+@property(nonatomic) dispatch_source_t timer;
+@end
+
+@implementation PLDeferredWriter {
+    deferred_write_t _state;
+    // Only touched on ioQueue
+    deferred_file_t _file;
+}
+
+static NSHashTable<PLDeferredWriter *> *writers;
+// Shared by every writer so flush can wait for writes already queued
+static dispatch_queue_t ioQueue;
+
++ (void)initialize {
+    if (self != PLDeferredWriter.class) return;
+    writers = [NSHashTable weakObjectsHashTable];
+    ioQueue = dispatch_queue_create("PLDeferredWriter", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+    for (NSNotificationName name in @[UIApplicationDidEnterBackgroundNotification, UIApplicationWillTerminateNotification]) {
+        [NSNotificationCenter.defaultCenter addObserverForName:name object:nil
+            queue:NSOperationQueue.mainQueue usingBlock:^(NSNotification *note) {
+            [PLDeferredWriter flushAll];
+        }];
+    }
+}
+
++ (void)flushAll {
+    NSArray<PLDeferredWriter *> *all;
+    @synchronized (writers) {
+        all = writers.allObjects;
+    }
+    for (PLDeferredWriter *writer in all) {
+        [writer flush];
+    }
+}
+
+- (instancetype)initWithPath:(NSString *)path serializer:(NSData *(^)(void))serializer {
+    self = [super init];
+    _path = path;
+    self.serializer = serializer;
+    deferred_write_init(&_state, 0.5, 2);
+    self.timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+    __weak PLDeferredWriter *weakSelf = self;
+    dispatch_source_set_event_handler(self.timer, ^{
+        [weakSelf writeAndWait:NO];
+    });
+    dispatch_source_set_timer(self.timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+    dispatch_resume(self.timer);
+    @synchronized (writers) {
+        [writers addObject:self];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    dispatch_source_cancel(_timer);
+    deferred_file_forget(&_file);
+}
+
+- (NSTimeInterval)delay {
+    return _state.delay;
+}
+
+- (void)setDelay:(NSTimeInterval)delay {
+    _state.delay = delay;
+}
+
+- (NSTimeInterval)maxDelay {
+    return _state.maxDelay;
+}
+
+- (void)setMaxDelay:(NSTimeInterval)maxDelay {
+    _state.maxDelay = maxDelay;
+}
+
+- (NSUInteger)writeCount {
+    __block NSUInteger count;
+    dispatch_sync(ioQueue, ^{
+        count = self->_file.writeCount;
+    });
+    return count;
+}
+
+- (void)setNeedsWrite {
+    NSTimeInterval now = NSProcessInfo.processInfo.systemUptime;
+    NSTimeInterval deadline = deferred_write_changed(&_state, now);
+    dispatch_source_set_timer(self.timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)((deadline - now) * NSEC_PER_SEC)),
+        DISPATCH_TIME_FOREVER, 50 * NSEC_PER_MSEC);
+}
+
+- (void)flush {
+    [self writeAndWait:YES];
+}
+
+- (void)cancel {
+    deferred_write_cancel(&_state);
+    dispatch_source_set_timer(self.timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+    // Lets a write already queued land first, so it can't recreate the file afterwards
+    dispatch_sync(ioQueue, ^{
+        deferred_file_forget(&self->_file);
+    });
+}
+
+- (void)writeAndWait:(BOOL)wait {
+    if (deferred_write_take(&_state)) {
+        dispatch_source_set_timer(self.timer, DISPATCH_TIME_FOREVER, DISPATCH_TIME_FOREVER, 0);
+
+        NSData *data = self.serializer();
+        if (data) {
+            dispatch_async(ioQueue, ^{
+                if (!deferred_file_write(&self->_file, self.path.fileSystemRepresentation, data.bytes, data.length)) {
+                    NSLog(@"[PLDeferredWriter] Failed to write %@: %s", self.path.lastPathComponent, strerror(errno));
+                }
+            });
+        }
+    }
+    if (wait) {
+        dispatch_sync(ioQueue, ^{});
+    }
+}
+
+@end
@@ -4,5 +4,6 @@
 - (void)actionStartStopLogOutput;
 - (void)actionToggleLogOutput;
 + (void)appendToLog:(NSString *)line;
++ (void)appendToLog:(const char *)text length:(size_t)length;
 + (void)handleExitCode:(int)code;
 @end
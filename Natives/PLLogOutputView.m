@@ -1,23 +1,41 @@
+#include <pthread.h>
+
 #import "PLLogOutputView.h"
 #import "SurfaceViewController.h"
+#include "log_store.h"
 #import "utils.h"
 
+// Enough for a few thousand screens of output, older lines are dropped
+#define LOG_ARENA_SIZE (4 << 20)
+#define LOG_MAX_LINES 32768
+
 @interface PLLogOutputView()<UITableViewDataSource, UITableViewDelegate>
 @property(nonatomic) UITableView* logTableView;
 @property(nonatomic) UINavigationBar* navigationBar;
+@property(nonatomic) NSString* searchQuery;
+// Rows shown by the table, a snapshot of the store taken at the last refresh
+@property(nonatomic) uint64_t displayedFirstSeq;
+@property(nonatomic) NSInteger displayedCount;
 @end
 
 @implementation PLLogOutputView
 static BOOL fatalErrorOccurred;
-static NSMutableArray* logLines;
+static log_store_t* logStore;
+static pthread_mutex_t logStoreLock = PTHREAD_MUTEX_INITIALIZER;
+static BOOL refreshPending;
 static PLLogOutputView* current;
 
++ (void)initialize {
+    if (self == PLLogOutputView.class) {
+        logStore = log_store_create(LOG_ARENA_SIZE, LOG_MAX_LINES);
+    }
+}
+
 - (instancetype)initWithFrame:(CGRect)frame {
     frame.origin.y = frame.size.height;
     self = [super initWithFrame:frame];
     frame.origin.y = 0;
 
-    logLines = [NSMutableArray new];
     self.backgroundColor = [UIColor colorWithWhite:0 alpha:0.5];
     self.hidden = YES;
 
@@ -26,7 +44,9 @@ static PLLogOutputView* current;
         [[UIBarButtonItem alloc] initWithBarButtonSystemItem:UIBarButtonSystemItemStop
             target:self action:@selector(actionToggleLogOutput)],
         [[UIBarButtonItem alloc] initWithBarButtonSystemItem:UIBarButtonSystemItemTrash
-            target:self action:@selector(actionClearLogOutput)]
+            target:self action:@selector(actionClearLogOutput)],
+        [[UIBarButtonItem alloc] initWithBarButtonSystemItem:UIBarButtonSystemItemSearch
+            target:self action:@selector(actionSearchLogOutput)]
     ];
     self.navigationBar = [[UINavigationBar alloc] initWithFrame:CGRectMake(0, 0, frame.size.width, 44)];
     self.navigationBar.items = @[navigationItem];
@@ -52,11 +72,12 @@ static PLLogOutputView* current;
     [self actionStartStopLogOutput];
 
     current = self;
+    [self refreshLogOutput];
     return self;
 }
 
 - (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section {
-    return logLines.count;
+    return self.displayedCount;
 }
 
 - (UITableViewCell *)tableView:(UITableView *)tableView cellForRowAtIndexPath:(NSIndexPath *)indexPath {
@@ -69,7 +90,35 @@ static PLLogOutputView* current;
         cell.textLabel.font = [UIFont fontWithName:@"Menlo-Regular" size:16];
         cell.textLabel.textColor = UIColor.whiteColor;
     }
-    cell.textLabel.text = logLines[indexPath.row];
+
+    size_t length;
+    log_severity_t severity = LOG_SEVERITY_INFO;
+    BOOL matched = NO;
+    pthread_mutex_lock(&logStoreLock);
+    uint64_t seq = self.displayedFirstSeq + indexPath.row;
+    const char *line = log_store_line(logStore, seq, &length, &severity);
+    if (line) {
+        // Lines cut at the length limit may end in a partial UTF-8 sequence
+        cell.textLabel.text = [[NSString alloc] initWithBytes:line length:length encoding:NSUTF8StringEncoding] ?:
+            [[NSString alloc] initWithBytes:line length:length encoding:NSISOLatin1StringEncoding];
+    } else {
+        cell.textLabel.text = @"";
+    }
+    matched = self.searchQuery.length > 0 && log_store_line_matches(logStore, seq);
+    pthread_mutex_unlock(&logStoreLock);
+
+    switch (severity) {
+        case LOG_SEVERITY_ERROR:
+            cell.textLabel.textColor = UIColor.systemRedColor;
+            break;
+        case LOG_SEVERITY_WARN:
+            cell.textLabel.textColor = UIColor.systemYellowColor;
+            break;
+        default:
+            cell.textLabel.textColor = UIColor.whiteColor;
+            break;
+    }
+    cell.backgroundColor = matched ? [UIColor colorWithWhite:1 alpha:0.2] : UIColor.clearColor;
 
     return cell;
 }
@@ -99,8 +148,90 @@ static PLLogOutputView* current;
 }
 
 - (void)actionClearLogOutput {
-    [logLines removeAllObjects];
-    [self.logTableView reloadData];
+    pthread_mutex_lock(&logStoreLock);
+    log_store_clear(logStore);
+    pthread_mutex_unlock(&logStoreLock);
+    [self refreshLogOutput];
+}
+
+- (void)actionSearchLogOutput {
+    UIAlertController *alert = [UIAlertController alertControllerWithTitle:localize(@"game.log.search", nil)
+        message:localize(@"game.log.search.message", nil) preferredStyle:UIAlertControllerStyleAlert];
+    [alert addTextFieldWithConfigurationHandler:^(UITextField *textField) {
+        textField.text = self.searchQuery;
+        textField.clearButtonMode = UITextFieldViewModeWhileEditing;
+        textField.autocorrectionType = UITextAutocorrectionTypeNo;
+        textField.autocapitalizationType = UITextAutocapitalizationTypeNone;
+    }];
+    [alert addAction:[UIAlertAction actionWithTitle:localize(@"game.log.search.previous", nil) style:UIAlertActionStyleDefault handler:^(UIAlertAction *action) {
+        [self jumpToMatch:alert.textFields[0].text forward:NO];
+    }]];
+    [alert addAction:[UIAlertAction actionWithTitle:localize(@"game.log.search.next", nil) style:UIAlertActionStyleDefault handler:^(UIAlertAction *action) {
+        [self jumpToMatch:alert.textFields[0].text forward:YES];
+    }]];
+    [alert addAction:[UIAlertAction actionWithTitle:localize(@"Cancel", nil) style:UIAlertActionStyleCancel handler:nil]];
+    [currentVC() presentViewController:alert animated:YES completion:nil];
+}
+
+// An empty query steps through warnings and errors instead
+- (void)jumpToMatch:(NSString *)query forward:(BOOL)forward {
+    NSIndexPath *anchor = forward ?
+        self.logTableView.indexPathsForVisibleRows.lastObject :
+        self.logTableView.indexPathsForVisibleRows.firstObject;
+    uint64_t fromSeq = self.displayedFirstSeq + (anchor ? anchor.row : 0);
+
+    uint64_t seq;
+    pthread_mutex_lock(&logStoreLock);
+    if (![query isEqualToString:self.searchQuery]) {
+        log_store_set_query(logStore, query.UTF8String,
+            query.length > 0 ? LOG_SEVERITY_INFO : LOG_SEVERITY_WARN);
+        // Start over from the top or bottom for a new query
+        fromSeq = forward ? log_store_first_seq(logStore) : log_store_end_seq(logStore);
+        seq = forward && log_store_line_matches(logStore, fromSeq) ?
+            fromSeq : log_store_find_match(logStore, fromSeq, forward);
+    } else {
+        seq = log_store_find_match(logStore, fromSeq, forward);
+    }
+    pthread_mutex_unlock(&logStoreLock);
+    self.searchQuery = query;
+
+    [self refreshLogOutput];
+    if (seq == UINT64_MAX || seq < self.displayedFirstSeq ||
+        seq >= self.displayedFirstSeq + self.displayedCount) {
+        return;
+    }
+    NSIndexPath *indexPath = [NSIndexPath indexPathForRow:seq - self.displayedFirstSeq inSection:0];
+    [self.logTableView scrollToRowAtIndexPath:indexPath
+        atScrollPosition:UITableViewScrollPositionMiddle animated:NO];
+}
+
+// Takes a new snapshot of the store, keeping the scroll position pinned to
+// the bottom if it was there
+- (void)refreshLogOutput {
+    UITableView *tableView = self.logTableView;
+    BOOL atBottom = tableView.contentOffset.y + tableView.bounds.size.height >=
+        tableView.contentSize.height - tableView.rowHeight;
+
+    pthread_mutex_lock(&logStoreLock);
+    uint64_t firstSeq = log_store_first_seq(logStore);
+    NSInteger count = log_store_end_seq(logStore) - firstSeq;
+    pthread_mutex_unlock(&logStoreLock);
+    // Rows only shift when old lines were dropped
+    CGFloat shift = (CGFloat)(firstSeq - self.displayedFirstSeq) * tableView.rowHeight;
+    self.displayedFirstSeq = firstSeq;
+    self.displayedCount = count;
+
+    UIView.animationsEnabled = NO;
+    [tableView reloadData];
+    if (count > 0 && atBottom) {
+        [tableView scrollToRowAtIndexPath:[NSIndexPath indexPathForRow:count-1 inSection:0]
+            atScrollPosition:UITableViewScrollPositionBottom animated:NO];
+    } else if (shift > 0) {
+        CGPoint offset = tableView.contentOffset;
+        offset.y = MAX(offset.y - shift, -tableView.contentInset.top);
+        tableView.contentOffset = offset;
+    }
+    UIView.animationsEnabled = YES;
 }
 
 - (void)actionShareLatestlog {
@@ -114,6 +245,9 @@ static PLLogOutputView* current;
 
 - (void)actionStartStopLogOutput {
     canAppendToLog = !canAppendToLog;
+    if (canAppendToLog) {
+        [self refreshLogOutput];
+    }
     UINavigationItem* item = self.navigationBar.items[0];
     item.leftBarButtonItem =
         [[UIBarButtonItem alloc] initWithBarButtonSystemItem:
@@ -139,34 +273,33 @@ static PLLogOutputView* current;
     }];
 }
 
-+ (void)_appendToLog:(NSString *)line {
-    if (line.length == 0) {
-        return;
++ (void)appendToLog:(const char *)text length:(size_t)length {
+    pthread_mutex_lock(&logStoreLock);
+    log_store_append(logStore, text, length);
+    // Lines are always kept, the view only picks them up while unpaused.
+    // Batches whatever arrives within a frame or so into one reload.
+    BOOL scheduleRefresh = canAppendToLog && !refreshPending;
+    if (scheduleRefresh) {
+        refreshPending = YES;
     }
+    pthread_mutex_unlock(&logStoreLock);
 
-    NSIndexPath *indexPath = [NSIndexPath indexPathForRow:logLines.count inSection:0];
-    [logLines addObject:line];
-    UIView.animationsEnabled = NO;
-    [current.logTableView beginUpdates];
-    [current.logTableView
-        insertRowsAtIndexPaths:@[indexPath]
-        withRowAnimation:UITableViewRowAnimationNone];
-    [current.logTableView endUpdates];
-    UIView.animationsEnabled = YES;
-
-    [current.logTableView 
-        scrollToRowAtIndexPath:indexPath
-        atScrollPosition:UITableViewScrollPositionBottom animated:NO];
+    if (scheduleRefresh) {
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 50 * NSEC_PER_MSEC), dispatch_get_main_queue(), ^{
+            pthread_mutex_lock(&logStoreLock);
+            refreshPending = NO;
+            pthread_mutex_unlock(&logStoreLock);
+            if (canAppendToLog) {
+                [current refreshLogOutput];
+            }
+        });
+    }
 }
 
 + (void)appendToLog:(NSString *)string {
-    dispatch_async(dispatch_get_main_queue(), ^(void){
-        NSArray *lines = [string componentsSeparatedByCharactersInSet:
-            NSCharacterSet.newlineCharacterSet];
-        for (NSString *line in lines) {
-            [self _appendToLog:line];
-        }
-    });
+    const char *text = string.UTF8String;
+    if (!text) return;
+    [self appendToLog:text length:strlen(text)];
 }
 
 + (void)handleExitCode:(int)code {
@@ -186,24 +319,13 @@ static PLLogOutputView* current;
         navigationBar.items[0].rightBarButtonItems = nil;
         navigationBar.items[0].rightBarButtonItem = exitItem;
 
-        if (canAppendToLog) {
-            canAppendToLog = NO;
-            fatalErrorOccurred = YES;
-            return;
+        // The store has kept every recent line even while paused, show them all
+        canAppendToLog = NO;
+        [current refreshLogOutput];
+        if (current.displayedCount > 0) {
+            [current.logTableView scrollToRowAtIndexPath:[NSIndexPath indexPathForRow:current.displayedCount-1 inSection:0]
+                atScrollPosition:UITableViewScrollPositionBottom animated:NO];
         }
-        [current actionClearLogOutput];
-        [self _appendToLog:@"... (latestlog.txt)"];
-        NSString *latestlogPath = [NSString stringWithFormat:@"%s/latestlog.txt", getenv("POJAV_HOME")];
-        NSString *linesStr = [NSString stringWithContentsOfFile:latestlogPath
-            encoding:NSUTF8StringEncoding error:nil];
-        NSArray *lines = [linesStr componentsSeparatedByCharactersInSet:
-            NSCharacterSet.newlineCharacterSet];
-
-        // Print last 100 lines from latestlog.txt
-        for (int i = MAX(lines.count-100, 0); i < lines.count; i++) {
-            [self _appendToLog:lines[i]];
-        }
-
         fatalErrorOccurred = YES;
     });
 }
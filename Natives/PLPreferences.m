@@ -1,10 +1,13 @@
 #import "LauncherPreferences.h"
+#import "PLDeferredWriter.h"
 #import "PLPreferences.h"
 #import "UIKit+hook.h"
 #import "config.h"
 #import "utils.h"
 
 @interface PLPreferences()
+// Sliders and switches set values many times a second, writes are coalesced
+@property(nonatomic) PLDeferredWriter *globalWriter, *instanceWriter;
 @end
 
 @implementation PLPreferences
@@ -45,7 +48,9 @@
             @"virtmouse_enable": @NO,
             @"gyroscope_enable": @NO,
             @"gyroscope_invert_x_axis": @NO,
-            @"gyroscope_sensitivity": @(100)
+            @"gyroscope_sensitivity": @(100),
+            @"gyroscope_smoothing": @(10),
+            @"gyroscope_deadzone": @(1)
         }.mutableCopy,
         @"java": @{
             @"java_homes": @{
@@ -85,7 +90,9 @@
             @"debug_ipad_ui": @(realUIIdiom == UIUserInterfaceIdiomPad),
             @"debug_auto_correction": @YES,
             @"debug_show_layout_bounds": @NO,
-            @"debug_show_layout_overlap": @NO
+            @"debug_show_layout_overlap": @NO,
+            @"debug_stall_threshold": @(0),
+            @"debug_headless_forge_installer": @NO
         }.mutableCopy;
         defaults[@"warnings"] = @{
             @"local_warn": @YES,
@@ -191,6 +198,7 @@
 }
 
 - (void)toggleIsolationForced:(BOOL)force {
+    [self.instanceWriter flush];
     NSMutableDictionary *instancePref = [NSMutableDictionary dictionaryWithContentsOfFile:self.instancePath];
     if (force || [instancePref[@"internal"][@"isolated"] boolValue]) {
         NSLog(@"[PLPreferences] Using isolated preferences from %@", self.instancePath.stringByResolvingSymlinksInPath);
@@ -241,6 +249,8 @@
 
 - (void)reset {
     if (self.instancePref) {
+        // A pending write would bring the old values back right after
+        [self.instanceWriter cancel];
         [NSFileManager.defaultManager removeItemAtPath:self.instancePath error:nil];
         [self toggleIsolationForced:YES];
         // Only reset isolated values
@@ -251,12 +261,31 @@
     [self saveGlobalPref];
 }
 
++ (PLDeferredWriter *)writerForPath:(NSString *)path pref:(NSDictionary *(^)(void))pref {
+    return [[PLDeferredWriter alloc] initWithPath:path serializer:^NSData *{
+        return [NSPropertyListSerialization dataWithPropertyList:pref()
+            format:NSPropertyListXMLFormat_v1_0 options:0 error:nil];
+    }];
+}
+
 - (void)saveGlobalPref {
-    [self.globalPref writeToFile:self.globalPath atomically:YES];
+    if (![self.globalWriter.path isEqualToString:self.globalPath]) {
+        __weak PLPreferences *weakSelf = self;
+        self.globalWriter = [PLPreferences writerForPath:self.globalPath pref:^{
+            return weakSelf.globalPref;
+        }];
+    }
+    [self.globalWriter setNeedsWrite];
 }
 
 - (void)saveInstancePref {
-    [self.instancePref writeToFile:self.instancePath atomically:YES];
+    if (![self.instanceWriter.path isEqualToString:self.instancePath]) {
+        __weak PLPreferences *weakSelf = self;
+        self.instanceWriter = [PLPreferences writerForPath:self.instancePath pref:^{
+            return weakSelf.instancePref;
+        }];
+    }
+    [self.instanceWriter setNeedsWrite];
 }
 
 @end
@@ -1,10 +1,13 @@
+#import "IconStore.h"
 #import "LauncherPreferences.h"
+#import "PLDeferredWriter.h"
 #import "PLProfiles.h"
 #import "utils.h"
 
 static PLProfiles* current;
 
 @interface PLProfiles()
+@property(nonatomic) PLDeferredWriter *writer;
 @end
 
 @implementation PLProfiles
@@ -29,6 +32,8 @@ static PLProfiles* current;
 }
 
 + (void)updateCurrent {
+    // Pending edits must land before the file is read back
+    [current.writer flush];
     current = [[PLProfiles alloc] initWithCurrentInstance];
 }
 
@@ -41,6 +46,7 @@ static PLProfiles* current;
 
     NSDictionary *valueDefaults = @{
         @"javaVersion": @"0",
+        @"profilerInterval": @"0",
         @"gameDir": @"."
     };
     if (valueDefaults[key]) {
@@ -63,15 +69,40 @@ static PLProfiles* current;
 - (id)initWithCurrentInstance {
     self = [super init];
     self.profilePath = [@(getenv("POJAV_GAME_DIR")) stringByAppendingPathComponent:@"launcher_profiles.json"];
+    __weak PLProfiles *weakSelf = self;
+    self.writer = [[PLDeferredWriter alloc] initWithPath:self.profilePath serializer:^NSData *{
+        return [NSJSONSerialization dataWithJSONObject:weakSelf.profileDict options:NSJSONWritingPrettyPrinted error:nil];
+    }];
     self.profileDict = parseJSONFromFile(self.profilePath);
     if (self.profileDict[@"NSErrorObject"]) {
         self.profileDict = PLProfiles.defaultProfiles;
         [self save];
+    } else if ([self migrateIcons]) {
+        [self save];
     }
 
     return self;
 }
 
+// An earlier version replaced data URL icons with "iconstore:" references,
+// which no other launcher understands; put data URLs back
+- (BOOL)migrateIcons {
+    BOOL changed = NO;
+    for (NSMutableDictionary *profile in [self.profiles allValues]) {
+        NSString *icon = profile[@"icon"];
+        NSString *migrated = [IconStore.sharedStore portableIconString:icon];
+        if (migrated != icon) {
+            if (migrated) {
+                profile[@"icon"] = migrated;
+            } else {
+                [profile removeObjectForKey:@"icon"];
+            }
+            changed = YES;
+        }
+    }
+    return changed;
+}
+
 - (id)profiles {
     return self.profileDict[@"profiles"];
 }
@@ -90,7 +121,7 @@ static PLProfiles* current;
 }
 
 - (void)save {
-    saveJSONToFile(self.profileDict, self.profilePath);
+    [self.writer setNeedsWrite];
 }
 
 @end
@@ -15,6 +15,7 @@
 #import "JavaLauncher.h"
 #import "LauncherPreferences.h"
 #import "MinecraftResourceUtils.h"
+#import "PLDeferredWriter.h"
 #import "PLProfiles.h"
 #import "SurfaceViewController.h"
 #import "TrackedTextField.h"
@@ -26,9 +27,6 @@
 
 #include <dlfcn.h>
 
-int memorystatus_control(uint32_t command, int32_t pid, uint32_t flags, void *buffer, size_t buffersize);
-#define MEMORYSTATUS_CMD_SET_JETSAM_TASK_LIMIT        6
-
 static int currentHotbarSlot = -1;
 static GameSurfaceView* pojavWindow;
 
@@ -261,7 +259,6 @@ static GameSurfaceView* pojavWindow;
     [self performSelector:@selector(initCategory_LogView)];
 
     // [self setPreferredFramesPerSecond:1000];
-    [self updateJetsamControl];
     [self updatePreferenceChanges];
     [self loadCustomControls];
 
@@ -298,19 +295,6 @@ static GameSurfaceView* pojavWindow;
     [session setActive:YES error:&sessionError];
 }
 
-- (void)updateJetsamControl {
-    if (!getEntitlementValue(@"com.apple.private.memorystatus")) {
-        return;
-    }
-    // More 1024MB is necessary for other memory regions (native, Java GC, etc.)
-    int limit = getPrefInt(@"java.allocated_memory") + 1024;
-    if (memorystatus_control(MEMORYSTATUS_CMD_SET_JETSAM_TASK_LIMIT, getpid(), limit, NULL, 0) == -1) {
-        NSLog(@"Failed to set Jetsam task limit: error: %s", strerror(errno));
-    } else {
-        NSLog(@"Successfully set Jetsam task limit");
-    }
-}
-
 - (void)updatePreferenceChanges {
     // Update UITextField auto correction
     if (getPrefBool(@"debug.debug_auto_correction")) {
@@ -322,6 +306,7 @@ static GameSurfaceView* pojavWindow;
     BOOL gyroEnabled = getPrefBool(@"control.gyroscope_enable");
     BOOL gyroInvertX = getPrefBool(@"control.gyroscope_invert_x_axis");
     int gyroSensitivity = getPrefInt(@"control.gyroscope_sensitivity");
+    [GyroInput updateSmoothing:getPrefInt(@"control.gyroscope_smoothing") deadzone:getPrefInt(@"control.gyroscope_deadzone")];
     [GyroInput updateSensitivity:gyroEnabled?gyroSensitivity:0 invertXAxis:gyroInvertX];
 
     self.mouseSpeed = getPrefFloat(@"control.mouse_speed") / 100.0;
@@ -428,6 +413,8 @@ static GameSurfaceView* pojavWindow;
 }
 
 - (void)launchMinecraft {
+    // The Java side reads launcher_profiles.json from disk
+    [PLDeferredWriter flushAll];
     dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
         int minVersion = [self.metadata[@"javaVersion"][@"majorVersion"] intValue];
         if (minVersion == 0) {
@@ -921,13 +908,13 @@ static GameSurfaceView* pojavWindow;
         return;
     }
     CGPoint location = [sender locationInView:self.ctrlView];
-    for (ControlButton *button in self.swipeableButtons) {
-        if (CGRectContainsPoint(button.frame, location) && (ControlButton *)self.swipingButton != button) {
-            [self executebtn_up:self.swipingButton isOutside:NO];
-            self.swipingButton = (ControlButton *)button;
-            [self executebtn:self.swipingButton withAction:ACTION_DOWN];
-            break;
-        }
+    ControlButton *button = [self.ctrlView controlAtPoint:location passingTest:^BOOL(ControlButton *control) {
+        return [control.properties[@"isSwipeable"] boolValue];
+    }];
+    if (button && self.swipingButton != button) {
+        [self executebtn_up:self.swipingButton isOutside:NO];
+        self.swipingButton = button;
+        [self executebtn:self.swipingButton withAction:ACTION_DOWN];
     }
 }
 
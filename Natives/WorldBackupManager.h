@@ -0,0 +1,35 @@
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+// Incremental world backups. File contents are split into segments (chunks
+// for region files) and kept once each in a content-addressed store shared by
+// every world of the instance; a snapshot is just a manifest of segment hashes.
+@interface WorldBackupManager : NSObject
+
+@property(nonatomic, readonly) NSString *storePath;
+
+- (instancetype)initWithStorePath:(NSString *)storePath;
+
+// Newest first, each with "name", "date", "files" and "addedBytes"
+- (NSArray<NSDictionary *> *)snapshotsForWorld:(NSString *)world;
+
+// Operations run one at a time, in the order they were requested.
+// Handlers are called on the main queue.
+- (void)backupWorldAtPath:(NSString *)worldPath
+    progress:(nullable void(^)(NSProgress *progress))progressHandler
+    completion:(void(^)(NSError * _Nullable error))completion;
+- (void)restoreSnapshot:(NSString *)snapshot toWorldAtPath:(NSString *)worldPath
+    completion:(void(^)(NSError * _Nullable error))completion;
+- (void)exportSnapshot:(NSString *)snapshot ofWorld:(NSString *)world toZipAtPath:(NSString *)zipPath
+    completion:(void(^)(NSError * _Nullable error))completion;
+
+// Deletes snapshots beyond the newest keepCount of each world, then every
+// segment no remaining snapshot refers to. Returns the bytes freed. These
+// wait for earlier operations to finish, don't call them on the main queue.
+- (unsigned long long)pruneKeepingLast:(NSUInteger)keepCount;
+- (void)deleteSnapshot:(NSString *)snapshot ofWorld:(NSString *)world;
+
+@end
+
+NS_ASSUME_NONNULL_END
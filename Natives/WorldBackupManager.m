@@ -0,0 +1,336 @@
+#import "UnzipKit.h"
+#import "WorldBackupManager.h"
+#include "backup_store.h"
+
+static NSError *backupError(NSString *message) {
+    return [NSError errorWithDomain:@"WorldBackupManager" code:-1
+        userInfo:@{NSLocalizedDescriptionKey: message}];
+}
+
+// Stored and compared as integer milliseconds. Manifests are XML plists,
+// where an NSDate only keeps whole seconds. Version 1 manifests stored those
+// dates, which then never match and just cost one extra re-read.
+static long long backupMTime(id value) {
+    if ([value isKindOfClass:NSNumber.class]) {
+        return [value longLongValue];
+    }
+    return llround([value timeIntervalSince1970] * 1000);
+}
+
+static NSDate *backupMTimeDate(id value) {
+    return [NSDate dateWithTimeIntervalSince1970:backupMTime(value) / 1000.0];
+}
+
+// Backups, restores, exports and pruning of every store run one at a time.
+// Otherwise a prune could delete segments that a backup in flight has just
+// reused but not yet referenced from a manifest.
+static dispatch_queue_t backupQueue() {
+    static dispatch_queue_t queue;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        queue = dispatch_queue_create("WorldBackupManager", dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_UTILITY, 0));
+    });
+    return queue;
+}
+
+@implementation WorldBackupManager
+
+- (instancetype)initWithStorePath:(NSString *)storePath {
+    self = [super init];
+    _storePath = storePath;
+    [NSFileManager.defaultManager createDirectoryAtPath:[storePath stringByAppendingPathComponent:@"objects"]
+        withIntermediateDirectories:YES attributes:nil error:nil];
+    [NSFileManager.defaultManager createDirectoryAtPath:[storePath stringByAppendingPathComponent:@"snapshots"]
+        withIntermediateDirectories:YES attributes:nil error:nil];
+    return self;
+}
+
+#pragma mark Store
+
+- (NSString *)snapshotPath:(NSString *)snapshot ofWorld:(NSString *)world {
+    return [NSString stringWithFormat:@"%@/snapshots/%@/%@.plist", self.storePath, world, snapshot];
+}
+
+- (NSData *)loadObject:(NSString *)hash {
+    size_t length;
+    uint8_t *bytes = backup_load_object(self.storePath.UTF8String, hash.UTF8String, &length);
+    return bytes ? [NSData dataWithBytesNoCopy:bytes length:length freeWhenDone:YES] : nil;
+}
+
+// Splits the file into segments and stores each one, returns their hashes in order
+- (NSArray<NSString *> *)storeFileAtPath:(NSString *)path addedBytes:(unsigned long long *)addedBytes {
+    size_t count;
+    uint64_t added = 0;
+    backup_hash_t *hashes = backup_store_file(self.storePath.UTF8String, path.UTF8String,
+        [path.pathExtension isEqualToString:@"mca"], &count, &added);
+    if (!hashes) {
+        return nil;
+    }
+    NSMutableArray *result = [NSMutableArray arrayWithCapacity:count];
+    for (size_t i = 0; i < count; i++) {
+        [result addObject:@(hashes[i])];
+    }
+    free(hashes);
+    *addedBytes += added;
+    return result;
+}
+
+- (BOOL)writeFileEntry:(NSDictionary *)entry toPath:(NSString *)path {
+    [NSFileManager.defaultManager createDirectoryAtPath:path.stringByDeletingLastPathComponent
+        withIntermediateDirectories:YES attributes:nil error:nil];
+    NSArray<NSString *> *segments = entry[@"segments"];
+    const char **hashes = malloc(MAX(segments.count, 1) * sizeof(char *));
+    for (NSUInteger i = 0; i < segments.count; i++) {
+        hashes[i] = segments[i].UTF8String;
+    }
+    BOOL restored = backup_restore_file(self.storePath.UTF8String, hashes, segments.count, path.UTF8String);
+    free(hashes);
+    if (restored) {
+        [NSFileManager.defaultManager setAttributes:@{NSFileModificationDate: backupMTimeDate(entry[@"mtime"])} ofItemAtPath:path error:nil];
+    }
+    return restored;
+}
+
+#pragma mark Snapshots
+
+- (NSArray<NSDictionary *> *)snapshotsForWorld:(NSString *)world {
+    NSString *directory = [NSString stringWithFormat:@"%@/snapshots/%@", self.storePath, world];
+    NSArray *files = [NSFileManager.defaultManager contentsOfDirectoryAtPath:directory error:nil];
+    NSMutableArray *snapshots = [NSMutableArray new];
+    // Names are timestamps, so they sort by age
+    for (NSString *file in [files sortedArrayUsingSelector:@selector(compare:)].reverseObjectEnumerator) {
+        if (![file.pathExtension isEqualToString:@"plist"]) continue;
+        NSDictionary *manifest = [NSDictionary dictionaryWithContentsOfFile:[directory stringByAppendingPathComponent:file]];
+        if (!manifest) continue;
+        [snapshots addObject:@{
+            @"name": file.stringByDeletingPathExtension,
+            @"date": manifest[@"date"],
+            @"files": @([manifest[@"files"] count]),
+            @"addedBytes": manifest[@"addedBytes"]
+        }];
+    }
+    return snapshots;
+}
+
+- (void)backupWorldAtPath:(NSString *)worldPath progress:(void(^)(NSProgress *progress))progressHandler completion:(void(^)(NSError *error))completion {
+    NSString *world = worldPath.lastPathComponent;
+    dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_UTILITY, 0);
+    dispatch_async(backupQueue(), ^{
+        NSDictionary *previousFiles;
+        NSString *latest = [self snapshotsForWorld:world].firstObject[@"name"];
+        if (latest) {
+            previousFiles = [NSDictionary dictionaryWithContentsOfFile:[self snapshotPath:latest ofWorld:world]][@"files"];
+        }
+
+        // Files whose size and modification time didn't change reuse the previous entry
+        NSMutableDictionary *files = [NSMutableDictionary new];
+        NSMutableArray *changed = [NSMutableArray new];
+        NSDirectoryEnumerator *enumerator = [NSFileManager.defaultManager enumeratorAtPath:worldPath];
+        for (NSString *file in enumerator) {
+            NSDictionary *attributes = enumerator.fileAttributes;
+            if (![attributes.fileType isEqualToString:NSFileTypeRegular] ||
+                [file isEqualToString:@"session.lock"]) {
+                continue;
+            }
+            NSDictionary *previous = previousFiles[file];
+            if (previous && [previous[@"size"] unsignedLongLongValue] == attributes.fileSize &&
+                backupMTime(previous[@"mtime"]) == backupMTime(attributes.fileModificationDate)) {
+                files[file] = previous;
+            } else {
+                [changed addObject:@[file, attributes]];
+            }
+        }
+
+        NSProgress *progress = [NSProgress progressWithTotalUnitCount:changed.count];
+        __block unsigned long long addedBytes = 0;
+        __block NSError *error;
+        NSLock *lock = [NSLock new];
+        dispatch_apply(changed.count, queue, ^(size_t i) {
+            NSString *file = changed[i][0];
+            NSDictionary *attributes = changed[i][1];
+            unsigned long long fileAddedBytes = 0;
+            NSArray *hashes = [self storeFileAtPath:[worldPath stringByAppendingPathComponent:file] addedBytes:&fileAddedBytes];
+
+            [lock lock];
+            if (hashes) {
+                files[file] = @{
+                    @"size": @(attributes.fileSize),
+                    @"mtime": @(backupMTime(attributes.fileModificationDate)),
+                    @"segments": hashes
+                };
+                addedBytes += fileAddedBytes;
+            } else if (!error) {
+                error = backupError([NSString stringWithFormat:@"Failed to back up %@", file]);
+            }
+            progress.completedUnitCount++;
+            [lock unlock];
+            if (progressHandler) {
+                dispatch_async(dispatch_get_main_queue(), ^{
+                    progressHandler(progress);
+                });
+            }
+        });
+
+        if (!error) {
+            // Milliseconds keep names unique and still sorting by age; the
+            // suffix covers another process backing up the same world
+            NSDateFormatter *formatter = [NSDateFormatter new];
+            formatter.dateFormat = @"yyyyMMdd-HHmmss-SSS";
+            formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+            NSDate *date = NSDate.date;
+            NSString *name = [formatter stringFromDate:date];
+            NSString *path = [self snapshotPath:name ofWorld:world];
+            for (int i = 1; [NSFileManager.defaultManager fileExistsAtPath:path]; i++) {
+                path = [self snapshotPath:[NSString stringWithFormat:@"%@-%d", name, i] ofWorld:world];
+            }
+            [NSFileManager.defaultManager createDirectoryAtPath:path.stringByDeletingLastPathComponent
+                withIntermediateDirectories:YES attributes:nil error:nil];
+            NSDictionary *manifest = @{
+                @"version": @(2),
+                @"date": date,
+                @"addedBytes": @(addedBytes),
+                @"files": files
+            };
+            if (![manifest writeToFile:path atomically:YES]) {
+                error = backupError(@"Failed to write snapshot");
+            }
+        }
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(error);
+        });
+    });
+}
+
+- (void)restoreSnapshot:(NSString *)snapshot toWorldAtPath:(NSString *)worldPath completion:(void(^)(NSError *error))completion {
+    NSString *world = worldPath.lastPathComponent;
+    dispatch_queue_t queue = dispatch_get_global_queue(QOS_CLASS_UTILITY, 0);
+    dispatch_async(backupQueue(), ^{
+        NSDictionary *files = [NSDictionary dictionaryWithContentsOfFile:[self snapshotPath:snapshot ofWorld:world]][@"files"];
+        if (!files) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completion(backupError(@"Snapshot not found"));
+            });
+            return;
+        }
+
+        // Drop files the snapshot doesn't have
+        NSMutableArray *extraFiles = [NSMutableArray new];
+        NSDirectoryEnumerator *enumerator = [NSFileManager.defaultManager enumeratorAtPath:worldPath];
+        for (NSString *file in enumerator) {
+            if ([enumerator.fileAttributes.fileType isEqualToString:NSFileTypeRegular] &&
+                !files[file] && ![file isEqualToString:@"session.lock"]) {
+                [extraFiles addObject:file];
+            }
+        }
+        for (NSString *file in extraFiles) {
+            [NSFileManager.defaultManager removeItemAtPath:[worldPath stringByAppendingPathComponent:file] error:nil];
+        }
+
+        // Only rewrite files that differ from the snapshot
+        NSArray *paths = files.allKeys;
+        __block NSError *error;
+        NSLock *lock = [NSLock new];
+        dispatch_apply(paths.count, queue, ^(size_t i) {
+            NSDictionary *entry = files[paths[i]];
+            NSString *path = [worldPath stringByAppendingPathComponent:paths[i]];
+            NSDictionary *attributes = [NSFileManager.defaultManager attributesOfItemAtPath:path error:nil];
+            if (attributes && attributes.fileSize == [entry[@"size"] unsignedLongLongValue] &&
+                backupMTime(attributes.fileModificationDate) == backupMTime(entry[@"mtime"])) {
+                return;
+            }
+            if (![self writeFileEntry:entry toPath:path]) {
+                [lock lock];
+                error = error ?: backupError([NSString stringWithFormat:@"Failed to restore %@", paths[i]]);
+                [lock unlock];
+            }
+        });
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(error);
+        });
+    });
+}
+
+- (void)exportSnapshot:(NSString *)snapshot ofWorld:(NSString *)world toZipAtPath:(NSString *)zipPath completion:(void(^)(NSError *error))completion {
+    dispatch_async(backupQueue(), ^{
+        NSDictionary *files = [NSDictionary dictionaryWithContentsOfFile:[self snapshotPath:snapshot ofWorld:world]][@"files"];
+        NSError *error;
+        UZKArchive *zip = files ? [[UZKArchive alloc] initWithPath:zipPath error:&error] : nil;
+        if (!zip) {
+            error = error ?: backupError(@"Snapshot not found");
+        }
+        for (NSString *file in files) {
+            if (error) break;
+            NSMutableData *data = [NSMutableData dataWithCapacity:[files[file][@"size"] unsignedLongLongValue]];
+            for (NSString *hash in files[file][@"segments"]) {
+                NSData *segment = [self loadObject:hash];
+                if (!segment) {
+                    error = backupError([NSString stringWithFormat:@"Missing data for %@", file]);
+                    break;
+                }
+                [data appendData:segment];
+            }
+            if (!error && ![zip writeData:data filePath:[world stringByAppendingPathComponent:file]
+                fileDate:backupMTimeDate(files[file][@"mtime"]) error:&error]) {
+                error = error ?: backupError([NSString stringWithFormat:@"Failed to archive %@", file]);
+            }
+        }
+        if (error) {
+            [NSFileManager.defaultManager removeItemAtPath:zipPath error:nil];
+        }
+        dispatch_async(dispatch_get_main_queue(), ^{
+            completion(error);
+        });
+    });
+}
+
+- (unsigned long long)pruneKeepingLast:(NSUInteger)keepCount {
+    __block unsigned long long freedBytes;
+    dispatch_sync(backupQueue(), ^{
+        freedBytes = [self pruneLockedKeepingLast:keepCount];
+    });
+    return freedBytes;
+}
+
+// Runs on backupQueue
+- (unsigned long long)pruneLockedKeepingLast:(NSUInteger)keepCount {
+    NSFileManager *fm = NSFileManager.defaultManager;
+    NSString *snapshotsPath = [self.storePath stringByAppendingPathComponent:@"snapshots"];
+    NSMutableSet *referenced = [NSMutableSet new];
+    for (NSString *world in [fm contentsOfDirectoryAtPath:snapshotsPath error:nil]) {
+        NSArray *snapshots = [self snapshotsForWorld:world];
+        for (NSUInteger i = 0; i < snapshots.count; i++) {
+            NSString *path = [self snapshotPath:snapshots[i][@"name"] ofWorld:world];
+            if (i >= keepCount) {
+                [fm removeItemAtPath:path error:nil];
+                continue;
+            }
+            NSDictionary *files = [NSDictionary dictionaryWithContentsOfFile:path][@"files"];
+            for (NSString *file in files) {
+                [referenced addObjectsFromArray:files[file][@"segments"]];
+            }
+        }
+    }
+
+    unsigned long long freedBytes = 0;
+    NSString *objectsPath = [self.storePath stringByAppendingPathComponent:@"objects"];
+    NSDirectoryEnumerator *enumerator = [fm enumeratorAtPath:objectsPath];
+    for (NSString *file in enumerator) {
+        // Skips directories and objects still being written
+        if (file.pathComponents.count != 2 || file.pathExtension.length > 0) continue;
+        NSString *hash = [file stringByReplacingOccurrencesOfString:@"/" withString:@""];
+        if (![referenced containsObject:hash]) {
+            freedBytes += enumerator.fileAttributes.fileSize;
+            [fm removeItemAtPath:[objectsPath stringByAppendingPathComponent:file] error:nil];
+        }
+    }
+    return freedBytes;
+}
+
+- (void)deleteSnapshot:(NSString *)snapshot ofWorld:(NSString *)world {
+    dispatch_sync(backupQueue(), ^{
+        [NSFileManager.defaultManager removeItemAtPath:[self snapshotPath:snapshot ofWorld:world] error:nil];
+        [self pruneLockedKeepingLast:NSUIntegerMax];
+    });
+}
+
+@end
@@ -0,0 +1,224 @@
+#import "LauncherPreferences.h"
+#import "PLProfiles.h"
+#import "WorldBackupManager.h"
+#import "WorldBackupViewController.h"
+#import "ios_uikit_bridge.h"
+#import "utils.h"
+
+// Snapshots kept per world by the prune action
+#define BACKUP_PRUNE_KEEP 5
+
+@interface WorldBackupViewController ()
+@property(nonatomic) WorldBackupManager *manager;
+@property(nonatomic) NSString *savesPath;
+@property(nonatomic) NSArray<NSString *> *worlds;
+@property(nonatomic) NSMutableDictionary<NSString *, NSArray *> *snapshots;
+// Only one backup, restore or export runs at a time
+@property(nonatomic) NSString *busyWorld;
+@property(nonatomic) NSString *busyStatus;
+@end
+
+@implementation WorldBackupViewController
+
+- (void)viewDidLoad {
+    [super viewDidLoad];
+    [self setTitle:localize(@"profile.title.world_backups", nil)];
+
+    self.tableView = [[UITableView alloc] initWithFrame:CGRectZero style:UITableViewStyleInsetGrouped];
+    self.navigationItem.rightBarButtonItem = [[UIBarButtonItem alloc]
+        initWithBarButtonSystemItem:UIBarButtonSystemItemTrash
+        target:self action:@selector(actionPrune)];
+
+    // Same resolution as the launch path, backups are shared by every profile of the instance
+    NSString *instancePath = [NSString stringWithFormat:@"%s/instances/%@",
+        getenv("POJAV_HOME"), getPrefObject(@"general.game_directory")];
+    NSString *gameDir = [instancePath stringByAppendingPathComponent:
+        [PLProfiles resolveKeyForCurrentProfile:@"gameDir"]].stringByStandardizingPath;
+    self.savesPath = [gameDir stringByAppendingPathComponent:@"saves"];
+    self.manager = [[WorldBackupManager alloc] initWithStorePath:[instancePath stringByAppendingPathComponent:@"backups"]];
+    [self reloadWorlds];
+}
+
+- (void)reloadWorlds {
+    NSMutableArray *worlds = [NSMutableArray new];
+    for (NSString *world in [NSFileManager.defaultManager contentsOfDirectoryAtPath:self.savesPath error:nil]) {
+        NSString *levelPath = [NSString stringWithFormat:@"%@/%@/level.dat", self.savesPath, world];
+        if ([NSFileManager.defaultManager fileExistsAtPath:levelPath]) {
+            [worlds addObject:world];
+        }
+    }
+    self.worlds = [worlds sortedArrayUsingSelector:@selector(localizedStandardCompare:)];
+    self.snapshots = [NSMutableDictionary new];
+    for (NSString *world in self.worlds) {
+        self.snapshots[world] = [self.manager snapshotsForWorld:world];
+    }
+    [self.tableView reloadData];
+}
+
+- (NSString *)worldPath:(NSString *)world {
+    return [self.savesPath stringByAppendingPathComponent:world];
+}
+
+- (void)setBusyWorld:(NSString *)world status:(NSString *)status {
+    self.busyWorld = world;
+    self.busyStatus = status;
+    self.navigationItem.rightBarButtonItem.enabled = world == nil;
+    [self.tableView reloadData];
+}
+
+- (void)finishOperation:(NSError *)error {
+    [self setBusyWorld:nil status:nil];
+    if (error) {
+        showDialog(localize(@"Error", nil), error.localizedDescription);
+    }
+    [self reloadWorlds];
+}
+
+#pragma mark Actions
+
+- (void)actionBackupWorld:(NSString *)world {
+    [self setBusyWorld:world status:localize(@"world_backup.status.preparing", nil)];
+    [self.manager backupWorldAtPath:[self worldPath:world] progress:^(NSProgress *progress) {
+        self.busyStatus = [NSString stringWithFormat:localize(@"world_backup.status.backing_up", nil),
+            (int)(progress.fractionCompleted * 100)];
+        [self.tableView reloadSections:[NSIndexSet indexSetWithIndex:[self.worlds indexOfObject:world]]
+            withRowAnimation:UITableViewRowAnimationNone];
+    } completion:^(NSError *error) {
+        [self finishOperation:error];
+    }];
+}
+
+- (void)actionRestoreSnapshot:(NSDictionary *)snapshot ofWorld:(NSString *)world {
+    NSString *message = [NSString stringWithFormat:localize(@"world_backup.confirm.restore", nil), world];
+    UIAlertController *alert = [UIAlertController alertControllerWithTitle:localize(@"preference.title.confirm", nil)
+        message:message preferredStyle:UIAlertControllerStyleAlert];
+    [alert addAction:[UIAlertAction actionWithTitle:localize(@"Cancel", nil) style:UIAlertActionStyleCancel handler:nil]];
+    [alert addAction:[UIAlertAction actionWithTitle:localize(@"world_backup.action.restore", nil) style:UIAlertActionStyleDestructive handler:^(UIAlertAction *action) {
+        [self setBusyWorld:world status:localize(@"world_backup.status.restoring", nil)];
+        [self.manager restoreSnapshot:snapshot[@"name"] toWorldAtPath:[self worldPath:world] completion:^(NSError *error) {
+            [self finishOperation:error];
+        }];
+    }]];
+    [self presentViewController:alert animated:YES completion:nil];
+}
+
+- (void)actionExportSnapshot:(NSDictionary *)snapshot ofWorld:(NSString *)world sourceView:(UIView *)sourceView {
+    NSString *zipPath = [NSString stringWithFormat:@"%@/%@-%@.zip", NSTemporaryDirectory(), world, snapshot[@"name"]];
+    [self setBusyWorld:world status:localize(@"world_backup.status.exporting", nil)];
+    [self.manager exportSnapshot:snapshot[@"name"] ofWorld:world toZipAtPath:zipPath completion:^(NSError *error) {
+        [self finishOperation:error];
+        if (error) return;
+        UIActivityViewController *activityVC = [[UIActivityViewController alloc]
+            initWithActivityItems:@[[NSURL fileURLWithPath:zipPath]] applicationActivities:nil];
+        activityVC.completionWithItemsHandler = ^(UIActivityType type, BOOL completed, NSArray *items, NSError *activityError) {
+            [NSFileManager.defaultManager removeItemAtPath:zipPath error:nil];
+        };
+        activityVC.popoverPresentationController.sourceView = sourceView;
+        activityVC.popoverPresentationController.sourceRect = sourceView.bounds;
+        [self presentViewController:activityVC animated:YES completion:nil];
+    }];
+}
+
+- (void)actionPrune {
+    NSString *message = [NSString stringWithFormat:localize(@"world_backup.confirm.prune", nil), BACKUP_PRUNE_KEEP];
+    UIAlertController *alert = [UIAlertController alertControllerWithTitle:localize(@"world_backup.action.prune", nil)
+        message:message preferredStyle:UIAlertControllerStyleAlert];
+    [alert addAction:[UIAlertAction actionWithTitle:localize(@"Cancel", nil) style:UIAlertActionStyleCancel handler:nil]];
+    [alert addAction:[UIAlertAction actionWithTitle:localize(@"OK", nil) style:UIAlertActionStyleDestructive handler:^(UIAlertAction *action) {
+        [self setBusyWorld:@"" status:nil];
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+            unsigned long long freed = [self.manager pruneKeepingLast:BACKUP_PRUNE_KEEP];
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [self finishOperation:nil];
+                showDialog(localize(@"world_backup.action.prune", nil), [NSString stringWithFormat:
+                    localize(@"world_backup.status.pruned", nil),
+                    [NSByteCountFormatter stringFromByteCount:freed countStyle:NSByteCountFormatterCountStyleFile]]);
+            });
+        });
+    }]];
+    [self presentViewController:alert animated:YES completion:nil];
+}
+
+#pragma mark Table view
+
+- (NSInteger)numberOfSectionsInTableView:(UITableView *)tableView {
+    return self.worlds.count;
+}
+
+- (NSString *)tableView:(UITableView *)tableView titleForHeaderInSection:(NSInteger)section {
+    return self.worlds[section];
+}
+
+- (NSString *)tableView:(UITableView *)tableView titleForFooterInSection:(NSInteger)section {
+    if (self.worlds.count == 0) {
+        return localize(@"world_backup.empty", nil);
+    }
+    return nil;
+}
+
+- (NSInteger)tableView:(UITableView *)tableView numberOfRowsInSection:(NSInteger)section {
+    // Backup action, then snapshots newest first
+    return 1 + self.snapshots[self.worlds[section]].count;
+}
+
+- (UITableViewCell *)tableView:(UITableView *)tableView cellForRowAtIndexPath:(NSIndexPath *)indexPath {
+    UITableViewCell *cell = [tableView dequeueReusableCellWithIdentifier:@"cell"];
+    if (cell == nil) {
+        cell = [[UITableViewCell alloc] initWithStyle:UITableViewCellStyleSubtitle reuseIdentifier:@"cell"];
+    }
+
+    NSString *world = self.worlds[indexPath.section];
+    BOOL busy = self.busyWorld != nil;
+    cell.userInteractionEnabled = !busy;
+    if (indexPath.row == 0) {
+        cell.imageView.image = [UIImage systemImageNamed:@"externaldrive.badge.plus"];
+        cell.textLabel.text = localize(@"world_backup.action.backup", nil);
+        cell.detailTextLabel.text = [self.busyWorld isEqualToString:world] ? self.busyStatus : nil;
+    } else {
+        NSDictionary *snapshot = self.snapshots[world][indexPath.row - 1];
+        cell.imageView.image = [UIImage systemImageNamed:@"clock.arrow.circlepath"];
+        cell.textLabel.text = [NSDateFormatter localizedStringFromDate:snapshot[@"date"]
+            dateStyle:NSDateFormatterMediumStyle timeStyle:NSDateFormatterShortStyle];
+        cell.detailTextLabel.text = [NSString stringWithFormat:localize(@"world_backup.detail.snapshot", nil),
+            [snapshot[@"files"] intValue],
+            [NSByteCountFormatter stringFromByteCount:[snapshot[@"addedBytes"] longLongValue]
+                countStyle:NSByteCountFormatterCountStyleFile]];
+    }
+    cell.textLabel.enabled = cell.detailTextLabel.enabled = !busy;
+    return cell;
+}
+
+- (void)tableView:(UITableView *)tableView didSelectRowAtIndexPath:(NSIndexPath *)indexPath {
+    [tableView deselectRowAtIndexPath:indexPath animated:NO];
+    NSString *world = self.worlds[indexPath.section];
+    if (indexPath.row == 0) {
+        [self actionBackupWorld:world];
+        return;
+    }
+
+    NSDictionary *snapshot = self.snapshots[world][indexPath.row - 1];
+    UITableViewCell *cell = [tableView cellForRowAtIndexPath:indexPath];
+    UIAlertController *sheet = [UIAlertController alertControllerWithTitle:cell.textLabel.text
+        message:nil preferredStyle:UIAlertControllerStyleActionSheet];
+    sheet.popoverPresentationController.sourceView = cell;
+    sheet.popoverPresentationController.sourceRect = cell.bounds;
+    [sheet addAction:[UIAlertAction actionWithTitle:localize(@"world_backup.action.restore", nil) style:UIAlertActionStyleDefault handler:^(UIAlertAction *action) {
+        [self actionRestoreSnapshot:snapshot ofWorld:world];
+    }]];
+    [sheet addAction:[UIAlertAction actionWithTitle:localize(@"world_backup.action.export", nil) style:UIAlertActionStyleDefault handler:^(UIAlertAction *action) {
+        [self actionExportSnapshot:snapshot ofWorld:world sourceView:cell];
+    }]];
+    [sheet addAction:[UIAlertAction actionWithTitle:localize(@"Delete", nil) style:UIAlertActionStyleDestructive handler:^(UIAlertAction *action) {
+        [self setBusyWorld:world status:nil];
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_UTILITY, 0), ^{
+            [self.manager deleteSnapshot:snapshot[@"name"] ofWorld:world];
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [self finishOperation:nil];
+            });
+        });
+    }]];
+    [sheet addAction:[UIAlertAction actionWithTitle:localize(@"Cancel", nil) style:UIAlertActionStyleCancel handler:nil]];
+    [self presentViewController:sheet animated:YES completion:nil];
+}
+
+@end
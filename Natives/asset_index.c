@@ -0,0 +1,251 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "asset_index.h"
+#include "file_stamp.h"
+#include "json_cursor.h"
+
+#define ASSET_INDEX_MAGIC "AIDX"
+// 2: sourceMtime in nanoseconds
+#define ASSET_INDEX_VERSION 2
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t count;
+    uint32_t flags;
+    uint64_t sourceSize;
+    int64_t sourceMtimeNs;
+    uint32_t namesOffset, namesLength;
+    uint32_t verifiedOffset, reserved;
+} asset_index_header_t;
+
+struct asset_index {
+    uint8_t *map;
+    size_t mapLength;
+    const asset_index_header_t *header;
+    const asset_object_t *objects;
+    const char *names;
+    uint8_t *verified;
+};
+
+static int asset_hash_compare(const void *a, const void *b) {
+    return memcmp(((const asset_object_t *)a)->hash, ((const asset_object_t *)b)->hash, 20);
+}
+
+static bool asset_hash_from_hex(const char *hex, size_t length, uint8_t hash[20]) {
+    if (length != 40) return false;
+    for (int i = 0; i < 40; i++) {
+        char c = hex[i];
+        int value;
+        if (c >= '0' && c <= '9') value = c - '0';
+        else if (c >= 'a' && c <= 'f') value = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value = c - 'A' + 10;
+        else return false;
+        if (i % 2 == 0) hash[i / 2] = value << 4;
+        else hash[i / 2] |= value;
+    }
+    return true;
+}
+
+void asset_hash_to_hex(const uint8_t hash[20], char hex[41]) {
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < 20; i++) {
+        hex[i * 2] = digits[hash[i] >> 4];
+        hex[i * 2 + 1] = digits[hash[i] & 0xF];
+    }
+    hex[40] = '\0';
+}
+
+static void *asset_map_file(const char *path, int flags, size_t *length, struct stat *st) {
+    int fd = open(path, flags);
+    if (fd < 0) return NULL;
+    void *map = MAP_FAILED;
+    if (fstat(fd, st) == 0 && st->st_size > 0) {
+        int prot = flags == O_RDWR ? PROT_READ | PROT_WRITE : PROT_READ;
+        map = mmap(NULL, st->st_size, prot, flags == O_RDWR ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+    *length = st->st_size;
+    return map;
+}
+
+int asset_index_compile(const char *jsonPath, const char *binPath) {
+    struct stat st;
+    size_t jsonLength;
+    const char *json = asset_map_file(jsonPath, O_RDONLY, &jsonLength, &st);
+    if (!json) return errno ? errno : EINVAL;
+
+    asset_index_header_t header = {
+        .magic = ASSET_INDEX_MAGIC,
+        .version = ASSET_INDEX_VERSION,
+        .sourceSize = st.st_size,
+        .sourceMtimeNs = file_stamp_mtime_ns(&st)
+    };
+
+    json_cursor_t cursor;
+    json_cursor_init(&cursor, json, jsonLength);
+    if (json_enter_object(&cursor) && json_find_key(&cursor, "map_to_resources")) {
+        bool value;
+        if (json_read_bool(&cursor, &value) && value) {
+            header.flags |= ASSET_INDEX_MAP_TO_RESOURCES;
+        }
+    }
+
+    size_t capacity = 4096, count = 0;
+    size_t namesCapacity = 256 * 1024, namesLength = 0;
+    asset_object_t *objects = malloc(capacity * sizeof(asset_object_t));
+    char *names = malloc(namesCapacity);
+    int result = 0;
+
+    json_cursor_init(&cursor, json, jsonLength);
+    if (!json_enter_object(&cursor) || !json_find_key(&cursor, "objects") || !json_enter_object(&cursor)) {
+        result = EINVAL;
+        goto done;
+    }
+
+    json_string_t key;
+    while (json_next_key(&cursor, &key)) {
+        if (namesLength + key.length * 4 + 1 > namesCapacity) {
+            namesCapacity = (namesCapacity + key.length * 4 + 1) * 2;
+            names = realloc(names, namesCapacity);
+        }
+        size_t nameLength = json_string_copy(key, names + namesLength, namesCapacity - namesLength);
+        if (nameLength == (size_t)-1 || !json_enter_object(&cursor)) {
+            result = EINVAL;
+            goto done;
+        }
+
+        asset_object_t object = {.nameOffset = (uint32_t)namesLength, .nameLength = (uint32_t)nameLength};
+        bool hasHash = false;
+        json_string_t field, value;
+        while (json_next_key(&cursor, &field)) {
+            uint64_t size;
+            if (json_string_equals(field, "hash") && json_read_string(&cursor, &value)) {
+                hasHash = asset_hash_from_hex(value.start, value.length, object.hash);
+            } else if (json_string_equals(field, "size") && json_read_uint64(&cursor, &size)) {
+                object.size = (uint32_t)size;
+            } else {
+                json_skip_value(&cursor);
+            }
+        }
+        if (!hasHash) continue;
+
+        if (count == capacity) {
+            capacity *= 2;
+            objects = realloc(objects, capacity * sizeof(asset_object_t));
+        }
+        objects[count++] = object;
+        namesLength += nameLength + 1;
+    }
+    qsort(objects, count, sizeof(asset_object_t), asset_hash_compare);
+
+    header.count = (uint32_t)count;
+    header.namesOffset = sizeof(header) + count * sizeof(asset_object_t);
+    header.namesLength = (uint32_t)namesLength;
+    header.verifiedOffset = header.namesOffset + (uint32_t)namesLength;
+    size_t verifiedLength = (count + 7) / 8;
+
+    // Written aside and renamed over, a reader never maps a half-written table
+    char tmpPath[PATH_MAX];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", binPath);
+    FILE *file = fopen(tmpPath, "wb");
+    if (!file) {
+        result = errno;
+        goto done;
+    }
+    uint8_t *verified = calloc(1, verifiedLength + 1);
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(objects, sizeof(asset_object_t), count, file) == count &&
+        fwrite(names, 1, namesLength, file) == namesLength &&
+        fwrite(verified, 1, verifiedLength, file) == verifiedLength;
+    free(verified);
+    if (fclose(file) != 0 || !written || rename(tmpPath, binPath) != 0) {
+        result = errno ? errno : EIO;
+        unlink(tmpPath);
+    }
+
+done:
+    free(objects);
+    free(names);
+    munmap((void *)json, jsonLength);
+    return result;
+}
+
+asset_index_t *asset_index_open(const char *binPath, const char *jsonPath) {
+    struct stat jsonStat, st;
+    if (stat(jsonPath, &jsonStat) != 0) return NULL;
+
+    size_t length;
+    uint8_t *map = asset_map_file(binPath, O_RDWR, &length, &st);
+    if (!map) return NULL;
+
+    const asset_index_header_t *header = (const asset_index_header_t *)map;
+    if (length < sizeof(*header) || memcmp(header->magic, ASSET_INDEX_MAGIC, 4) ||
+        header->version != ASSET_INDEX_VERSION ||
+        header->sourceSize != (uint64_t)jsonStat.st_size || header->sourceMtimeNs != file_stamp_mtime_ns(&jsonStat) ||
+        header->namesOffset != sizeof(*header) + (uint64_t)header->count * sizeof(asset_object_t) ||
+        header->verifiedOffset != (uint64_t)header->namesOffset + header->namesLength ||
+        length < header->verifiedOffset + ((uint64_t)header->count + 7) / 8) {
+        munmap(map, length);
+        return NULL;
+    }
+
+    asset_index_t *index = malloc(sizeof(asset_index_t));
+    index->map = map;
+    index->mapLength = length;
+    index->header = header;
+    index->objects = (const asset_object_t *)(map + sizeof(*header));
+    index->names = (const char *)map + header->namesOffset;
+    index->verified = map + header->verifiedOffset;
+    return index;
+}
+
+void asset_index_close(asset_index_t *index) {
+    if (!index) return;
+    msync(index->map, index->mapLength, MS_ASYNC);
+    munmap(index->map, index->mapLength);
+    free(index);
+}
+
+size_t asset_index_count(const asset_index_t *index) {
+    return index->header->count;
+}
+
+uint32_t asset_index_flags(const asset_index_t *index) {
+    return index->header->flags;
+}
+
+const asset_object_t *asset_index_object(const asset_index_t *index, size_t i) {
+    return &index->objects[i];
+}
+
+const char *asset_index_name(const asset_index_t *index, const asset_object_t *object) {
+    return index->names + object->nameOffset;
+}
+
+const asset_object_t *asset_index_find(const asset_index_t *index, const uint8_t hash[20]) {
+    asset_object_t key;
+    memcpy(key.hash, hash, 20);
+    return bsearch(&key, index->objects, index->header->count, sizeof(asset_object_t), asset_hash_compare);
+}
+
+bool asset_index_is_verified(const asset_index_t *index, size_t i) {
+    return index->verified[i / 8] & (1 << (i % 8));
+}
+
+void asset_index_set_verified(asset_index_t *index, size_t i, bool verified) {
+    if (verified) {
+        index->verified[i / 8] |= 1 << (i % 8);
+    } else {
+        index->verified[i / 8] &= ~(1 << (i % 8));
+    }
+}
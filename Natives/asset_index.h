@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Asset indexes compiled from their JSON into a packed table that is mapped
+// straight from disk: fixed-size records sorted by hash, a blob of
+// NUL-terminated names, and one "verified" bit per record that is written back
+// through the mapping. The table remembers the size and nanosecond mtime of
+// the JSON it came from, so a re-downloaded index gets compiled again even
+// within the same second.
+
+#define ASSET_INDEX_MAP_TO_RESOURCES 1
+
+typedef struct {
+    uint8_t hash[20];
+    uint32_t size;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+} asset_object_t;
+
+typedef struct asset_index asset_index_t;
+
+// Returns 0 or an errno (EINVAL for malformed JSON)
+int asset_index_compile(const char *jsonPath, const char *binPath);
+// NULL if binPath is missing, damaged or older than jsonPath
+asset_index_t *asset_index_open(const char *binPath, const char *jsonPath);
+void asset_index_close(asset_index_t *index);
+
+size_t asset_index_count(const asset_index_t *index);
+uint32_t asset_index_flags(const asset_index_t *index);
+const asset_object_t *asset_index_object(const asset_index_t *index, size_t i);
+const char *asset_index_name(const asset_index_t *index, const asset_object_t *object);
+// Any object with this content, or NULL
+const asset_object_t *asset_index_find(const asset_index_t *index, const uint8_t hash[20]);
+
+bool asset_index_is_verified(const asset_index_t *index, size_t i);
+void asset_index_set_verified(asset_index_t *index, size_t i, bool verified);
+
+void asset_hash_to_hex(const uint8_t hash[20], char hex[41]);
@@ -23,7 +23,14 @@ typedef void(^Callback)(id status, BOOL success);
 
 @interface MicrosoftAuthenticator : BaseAuthenticator
 
+// Serves every endpoint as <endpointBaseURL>/<host>/<path> instead, for
+// testing against a local server. nil for the real services.
+@property(class, nonatomic, copy) NSString *endpointBaseURL;
+
 + (void)clearTokenDataOfProfile:(NSString *)profile;
 + (NSDictionary *)tokenDataOfProfile:(NSString *)profile;
+// Renews the token regardless of its expiry, without any UI. Runs on the
+// main queue, and so does the completion.
+- (void)refreshInBackgroundWithCompletion:(void(^)(BOOL success))completion;
 
 @end
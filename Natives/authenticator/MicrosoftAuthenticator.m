@@ -1,13 +1,38 @@
 #import "AFNetworking.h"
 #import "BaseAuthenticator.h"
+#import "TokenRefreshScheduler.h"
 #import "../ios_uikit_bridge.h"
 #import "../utils.h"
 #include "jni.h"
+#include "token_refresh.h"
 
 typedef void(^XSTSCallback)(NSString *xsts, NSString *uhs);
 
+@interface MicrosoftAuthenticator()
+// Set while the scheduler renews a still valid token, nobody is waiting on it.
+// Only changed on the main queue, where AFNetworking also runs the failure
+// block that reads it; atomic since a foreground login may run elsewhere.
+@property(atomic) BOOL refreshingInBackground;
+@end
+
 @implementation MicrosoftAuthenticator
 
+static NSString *endpointBaseURL;
+
++ (NSString *)endpointBaseURL {
+    return endpointBaseURL;
+}
+
++ (void)setEndpointBaseURL:(NSString *)baseURL {
+    endpointBaseURL = baseURL.copy;
+}
+
++ (NSString *)endpoint:(NSString *)url {
+    if (!endpointBaseURL) return url;
+    // Keeps the host as the first path component
+    return [endpointBaseURL stringByAppendingString:[url substringFromIndex:@"https:/".length]];
+}
+
 - (void)acquireAccessToken:(NSString *)authcode refresh:(BOOL)refresh callback:(Callback)callback {
     callback(localize(@"login.msa.progress.acquireAccessToken", nil), YES);
 
@@ -20,11 +45,11 @@ typedef void(^XSTSCallback)(NSString *xsts, NSString *uhs);
     };
 
     AFHTTPSessionManager *manager = AFHTTPSessionManager.manager;
-    [manager GET:@"https://login.live.com/oauth20_token.srf" parameters:data headers:nil progress:nil success:^(NSURLSessionDataTask *task, NSDictionary *response) {
+    [manager GET:[MicrosoftAuthenticator endpoint:@"https://login.live.com/oauth20_token.srf"] parameters:data headers:nil progress:nil success:^(NSURLSessionDataTask *task, NSDictionary *response) {
         self.authData[@"msaRefreshToken"] = response[@"refresh_token"];
         [self acquireXBLToken:response[@"access_token"] callback:callback];
     } failure:^(NSURLSessionDataTask *task, NSError *error) {
-        if (error.code == NSURLErrorDataNotAllowed) {
+        if (error.code == NSURLErrorDataNotAllowed && !self.refreshingInBackground) {
             // The account token is expired and offline
             self.authData[@"accessToken"] = @"offline";
             callback(nil, YES);
@@ -49,7 +74,7 @@ typedef void(^XSTSCallback)(NSString *xsts, NSString *uhs);
 
     AFHTTPSessionManager *manager = AFHTTPSessionManager.manager;
     manager.requestSerializer = AFJSONRequestSerializer.serializer;
-    [manager POST:@"https://user.auth.xboxlive.com/user/authenticate" parameters:data headers:nil progress:nil success:^(NSURLSessionDataTask *task, NSDictionary *response) {
+    [manager POST:[MicrosoftAuthenticator endpoint:@"https://user.auth.xboxlive.com/user/authenticate"] parameters:data headers:nil progress:nil success:^(NSURLSessionDataTask *task, NSDictionary *response) {
         Callback innerCallback = ^(NSString* status, BOOL success) {
             if (!success) {
                 callback(status, NO);
@@ -97,7 +122,7 @@ typedef void(^XSTSCallback)(NSString *xsts, NSString *uhs);
 
     AFHTTPSessionManager *manager = AFHTTPSessionManager.manager;
     manager.requestSerializer = AFJSONRequestSerializer.serializer;
-    [manager POST:@"https://xsts.auth.xboxlive.com/xsts/authorize" parameters:data headers:nil progress:nil success:^(NSURLSessionDataTask *task, NSDictionary *response) {
+    [manager POST:[MicrosoftAuthenticator endpoint:@"https://xsts.auth.xboxlive.com/xsts/authorize"] parameters:data headers:nil progress:nil success:^(NSURLSessionDataTask *task, NSDictionary *response) {
         NSString *uhs = response[@"DisplayClaims"][@"xui"][0][@"uhs"];
         xstsCallback(response[@"Token"], uhs);
     } failure:^(NSURLSessionDataTask *task, NSError *error) {
@@ -140,7 +165,7 @@ typedef void(^XSTSCallback)(NSString *xsts, NSString *uhs);
     };
 
     AFHTTPSessionManager *manager = AFHTTPSessionManager.manager;
-    [manager GET:@"https://profile.xboxlive.com/users/me/profile/settings?settings=PublicGamerpic,Gamertag" parameters:nil headers:headers progress:nil success:^(NSURLSessionDataTask *task, NSDictionary *response) {
+    [manager GET:[MicrosoftAuthenticator endpoint:@"https://profile.xboxlive.com/users/me/profile/settings?settings=PublicGamerpic,Gamertag"] parameters:nil headers:headers progress:nil success:^(NSURLSessionDataTask *task, NSDictionary *response) {
         self.authData[@"profilePicURL"] = [NSString stringWithFormat:@"%@&h=120&w=120", response[@"profileUsers"][0][@"settings"][0][@"value"]];
         self.authData[@"xboxGamertag"] = response[@"profileUsers"][0][@"settings"][1][@"value"];
         callback(nil, YES);
@@ -158,16 +183,20 @@ typedef void(^XSTSCallback)(NSString *xsts, NSString *uhs);
 
     AFHTTPSessionManager *manager = AFHTTPSessionManager.manager;
     manager.requestSerializer = AFJSONRequestSerializer.serializer;
-    [manager POST:@"https://api.minecraftservices.com/authentication/login_with_xbox" parameters:data headers:nil progress:nil success:^(NSURLSessionDataTask *task, NSDictionary *response) {
+    // The token's lifetime counts from the request, not from when the answer came in
+    NSTimeInterval requestedAt = NSDate.date.timeIntervalSince1970;
+    [manager POST:[MicrosoftAuthenticator endpoint:@"https://api.minecraftservices.com/authentication/login_with_xbox"] parameters:data headers:nil progress:nil success:^(NSURLSessionDataTask *task, NSDictionary *response) {
         self.authData[@"accessToken"] = response[@"access_token"];
-        [self checkMCProfile:response[@"access_token"] callback:callback];
+        double expiresAt = token_refresh_expiry(requestedAt, [response[@"expires_in"] doubleValue]);
+        [self checkMCProfile:response[@"access_token"] expiresAt:expiresAt callback:callback];
     } failure:^(NSURLSessionDataTask *task, NSError *error) {
         callback(error, NO);
     }];
 }
 
-- (void)checkMCProfile:(NSString *)mcAccessToken callback:(Callback)callback {
-    self.authData[@"expiresAt"] = @((long)[NSDate.date timeIntervalSince1970] + 86400);
+- (void)checkMCProfile:(NSString *)mcAccessToken expiresAt:(NSTimeInterval)expiry callback:(Callback)callback {
+    // Only committed together with the token, a failed refresh must not extend the old one
+    NSNumber *expiresAt = @((long)expiry);
 
     callback(localize(@"login.msa.progress.checkMCProfile", nil), YES);
 
@@ -176,7 +205,7 @@ typedef void(^XSTSCallback)(NSString *xsts, NSString *uhs);
     };
     AFHTTPSessionManager *manager = AFHTTPSessionManager.manager;
     manager.requestSerializer = AFJSONRequestSerializer.serializer;
-    [manager GET:@"https://api.minecraftservices.com/minecraft/profile" parameters:nil headers:headers progress:nil success:^(NSURLSessionDataTask *task, NSDictionary *response) {
+    [manager GET:[MicrosoftAuthenticator endpoint:@"https://api.minecraftservices.com/minecraft/profile"] parameters:nil headers:headers progress:nil success:^(NSURLSessionDataTask *task, NSDictionary *response) {
         NSString *uuid = response[@"id"];
         self.authData[@"profileId"] = [NSString stringWithFormat:@"%@-%@-%@-%@-%@",
             [uuid substringWithRange:NSMakeRange(0, 8)],
@@ -188,6 +217,7 @@ typedef void(^XSTSCallback)(NSString *xsts, NSString *uhs);
         self.authData[@"profilePicURL"] = [NSString stringWithFormat:@"https://mc-heads.net/head/%@/120", self.authData[@"profileId"]];
         self.authData[@"oldusername"] = self.authData[@"username"];
         self.authData[@"username"] = response[@"name"];
+        self.authData[@"expiresAt"] = expiresAt;
         callback(nil, [self saveChanges]);
     } failure:^(NSURLSessionDataTask *task, NSError *error) {
         NSData *errorData = error.userInfo[AFNetworkingOperationFailingURLResponseDataErrorKey];
@@ -196,6 +226,7 @@ typedef void(^XSTSCallback)(NSString *xsts, NSString *uhs);
             // If there is no profile, use the Xbox gamertag as username with Demo mode
             self.authData[@"profileId"] = @"00000000-0000-0000-0000-000000000000";
             self.authData[@"username"] = [NSString stringWithFormat:@"Demo.%@", self.authData[@"xboxGamertag"]];
+            self.authData[@"expiresAt"] = expiresAt;
 
             if ([self saveChanges]) {
                 callback(@"DEMO", YES);
@@ -215,6 +246,9 @@ typedef void(^XSTSCallback)(NSString *xsts, NSString *uhs);
 }
 
 - (void)refreshTokenWithCallback:(Callback)callback {
+    // From here on tokens are renewed ahead of time instead of on the next launch
+    [TokenRefreshScheduler.sharedScheduler start];
+
     // Move tokens to keychain if we haven't
     if (!self.tokenData) {
         showDialog(localize(@"Error", nil), @"Failed to load account tokens from keychain");
@@ -229,6 +263,32 @@ typedef void(^XSTSCallback)(NSString *xsts, NSString *uhs);
     }
 }
 
+- (void)refreshInBackgroundWithCompletion:(void(^)(BOOL success))completion {
+    if (!NSThread.isMainThread) {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self refreshInBackgroundWithCompletion:completion];
+        });
+        return;
+    }
+    NSString *refreshToken = self.tokenData[@"refreshToken"];
+    if (!refreshToken) {
+        completion(NO);
+        return;
+    }
+    self.refreshingInBackground = YES;
+    [self acquireAccessToken:refreshToken refresh:YES callback:^(id status, BOOL success) {
+        // Progress messages come in as status with success
+        if (success && status != nil) return;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            self.refreshingInBackground = NO;
+            if (!success) {
+                NSLog(@"[MicrosoftAuthenticator] Background refresh failed: %@", status);
+            }
+            completion(success);
+        });
+    }];
+}
+
 - (BOOL)saveChanges {
     BOOL savedToKeychain = [self setAccessToken:self.authData[@"accessToken"] refreshToken:self.authData[@"msaRefreshToken"]];
     if (!savedToKeychain) {
@@ -236,7 +296,9 @@ typedef void(^XSTSCallback)(NSString *xsts, NSString *uhs);
         return NO;
     }
     [self.authData removeObjectsForKeys:@[@"accessToken", @"msaRefreshToken"]];
-    return [super saveChanges];
+    BOOL saved = [super saveChanges];
+    [TokenRefreshScheduler.sharedScheduler reschedule];
+    return saved;
 }
 
 #pragma mark Keychain
@@ -0,0 +1,25 @@
+#import <Foundation/Foundation.h>
+
+// Renews the selected Microsoft account's Minecraft token well ahead of its
+// expiry while the app is in the foreground, so pressing Play only ever finds a
+// valid token. Failed attempts back off exponentially; once a token has fully
+// expired the regular refreshTokenWithCallback: path takes over again.
+@interface TokenRefreshScheduler : NSObject
+
+// Seconds before expiry at which a refresh is attempted
+@property(nonatomic) NSTimeInterval refreshLeadTime;
+@property(nonatomic) NSTimeInterval minRetryDelay, maxRetryDelay;
+
++ (instancetype)sharedScheduler;
+// The clock returns seconds since 1970, replaceable for testing
+- (instancetype)initWithClock:(NSTimeInterval(^)(void))clock;
+
+// Starts watching app activation and schedules the first check
+- (void)start;
+// Re-evaluates the timer, e.g. after a login, an account switch or a refresh
+- (void)reschedule;
+
+// When the next attempt is due for a token expiring at expiresAt
+- (NSTimeInterval)nextAttemptForExpiry:(NSTimeInterval)expiresAt;
+
+@end
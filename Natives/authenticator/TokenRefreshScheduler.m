@@ -0,0 +1,129 @@
+#import <UIKit/UIKit.h>
+#import "BaseAuthenticator.h"
+#import "TokenRefreshScheduler.h"
+#import "../utils.h"
+#include "token_refresh.h"
+
+@interface TokenRefreshScheduler()
+@property(nonatomic, copy) NSTimeInterval(^clock)(void);
+@property(nonatomic) dispatch_source_t timer;
+@property(nonatomic, copy) NSString *accountName;
+@property(nonatomic) BOOL refreshing, started;
+@end
+
+@implementation TokenRefreshScheduler {
+    token_refresh_t _state;
+}
+
++ (instancetype)sharedScheduler {
+    static TokenRefreshScheduler *scheduler;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        scheduler = [[TokenRefreshScheduler alloc] initWithClock:^{
+            return NSDate.date.timeIntervalSince1970;
+        }];
+    });
+    return scheduler;
+}
+
+- (instancetype)initWithClock:(NSTimeInterval(^)(void))clock {
+    self = [super init];
+    self.clock = clock;
+    token_refresh_init(&_state);
+    return self;
+}
+
+- (NSTimeInterval)refreshLeadTime {
+    return _state.leadTime;
+}
+
+- (void)setRefreshLeadTime:(NSTimeInterval)refreshLeadTime {
+    _state.leadTime = refreshLeadTime;
+}
+
+- (NSTimeInterval)minRetryDelay {
+    return _state.minRetryDelay;
+}
+
+- (void)setMinRetryDelay:(NSTimeInterval)minRetryDelay {
+    _state.minRetryDelay = minRetryDelay;
+}
+
+- (NSTimeInterval)maxRetryDelay {
+    return _state.maxRetryDelay;
+}
+
+- (void)setMaxRetryDelay:(NSTimeInterval)maxRetryDelay {
+    _state.maxRetryDelay = maxRetryDelay;
+}
+
+- (void)start {
+    if (self.started) return;
+    self.started = YES;
+    // Timers don't advance while the app is suspended, so check again on every return
+    [NSNotificationCenter.defaultCenter addObserver:self selector:@selector(reschedule)
+        name:UIApplicationDidBecomeActiveNotification object:nil];
+    [self reschedule];
+}
+
+- (NSTimeInterval)nextAttemptForExpiry:(NSTimeInterval)expiresAt {
+    return token_refresh_next_attempt(&_state, expiresAt);
+}
+
+- (void)reschedule {
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [self rescheduleOnMain];
+    });
+}
+
+- (void)rescheduleOnMain {
+    if (self.timer) {
+        dispatch_source_cancel(self.timer);
+        self.timer = nil;
+    }
+    if (!self.started || self.refreshing) return;
+
+    MicrosoftAuthenticator *account = BaseAuthenticator.current;
+    if (![account isKindOfClass:MicrosoftAuthenticator.class]) return;
+    if (![self.accountName isEqualToString:account.authData[@"username"]]) {
+        // Backoff belongs to the account that failed
+        self.accountName = account.authData[@"username"];
+        token_refresh_reset(&_state);
+    }
+
+    NSTimeInterval now = self.clock();
+    double attemptAt;
+    switch (token_refresh_plan(&_state, now, [account.authData[@"expiresAt"] doubleValue], &attemptAt)) {
+        case TOKEN_REFRESH_EXPIRED:
+            // Nothing left to save, the next launch refreshes in the foreground
+            return;
+        case TOKEN_REFRESH_NOW:
+            [self refreshAccount:account];
+            return;
+        case TOKEN_REFRESH_LATER:
+            break;
+    }
+
+    self.timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_main_queue());
+    dispatch_source_set_timer(self.timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)((attemptAt - now) * NSEC_PER_SEC)),
+        DISPATCH_TIME_FOREVER, 10 * NSEC_PER_SEC);
+    dispatch_source_set_event_handler(self.timer, ^{
+        [self rescheduleOnMain];
+    });
+    dispatch_resume(self.timer);
+}
+
+- (void)refreshAccount:(MicrosoftAuthenticator *)account {
+    NSLog(@"[TokenRefresh] Renewing token of %@ ahead of expiry", account.authData[@"username"]);
+    self.refreshing = YES;
+    [account refreshInBackgroundWithCompletion:^(BOOL success) {
+        self.refreshing = NO;
+        double delay = token_refresh_finished(&self->_state, self.clock(), success);
+        if (!success) {
+            NSLog(@"[TokenRefresh] Attempt %u failed, retrying in %.0fs", self->_state.failureCount, delay);
+        }
+        [self rescheduleOnMain];
+    }];
+}
+
+@end
@@ -0,0 +1,181 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "backup_store.h"
+#include "region_file.h"
+
+bool backup_object_path(const char *storePath, const char *hash, char *path, size_t pathSize) {
+    int length = snprintf(path, pathSize, "%s/objects/%.2s/%s", storePath, hash, hash + 2);
+    return length >= 0 && (size_t)length < pathSize;
+}
+
+static bool backup_write_all(int fd, const uint8_t *bytes, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written <= 0) return false;
+        bytes += written;
+        length -= written;
+    }
+    return true;
+}
+
+bool backup_store_bytes(const char *storePath, const uint8_t *bytes, size_t length, backup_hash_t hash, uint64_t *addedBytes) {
+    sha1_hex(bytes, length, hash);
+    char path[4096];
+    if (!backup_object_path(storePath, hash, path, sizeof(path))) {
+        return false;
+    }
+    if (access(path, F_OK) == 0) {
+        return true;
+    }
+
+    // Chunks in region files are already compressed, those are kept as they are
+    uLongf compressedLength = compressBound(length);
+    uint8_t *object = malloc(5 + compressedLength);
+    size_t objectLength;
+    if (compress2(object + 5, &compressedLength, bytes, length, Z_DEFAULT_COMPRESSION) == Z_OK &&
+        compressedLength < length) {
+        object[0] = BACKUP_OBJECT_ZLIB;
+        for (int i = 0; i < 4; i++) object[1 + i] = (uint8_t)(length >> (i * 8));
+        objectLength = 5 + compressedLength;
+    } else {
+        object[0] = BACKUP_OBJECT_RAW;
+        object = realloc(object, 1 + length);
+        memcpy(object + 1, bytes, length);
+        objectLength = 1 + length;
+    }
+
+    // Another thread may store the same segment, the rename settles it
+    char tmpPath[4096 + 16];
+    snprintf(tmpPath, sizeof(tmpPath), "%s", path);
+    *strrchr(tmpPath, '/') = '\0';
+    mkdir(tmpPath, 0755);
+    snprintf(tmpPath, sizeof(tmpPath), "%s.XXXXXX.tmp", path);
+    int fd = mkstemps(tmpPath, 4);
+    bool stored = fd != -1 && backup_write_all(fd, object, objectLength);
+    if (fd != -1 && close(fd) != 0) stored = false;
+    if (stored && rename(tmpPath, path) != 0) stored = false;
+    if (!stored && fd != -1) unlink(tmpPath);
+    free(object);
+    if (stored) *addedBytes += objectLength;
+    return stored;
+}
+
+uint8_t *backup_load_object(const char *storePath, const char *hash, size_t *length) {
+    char path[4096];
+    if (!backup_object_path(storePath, hash, path, sizeof(path))) {
+        return NULL;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return NULL;
+    }
+    struct stat st;
+    uint8_t *object = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size >= 1) {
+        object = malloc(st.st_size);
+        if (read(fd, object, st.st_size) != st.st_size) {
+            free(object);
+            object = NULL;
+        }
+    }
+    close(fd);
+    if (!object) {
+        return NULL;
+    }
+
+    uint8_t *data = NULL;
+    if (object[0] == BACKUP_OBJECT_RAW) {
+        *length = st.st_size - 1;
+        data = malloc(*length ? *length : 1);
+        memcpy(data, object + 1, *length);
+    } else if (object[0] == BACKUP_OBJECT_ZLIB && st.st_size >= 5) {
+        uLongf rawLength = 0;
+        for (int i = 0; i < 4; i++) rawLength |= (uLongf)object[1 + i] << (i * 8);
+        uLongf outLength = rawLength;
+        data = malloc(rawLength ? rawLength : 1);
+        if (uncompress(data, &outLength, object + 5, st.st_size - 5) != Z_OK || outLength != rawLength) {
+            free(data);
+            data = NULL;
+        }
+        *length = rawLength;
+    }
+    free(object);
+    return data;
+}
+
+backup_hash_t *backup_store_file(const char *storePath, const char *path, bool region, size_t *count, uint64_t *addedBytes) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return NULL;
+    }
+    struct stat st;
+    fstat(fd, &st);
+
+    region_segment_t *segments = malloc(REGION_MAX_SEGMENTS * sizeof(region_segment_t));
+    size_t segmentCount = 1;
+    segments[0] = (region_segment_t){0, st.st_size};
+    uint8_t header[REGION_HEADER_SIZE];
+    if (region && st.st_size > REGION_HEADER_SIZE &&
+        pread(fd, header, REGION_HEADER_SIZE, 0) == REGION_HEADER_SIZE) {
+        segmentCount = region_split_segments(header, st.st_size, segments);
+    }
+
+    // One hash per started segment-size block is enough for every segment
+    size_t capacity = segmentCount + st.st_size / BACKUP_SEGMENT_SIZE + 1;
+    backup_hash_t *hashes = malloc(capacity * sizeof(backup_hash_t));
+    uint8_t *buffer = malloc(BACKUP_SEGMENT_SIZE);
+    size_t hashCount = 0;
+    bool failed = false;
+    for (size_t i = 0; i < segmentCount && !failed; i++) {
+        uint64_t offset = segments[i].offset, end = offset + segments[i].length;
+        while (offset < end) {
+            size_t length = end - offset < BACKUP_SEGMENT_SIZE ? end - offset : BACKUP_SEGMENT_SIZE;
+            if (pread(fd, buffer, length, offset) != (ssize_t)length ||
+                !backup_store_bytes(storePath, buffer, length, hashes[hashCount], addedBytes)) {
+                failed = true;
+                break;
+            }
+            hashCount++;
+            offset += length;
+        }
+    }
+    free(buffer);
+    free(segments);
+    close(fd);
+    if (failed) {
+        free(hashes);
+        return NULL;
+    }
+    *count = hashCount;
+    return hashes;
+}
+
+bool backup_restore_file(const char *storePath, const char *const *hashes, size_t count, const char *path) {
+    char tmpPath[4096];
+    if (snprintf(tmpPath, sizeof(tmpPath), "%s.restore.tmp", path) >= (int)sizeof(tmpPath)) {
+        return false;
+    }
+    int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        return false;
+    }
+    bool failed = false;
+    for (size_t i = 0; i < count && !failed; i++) {
+        size_t length;
+        uint8_t *data = backup_load_object(storePath, hashes[i], &length);
+        failed = !data || !backup_write_all(fd, data, length);
+        free(data);
+    }
+    if (close(fd) != 0) failed = true;
+    if (failed || rename(tmpPath, path) != 0) {
+        unlink(tmpPath);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sha1.h"
+
+// Content-addressed segment store behind WorldBackupManager. A segment is
+// kept once, at objects/<first two hex digits>/<rest> under the store, named
+// by the SHA-1 of its bytes.
+
+// Other files, and anything in a region file bigger than this, are split at fixed offsets
+#define BACKUP_SEGMENT_SIZE (1 << 20)
+
+// Object files start with one of these, zlib objects then store the raw length
+#define BACKUP_OBJECT_RAW 0
+#define BACKUP_OBJECT_ZLIB 1
+
+typedef char backup_hash_t[SHA1_HEX_LENGTH + 1];
+
+// Returns false if path is too small
+bool backup_object_path(const char *storePath, const char *hash, char *path, size_t pathSize);
+
+// Stores the segment unless it is already there, adding the bytes written to *addedBytes
+bool backup_store_bytes(const char *storePath, const uint8_t *bytes, size_t length, backup_hash_t hash, uint64_t *addedBytes);
+// Returns the segment's bytes (free() them), or NULL if missing or damaged
+uint8_t *backup_load_object(const char *storePath, const char *hash, size_t *length);
+
+// Splits the file into segments, by chunk if it is a region file, and stores
+// each one. Returns their hashes in file order (free() them), NULL on failure.
+backup_hash_t *backup_store_file(const char *storePath, const char *path, bool region, size_t *count, uint64_t *addedBytes);
+// Writes the segments to a temporary file, then renames it over path
+bool backup_restore_file(const char *storePath, const char *const *hashes, size_t count, const char *path);
@@ -11,18 +11,21 @@ typedef union {
 
 typedef basic_render_window_t* (*br_init_context_t)(basic_render_window_t* share);
 typedef void (*br_make_current_t)(basic_render_window_t* bundle);
+typedef void (*br_destroy_context_t)(basic_render_window_t* bundle);
 typedef basic_render_window_t* (*br_get_current_t)();
 
 bool (*br_init)();
 br_init_context_t br_init_context;
 br_make_current_t br_make_current;
+br_destroy_context_t br_destroy_context;
 //br_get_current_t br_get_current = NULL;
 void (*br_swap_buffers)();
 void (*br_setup_window)();
 void (*br_swap_interval)(int swapInterval);
 void (*br_terminate)();
 
-static __thread basic_render_window_t* currentBundle;
+// Defined in egl_bridge.m so that every bridge sees the same per-thread value
+extern __thread basic_render_window_t* currentBundle;
 static inline basic_render_window_t* br_get_current() {
     return currentBundle;
 }
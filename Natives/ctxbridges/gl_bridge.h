@@ -1,11 +1,13 @@
 #pragma once
 
 #include <EGL/egl.h>
+#include <stdbool.h>
 
 typedef struct {
     PFNEGLBINDAPIPROC eglBindAPI;
     PFNEGLCHOOSECONFIGPROC eglChooseConfig;
     PFNEGLCREATECONTEXTPROC eglCreateContext;
+    PFNEGLCREATEPBUFFERSURFACEPROC eglCreatePbufferSurface;
     PFNEGLCREATEWINDOWSURFACEPROC eglCreateWindowSurface;
     PFNEGLDESTROYCONTEXTPROC eglDestroyContext;
     PFNEGLDESTROYSURFACEPROC eglDestroySurface;
@@ -31,6 +33,20 @@ typedef struct {
     EGLint     format;
     EGLContext context;
     EGLSurface surface;
+    // Shared worker context backed by a pbuffer (or no surface at all)
+    bool offscreen;
+    // Offscreen with a pbuffer of its own instead of one from the pool
+    bool standalone;
+    // Current on some thread, guarded by the bridge
+    bool hasOwner;
+    // Destroyed while current elsewhere, freed when the owner lets go
+    bool destroyPending;
 } gl_render_window_t;
 
 void set_gl_bridge_tbl();
+
+// Standalone pbuffer-backed context, used to probe renderers before the game window exists
+bool gl_init();
+gl_render_window_t* gl_init_offscreen_context(bool desktopGL);
+void gl_make_current(gl_render_window_t* bundle);
+void gl_destroy_context(gl_render_window_t* bundle);
@@ -5,6 +5,7 @@
 #include "bridge_tbl.h"
 #include "environ.h"
 #include "gl_bridge.h"
+#include "gl_offscreen.h"
 #include "utils.h"
 
 static EGLDisplay g_EglDisplay;
@@ -16,6 +17,7 @@ void dlsym_EGL() {
     handle.eglBindAPI = dlsym(dl_handle, "eglBindAPI");
     handle.eglChooseConfig = dlsym(dl_handle, "eglChooseConfig");
     handle.eglCreateContext = dlsym(dl_handle, "eglCreateContext");
+    handle.eglCreatePbufferSurface = dlsym(dl_handle, "eglCreatePbufferSurface");
     handle.eglCreateWindowSurface = dlsym(dl_handle, "eglCreateWindowSurface");
     handle.eglDestroyContext = dlsym(dl_handle, "eglDestroyContext");
     handle.eglDestroySurface = dlsym(dl_handle, "eglDestroySurface");
@@ -26,6 +28,7 @@ void dlsym_EGL() {
     handle.eglGetPlatformDisplay = dlsym(dl_handle, "eglGetPlatformDisplay");
     handle.eglInitialize = dlsym(dl_handle, "eglInitialize");
     handle.eglMakeCurrent = dlsym(dl_handle, "eglMakeCurrent");
+    handle.eglQueryString = dlsym(dl_handle, "eglQueryString");
     handle.eglSwapBuffers = dlsym(dl_handle, "eglSwapBuffers");
     handle.eglReleaseThread = dlsym(dl_handle, "eglReleaseThread");
     handle.eglSwapInterval = dlsym(dl_handle, "eglSwapInterval");
@@ -33,7 +36,7 @@ void dlsym_EGL() {
     handle.eglGetCurrentSurface = dlsym(dl_handle, "eglGetCurrentSurface");
 }
 
-static bool gl_init() {
+bool gl_init() {
     dlsym_EGL();
 
     g_EglDisplay = handle.eglGetDisplay(EGL_DEFAULT_DISPLAY);
@@ -45,15 +48,14 @@ static bool gl_init() {
         NSDebugLog(@"EGLBridge: Error eglInitialize() failed: 0x%x", handle.eglGetError());
         return false;
     }
+    const char *extensions = handle.eglQueryString(g_EglDisplay, EGL_EXTENSIONS);
+    gl_offscreen_init(&handle, g_EglDisplay, extensions && strstr(extensions, "EGL_KHR_surfaceless_context"));
     return true;
 }
 
-gl_render_window_t* gl_init_context(gl_render_window_t *share) {
+static gl_render_window_t* gl_init_context_internal(gl_render_window_t *share, bool offscreen, bool standalone, bool angleDesktopGL) {
     gl_render_window_t* bundle = calloc(1, sizeof(gl_render_window_t));
 
-    NSString *renderer = NSProcessInfo.processInfo.environment[@"AMETHYST_RENDERER"];
-    BOOL angleDesktopGL = [renderer isEqualToString:@ RENDERER_NAME_MTL_ANGLE];
-
     const EGLint attribs[] = {
         EGL_RED_SIZE, 8,
         EGL_GREEN_SIZE, 8,
@@ -91,6 +93,20 @@ gl_render_window_t* gl_init_context(gl_render_window_t *share) {
     }
     if (!bindResult) NSDebugLog(@"EGLBridge: bind failed: %p\n", handle.eglGetError());
 
+    // Shared contexts are created by mods for their worker threads (off-thread
+    // chunk and texture uploads). Keep them off the window layer so they don't
+    // fight the render thread over the same surface.
+    bundle->offscreen = offscreen;
+    bundle->standalone = standalone;
+    if (bundle->offscreen) {
+        if (!gl_offscreen_create_context(bundle, share)) {
+            NSDebugLog(@"EGLBridge: Error creating an offscreen context: 0x%x", handle.eglGetError());
+            free(bundle);
+            return NULL;
+        }
+        return bundle;
+    }
+
     bundle->surface = handle.eglCreateWindowSurface(g_EglDisplay, bundle->config, (__bridge EGLNativeWindowType)SurfaceViewController.surface.layer, NULL);
     if (!bundle->surface) {
         NSDebugLog(@"EGLBridge: eglCreateWindowSurface finished with error: 0x%x", handle.eglGetError());
@@ -105,6 +121,7 @@ gl_render_window_t* gl_init_context(gl_render_window_t *share) {
     bundle->context = handle.eglCreateContext(g_EglDisplay, bundle->config, share ? share->context : EGL_NO_CONTEXT, ctx_attribs);
     if (!bundle->context) {
         NSDebugLog(@"EGLBridge: Error eglCreateContext finished with error: 0x%x", handle.eglGetError());
+        handle.eglDestroySurface(g_EglDisplay, bundle->surface);
         free(bundle);
         return NULL;
     }
@@ -113,22 +130,37 @@ gl_render_window_t* gl_init_context(gl_render_window_t *share) {
     return bundle;
 }
 
-void gl_make_current(gl_render_window_t* bundle) {
-    if(!bundle) {
-        if(handle.eglMakeCurrent(g_EglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT)) {
-            currentBundle = NULL;
-        }
-        return;
-    }
+gl_render_window_t* gl_init_context(gl_render_window_t *share) {
+    NSString *renderer = NSProcessInfo.processInfo.environment[@"AMETHYST_RENDERER"];
+    return gl_init_context_internal(share, share != NULL, false, [renderer isEqualToString:@ RENDERER_NAME_MTL_ANGLE]);
+}
+
+gl_render_window_t* gl_init_offscreen_context(bool desktopGL) {
+    return gl_init_context_internal(NULL, true, true, desktopGL);
+}
 
-    if(handle.eglMakeCurrent(g_EglDisplay, bundle->surface, bundle->surface, bundle->context)) {
+void gl_make_current(gl_render_window_t* bundle) {
+    if (gl_offscreen_make_current(bundle, (gl_render_window_t *)currentBundle)) {
         currentBundle = (basic_render_window_t *)bundle;
-    } else {
+    } else if (bundle) {
         NSLog(@"EGLBridge: eglMakeCurrent returned with error: 0x%x", handle.eglGetError());
     }
 }
 
+void gl_destroy_context(gl_render_window_t* bundle) {
+    // The window context lives until gl_terminate
+    if (!bundle->offscreen) return;
+
+    if (currentBundle == (basic_render_window_t *)bundle) {
+        gl_make_current(NULL);
+    }
+    if (!gl_offscreen_destroy(bundle)) {
+        NSLog(@"EGLBridge: Context %p is current on another thread, deferring its destruction", bundle->context);
+    }
+}
+
 void gl_swap_buffers() {
+    if (currentBundle->gl.offscreen) return;
     if (!handle.eglSwapBuffers(g_EglDisplay, currentBundle->gl.surface) && handle.eglGetError() == EGL_BAD_SURFACE) {
         NSLog(@"eglSwapBuffers error 0x%x", handle.eglGetError());
         //stopSwapBuffers = true;
@@ -142,6 +174,7 @@ void gl_swap_interval(int swapInterval) {
 
 void gl_terminate() {
     handle.eglMakeCurrent(g_EglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    gl_offscreen_terminate();
     handle.eglDestroySurface(g_EglDisplay, currentBundle->gl.surface);
     handle.eglDestroyContext(g_EglDisplay, currentBundle->gl.context);
     handle.eglTerminate(g_EglDisplay);
@@ -154,6 +187,7 @@ void set_gl_bridge_tbl() {
     br_init = gl_init;
     br_init_context = (br_init_context_t) gl_init_context;
     br_make_current = (br_make_current_t) gl_make_current;
+    br_destroy_context = (br_destroy_context_t) gl_destroy_context;
     br_swap_buffers = gl_swap_buffers;
     br_swap_interval = gl_swap_interval;
     br_terminate = gl_terminate;
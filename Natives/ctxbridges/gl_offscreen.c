@@ -0,0 +1,157 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gl_offscreen.h"
+
+static const egl_library *egl;
+static EGLDisplay g_Display;
+static bool g_SurfacelessSupported;
+
+// Released pbuffer surfaces of worker contexts, reused by the next one with
+// the same config
+#define OFFSCREEN_POOL_SIZE 4
+typedef struct {
+    EGLSurface surface;
+    EGLConfig config;
+} offscreen_surface_t;
+static offscreen_surface_t g_Pool[OFFSCREEN_POOL_SIZE];
+static int g_PoolCount;
+static pthread_mutex_t g_PoolLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Guards the owner fields of the bundles, a context may be destroyed from a
+// thread other than the one it is current on
+static pthread_mutex_t g_BundleLock = PTHREAD_MUTEX_INITIALIZER;
+
+void gl_offscreen_init(const egl_library *library, EGLDisplay display, bool surfacelessSupported) {
+    egl = library;
+    g_Display = display;
+    g_SurfacelessSupported = surfacelessSupported;
+}
+
+static EGLSurface gl_offscreen_create_pbuffer(EGLConfig config) {
+    // Offscreen contexts never present, a 1x1 pbuffer is enough to make them current
+    const EGLint pbuffer_attribs[] = {
+        EGL_WIDTH, 1,
+        EGL_HEIGHT, 1,
+        EGL_NONE
+    };
+    return egl->eglCreatePbufferSurface(g_Display, config, pbuffer_attribs);
+}
+
+static EGLSurface gl_offscreen_acquire(EGLConfig config) {
+    EGLSurface surface = EGL_NO_SURFACE;
+    pthread_mutex_lock(&g_PoolLock);
+    for (int i = g_PoolCount - 1; i >= 0; i--) {
+        if (g_Pool[i].config == config) {
+            surface = g_Pool[i].surface;
+            g_Pool[i] = g_Pool[--g_PoolCount];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_PoolLock);
+    return surface != EGL_NO_SURFACE ? surface : gl_offscreen_create_pbuffer(config);
+}
+
+static void gl_offscreen_release(EGLSurface surface, EGLConfig config) {
+    if (surface == EGL_NO_SURFACE) return;
+    EGLSurface evicted = EGL_NO_SURFACE;
+    pthread_mutex_lock(&g_PoolLock);
+    if (g_PoolCount == OFFSCREEN_POOL_SIZE) {
+        // Keep the most recent ones, older configs are unlikely to come back
+        evicted = g_Pool[0].surface;
+        memmove(g_Pool, g_Pool + 1, sizeof(g_Pool) - sizeof(g_Pool[0]));
+        g_PoolCount--;
+    }
+    g_Pool[g_PoolCount++] = (offscreen_surface_t){surface, config};
+    pthread_mutex_unlock(&g_PoolLock);
+    if (evicted != EGL_NO_SURFACE) {
+        egl->eglDestroySurface(g_Display, evicted);
+    }
+}
+
+static void gl_offscreen_free_surface(gl_render_window_t *bundle) {
+    if (!bundle->standalone) {
+        gl_offscreen_release(bundle->surface, bundle->config);
+    } else if (bundle->surface != EGL_NO_SURFACE) {
+        egl->eglDestroySurface(g_Display, bundle->surface);
+    }
+}
+
+bool gl_offscreen_create_context(gl_render_window_t *bundle, gl_render_window_t *share) {
+    bundle->surface = bundle->standalone ?
+        gl_offscreen_create_pbuffer(bundle->config) : gl_offscreen_acquire(bundle->config);
+    // Without a pbuffer the context can still be made current on its own
+    if (bundle->surface == EGL_NO_SURFACE && !g_SurfacelessSupported) {
+        return false;
+    }
+
+    const EGLint ctx_attribs[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 3,
+        EGL_NONE
+    };
+    bundle->context = egl->eglCreateContext(g_Display, bundle->config, share ? share->context : EGL_NO_CONTEXT, ctx_attribs);
+    if (bundle->context == EGL_NO_CONTEXT) {
+        gl_offscreen_free_surface(bundle);
+        bundle->surface = EGL_NO_SURFACE;
+        return false;
+    }
+    return true;
+}
+
+static void gl_offscreen_free(gl_render_window_t *bundle) {
+    egl->eglDestroyContext(g_Display, bundle->context);
+    gl_offscreen_free_surface(bundle);
+    free(bundle);
+}
+
+// Called on the thread the bundle was current on once it no longer is.
+// Returns true if the bundle was waiting for that to be destroyed.
+static bool gl_offscreen_release_owner(gl_render_window_t *bundle) {
+    pthread_mutex_lock(&g_BundleLock);
+    bundle->hasOwner = false;
+    bool destroy = bundle->destroyPending;
+    pthread_mutex_unlock(&g_BundleLock);
+    return destroy;
+}
+
+bool gl_offscreen_make_current(gl_render_window_t *bundle, gl_render_window_t *previous) {
+    if (!bundle) {
+        if (!egl->eglMakeCurrent(g_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT)) {
+            return false;
+        }
+    } else {
+        if (!egl->eglMakeCurrent(g_Display, bundle->surface, bundle->surface, bundle->context)) {
+            return false;
+        }
+        pthread_mutex_lock(&g_BundleLock);
+        bundle->hasOwner = true;
+        pthread_mutex_unlock(&g_BundleLock);
+    }
+    if (previous && previous != bundle && gl_offscreen_release_owner(previous)) {
+        gl_offscreen_free(previous);
+    }
+    return true;
+}
+
+bool gl_offscreen_destroy(gl_render_window_t *bundle) {
+    pthread_mutex_lock(&g_BundleLock);
+    bool inUse = bundle->hasOwner;
+    if (inUse) {
+        // Still current on another thread, whose current bundle points at it
+        bundle->destroyPending = true;
+    }
+    pthread_mutex_unlock(&g_BundleLock);
+    if (!inUse) {
+        gl_offscreen_free(bundle);
+    }
+    return !inUse;
+}
+
+void gl_offscreen_terminate(void) {
+    pthread_mutex_lock(&g_PoolLock);
+    while (g_PoolCount > 0) {
+        egl->eglDestroySurface(g_Display, g_Pool[--g_PoolCount].surface);
+    }
+    pthread_mutex_unlock(&g_PoolLock);
+}
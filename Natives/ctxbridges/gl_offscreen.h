@@ -0,0 +1,29 @@
+#pragma once
+
+#include "gl_bridge.h"
+
+// Offscreen contexts of the EGL bridge: standalone ones with a pbuffer of
+// their own, and shared worker contexts that take a 1x1 pbuffer from a small
+// pool (a surface can only be made current with a context of the same config).
+// A worker context may be destroyed while it is current on another thread;
+// that thread frees it once it makes another context current, or none.
+// Plain C over the bridge's EGL entry points, so the lifecycle also runs
+// against Mesa's surfaceless EGL on Linux.
+
+void gl_offscreen_init(const egl_library *egl, EGLDisplay display, bool surfacelessSupported);
+
+// Creates the surface and context of a bundle whose config, offscreen and
+// standalone fields are set. On failure nothing is left to release.
+bool gl_offscreen_create_context(gl_render_window_t *bundle, gl_render_window_t *share);
+
+// Makes bundle (or nothing, if NULL) current on this thread in place of
+// previous, the bundle that was current on it. Frees previous if it was
+// destroyed meanwhile. Returns false if eglMakeCurrent failed.
+bool gl_offscreen_make_current(gl_render_window_t *bundle, gl_render_window_t *previous);
+
+// Frees an offscreen bundle that is not current on this thread. Returns false
+// if it is current on another one, which then frees it.
+bool gl_offscreen_destroy(gl_render_window_t *bundle);
+
+// Destroys the pooled surfaces
+void gl_offscreen_terminate(void);
@@ -0,0 +1,145 @@
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "renderer_bench.h"
+
+#define BENCH_DRAW_CALLS 2000
+#define BENCH_TEXTURE_UPLOADS 16
+#define BENCH_TEXTURE_SIZE 512
+#define BENCH_SHADER_COMPILES 8
+
+// Same dialect as the core profile shaders of 1.17+
+static const char *benchVertexShader =
+    "#version 150\n"
+    "in vec2 pos;\n"
+    "uniform float offset;\n"
+    "void main() { gl_Position = vec4(pos.x + offset, pos.y, 0.0, 1.0); }\n";
+static const char *benchFragmentShader =
+    "#version 150\n"
+    "uniform float offset;\n"
+    "out vec4 fragColor;\n"
+    "void main() { fragColor = vec4(offset, 0.5, 0.25, 1.0); }\n";
+
+static double bench_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+bool renderer_bench_load(void *dl_handle, renderer_bench_gl_t *gl) {
+#define BENCH_LOOKUP(func) \
+    gl->func = dlsym(dl_handle, #func); \
+    if (!gl->func) return false;
+    BENCH_LOOKUP(glAttachShader)
+    BENCH_LOOKUP(glBindAttribLocation)
+    BENCH_LOOKUP(glBindBuffer)
+    BENCH_LOOKUP(glBindTexture)
+    BENCH_LOOKUP(glBindVertexArray)
+    BENCH_LOOKUP(glBufferData)
+    BENCH_LOOKUP(glCompileShader)
+    BENCH_LOOKUP(glCreateProgram)
+    BENCH_LOOKUP(glCreateShader)
+    BENCH_LOOKUP(glDeleteBuffers)
+    BENCH_LOOKUP(glDeleteProgram)
+    BENCH_LOOKUP(glDeleteShader)
+    BENCH_LOOKUP(glDeleteTextures)
+    BENCH_LOOKUP(glDeleteVertexArrays)
+    BENCH_LOOKUP(glDrawArrays)
+    BENCH_LOOKUP(glEnableVertexAttribArray)
+    BENCH_LOOKUP(glFinish)
+    BENCH_LOOKUP(glGenBuffers)
+    BENCH_LOOKUP(glGenTextures)
+    BENCH_LOOKUP(glGenVertexArrays)
+    BENCH_LOOKUP(glGetProgramiv)
+    BENCH_LOOKUP(glGetUniformLocation)
+    BENCH_LOOKUP(glLinkProgram)
+    BENCH_LOOKUP(glShaderSource)
+    BENCH_LOOKUP(glTexImage2D)
+    BENCH_LOOKUP(glUniform1f)
+    BENCH_LOOKUP(glUseProgram)
+    BENCH_LOOKUP(glVertexAttribPointer)
+    BENCH_LOOKUP(glViewport)
+#undef BENCH_LOOKUP
+    return true;
+}
+
+static GLuint bench_compile_program(const renderer_bench_gl_t *gl) {
+    GLuint program = gl->glCreateProgram();
+    GLuint vs = gl->glCreateShader(GL_VERTEX_SHADER);
+    GLuint fs = gl->glCreateShader(GL_FRAGMENT_SHADER);
+    gl->glShaderSource(vs, 1, &benchVertexShader, NULL);
+    gl->glShaderSource(fs, 1, &benchFragmentShader, NULL);
+    gl->glCompileShader(vs);
+    gl->glCompileShader(fs);
+    gl->glAttachShader(program, vs);
+    gl->glAttachShader(program, fs);
+    gl->glBindAttribLocation(program, 0, "pos");
+    gl->glLinkProgram(program);
+    gl->glDeleteShader(vs);
+    gl->glDeleteShader(fs);
+
+    GLint linked = 0;
+    gl->glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        gl->glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+bool renderer_bench_run(const renderer_bench_gl_t *gl, renderer_bench_result_t *result) {
+    gl->glViewport(0, 0, 1, 1);
+    gl->glFinish();
+
+    double start = bench_now_ms();
+    GLuint program = 0;
+    for (int i = 0; i < BENCH_SHADER_COMPILES; i++) {
+        if (program) gl->glDeleteProgram(program);
+        program = bench_compile_program(gl);
+        if (!program) return false;
+    }
+    gl->glFinish();
+    result->compile = bench_now_ms() - start;
+
+    void *pixels = calloc(BENCH_TEXTURE_SIZE * BENCH_TEXTURE_SIZE, 4);
+    GLuint texture;
+    gl->glGenTextures(1, &texture);
+    gl->glBindTexture(GL_TEXTURE_2D, texture);
+    start = bench_now_ms();
+    for (int i = 0; i < BENCH_TEXTURE_UPLOADS; i++) {
+        gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, BENCH_TEXTURE_SIZE, BENCH_TEXTURE_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+    gl->glFinish();
+    result->upload = bench_now_ms() - start;
+    gl->glDeleteTextures(1, &texture);
+    free(pixels);
+
+    const GLfloat triangle[] = {-1, -1, 1, -1, 0, 1};
+    GLuint vao, vbo;
+    gl->glGenVertexArrays(1, &vao);
+    gl->glBindVertexArray(vao);
+    gl->glGenBuffers(1, &vbo);
+    gl->glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    gl->glBufferData(GL_ARRAY_BUFFER, sizeof(triangle), triangle, GL_STATIC_DRAW);
+    gl->glEnableVertexAttribArray(0);
+    gl->glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    gl->glUseProgram(program);
+    GLint offset = gl->glGetUniformLocation(program, "offset");
+    start = bench_now_ms();
+    for (int i = 0; i < BENCH_DRAW_CALLS; i++) {
+        // Uniform changes keep the driver from batching the draws away
+        gl->glUniform1f(offset, (i & 1) * 0.01f);
+        gl->glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+    gl->glFinish();
+    result->draw = bench_now_ms() - start;
+    gl->glUseProgram(0);
+    gl->glDeleteBuffers(1, &vbo);
+    gl->glDeleteVertexArrays(1, &vao);
+    gl->glDeleteProgram(program);
+
+    // Draw throughput dominates frame time, compile/upload mostly affect loading
+    result->score = result->draw + (result->upload + result->compile) / 4;
+    return true;
+}
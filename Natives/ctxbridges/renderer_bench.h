@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdbool.h>
+
+#define GL_GLEXT_PROTOTYPES
+#include "GL/gl.h"
+#include "GL/glext.h"
+
+// The workload the renderer probe times: shader compiles, texture uploads
+// and uniform-separated draw calls, in the core profile GLSL dialect the
+// game uses. Entry points come from the renderer library itself rather than
+// the process-wide GL symbols, so each candidate can be measured in turn.
+
+typedef struct {
+    void (*glAttachShader)(GLuint program, GLuint shader);
+    void (*glBindAttribLocation)(GLuint program, GLuint index, const GLchar *name);
+    void (*glBindBuffer)(GLenum target, GLuint buffer);
+    void (*glBindTexture)(GLenum target, GLuint texture);
+    void (*glBindVertexArray)(GLuint array);
+    void (*glBufferData)(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
+    void (*glCompileShader)(GLuint shader);
+    GLuint (*glCreateProgram)(void);
+    GLuint (*glCreateShader)(GLenum type);
+    void (*glDeleteBuffers)(GLsizei n, const GLuint *buffers);
+    void (*glDeleteProgram)(GLuint program);
+    void (*glDeleteShader)(GLuint shader);
+    void (*glDeleteTextures)(GLsizei n, const GLuint *textures);
+    void (*glDeleteVertexArrays)(GLsizei n, const GLuint *arrays);
+    void (*glDrawArrays)(GLenum mode, GLint first, GLsizei count);
+    void (*glEnableVertexAttribArray)(GLuint index);
+    void (*glFinish)(void);
+    void (*glGenBuffers)(GLsizei n, GLuint *buffers);
+    void (*glGenTextures)(GLsizei n, GLuint *textures);
+    void (*glGenVertexArrays)(GLsizei n, GLuint *arrays);
+    void (*glGetProgramiv)(GLuint program, GLenum pname, GLint *params);
+    GLint (*glGetUniformLocation)(GLuint program, const GLchar *name);
+    void (*glLinkProgram)(GLuint program);
+    void (*glShaderSource)(GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length);
+    void (*glTexImage2D)(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels);
+    void (*glUniform1f)(GLint location, GLfloat v0);
+    void (*glUseProgram)(GLuint program);
+    void (*glVertexAttribPointer)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer);
+    void (*glViewport)(GLint x, GLint y, GLsizei width, GLsizei height);
+} renderer_bench_gl_t;
+
+// Timings in milliseconds, lower scores are better
+typedef struct {
+    double compile;
+    double upload;
+    double draw;
+    double score;
+} renderer_bench_result_t;
+
+// Returns false if the library lacks any of the entry points
+bool renderer_bench_load(void *dl_handle, renderer_bench_gl_t *gl);
+// Runs the workload on the current context. Returns false if the renderer
+// can't compile or link the shaders, i.e. it is unusable for the game.
+bool renderer_bench_run(const renderer_bench_gl_t *gl, renderer_bench_result_t *result);
@@ -0,0 +1,13 @@
+#pragma once
+
+// Returns the fastest renderer library that supports the requested
+// GL major version on this device. Each candidate is benchmarked once per
+// device model (draw calls, texture upload, shader compile) and the results
+// are cached in $POJAV_HOME/renderer_benchmark.plist.
+// Waits for renderer_probe_start if it is still measuring.
+const char* renderer_probe_select(int glMajor);
+
+// Runs the benchmark on a background queue unless this device model already
+// has results, so that it overlaps JVM startup instead of stalling the GLFW
+// thread when the game asks for a context. Only the first call does anything.
+void renderer_probe_start();
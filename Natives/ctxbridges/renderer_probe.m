@@ -0,0 +1,149 @@
+#import <Foundation/Foundation.h>
+#import "HostManagerBridge.h"
+
+#include <dlfcn.h>
+
+#include "environ.h"
+#include "gl_bridge.h"
+#include "renderer_bench.h"
+#include "renderer_probe.h"
+#include "utils.h"
+
+// Bump when the workload changes so that stale scores are re-measured
+#define PROBE_VERSION 1
+
+typedef struct {
+    const char *name;
+    int minMajor, maxMajor;
+} probe_renderer_t;
+
+// gl4es is the only one with the fixed-function pipeline legacy versions
+// need, so in practice only the core profile renderers get benchmarked
+static const probe_renderer_t probeRenderers[] = {
+    {RENDERER_NAME_GL4ES, 1, 2},
+    {RENDERER_NAME_MTL_ANGLE, 3, 4},
+    {RENDERER_NAME_MOBILEGLUES, 3, 4}
+};
+
+#define PROBE_RENDERER_COUNT (int)(sizeof(probeRenderers) / sizeof(probe_renderer_t))
+
+// Measured results of this device model, filled in by the background probe
+static NSDictionary *probeResults;
+static dispatch_group_t probeGroup;
+
+static BOOL probe_is_desktop_gl(const char *name) {
+    return !strcmp(name, RENDERER_NAME_MTL_ANGLE);
+}
+
+// Only renderers that compete with another one for some version are worth timing
+static BOOL probe_has_rival(int index) {
+    for (int i = 0; i < PROBE_RENDERER_COUNT; i++) {
+        if (i != index && probeRenderers[i].minMajor <= probeRenderers[index].maxMajor &&
+            probeRenderers[index].minMajor <= probeRenderers[i].maxMajor) {
+            return YES;
+        }
+    }
+    return NO;
+}
+
+static NSDictionary* probe_renderer(const char *name) {
+    void *dl_handle = dlopen([NSString stringWithFormat:@"@rpath/%s", name].UTF8String, RTLD_LOCAL);
+    if (!dl_handle) {
+        NSLog(@"[RendererProbe] Skipping %s: %s", name, dlerror());
+        return nil;
+    }
+    renderer_bench_gl_t gl;
+    if (!renderer_bench_load(dl_handle, &gl)) {
+        NSLog(@"[RendererProbe] Skipping %s: missing GL entry points", name);
+        return nil;
+    }
+
+    NSDictionary *result = nil;
+    renderer_bench_result_t timings;
+    // A standalone context, its pbuffer is destroyed with it rather than
+    // pooled for the game's worker contexts
+    gl_render_window_t *bundle = gl_init_offscreen_context(probe_is_desktop_gl(name));
+    if (bundle) {
+        gl_make_current(bundle);
+        if (renderer_bench_run(&gl, &timings)) {
+            result = @{
+                @"compile": @(timings.compile),
+                @"upload": @(timings.upload),
+                @"draw": @(timings.draw),
+                @"score": @(timings.score)
+            };
+        }
+        gl_make_current(NULL);
+        gl_destroy_context(bundle);
+    }
+
+    NSLog(@"[RendererProbe] %s: %@", name, result ?: @"unusable");
+    return result;
+}
+
+static NSDictionary* probe_measure() {
+    NSString *cachePath = [NSString stringWithFormat:@"%s/renderer_benchmark.plist", getenv("POJAV_HOME")];
+    NSMutableDictionary *cache = [NSMutableDictionary dictionaryWithContentsOfFile:cachePath] ?: [NSMutableDictionary new];
+    NSString *model = [NSString stringWithFormat:@"%@ v%d", [HostManager GetModelName] ?: @"unknown", PROBE_VERSION];
+    NSMutableDictionary *results = [cache[model] mutableCopy] ?: [NSMutableDictionary new];
+
+    BOOL changed = NO;
+    for (int i = 0; i < PROBE_RENDERER_COUNT; i++) {
+        NSString *name = @(probeRenderers[i].name);
+        if (results[name] || !probe_has_rival(i)) continue;
+        if (!changed && !gl_init()) {
+            break;
+        }
+        // Record failures too, so a broken renderer is not probed every launch
+        results[name] = probe_renderer(probeRenderers[i].name) ?: @{};
+        changed = YES;
+    }
+    if (changed) {
+        cache[model] = results;
+        [cache writeToFile:cachePath atomically:YES];
+    }
+    return results;
+}
+
+void renderer_probe_start() {
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        probeGroup = dispatch_group_create();
+        dispatch_group_async(probeGroup, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^{
+            probeResults = probe_measure();
+        });
+    });
+}
+
+const char* renderer_probe_select(int glMajor) {
+    // Fallback when nothing could be measured, same as the version-only logic
+    const char *fallback = glMajor <= 2 ? RENDERER_NAME_GL4ES : RENDERER_NAME_MTL_ANGLE;
+
+    const probe_renderer_t *candidates[PROBE_RENDERER_COUNT];
+    int candidateCount = 0;
+    for (int i = 0; i < PROBE_RENDERER_COUNT; i++) {
+        if (glMajor >= probeRenderers[i].minMajor && glMajor <= probeRenderers[i].maxMajor) {
+            candidates[candidateCount++] = &probeRenderers[i];
+        }
+    }
+    if (candidateCount < 2) {
+        return candidateCount ? candidates[0]->name : fallback;
+    }
+
+    // Normally done by now, it started with the JVM. The game's own EGL
+    // setup comes after this, so the probe never shares the display with it.
+    renderer_probe_start();
+    dispatch_group_wait(probeGroup, DISPATCH_TIME_FOREVER);
+
+    const char *best = fallback;
+    double bestScore = INFINITY;
+    for (int i = 0; i < candidateCount; i++) {
+        NSNumber *score = probeResults[@(candidates[i]->name)][@"score"];
+        if (score && score.doubleValue < bestScore) {
+            bestScore = score.doubleValue;
+            best = candidates[i]->name;
+        }
+    }
+    NSLog(@"[RendererProbe] Selected %s for OpenGL %d.x", best, glMajor);
+    return best;
+}
@@ -0,0 +1,312 @@
+// Thin Vulkan wrapper around MoltenVK that gives the game a persistent,
+// process-wide VkPipelineCache. LWJGL loads this library in place of
+// libMoltenVK.dylib (see org.lwjgl.vulkan.libname) and resolves everything
+// through vkGetInstanceProcAddr, so only a handful of entry points need to be
+// intercepted:
+// - vkCreateDevice: create the cache, seeded from the blob on disk if its
+//   header matches the physical device
+// - vkCreate{Graphics,Compute}Pipelines: use the cache when the caller has none
+// - vkDestroyPipelineCache: merge caller-owned caches into ours before they go
+// - vkDestroyDevice: save the cache
+// The cache is also saved periodically in the background while dirty.
+// AMETHYST_VK_DRIVER names another Vulkan library to wrap, e.g. the loader
+// with lavapipe for the host tests.
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <vulkan/vulkan.h>
+
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#endif
+
+#define SAVE_INTERVAL_SEC 60
+
+static PFN_vkGetInstanceProcAddr real_vkGetInstanceProcAddr;
+static PFN_vkGetDeviceProcAddr real_vkGetDeviceProcAddr;
+// The driver's own export, for callers that resolve devices before any instance
+static PFN_vkGetDeviceProcAddr driver_vkGetDeviceProcAddr;
+static PFN_vkCreateDevice real_vkCreateDevice;
+static PFN_vkDestroyDevice real_vkDestroyDevice;
+static PFN_vkGetPhysicalDeviceProperties real_vkGetPhysicalDeviceProperties;
+static PFN_vkCreatePipelineCache real_vkCreatePipelineCache;
+static PFN_vkDestroyPipelineCache real_vkDestroyPipelineCache;
+static PFN_vkGetPipelineCacheData real_vkGetPipelineCacheData;
+static PFN_vkMergePipelineCaches real_vkMergePipelineCaches;
+static PFN_vkCreateGraphicsPipelines real_vkCreateGraphicsPipelines;
+static PFN_vkCreateComputePipelines real_vkCreateComputePipelines;
+
+static pthread_mutex_t g_Lock = PTHREAD_MUTEX_INITIALIZER;
+static VkInstance g_Instance;
+static VkDevice g_Device;
+static VkPipelineCache g_Cache;
+// Set by pipeline creation on any thread without taking g_Lock
+static atomic_bool g_Dirty;
+#ifdef __APPLE__
+static dispatch_source_t g_SaveTimer;
+#endif
+
+VkPipelineCache amethyst_vkGetPipelineCache(VkDevice device);
+
+static void vkpc_load_moltenvk() {
+    if (real_vkGetInstanceProcAddr) return;
+    const char *driver = getenv("AMETHYST_VK_DRIVER");
+    void *dl_handle;
+    if (driver && *driver) {
+        dl_handle = dlopen(driver, RTLD_LOCAL | RTLD_LAZY);
+    } else {
+        dl_handle = dlopen("libMoltenVK.dylib", RTLD_NOLOAD | RTLD_LAZY);
+        if (!dl_handle) {
+            dl_handle = dlopen("@rpath/libMoltenVK.dylib", RTLD_LOCAL | RTLD_LAZY);
+        }
+    }
+    if (!dl_handle) {
+        printf("[VkPipelineCache] Failed to load MoltenVK: %s\n", dlerror());
+        return;
+    }
+    driver_vkGetDeviceProcAddr = dlsym(dl_handle, "vkGetDeviceProcAddr");
+    real_vkGetInstanceProcAddr = dlsym(dl_handle, "vkGetInstanceProcAddr");
+}
+
+static const char *vkpc_path() {
+    const char *path = getenv("AMETHYST_VK_PIPELINE_CACHE");
+    return (path && *path) ? path : NULL;
+}
+
+// Returns the blob on disk if it was written for this exact device and driver
+static void *vkpc_read_blob(VkPhysicalDevice physicalDevice, size_t *size) {
+    *size = 0;
+    const char *path = vkpc_path();
+    if (!path) return NULL;
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return NULL;
+    struct stat st;
+    void *data = NULL;
+    if (fstat(fileno(file), &st) == 0 && st.st_size >= 16 + VK_UUID_SIZE) {
+        data = malloc(st.st_size);
+        if (fread(data, 1, st.st_size, file) != (size_t)st.st_size) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(file);
+    if (!data) return NULL;
+
+    VkPhysicalDeviceProperties props;
+    real_vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    const uint32_t *header = data;
+    if (header[0] < 16 + VK_UUID_SIZE || header[0] > st.st_size ||
+        header[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        header[2] != props.vendorID || header[3] != props.deviceID ||
+        memcmp(&header[4], props.pipelineCacheUUID, VK_UUID_SIZE)) {
+        printf("[VkPipelineCache] Discarding cache written for another device or driver\n");
+        free(data);
+        return NULL;
+    }
+    *size = st.st_size;
+    return data;
+}
+
+// Must be called with g_Lock held
+static void vkpc_save_locked() {
+    const char *path = vkpc_path();
+    if (!path || !g_Cache) return;
+    // Cleared before reading the data, pipelines created meanwhile mark it again
+    if (!atomic_exchange(&g_Dirty, false)) return;
+
+    size_t size = 0;
+    if (real_vkGetPipelineCacheData(g_Device, g_Cache, &size, NULL) != VK_SUCCESS || size == 0) {
+        atomic_store(&g_Dirty, true);
+        return;
+    }
+    void *data = malloc(size);
+    if (real_vkGetPipelineCacheData(g_Device, g_Cache, &size, data) != VK_SUCCESS) {
+        atomic_store(&g_Dirty, true);
+        free(data);
+        return;
+    }
+
+    // Write to a sibling file and rename over the old one so a crash never
+    // leaves a truncated cache behind
+    char tmpPath[PATH_MAX];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd != -1) {
+        bool ok = write(fd, data, size) == (ssize_t)size;
+        ok = close(fd) == 0 && ok;
+        if (ok && rename(tmpPath, path) == 0) {
+            printf("[VkPipelineCache] Saved %zu bytes\n", size);
+            free(data);
+            return;
+        }
+        unlink(tmpPath);
+    }
+    atomic_store(&g_Dirty, true);
+    free(data);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL hooked_vkCreateDevice(VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDevice *pDevice) {
+    VkResult result = real_vkCreateDevice(physicalDevice, pCreateInfo, pAllocator, pDevice);
+    if (result != VK_SUCCESS) return result;
+
+    pthread_mutex_lock(&g_Lock);
+    if (g_Device) {
+        // Only the first device gets the persistent cache
+        pthread_mutex_unlock(&g_Lock);
+        return result;
+    }
+
+    size_t size;
+    void *blob = vkpc_read_blob(physicalDevice, &size);
+    VkPipelineCacheCreateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = size,
+        .pInitialData = blob
+    };
+    if (real_vkCreatePipelineCache(*pDevice, &info, NULL, &g_Cache) != VK_SUCCESS && blob) {
+        // The driver rejected the blob, start over with an empty cache
+        info.initialDataSize = 0;
+        info.pInitialData = NULL;
+        real_vkCreatePipelineCache(*pDevice, &info, NULL, &g_Cache);
+    }
+    free(blob);
+    printf("[VkPipelineCache] Created cache %p (%zu bytes loaded)\n", (void *)g_Cache, size);
+
+    if (g_Cache) {
+        g_Device = *pDevice;
+#ifdef __APPLE__
+        g_SaveTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+        dispatch_source_set_timer(g_SaveTimer, dispatch_time(DISPATCH_TIME_NOW, SAVE_INTERVAL_SEC * NSEC_PER_SEC),
+            SAVE_INTERVAL_SEC * NSEC_PER_SEC, NSEC_PER_SEC);
+        dispatch_source_set_event_handler(g_SaveTimer, ^{
+            pthread_mutex_lock(&g_Lock);
+            vkpc_save_locked();
+            pthread_mutex_unlock(&g_Lock);
+        });
+        dispatch_resume(g_SaveTimer);
+#endif
+    }
+    pthread_mutex_unlock(&g_Lock);
+    return result;
+}
+
+static VKAPI_ATTR void VKAPI_CALL hooked_vkDestroyDevice(VkDevice device, const VkAllocationCallbacks *pAllocator) {
+    pthread_mutex_lock(&g_Lock);
+    if (device && device == g_Device) {
+#ifdef __APPLE__
+        dispatch_source_cancel(g_SaveTimer);
+        g_SaveTimer = NULL;
+#endif
+        vkpc_save_locked();
+        real_vkDestroyPipelineCache(g_Device, g_Cache, NULL);
+        g_Cache = VK_NULL_HANDLE;
+        g_Device = VK_NULL_HANDLE;
+    }
+    pthread_mutex_unlock(&g_Lock);
+    real_vkDestroyDevice(device, pAllocator);
+}
+
+static VKAPI_ATTR void VKAPI_CALL hooked_vkDestroyPipelineCache(VkDevice device, VkPipelineCache pipelineCache, const VkAllocationCallbacks *pAllocator) {
+    pthread_mutex_lock(&g_Lock);
+    if (pipelineCache && device == g_Device && pipelineCache != g_Cache &&
+        real_vkMergePipelineCaches(device, g_Cache, 1, &pipelineCache) == VK_SUCCESS) {
+        atomic_store(&g_Dirty, true);
+    }
+    pthread_mutex_unlock(&g_Lock);
+    real_vkDestroyPipelineCache(device, pipelineCache, pAllocator);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL hooked_vkCreateGraphicsPipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo *pCreateInfos, const VkAllocationCallbacks *pAllocator, VkPipeline *pPipelines) {
+    if (!pipelineCache && device == g_Device) {
+        pipelineCache = g_Cache;
+        atomic_store(&g_Dirty, true);
+    }
+    return real_vkCreateGraphicsPipelines(device, pipelineCache, createInfoCount, pCreateInfos, pAllocator, pPipelines);
+}
+
+static VKAPI_ATTR VkResult VKAPI_CALL hooked_vkCreateComputePipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkComputePipelineCreateInfo *pCreateInfos, const VkAllocationCallbacks *pAllocator, VkPipeline *pPipelines) {
+    if (!pipelineCache && device == g_Device) {
+        pipelineCache = g_Cache;
+        atomic_store(&g_Dirty, true);
+    }
+    return real_vkCreateComputePipelines(device, pipelineCache, createInfoCount, pCreateInfos, pAllocator, pPipelines);
+}
+
+static PFN_vkVoidFunction vkpc_hooked_device_proc(const char *pName) {
+    if (!strcmp(pName, "vkDestroyDevice")) return (PFN_vkVoidFunction)hooked_vkDestroyDevice;
+    if (!strcmp(pName, "vkDestroyPipelineCache")) return (PFN_vkVoidFunction)hooked_vkDestroyPipelineCache;
+    if (!strcmp(pName, "vkCreateGraphicsPipelines")) return (PFN_vkVoidFunction)hooked_vkCreateGraphicsPipelines;
+    if (!strcmp(pName, "vkCreateComputePipelines")) return (PFN_vkVoidFunction)hooked_vkCreateComputePipelines;
+    return NULL;
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice device, const char *pName) {
+    vkpc_load_moltenvk();
+    // Only known once vkGetInstanceProcAddr saw an instance
+    PFN_vkGetDeviceProcAddr getDeviceProcAddr = real_vkGetDeviceProcAddr ? real_vkGetDeviceProcAddr : driver_vkGetDeviceProcAddr;
+    if (!getDeviceProcAddr) return NULL;
+    PFN_vkVoidFunction func = getDeviceProcAddr(device, pName);
+    if (func && device == g_Device) {
+        PFN_vkVoidFunction hooked = vkpc_hooked_device_proc(pName);
+        if (hooked) return hooked;
+    }
+    return func;
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance instance, const char *pName) {
+    vkpc_load_moltenvk();
+    if (!real_vkGetInstanceProcAddr) return NULL;
+    if (!strcmp(pName, "vkGetInstanceProcAddr")) return (PFN_vkVoidFunction)vkGetInstanceProcAddr;
+    // LWJGL's function provider resolves everything through here, MoltenVK
+    // knows nothing about our own export
+    if (!strcmp(pName, "amethyst_vkGetPipelineCache")) return (PFN_vkVoidFunction)amethyst_vkGetPipelineCache;
+
+    PFN_vkVoidFunction func = real_vkGetInstanceProcAddr(instance, pName);
+    if (!func || !instance) return func;
+
+    if (instance != g_Instance) {
+        pthread_mutex_lock(&g_Lock);
+        if (!g_Device) {
+            g_Instance = instance;
+            real_vkGetDeviceProcAddr = (PFN_vkGetDeviceProcAddr)real_vkGetInstanceProcAddr(instance, "vkGetDeviceProcAddr");
+            real_vkCreateDevice = (PFN_vkCreateDevice)real_vkGetInstanceProcAddr(instance, "vkCreateDevice");
+            real_vkDestroyDevice = (PFN_vkDestroyDevice)real_vkGetInstanceProcAddr(instance, "vkDestroyDevice");
+            real_vkGetPhysicalDeviceProperties = (PFN_vkGetPhysicalDeviceProperties)real_vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties");
+            // Instance-level trampolines dispatch to any device of the instance
+            real_vkCreatePipelineCache = (PFN_vkCreatePipelineCache)real_vkGetInstanceProcAddr(instance, "vkCreatePipelineCache");
+            real_vkDestroyPipelineCache = (PFN_vkDestroyPipelineCache)real_vkGetInstanceProcAddr(instance, "vkDestroyPipelineCache");
+            real_vkGetPipelineCacheData = (PFN_vkGetPipelineCacheData)real_vkGetInstanceProcAddr(instance, "vkGetPipelineCacheData");
+            real_vkMergePipelineCaches = (PFN_vkMergePipelineCaches)real_vkGetInstanceProcAddr(instance, "vkMergePipelineCaches");
+            real_vkCreateGraphicsPipelines = (PFN_vkCreateGraphicsPipelines)real_vkGetInstanceProcAddr(instance, "vkCreateGraphicsPipelines");
+            real_vkCreateComputePipelines = (PFN_vkCreateComputePipelines)real_vkGetInstanceProcAddr(instance, "vkCreateComputePipelines");
+        }
+        pthread_mutex_unlock(&g_Lock);
+    }
+    if (instance != g_Instance) return func;
+
+    if (!strcmp(pName, "vkGetDeviceProcAddr")) return (PFN_vkVoidFunction)vkGetDeviceProcAddr;
+    if (!strcmp(pName, "vkCreateDevice")) return (PFN_vkVoidFunction)hooked_vkCreateDevice;
+    // Device functions fetched through the instance dispatch to any device,
+    // the hooks fall through for devices other than ours
+    PFN_vkVoidFunction hooked = vkpc_hooked_device_proc(pName);
+    return hooked ? hooked : func;
+}
+
+// Exposed to Java through GLFWVulkan.glfwGetPipelineCacheAmethyst
+VkPipelineCache amethyst_vkGetPipelineCache(VkDevice device) {
+    pthread_mutex_lock(&g_Lock);
+    VkPipelineCache cache = device == g_Device ? g_Cache : VK_NULL_HANDLE;
+    pthread_mutex_unlock(&g_Lock);
+    return cache;
+}
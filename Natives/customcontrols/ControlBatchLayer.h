@@ -0,0 +1,16 @@
+#import <QuartzCore/QuartzCore.h>
+#include "control_batch.h"
+
+/**
+ * Draws all batched controls of a ControlLayout into one backing store.
+ * The buttons stay in the view tree for touch handling but keep their own
+ * layers empty; only the regions of controls that changed get redrawn.
+ */
+@interface ControlBatchLayer : CALayer
+
+- (NSUInteger)addControl;
+- (void)updateControl:(NSUInteger)index item:(const control_item_t *)item title:(NSString *)title;
+- (void)setControl:(NSUInteger)index highlighted:(BOOL)highlighted;
+- (void)removeAllControls;
+
+@end
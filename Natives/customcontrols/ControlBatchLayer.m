@@ -0,0 +1,139 @@
+#import <UIKit/UIKit.h>
+#import "ControlBatchLayer.h"
+
+#define TITLE_FONT_SIZE 15.0
+#define TITLE_MIN_FONT_SIZE 6.0
+
+@interface ControlBatchLayer() {
+    control_batch_t _batch;
+}
+@property(nonatomic) NSMutableArray<NSAttributedString *> *titles;
+@property(nonatomic) BOOL flushScheduled;
+@end
+
+@implementation ControlBatchLayer
+
+- (instancetype)init {
+    self = [super init];
+    control_batch_init(&_batch);
+    self.titles = [NSMutableArray new];
+    self.contentsScale = UIScreen.mainScreen.scale;
+    self.needsDisplayOnBoundsChange = YES;
+    return self;
+}
+
+- (void)dealloc {
+    control_batch_destroy(&_batch);
+}
+
+// Redraws must show up immediately, not crossfade
+- (id<CAAction>)actionForKey:(NSString *)event {
+    return nil;
+}
+
+- (NSUInteger)addControl {
+    [self.titles addObject:[NSAttributedString new]];
+    return control_batch_add(&_batch);
+}
+
+- (NSAttributedString *)fittedTitle:(NSString *)title inSize:(CGSize)size {
+    NSMutableParagraphStyle *style = [NSMutableParagraphStyle new];
+    style.alignment = NSTextAlignmentCenter;
+    style.lineBreakMode = NSLineBreakByCharWrapping;
+    // Same as the button's label: shrink until it fits
+    NSAttributedString *result;
+    for (CGFloat fontSize = TITLE_FONT_SIZE; fontSize >= TITLE_MIN_FONT_SIZE; fontSize--) {
+        result = [[NSAttributedString alloc] initWithString:title attributes:@{
+            NSFontAttributeName: [UIFont systemFontOfSize:fontSize],
+            NSForegroundColorAttributeName: UIColor.whiteColor,
+            NSParagraphStyleAttributeName: style
+        }];
+        CGRect bounds = [result boundingRectWithSize:CGSizeMake(size.width, CGFLOAT_MAX)
+            options:NSStringDrawingUsesLineFragmentOrigin context:nil];
+        if (bounds.size.height <= size.height) break;
+    }
+    return result;
+}
+
+- (void)updateControl:(NSUInteger)index item:(const control_item_t *)item title:(NSString *)title {
+    control_item_t *current = &_batch.items[index];
+    BOOL sizeChanged = current->frame.width != item->frame.width || current->frame.height != item->frame.height;
+    if (sizeChanged || ![self.titles[index].string isEqualToString:title ?: @""]) {
+        self.titles[index] = [self fittedTitle:title ?: @"" inSize:CGSizeMake(item->frame.width, item->frame.height)];
+        control_batch_invalidate_item(&_batch, index);
+    }
+    control_batch_update(&_batch, index, item);
+    [self scheduleFlush];
+}
+
+- (void)setControl:(NSUInteger)index highlighted:(BOOL)highlighted {
+    control_batch_set_flag(&_batch, index, CONTROL_ITEM_HIGHLIGHTED, highlighted);
+    [self scheduleFlush];
+}
+
+- (void)removeAllControls {
+    control_batch_remove_all(&_batch);
+    [self.titles removeAllObjects];
+    [self scheduleFlush];
+}
+
+// Coalesces all changes made during this run loop pass
+- (void)scheduleFlush {
+    if (self.flushScheduled) return;
+    self.flushScheduled = YES;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        self.flushScheduled = NO;
+        control_rect_t dirty[CONTROL_BATCH_MAX_DIRTY];
+        size_t count = control_batch_take_dirty(&_batch, dirty);
+        for (size_t i = 0; i < count; i++) {
+            [self setNeedsDisplayInRect:CGRectMake(dirty[i].x, dirty[i].y, dirty[i].width, dirty[i].height)];
+        }
+    });
+}
+
+static UIColor *colorFromARGB(uint32_t argb, CGFloat opacity) {
+    return [UIColor colorWithRed:((argb >> 16) & 0xFF) / 255.0
+        green:((argb >> 8) & 0xFF) / 255.0
+        blue:(argb & 0xFF) / 255.0
+        alpha:((argb >> 24) & 0xFF) / 255.0 * opacity];
+}
+
+- (void)drawInContext:(CGContextRef)ctx {
+    CGRect clip = CGContextGetClipBoundingBox(ctx);
+    control_rect_t clipRect = {clip.origin.x, clip.origin.y, clip.size.width, clip.size.height};
+    UIGraphicsPushContext(ctx);
+    for (size_t i = 0; i < _batch.count; i++) {
+        const control_item_t *item = &_batch.items[i];
+        if (!control_item_visible(item) || !control_rect_intersects(control_item_bounds(item), clipRect)) {
+            continue;
+        }
+
+        CGRect frame = CGRectMake(item->frame.x, item->frame.y, item->frame.width, item->frame.height);
+        UIBezierPath *path = [UIBezierPath bezierPathWithRoundedRect:frame cornerRadius:item->cornerRadius];
+        [colorFromARGB(item->fillColor, item->opacity) setFill];
+        [path fill];
+        if (item->strokeWidth > 0) {
+            path.lineWidth = item->strokeWidth;
+            [colorFromARGB(item->strokeColor, item->opacity) setStroke];
+            [path stroke];
+        }
+
+        NSAttributedString *title = self.titles[i];
+        if (title.length == 0) continue;
+        CGRect textBounds = [title boundingRectWithSize:CGSizeMake(frame.size.width, CGFLOAT_MAX)
+            options:NSStringDrawingUsesLineFragmentOrigin context:nil];
+        CGRect textRect = CGRectMake(frame.origin.x,
+            frame.origin.y + (frame.size.height - textBounds.size.height) / 2,
+            frame.size.width, textBounds.size.height);
+        // System buttons dim their title while pressed
+        CGFloat alpha = item->opacity * (item->flags & CONTROL_ITEM_HIGHLIGHTED ? 0.2 : 1);
+        CGContextSaveGState(ctx);
+        CGContextClipToRect(ctx, frame);
+        CGContextSetAlpha(ctx, alpha);
+        [title drawWithRect:textRect options:NSStringDrawingUsesLineFragmentOrigin context:nil];
+        CGContextRestoreGState(ctx);
+    }
+    UIGraphicsPopContext();
+}
+
+@end
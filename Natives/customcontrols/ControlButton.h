@@ -14,8 +14,12 @@
 @property BOOL canBeHidden, displayInGame, displayInMenu, isToggleOn;
 @property(nonatomic) NSMutableDictionary* properties;
 @property(nonatomic) UIColor* savedBackgroundColor;
+// Drawn by the layout's batch layer, the button's own layer stays empty
+@property(nonatomic, readonly) BOOL batched;
 
 + (id)buttonWithProperties:(NSMutableDictionary *)propArray;
+// Whether the layout's batch layer can draw this kind of control
++ (BOOL)supportsBatching;
 
 - (CGFloat)calculateDynamicPos:(NSString *)string;
 - (BOOL)canSnap:(ControlButton *)button;
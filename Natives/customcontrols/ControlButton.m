@@ -1,3 +1,4 @@
+#import "ControlBatchLayer.h"
 #import "ControlButton.h"
 #import "ControlLayout.h"
 #import "CustomControlsUtils.h"
@@ -12,6 +13,14 @@
 #define INSERT_VALUE(KEY, VALUE) \
   string = [string stringByReplacingOccurrencesOfString:[NSString stringWithFormat:@"${%@}", @(KEY)] withString:VALUE];
 
+@interface ControlButton() {
+    control_item_t _batchItem;
+}
+@property(nonatomic) BOOL batched;
+@property(nonatomic) NSUInteger batchIndex;
+@property(nonatomic) UIColor *batchBackgroundColor;
+@end
+
 @implementation ControlButton
 
 + (void)load {
@@ -40,6 +49,100 @@
     return instance;
 }
 
++ (BOOL)supportsBatching {
+    return YES;
+}
+
+#pragma mark - Batched rendering
+
+- (ControlBatchLayer *)batchLayer {
+    return self.batched ? ((ControlLayout *)self.superview).batchLayer : nil;
+}
+
+- (void)willMoveToSuperview:(UIView *)newSuperview {
+    [super willMoveToSuperview:newSuperview];
+    if (self.batched && newSuperview != self.superview) {
+        // Leave nothing behind in the old layout's layer
+        _batchItem.flags = CONTROL_ITEM_HIDDEN;
+        [self.batchLayer updateControl:self.batchIndex item:&_batchItem title:nil];
+        [super setBackgroundColor:self.batchBackgroundColor];
+        self.batched = NO;
+    }
+}
+
+- (void)didMoveToSuperview {
+    [super didMoveToSuperview];
+    if (self.batched || ![self.superview isKindOfClass:ControlLayout.class] || !self.class.supportsBatching) {
+        return;
+    }
+    ControlBatchLayer *batchLayer = ((ControlLayout *)self.superview).batchLayer;
+    if (!batchLayer) return;
+    self.batchIndex = [batchLayer addControl];
+    self.batched = YES;
+    // The button only handles touches from now on, its own layer stays empty
+    self.batchBackgroundColor = super.backgroundColor;
+    [super setBackgroundColor:UIColor.clearColor];
+    self.layer.borderWidth = 0;
+    [self setTitle:nil forState:UIControlStateNormal];
+    [self syncBatchItem];
+    [(ControlLayout *)self.superview orderBatchLayer];
+}
+
+static uint32_t colorToARGB(UIColor *color) {
+    CGFloat r = 0, g = 0, b = 0, a = 0;
+    [color getRed:&r green:&g blue:&b alpha:&a];
+    return ((uint32_t)(a * 255) << 24) | ((uint32_t)(r * 255) << 16) | ((uint32_t)(g * 255) << 8) | (uint32_t)(b * 255);
+}
+
+- (void)syncBatchItem {
+    ControlBatchLayer *batchLayer = self.batchLayer;
+    if (!batchLayer) return;
+    CGRect frame = self.frame;
+    _batchItem.frame = (control_rect_t){frame.origin.x, frame.origin.y, frame.size.width, frame.size.height};
+    _batchItem.fillColor = colorToARGB(self.batchBackgroundColor);
+    _batchItem.opacity = self.alpha;
+    _batchItem.flags = (self.hidden ? CONTROL_ITEM_HIDDEN : 0) | (self.highlighted ? CONTROL_ITEM_HIGHLIGHTED : 0);
+    [batchLayer updateControl:self.batchIndex item:&_batchItem title:self.properties[@"name"]];
+}
+
+- (void)setFrame:(CGRect)frame {
+    [super setFrame:frame];
+    if ([self.superview isKindOfClass:ControlLayout.class]) {
+        [(ControlLayout *)self.superview setNeedsHitIndexRebuild];
+    }
+    [self syncBatchItem];
+}
+
+- (void)setHidden:(BOOL)hidden {
+    [super setHidden:hidden];
+    [self syncBatchItem];
+}
+
+- (void)setAlpha:(CGFloat)alpha {
+    [super setAlpha:alpha];
+    [self syncBatchItem];
+}
+
+- (void)setHighlighted:(BOOL)highlighted {
+    [super setHighlighted:highlighted];
+    if (self.batched) {
+        [self.batchLayer setControl:self.batchIndex highlighted:highlighted];
+    }
+}
+
+- (void)setBackgroundColor:(UIColor *)backgroundColor {
+    if (!self.batched) {
+        [super setBackgroundColor:backgroundColor];
+        return;
+    }
+    self.batchBackgroundColor = backgroundColor;
+    [self syncBatchItem];
+}
+
+- (UIColor *)backgroundColor {
+    return self.batched ? self.batchBackgroundColor : super.backgroundColor;
+}
+
 /*
 - (id)initWithName:(NSString *)name keycode:(int)keycode rect:(CGRect)rect transparency:(float)transparency {
     CGRect screenBounds = [[UIScreen mainScreen] bounds];
@@ -137,10 +240,25 @@
     string = [self processFunctions:string];
     // NSLog(@"After insert: %@", string);
 
-    // Calculate, since the dynamic position contains some math equations
-    NSExpression *expression = [NSExpression expressionWithFormat:string];
-    NSDictionary<NSString*, NSNumber*> *variables = @{@"pi": @(M_PI)};
-    return [[expression expressionValueWithObject:variables context:nil] floatValue] / screenScale;
+    // Every value is substituted by now, so the string alone determines the result;
+    // layouts repeat the same few equations across many buttons
+    static NSCache<NSString *, NSNumber *> *results;
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        results = [NSCache new];
+        results.countLimit = 1024;
+    });
+    NSNumber *result = [results objectForKey:string];
+    if (!result) {
+        // Calculate, since the dynamic position contains some math equations
+        NSExpression *expression = [NSExpression expressionWithFormat:string];
+        NSDictionary<NSString*, NSNumber*> *variables = @{@"pi": @(M_PI)};
+        result = [expression expressionValueWithObject:variables context:nil];
+        if (result) {
+            [results setObject:result forKey:string];
+        }
+    }
+    return result.floatValue / screenScale;
 }
 
 // NOTE: Unlike Android's impl, this method uses dp instead of px (no call to dpToPx)
@@ -197,6 +315,14 @@
         self.savedBackgroundColor = self.backgroundColor;
     }
 
+    if (self.batched) {
+        _batchItem.strokeColor = propStrokeColor;
+        _batchItem.strokeWidth = propStrokeWidth;
+        _batchItem.cornerRadius = MIN(propW, propH) / 200.0 * propCornerRadius;
+        [self syncBatchItem];
+        return;
+    }
+
     self.layer.borderColor = [convertARGB2UIColor(propStrokeColor) CGColor];
     self.layer.cornerRadius = MIN(self.frame.size.width, self.frame.size.height) / 200.0 * propCornerRadius;
     self.layer.borderWidth = propStrokeWidth;
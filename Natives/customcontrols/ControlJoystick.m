@@ -52,6 +52,11 @@ NSMutableDictionary* createButton(NSString* name, int* keycodes, NSString* dynam
     return instance;
 }
 
+// Draws its thumb and background with subviews
++ (BOOL)supportsBatching {
+    return NO;
+}
+
 - (void)touchesBegan:(NSSet<UITouch *> *)touches withEvent:(UIEvent *)event {
     if (isControlModifiable || touches.count != 1) return;
     if (touches.anyObject.view == self) {
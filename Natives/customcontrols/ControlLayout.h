@@ -1,16 +1,28 @@
 #import <UIKit/UIKit.h>
+#import "ControlBatchLayer.h"
 
 @interface CALayer(private)
 @property(atomic, assign) NSUInteger disableUpdateMask;
 @end
 
+@class ControlButton;
+
 @interface ControlLayout : UIView
 
 @property(nonatomic) NSMutableDictionary *layoutDictionary;
+// Draws the buttons outside the editor, nil while editing
+@property(nonatomic, readonly) ControlBatchLayer *batchLayer;
 
 - (void)loadControlLayout:(NSMutableDictionary *)layoutDictionary;
 - (void)loadControlFile:(NSString *)path;
 - (void)removeAllButtons;
 - (void)hideViewFromCapture:(BOOL)hide;
 
+// Topmost control whose frame contains point and that passes test
+- (ControlButton *)controlAtPoint:(CGPoint)point passingTest:(BOOL (^)(ControlButton *button))test;
+// Called when a control's frame changes
+- (void)setNeedsHitIndexRebuild;
+// Puts the batch layer right above the topmost batched control
+- (void)orderBatchLayer;
+
 @end
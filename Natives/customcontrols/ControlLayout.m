@@ -5,18 +5,54 @@
 #import "../LauncherPreferences.h"
 #import "../ios_uikit_bridge.h"
 #import "../utils.h"
+#include "control_grid.h"
 
-@interface ControlLayout ()
+// Roughly one default-sized button per cell
+#define HIT_INDEX_CELL_SIZE 48.0
+
+@interface ControlLayout () {
+    control_grid_t _hitIndex;
+}
+// Controls in subview order, as indexed by _hitIndex
+@property(nonatomic) NSArray<ControlButton *> *hitIndexControls;
+@property(nonatomic) BOOL hitIndexValid;
 @end
 
+typedef struct {
+    __unsafe_unretained NSArray<ControlButton *> *controls;
+    __unsafe_unretained BOOL (^test)(ControlButton *button);
+} HitIndexTestContext;
+
+static bool hitIndexTest(size_t index, void *context) {
+    HitIndexTestContext *ctx = context;
+    return ctx->test(ctx->controls[index]);
+}
+
 @implementation ControlLayout
 
+- (instancetype)initWithFrame:(CGRect)frame {
+    self = [super initWithFrame:frame];
+    control_grid_init(&_hitIndex);
+    return self;
+}
+
+- (void)dealloc {
+    control_grid_destroy(&_hitIndex);
+}
+
 - (void)loadControlLayout:(NSMutableDictionary *)layoutDictionary {
     self.layoutDictionary = layoutDictionary;
 
     CGFloat currentScale = [self.layoutDictionary[@"scaledAt"] floatValue];
     CGFloat savedScale = getPrefFloat(@"control.button_scale");
+    if (!isControlModifiable && !self.batchLayer) {
+        _batchLayer = [ControlBatchLayer new];
+        self.batchLayer.frame = self.bounds;
+        // Moved up by orderBatchLayer as controls get batched
+        [self.layer insertSublayer:self.batchLayer atIndex:0];
+    }
     loadControlObject(self, self.layoutDictionary);
+    [self orderBatchLayer];
 
     self.layoutDictionary[@"scaledAt"] = @(savedScale);
 }
@@ -36,6 +72,7 @@
 
 - (void)removeAllButtons {
     [self.subviews makeObjectsPerformSelector:@selector(removeFromSuperview)];
+    [self.batchLayer removeAllControls];
     [self.layoutDictionary removeAllObjects];
 }
 
@@ -59,15 +96,83 @@
 }
 
 - (UIView *)hitTest:(CGPoint)point withEvent:(UIEvent *)event {
-    UIView *result = [super hitTest:point withEvent:event];
-    if (result == self && !isControlModifiable) {
+    if (isControlModifiable) {
+        return [super hitTest:point withEvent:event];
+    }
+    // Same checks UIKit does, but only against the controls under the point
+    if (self.hidden || !self.userInteractionEnabled || self.alpha < 0.01 || ![self pointInside:point withEvent:event]) {
         return nil;
     }
-    return result;
+    ControlButton *button = [self controlAtPoint:point passingTest:^BOOL(ControlButton *control) {
+        return !control.hidden && control.userInteractionEnabled && control.alpha >= 0.01;
+    }];
+    return [button hitTest:[self convertPoint:point toView:button] withEvent:event];
+}
+
+- (void)orderBatchLayer {
+    if (!self.batchLayer) return;
+    // Controls drawn by their own layers (joysticks) keep their place relative
+    // to the batched ones below them; anything overlapping a batched control
+    // above the topmost of those still shows up under it
+    CALayer *below = nil;
+    for (UIView *view in self.subviews.reverseObjectEnumerator) {
+        if ([view isKindOfClass:ControlButton.class] && ((ControlButton *)view).batched) {
+            below = view.layer;
+            break;
+        }
+    }
+    if (below) {
+        [self.layer insertSublayer:self.batchLayer above:below];
+    } else {
+        [self.layer insertSublayer:self.batchLayer atIndex:0];
+    }
+}
+
+- (void)setNeedsHitIndexRebuild {
+    self.hitIndexValid = NO;
+}
+
+- (void)didAddSubview:(UIView *)subview {
+    [super didAddSubview:subview];
+    [self setNeedsHitIndexRebuild];
+}
+
+- (void)willRemoveSubview:(UIView *)subview {
+    [super willRemoveSubview:subview];
+    [self setNeedsHitIndexRebuild];
+}
+
+- (void)rebuildHitIndex {
+    NSMutableArray<ControlButton *> *controls = [NSMutableArray new];
+    for (UIView *view in self.subviews) {
+        if ([view isKindOfClass:ControlButton.class]) {
+            [controls addObject:(ControlButton *)view];
+        }
+    }
+    control_rect_t *rects = malloc(MAX(controls.count, 1) * sizeof(control_rect_t));
+    for (NSUInteger i = 0; i < controls.count; i++) {
+        CGRect frame = controls[i].frame;
+        rects[i] = (control_rect_t){frame.origin.x, frame.origin.y, frame.size.width, frame.size.height};
+    }
+    control_grid_build(&_hitIndex, rects, controls.count, HIT_INDEX_CELL_SIZE);
+    free(rects);
+    self.hitIndexControls = controls;
+    self.hitIndexValid = YES;
+}
+
+- (ControlButton *)controlAtPoint:(CGPoint)point passingTest:(BOOL (^)(ControlButton *button))test {
+    if (!self.hitIndexValid) {
+        [self rebuildHitIndex];
+    }
+    HitIndexTestContext context = {self.hitIndexControls, test};
+    long index = control_grid_hit(&_hitIndex, point.x, point.y, test ? hitIndexTest : NULL, &context);
+    return index < 0 ? nil : self.hitIndexControls[index];
 }
 
 - (void)setFrame:(CGRect)frame {
     [super setFrame:frame];
+    self.batchLayer.frame = self.bounds;
+    [self setNeedsHitIndexRebuild];
 
     for (UIView *view in self.subviews) {
         if (![view isKindOfClass:ControlButton.class]) {
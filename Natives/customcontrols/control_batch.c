@@ -0,0 +1,132 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "control_batch.h"
+
+void control_batch_init(control_batch_t *batch) {
+    memset(batch, 0, sizeof(*batch));
+}
+
+void control_batch_destroy(control_batch_t *batch) {
+    free(batch->items);
+    memset(batch, 0, sizeof(*batch));
+}
+
+void control_batch_remove_all(control_batch_t *batch) {
+    for (size_t i = 0; i < batch->count; i++) {
+        control_batch_invalidate_item(batch, i);
+    }
+    batch->count = 0;
+}
+
+size_t control_batch_add(control_batch_t *batch) {
+    if (batch->count == batch->capacity) {
+        batch->capacity = batch->capacity ? batch->capacity * 2 : 64;
+        batch->items = realloc(batch->items, batch->capacity * sizeof(control_item_t));
+    }
+    control_item_t *item = &batch->items[batch->count];
+    memset(item, 0, sizeof(*item));
+    item->flags = CONTROL_ITEM_HIDDEN;
+    return batch->count++;
+}
+
+void control_batch_update(control_batch_t *batch, size_t index, const control_item_t *item) {
+    control_item_t *current = &batch->items[index];
+    if (!memcmp(current, item, sizeof(*item))) return;
+    bool wasVisible = control_item_visible(current);
+    bool isVisible = control_item_visible(item);
+    if (!wasVisible && !isVisible) {
+        *current = *item;
+        return;
+    }
+    control_batch_invalidate_item(batch, index);
+    *current = *item;
+    control_batch_invalidate_item(batch, index);
+}
+
+void control_batch_set_flag(control_batch_t *batch, size_t index, uint32_t flag, bool on) {
+    control_item_t item = batch->items[index];
+    item.flags = on ? item.flags | flag : item.flags & ~flag;
+    control_batch_update(batch, index, &item);
+}
+
+void control_batch_invalidate_item(control_batch_t *batch, size_t index) {
+    const control_item_t *item = &batch->items[index];
+    if (control_item_visible(item)) {
+        control_batch_invalidate(batch, control_item_bounds(item));
+    }
+}
+
+static float control_rect_area(control_rect_t rect) {
+    return rect.width * rect.height;
+}
+
+void control_batch_invalidate(control_batch_t *batch, control_rect_t rect) {
+    if (rect.width <= 0 || rect.height <= 0) return;
+
+    // Fold in every region it touches; the union may now reach others
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < batch->dirtyCount; i++) {
+            if (control_rect_intersects(batch->dirty[i], rect)) {
+                rect = control_rect_union(batch->dirty[i], rect);
+                batch->dirty[i] = batch->dirty[--batch->dirtyCount];
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (batch->dirtyCount == CONTROL_BATCH_MAX_DIRTY) {
+        // Full: grow whichever region gains the least area by taking it
+        size_t best = 0;
+        float bestGrowth = INFINITY;
+        for (size_t i = 0; i < batch->dirtyCount; i++) {
+            control_rect_t joined = control_rect_union(batch->dirty[i], rect);
+            float growth = control_rect_area(joined) - control_rect_area(batch->dirty[i]);
+            if (growth < bestGrowth) {
+                best = i;
+                bestGrowth = growth;
+            }
+        }
+        rect = control_rect_union(batch->dirty[best], rect);
+        batch->dirty[best] = batch->dirty[--batch->dirtyCount];
+        control_batch_invalidate(batch, rect);
+        return;
+    }
+    batch->dirty[batch->dirtyCount++] = rect;
+}
+
+size_t control_batch_take_dirty(control_batch_t *batch, control_rect_t *out) {
+    size_t count = batch->dirtyCount;
+    memcpy(out, batch->dirty, count * sizeof(control_rect_t));
+    batch->dirtyCount = 0;
+    return count;
+}
+
+control_rect_t control_item_bounds(const control_item_t *item) {
+    float outset = item->strokeWidth / 2 + 1;
+    return (control_rect_t){
+        item->frame.x - outset, item->frame.y - outset,
+        item->frame.width + outset * 2, item->frame.height + outset * 2
+    };
+}
+
+bool control_item_visible(const control_item_t *item) {
+    return !(item->flags & CONTROL_ITEM_HIDDEN) && item->opacity > 0 &&
+        item->frame.width > 0 && item->frame.height > 0;
+}
+
+bool control_rect_intersects(control_rect_t a, control_rect_t b) {
+    return a.x < b.x + b.width && b.x < a.x + a.width &&
+        a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+control_rect_t control_rect_union(control_rect_t a, control_rect_t b) {
+    float minX = fminf(a.x, b.x), minY = fminf(a.y, b.y);
+    float maxX = fmaxf(a.x + a.width, b.x + b.width);
+    float maxY = fmaxf(a.y + a.height, b.y + b.height);
+    return (control_rect_t){minX, minY, maxX - minX, maxY - minY};
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Geometry and invalidation for drawing every control of a layout into one
+// layer. Items are kept in z-order; changing one dirties its old and new
+// bounds, and dirty rects are merged into at most CONTROL_BATCH_MAX_DIRTY
+// regions until the renderer takes them. Coordinates are in points.
+
+#define CONTROL_BATCH_MAX_DIRTY 8
+
+#define CONTROL_ITEM_HIDDEN 1
+#define CONTROL_ITEM_HIGHLIGHTED 2
+
+typedef struct {
+    float x, y, width, height;
+} control_rect_t;
+
+typedef struct {
+    control_rect_t frame;
+    uint32_t fillColor, strokeColor; // ARGB
+    float strokeWidth, cornerRadius, opacity;
+    uint32_t flags;
+} control_item_t;
+
+typedef struct {
+    control_item_t *items;
+    size_t count, capacity;
+    control_rect_t dirty[CONTROL_BATCH_MAX_DIRTY];
+    size_t dirtyCount;
+} control_batch_t;
+
+void control_batch_init(control_batch_t *batch);
+void control_batch_destroy(control_batch_t *batch);
+// Dirties everything that was visible
+void control_batch_remove_all(control_batch_t *batch);
+
+// New items start hidden; returns the index
+size_t control_batch_add(control_batch_t *batch);
+// Dirties the old and new bounds, unless nothing that shows changed
+void control_batch_update(control_batch_t *batch, size_t index, const control_item_t *item);
+void control_batch_set_flag(control_batch_t *batch, size_t index, uint32_t flag, bool on);
+void control_batch_invalidate(control_batch_t *batch, control_rect_t rect);
+void control_batch_invalidate_item(control_batch_t *batch, size_t index);
+
+// Copies the dirty regions into out (CONTROL_BATCH_MAX_DIRTY entries) and clears them
+size_t control_batch_take_dirty(control_batch_t *batch, control_rect_t *out);
+
+// Frame plus the half of the stroke drawn outside it
+control_rect_t control_item_bounds(const control_item_t *item);
+bool control_item_visible(const control_item_t *item);
+bool control_rect_intersects(control_rect_t a, control_rect_t b);
+control_rect_t control_rect_union(control_rect_t a, control_rect_t b);
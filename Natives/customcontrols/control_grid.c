@@ -0,0 +1,104 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "control_grid.h"
+
+#define CONTROL_GRID_MAX_CELLS 4096
+
+void control_grid_init(control_grid_t *grid) {
+    memset(grid, 0, sizeof(*grid));
+}
+
+void control_grid_destroy(control_grid_t *grid) {
+    free(grid->rects);
+    free(grid->cellStart);
+    free(grid->entries);
+    memset(grid, 0, sizeof(*grid));
+}
+
+static bool control_rect_contains(control_rect_t rect, float x, float y) {
+    // Same edges as CGRectContainsPoint
+    return x >= rect.x && x < rect.x + rect.width && y >= rect.y && y < rect.y + rect.height;
+}
+
+// Cell span of a rect, clamped to the grid
+static void control_grid_span(const control_grid_t *grid, control_rect_t rect,
+    uint32_t *minColumn, uint32_t *minRow, uint32_t *maxColumn, uint32_t *maxRow) {
+    float left = (rect.x - grid->originX) / grid->cellSize;
+    float top = (rect.y - grid->originY) / grid->cellSize;
+    float right = (rect.x + rect.width - grid->originX) / grid->cellSize;
+    float bottom = (rect.y + rect.height - grid->originY) / grid->cellSize;
+    *minColumn = (uint32_t)fmaxf(0, left);
+    *minRow = (uint32_t)fmaxf(0, top);
+    *maxColumn = (uint32_t)fminf(grid->columns - 1, fmaxf(0, right));
+    *maxRow = (uint32_t)fminf(grid->rows - 1, fmaxf(0, bottom));
+}
+
+void control_grid_build(control_grid_t *grid, const control_rect_t *rects, size_t count, float cellSize) {
+    control_grid_destroy(grid);
+    grid->count = count;
+    if (count == 0) return;
+    grid->rects = malloc(count * sizeof(control_rect_t));
+    memcpy(grid->rects, rects, count * sizeof(control_rect_t));
+
+    control_rect_t bounds = rects[0];
+    for (size_t i = 1; i < count; i++) {
+        bounds = control_rect_union(bounds, rects[i]);
+    }
+    grid->originX = bounds.x;
+    grid->originY = bounds.y;
+    grid->cellSize = fmaxf(cellSize, 1);
+    while (ceilf(bounds.width / grid->cellSize) * ceilf(bounds.height / grid->cellSize) > CONTROL_GRID_MAX_CELLS) {
+        grid->cellSize *= 2;
+    }
+    grid->columns = fmaxf(1, ceilf(bounds.width / grid->cellSize));
+    grid->rows = fmaxf(1, ceilf(bounds.height / grid->cellSize));
+
+    // Counting pass, then fill; walking controls in order keeps each cell in z-order
+    size_t cells = grid->columns * grid->rows;
+    grid->cellStart = calloc(cells + 1, sizeof(uint32_t));
+    uint32_t minColumn, minRow, maxColumn, maxRow;
+    for (size_t i = 0; i < count; i++) {
+        if (rects[i].width <= 0 || rects[i].height <= 0) continue;
+        control_grid_span(grid, rects[i], &minColumn, &minRow, &maxColumn, &maxRow);
+        for (uint32_t row = minRow; row <= maxRow; row++) {
+            for (uint32_t column = minColumn; column <= maxColumn; column++) {
+                grid->cellStart[row * grid->columns + column + 1]++;
+            }
+        }
+    }
+    for (size_t cell = 0; cell < cells; cell++) {
+        grid->cellStart[cell + 1] += grid->cellStart[cell];
+    }
+
+    grid->entries = malloc((grid->cellStart[cells] + 1) * sizeof(uint32_t));
+    uint32_t *fill = malloc(cells * sizeof(uint32_t));
+    memcpy(fill, grid->cellStart, cells * sizeof(uint32_t));
+    for (size_t i = 0; i < count; i++) {
+        if (rects[i].width <= 0 || rects[i].height <= 0) continue;
+        control_grid_span(grid, rects[i], &minColumn, &minRow, &maxColumn, &maxRow);
+        for (uint32_t row = minRow; row <= maxRow; row++) {
+            for (uint32_t column = minColumn; column <= maxColumn; column++) {
+                grid->entries[fill[row * grid->columns + column]++] = (uint32_t)i;
+            }
+        }
+    }
+    free(fill);
+}
+
+long control_grid_hit(const control_grid_t *grid, float x, float y, control_grid_test_t test, void *context) {
+    if (grid->count == 0) return -1;
+    float column = floorf((x - grid->originX) / grid->cellSize);
+    float row = floorf((y - grid->originY) / grid->cellSize);
+    if (column < 0 || row < 0 || column >= grid->columns || row >= grid->rows) return -1;
+
+    size_t cell = (size_t)row * grid->columns + (size_t)column;
+    for (uint32_t entry = grid->cellStart[cell + 1]; entry > grid->cellStart[cell]; entry--) {
+        uint32_t index = grid->entries[entry - 1];
+        if (control_rect_contains(grid->rects[index], x, y) && (!test || test(index, context))) {
+            return index;
+        }
+    }
+    return -1;
+}
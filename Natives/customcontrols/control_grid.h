@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "control_batch.h"
+
+// Uniform grid over control rectangles for resolving touch points. Each cell
+// lists the controls overlapping it in z-order, so a lookup only tests the
+// few controls in one cell, topmost first. Built from a snapshot of the
+// frames and rebuilt when they change; per-touch state such as visibility is
+// left to the caller's test.
+
+typedef bool (*control_grid_test_t)(size_t index, void *context);
+
+typedef struct {
+    control_rect_t *rects;
+    size_t count;
+    float originX, originY, cellSize;
+    uint32_t columns, rows;
+    uint32_t *cellStart; // columns * rows + 1 offsets into entries
+    uint32_t *entries;
+} control_grid_t;
+
+void control_grid_init(control_grid_t *grid);
+void control_grid_destroy(control_grid_t *grid);
+// cellSize is a hint, it grows for layouts that would need too many cells
+void control_grid_build(control_grid_t *grid, const control_rect_t *rects, size_t count, float cellSize);
+
+// Topmost control containing the point that passes test (NULL for any), or -1
+long control_grid_hit(const control_grid_t *grid, float x, float y, control_grid_test_t test, void *context);
@@ -0,0 +1,80 @@
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "deferred_write.h"
+#include "file_stamp.h"
+
+void deferred_write_init(deferred_write_t *state, double delay, double maxDelay) {
+    *state = (deferred_write_t){.delay = delay, .maxDelay = maxDelay};
+}
+
+double deferred_write_changed(deferred_write_t *state, double now) {
+    if (!state->pending) {
+        state->pending = true;
+        state->firstChange = now;
+    }
+    return fmin(now + state->delay, state->firstChange + state->maxDelay);
+}
+
+bool deferred_write_take(deferred_write_t *state) {
+    bool pending = state->pending;
+    state->pending = false;
+    return pending;
+}
+
+void deferred_write_cancel(deferred_write_t *state) {
+    state->pending = false;
+}
+
+static bool deferred_write_all(int fd, const uint8_t *bytes, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written <= 0) return false;
+        bytes += written;
+        length -= written;
+    }
+    return true;
+}
+
+bool deferred_file_write(deferred_file_t *file, const char *path, const void *data, size_t length) {
+    struct stat st;
+    if (file->lastWritten && file->lastLength == length && !memcmp(file->lastWritten, data, length) &&
+        stat(path, &st) == 0 && file_stamp_mtime_ns(&st) == file->lastMTime && st.st_size == file->lastSize) {
+        return true;
+    }
+
+    char tmpPath[PATH_MAX];
+    if (snprintf(tmpPath, sizeof(tmpPath), "%s.XXXXXX", path) >= (int)sizeof(tmpPath)) {
+        return false;
+    }
+    int fd = mkstemp(tmpPath);
+    bool written = fd != -1 && fchmod(fd, 0644) == 0 && deferred_write_all(fd, data, length) && fsync(fd) == 0;
+    if (fd != -1 && close(fd) != 0) written = false;
+    if (written && rename(tmpPath, path) != 0) written = false;
+    if (!written) {
+        if (fd != -1) unlink(tmpPath);
+        deferred_file_forget(file);
+        return false;
+    }
+
+    file->writeCount++;
+    free(file->lastWritten);
+    file->lastWritten = malloc(length ? length : 1);
+    if (length) memcpy(file->lastWritten, data, length);
+    file->lastLength = length;
+    if (stat(path, &st) == 0) {
+        file->lastMTime = file_stamp_mtime_ns(&st);
+        file->lastSize = st.st_size;
+    }
+    return true;
+}
+
+void deferred_file_forget(deferred_file_t *file) {
+    free(file->lastWritten);
+    file->lastWritten = NULL;
+    file->lastLength = 0;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// PLDeferredWriter's policy: when a burst of changes gets written, and how a
+// write replaces the file. Times are seconds on a monotonic clock.
+
+typedef struct {
+    double delay, maxDelay;
+    bool pending;
+    double firstChange;
+} deferred_write_t;
+
+void deferred_write_init(deferred_write_t *state, double delay, double maxDelay);
+// Records a change, returns when to write: the trailing edge of the burst,
+// but never later than maxDelay after its start
+double deferred_write_changed(deferred_write_t *state, double now);
+// Whether anything is to be written now, clearing it if so
+bool deferred_write_take(deferred_write_t *state);
+// Forgets the pending change, e.g. because the file is about to be deleted
+void deferred_write_cancel(deferred_write_t *state);
+
+typedef struct {
+    // What was last written and the stamp the file got
+    uint8_t *lastWritten;
+    size_t lastLength;
+    int64_t lastMTime;
+    off_t lastSize;
+    // Writes that actually hit the disk
+    unsigned long writeCount;
+} deferred_file_t;
+
+// Replaces path with data through a temporary file and a rename, so a crash
+// leaves either the previous or the new contents. Identical contents are
+// skipped unless the file changed on disk since the last write. Returns false
+// if the file couldn't be written.
+bool deferred_file_write(deferred_file_t *file, const char *path, const void *data, size_t length);
+// Forgets what was written, so the next write always hits the disk
+void deferred_file_forget(deferred_file_t *file);
@@ -0,0 +1,111 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dir_snapshot.h"
+#include "file_stamp.h"
+
+static int dir_entry_compare(const void *a, const void *b) {
+    return strcmp(((const dir_entry_t *)a)->name, ((const dir_entry_t *)b)->name);
+}
+
+const dir_entry_t *dir_snapshot_find(const dir_snapshot_t *snapshot, const char *name) {
+    if (!snapshot || snapshot->count == 0) return NULL;
+    dir_entry_t key = {.name = (char *)name};
+    return bsearch(&key, snapshot->entries, snapshot->count, sizeof(dir_entry_t), dir_entry_compare);
+}
+
+static bool dir_entry_stat(int dirFd, dir_entry_t *entry) {
+    struct stat st;
+    if (fstatat(dirFd, entry->name, &st, 0) != 0) {
+        // Dangling symlink or removed since readdir
+        if (fstatat(dirFd, entry->name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+            return false;
+        }
+    }
+    entry->size = st.st_size;
+    entry->mtime = file_stamp_mtime_ns(&st);
+    entry->isDirectory = S_ISDIR(st.st_mode);
+    return true;
+}
+
+int dir_snapshot_scan(const char *path, const dir_snapshot_t *previous, dir_snapshot_t *out) {
+    out->entries = NULL;
+    out->count = 0;
+
+    DIR *dir = opendir(path);
+    if (!dir) return errno;
+    int dirFd = dirfd(dir);
+
+    size_t capacity = previous && previous->count > 0 ? previous->count + 16 : 64;
+    dir_entry_t *entries = malloc(capacity * sizeof(dir_entry_t));
+    size_t count = 0;
+
+    struct dirent *ent;
+    while ((ent = readdir(dir))) {
+        if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, "..")) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity *= 2;
+            entries = realloc(entries, capacity * sizeof(dir_entry_t));
+        }
+        dir_entry_t *entry = &entries[count];
+        entry->inode = ent->d_ino;
+        entry->name = ent->d_name;
+        if (!dir_entry_stat(dirFd, entry)) {
+            continue;
+        }
+        entry->name = strdup(ent->d_name);
+        count++;
+    }
+    closedir(dir);
+
+    qsort(entries, count, sizeof(dir_entry_t), dir_entry_compare);
+    out->entries = entries;
+    out->count = count;
+    return 0;
+}
+
+void dir_snapshot_free(dir_snapshot_t *snapshot) {
+    for (size_t i = 0; i < snapshot->count; i++) {
+        free(snapshot->entries[i].name);
+    }
+    free(snapshot->entries);
+    snapshot->entries = NULL;
+    snapshot->count = 0;
+}
+
+size_t dir_snapshot_diff(const dir_snapshot_t *old, const dir_snapshot_t *new, dir_change_fn callback, void *context) {
+    size_t i = 0, j = 0, changes = 0;
+    while (i < old->count || j < new->count) {
+        int order;
+        if (i == old->count) {
+            order = 1;
+        } else if (j == new->count) {
+            order = -1;
+        } else {
+            order = strcmp(old->entries[i].name, new->entries[j].name);
+        }
+
+        if (order < 0) {
+            callback(context, DIR_CHANGE_REMOVED, &old->entries[i++]);
+            changes++;
+        } else if (order > 0) {
+            callback(context, DIR_CHANGE_ADDED, &new->entries[j++]);
+            changes++;
+        } else {
+            const dir_entry_t *a = &old->entries[i++], *b = &new->entries[j++];
+            if (a->inode != b->inode || a->size != b->size || a->mtime != b->mtime ||
+                a->isDirectory != b->isDirectory) {
+                callback(context, DIR_CHANGE_MODIFIED, b);
+                changes++;
+            }
+        }
+    }
+    return changes;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Listing of a single directory, entries sorted by name. Plain POSIX, the
+// platform watcher (kqueue/inotify) only decides when to rescan.
+
+typedef struct {
+    char *name;
+    uint64_t inode;
+    uint64_t size;
+    int64_t mtime;      // nanoseconds
+    bool isDirectory;   // symlinks are followed
+} dir_entry_t;
+
+typedef struct {
+    dir_entry_t *entries;
+    size_t count;
+} dir_snapshot_t;
+
+typedef enum {
+    DIR_CHANGE_ADDED,
+    DIR_CHANGE_REMOVED,
+    DIR_CHANGE_MODIFIED
+} dir_change_t;
+
+// Lists path into out, returns 0 or an errno. Every entry is stat'ed again:
+// a file rewritten in place keeps its name and inode, only its size and
+// mtime tell. previous, if not NULL, only sizes the new listing.
+int dir_snapshot_scan(const char *path, const dir_snapshot_t *previous, dir_snapshot_t *out);
+void dir_snapshot_free(dir_snapshot_t *snapshot);
+const dir_entry_t *dir_snapshot_find(const dir_snapshot_t *snapshot, const char *name);
+
+// Reports every difference from old to new, in name order. Returns the count.
+typedef void (*dir_change_fn)(void *context, dir_change_t change, const dir_entry_t *entry);
+size_t dir_snapshot_diff(const dir_snapshot_t *old, const dir_snapshot_t *new, dir_change_fn callback, void *context);
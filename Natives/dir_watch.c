@@ -0,0 +1,135 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <sys/event.h>
+#else
+#include <limits.h>
+#include <sys/inotify.h>
+#endif
+
+#include "dir_watch.h"
+
+struct dir_watch {
+    int fd;
+#ifdef __APPLE__
+    int dirFd;
+#else
+    int wd;
+    bool gone;
+#endif
+};
+
+#ifdef __APPLE__
+
+dir_watch_t *dir_watch_open(const char *path) {
+    int dirFd = open(path, O_EVTONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd < 0) return NULL;
+    int kq = kqueue();
+    struct kevent change;
+    EV_SET(&change, dirFd, EVFILT_VNODE, EV_ADD | EV_CLEAR,
+        NOTE_WRITE | NOTE_DELETE | NOTE_RENAME | NOTE_REVOKE, 0, NULL);
+    if (kq < 0 || kevent(kq, &change, 1, NULL, 0, NULL) < 0) {
+        int error = errno;
+        if (kq >= 0) close(kq);
+        close(dirFd);
+        errno = error;
+        return NULL;
+    }
+    dir_watch_t *watch = malloc(sizeof(dir_watch_t));
+    watch->fd = kq;
+    watch->dirFd = dirFd;
+    return watch;
+}
+
+int dir_watch_read(dir_watch_t *watch) {
+    int flags = 0;
+    struct kevent events[8];
+    const struct timespec poll = {0, 0};
+    int count;
+    while ((count = kevent(watch->fd, NULL, 0, events, 8, &poll)) > 0) {
+        for (int i = 0; i < count; i++) {
+            if (events[i].fflags & (NOTE_DELETE | NOTE_RENAME | NOTE_REVOKE)) {
+                flags |= DIR_WATCH_GONE;
+            } else {
+                flags |= DIR_WATCH_CHANGED;
+            }
+        }
+    }
+    if ((flags & DIR_WATCH_GONE) && watch->dirFd >= 0) {
+        // Closing the directory drops its knote, nothing more will arrive
+        close(watch->dirFd);
+        watch->dirFd = -1;
+    }
+    return flags;
+}
+
+void dir_watch_close(dir_watch_t *watch) {
+    if (!watch) return;
+    if (watch->dirFd >= 0) close(watch->dirFd);
+    close(watch->fd);
+    free(watch);
+}
+
+#else
+
+// Unlike kqueue, inotify also reports writes to the files inside
+#define DIR_WATCH_MASK (IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | \
+    IN_ATTRIB | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR)
+
+dir_watch_t *dir_watch_open(const char *path) {
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return NULL;
+    int wd = inotify_add_watch(fd, path, DIR_WATCH_MASK);
+    if (wd < 0) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return NULL;
+    }
+    dir_watch_t *watch = malloc(sizeof(dir_watch_t));
+    watch->fd = fd;
+    watch->wd = wd;
+    watch->gone = false;
+    return watch;
+}
+
+int dir_watch_read(dir_watch_t *watch) {
+    int flags = 0;
+    char buffer[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)]
+        __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t length;
+    while ((length = read(watch->fd, buffer, sizeof(buffer))) > 0) {
+        for (char *p = buffer; p < buffer + length;) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED | IN_UNMOUNT)) {
+                flags |= DIR_WATCH_GONE;
+            } else {
+                // IN_Q_OVERFLOW lost some events, a rescan still catches up
+                flags |= DIR_WATCH_CHANGED;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    if (watch->gone) return 0;
+    if (flags & DIR_WATCH_GONE) {
+        // A moved directory would go on reporting from its new place
+        inotify_rm_watch(watch->fd, watch->wd);
+        watch->gone = true;
+    }
+    return flags;
+}
+
+void dir_watch_close(dir_watch_t *watch) {
+    if (!watch) return;
+    close(watch->fd);
+    free(watch);
+}
+
+#endif
+
+int dir_watch_fd(const dir_watch_t *watch) {
+    return watch->fd;
+}
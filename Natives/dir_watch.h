@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdbool.h>
+
+// Change notifications for a single directory: kqueue on Apple platforms,
+// inotify on Linux. Only says that something changed, dir_snapshot tells
+// what. The descriptor from dir_watch_fd becomes readable while events are
+// pending, so it can be handed to a dispatch source or poll().
+
+typedef struct dir_watch dir_watch_t;
+
+enum {
+    DIR_WATCH_CHANGED = 1 << 0, // names came or went, or an entry was written
+    DIR_WATCH_GONE = 1 << 1     // the directory itself was removed or moved
+};
+
+// Returns NULL with errno set if path can't be watched
+dir_watch_t *dir_watch_open(const char *path);
+int dir_watch_fd(const dir_watch_t *watch);
+// Drains every pending event without blocking, returns the DIR_WATCH_* flags
+// seen (0 if none). Once GONE is reported the watch stays silent.
+int dir_watch_read(dir_watch_t *watch);
+// Closes every descriptor the watch holds
+void dir_watch_close(dir_watch_t *watch);
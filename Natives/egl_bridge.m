@@ -17,9 +17,12 @@
 #include "glfw_keycodes.h"
 #include "ctxbridges/bridge_tbl.h"
 #include "ctxbridges/osmesa_internal.h"
+#include "ctxbridges/renderer_probe.h"
+#include "stall_watchdog.h"
 #include "utils.h"
 
 int clientAPI;
+__thread basic_render_window_t* currentBundle;
 
 void JNI_LWJGL_changeRenderer(const char* value_c) {
     JNIEnv *env;
@@ -33,6 +36,8 @@ void JNI_LWJGL_changeRenderer(const char* value_c) {
 
 void pojavTerminate() {
     CallbackBridge_nativeSetInputReady(NO);
+    // The window is gone, no more frames are coming while the game saves and exits
+    stall_watchdog_stop();
     if (!br_terminate) return;
     br_terminate();
 }
@@ -78,22 +83,15 @@ void pojavSetWindowHint(int hint, int value) {
     if (hint == GLFW_CLIENT_API) {
         clientAPI = value;
     } else if (strcmp(getenv("AMETHYST_RENDERER"), "auto")==0 && hint == GLFW_CONTEXT_VERSION_MAJOR) {
-        switch (value) {
-            case 1:
-            case 2:
-                setenv("AMETHYST_RENDERER", RENDERER_NAME_GL4ES, 1);
-                JNI_LWJGL_changeRenderer(RENDERER_NAME_GL4ES);
-                break;
-            // case 4: use Zink?
-            default:
-                setenv("AMETHYST_RENDERER", RENDERER_NAME_MTL_ANGLE, 1);
-                JNI_LWJGL_changeRenderer(RENDERER_NAME_MTL_ANGLE);
-                break;
-        }
+        // Benchmarked once per device, then served from cache
+        const char *renderer = renderer_probe_select(value);
+        setenv("AMETHYST_RENDERER", renderer, 1);
+        JNI_LWJGL_changeRenderer(renderer);
     }
 }
 
 void pojavSwapBuffers() {
+    stall_watchdog_beat();
     br_swap_buffers();
 }
 
@@ -116,6 +114,11 @@ void* pojavCreateContext(basic_render_window_t* contextSrc) {
     return br_init_context(contextSrc);
 }
 
+void pojavDestroyContext(basic_render_window_t* window) {
+    if (!br_destroy_context || !window) return;
+    br_destroy_context(window);
+}
+
 void pojavSwapInterval(int interval) {
     if (!br_swap_interval) return;
     br_swap_interval(interval);
@@ -7,20 +7,7 @@
 
 #include <stdatomic.h>
 #include "jni.h"
-
-typedef struct {
-    short type;
-    union {
-        int i1;
-        float f1;
-    };
-    union {
-        int i2;
-        float f2;
-    };
-    short i3;
-    short i4;
-} GLFWInputEvent;
+#include "input/input_event_queue.h"
 
 typedef void GLFW_invoke_Char_func(void* window, unsigned int codepoint);
 typedef void GLFW_invoke_CharMods_func(void* window, unsigned int codepoint, int mods);
@@ -39,8 +26,6 @@ jmethodID method_SystemClipboardDataReceived;
 //struct pojav_environ_s {
     //render_window_t* mainWindowBundle;
     //BOOL force_vsync;
-    atomic_size_t eventCounter;
-    GLFWInputEvent events[8000];
     double cursorX, cursorY, cLastX, cLastY;
     //jmethodID method_accessAndroidClipboard;
     //jmethodID method_onGrabStateChanged;
@@ -1,6 +1,12 @@
+#ifdef __APPLE__
 #import <Foundation/Foundation.h>
+#endif
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <dlfcn.h>
+#include <pthread.h>
+#include <stdbool.h>
 
 #define GL_GLEXT_PROTOTYPES
 
@@ -9,6 +15,8 @@
 //#include "GLES3/gl32.h"
 #include "string_utils.h"
 
+#include <EGL/egl.h>
+
 #define LOOKUP_FUNC(func) \
     if (!gles_##func) { \
         gles_##func = dlsym(RTLD_NEXT, #func); \
@@ -16,11 +24,17 @@
         gles_##func = dlsym(RTLD_DEFAULT, #func); \
     }
 
+#ifdef __APPLE__
 #define AliasDecl(NAME, EXT) \
     asm(".global _"# NAME "\n_" #NAME ": b _" #NAME #EXT);
 
 #define AliasDeclPriv(NAME) \
     asm(".global _gl"# NAME "\n_gl" #NAME ": b _GL_" #NAME);
+#else
+// Host builds (tests) only need the functions implemented below
+#define AliasDecl(NAME, EXT)
+#define AliasDeclPriv(NAME)
+#endif
 
 // Core OpenGL 2.0
 AliasDecl(glGetTexImage, ANGLE)
@@ -53,6 +67,124 @@ void(*gles_glShaderSource)(GLuint shader, GLsizei count, const GLchar * const *s
 void(*gles_glTexImage2D)(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const GLvoid *data);
 void(*gles_glTexSubImage2D)(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const GLvoid *data);
 void(*gles_glTexParameterfv)(GLenum target, GLenum pname, const GLfloat *params);
+void(*gles_glReadBuffer)(GLenum mode);
+void(*gles_glDeleteTextures)(GLsizei n, const GLuint *textures);
+EGLBoolean(*gles_eglDestroyContext)(EGLDisplay dpy, EGLContext ctx);
+
+// Per-attachment FBOs used by glCopyTexSubImage2D, keyed by texture and level.
+// FBOs are not shared between contexts, so each context that copies gets its
+// own cache; it is dropped when eglDestroyContext takes the FBOs with it.
+#define COPY_FBO_CACHE_SIZE 8
+#define COPY_FBO_CONTEXTS 4
+typedef struct {
+    GLuint fbo;
+    GLuint texture;
+    GLint level;
+    GLenum attachment;
+    unsigned int lastUse;
+} copy_fbo_t;
+typedef struct {
+    EGLContext context;
+    copy_fbo_t entries[COPY_FBO_CACHE_SIZE];
+} copy_fbo_cache_t;
+static copy_fbo_cache_t copyFBOCaches[COPY_FBO_CONTEXTS];
+static unsigned int copyFBOClock;
+// Worker contexts copy from their own threads
+static pthread_mutex_t copyFBOLock = PTHREAD_MUTEX_INITIALIZER;
+
+static copy_fbo_cache_t *copyFBOCacheForContext(EGLContext context, bool create) {
+    copy_fbo_cache_t *unused = NULL;
+    for (int i = 0; i < COPY_FBO_CONTEXTS; i++) {
+        if (copyFBOCaches[i].context == context) return &copyFBOCaches[i];
+        if (!unused && !copyFBOCaches[i].context) unused = &copyFBOCaches[i];
+    }
+    if (!create || !unused) return NULL;
+    memset(unused, 0, sizeof(*unused));
+    unused->context = context;
+    return unused;
+}
+
+// Binds an FBO with (texture, level) attached to GL_DRAW_FRAMEBUFFER and
+// returns it. If every cache belongs to another live context, the FBO is a
+// temporary one the caller deletes. The caller restores the previous binding.
+static GLuint copyFBOBind(GLuint texture, GLint level, GLenum attachment, bool *temporary) {
+    pthread_mutex_lock(&copyFBOLock);
+    copy_fbo_cache_t *cache = copyFBOCacheForContext(eglGetCurrentContext(), true);
+    *temporary = cache == NULL;
+    if (!cache) {
+        pthread_mutex_unlock(&copyFBOLock);
+        GLuint fbo;
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, level);
+        return fbo;
+    }
+
+    copy_fbo_t *entry = &cache->entries[0];
+    for (int i = 0; i < COPY_FBO_CACHE_SIZE; i++) {
+        copy_fbo_t *e = &cache->entries[i];
+        if (e->fbo && e->texture == texture && e->level == level && e->attachment == attachment) {
+            entry = e;
+            break;
+        }
+        if (!e->fbo || (entry->fbo && e->lastUse < entry->lastUse)) {
+            entry = e;
+        }
+    }
+    entry->lastUse = ++copyFBOClock;
+
+    if (!entry->fbo) {
+        glGenFramebuffers(1, &entry->fbo);
+    }
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, entry->fbo);
+    if (entry->texture != texture || entry->level != level || entry->attachment != attachment) {
+        if (entry->attachment && entry->attachment != attachment) {
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, entry->attachment, GL_TEXTURE_2D, 0, 0);
+        }
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, level);
+        entry->texture = texture;
+        entry->level = level;
+        entry->attachment = attachment;
+    }
+    GLuint fbo = entry->fbo;
+    pthread_mutex_unlock(&copyFBOLock);
+    return fbo;
+}
+
+// Drops cached attachments of textures about to be deleted, so the FBOs
+// do not keep their storage alive. Other contexts of the share group can't
+// be touched from here; their entries are only forgotten, so a texture that
+// reuses the name gets attached again instead of hitting the dead one.
+static void copyFBODetachTextures(GLsizei n, const GLuint *textures) {
+    EGLContext context = eglGetCurrentContext();
+    GLint drawFB = -1;
+    pthread_mutex_lock(&copyFBOLock);
+    for (int c = 0; c < COPY_FBO_CONTEXTS; c++) {
+        copy_fbo_cache_t *cache = &copyFBOCaches[c];
+        if (!cache->context) continue;
+        for (int i = 0; i < COPY_FBO_CACHE_SIZE; i++) {
+            copy_fbo_t *e = &cache->entries[i];
+            if (!e->fbo || !e->texture) continue;
+            for (GLsizei j = 0; j < n; j++) {
+                if (textures[j] != e->texture) continue;
+                if (cache->context == context) {
+                    if (drawFB == -1) {
+                        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFB);
+                    }
+                    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, e->fbo);
+                    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, e->attachment, GL_TEXTURE_2D, 0, 0);
+                    e->attachment = 0;
+                }
+                e->texture = 0;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&copyFBOLock);
+    if (drawFB != -1) {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFB);
+    }
+}
 
 void glClearDepth(GLdouble depth) {
     glClearDepthf(depth);
@@ -234,41 +366,106 @@ void glTexParameterf(GLenum target, GLenum pname, GLfloat param) {
 
 // Handle reading depth buffer
 void glReadBuffer(GLenum mode) {
-    // Override with stub
+    LOOKUP_FUNC(glReadBuffer)
+    GLint readFB;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFB);
+    if (readFB == 0) {
+        // ES only knows GL_BACK and GL_NONE for the default framebuffer
+        switch (mode) {
+            case GL_NONE:
+                break;
+            case GL_FRONT:
+            case GL_FRONT_LEFT:
+            case GL_BACK:
+            case GL_BACK_LEFT:
+                mode = GL_BACK;
+                break;
+            default:
+                return;
+        }
+    } else if (mode != GL_NONE && (mode < GL_COLOR_ATTACHMENT0 || mode > GL_COLOR_ATTACHMENT15)) {
+        return;
+    }
+    gles_glReadBuffer(mode);
+}
+
+void glDeleteTextures(GLsizei n, const GLuint *textures) {
+    LOOKUP_FUNC(glDeleteTextures)
+    copyFBODetachTextures(n, textures);
+    gles_glDeleteTextures(n, textures);
+}
+
+// The bridge resolves EGL through this library, so context destruction
+// passes here and the copy FBO cache of that context can be dropped.
+EGLBoolean eglDestroyContext(EGLDisplay dpy, EGLContext ctx) {
+    LOOKUP_FUNC(eglDestroyContext)
+    pthread_mutex_lock(&copyFBOLock);
+    copy_fbo_cache_t *cache = copyFBOCacheForContext(ctx, false);
+    if (cache) {
+        // The FBOs die with the context
+        memset(cache, 0, sizeof(*cache));
+    }
+    pthread_mutex_unlock(&copyFBOLock);
+    return gles_eglDestroyContext(dpy, ctx);
+}
+
+static GLenum copyAttachmentForFormat(GLint internalformat, GLbitfield *mask) {
+    switch (internalformat) {
+        case GL_DEPTH_COMPONENT:
+        case GL_DEPTH_COMPONENT16:
+        case GL_DEPTH_COMPONENT24:
+        case GL_DEPTH_COMPONENT32:
+        case GL_DEPTH_COMPONENT32F:
+            *mask = GL_DEPTH_BUFFER_BIT;
+            return GL_DEPTH_ATTACHMENT;
+        case GL_DEPTH_STENCIL:
+        case GL_DEPTH24_STENCIL8:
+        case GL_DEPTH32F_STENCIL8:
+            *mask = GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT;
+            return GL_DEPTH_STENCIL_ATTACHMENT;
+        default:
+            *mask = GL_COLOR_BUFFER_BIT;
+            return GL_COLOR_ATTACHMENT0;
+    }
 }
 
 void glCopyTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height) {
-    if (target != GL_TEXTURE_2D) {
-        LOOKUP_FUNC(glCopyTexSubImage2D)
+    LOOKUP_FUNC(glCopyTexSubImage2D)
+    if (target != GL_TEXTURE_2D || width <= 0 || height <= 0) {
         gles_glCopyTexSubImage2D(target, level, xoffset, yoffset, x, y, width, height);
+        return;
     }
 
-    // Override with stub
-#if 0
-    float *pixels = malloc(width*height*sizeof(float));
-    for (int i = 0; i < width*height; i++) {
-        pixels[i] = 0.5f;
+    GLint texID, internalformat = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &texID);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_INTERNAL_FORMAT, &internalformat);
+    GLbitfield mask;
+    GLenum attachment = copyAttachmentForFormat(internalformat, &mask);
+
+    // ES cannot copy depth with glCopyTexSubImage2D, so blit from the read
+    // framebuffer into a cached FBO wrapping the destination level instead.
+    GLint drawFB;
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFB);
+    bool temporary;
+    GLuint fbo = copyFBOBind(texID, level, attachment, &temporary);
+    bool complete = glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (complete) {
+        if (scissor) glDisable(GL_SCISSOR_TEST);
+        glBlitFramebuffer(x, y, x + width, y + height,
+            xoffset, yoffset, xoffset + width, yoffset + height,
+            mask, GL_NEAREST);
+        if (scissor) glEnable(GL_SCISSOR_TEST);
+    }
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFB);
+    if (temporary) {
+        glDeleteFramebuffers(1, &fbo);
     }
-    glTexSubImage2D(target, level, xoffset, yoffset, width, height, GL_DEPTH_COMPONENT, GL_FLOAT, pixels);
-    free(pixels);
-#endif
 
-#if 0
-    static GLuint depthFB;
-    if (!depthFB) {
-        glGenFramebuffers(1, &depthFB);
+    if (!complete && mask == GL_COLOR_BUFFER_BIT) {
+        // Incomplete (e.g. non color-renderable format), let ES try the copy itself
+        gles_glCopyTexSubImage2D(target, level, xoffset, yoffset, x, y, width, height);
     }
-    int fbID, texID;
-    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &fbID);
-    glGetIntegerv(GL_TEXTURE_BINDING_2D, &texID);
-    //glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, depthFB);
-    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, target, texID, level);
-    assert(glCheckFramebufferStatus(GL_DRAW_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
-    glBlitFramebuffer(xoffset, yoffset, width, height, x, y, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, target, 0, level);
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbID);
-#endif
 }
 
 // VertexArray stuff
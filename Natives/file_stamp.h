@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+#include <sys/stat.h>
+
+// Modification time with the sub-second part, so a file rewritten within the
+// same second as the recorded stamp is still seen as changed.
+static inline int64_t file_stamp_mtime_ns(const struct stat *st) {
+#ifdef __APPLE__
+    return (int64_t)st->st_mtimespec.tv_sec * 1000000000 + st->st_mtimespec.tv_nsec;
+#else
+    return (int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+#endif
+}
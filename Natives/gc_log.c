@@ -0,0 +1,274 @@
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "gc_log.h"
+
+typedef struct {
+    double *values;
+    size_t count, capacity;
+} gclog_series_t;
+
+static void gclog_series_push(gclog_series_t *series, double value) {
+    if (series->count == series->capacity) {
+        series->capacity = series->capacity ? series->capacity * 2 : 256;
+        series->values = realloc(series->values, series->capacity * sizeof(double));
+    }
+    series->values[series->count++] = value;
+}
+
+static int gclog_compare(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of a sorted series
+static double gclog_percentile(const gclog_series_t *series, double p) {
+    if (series->count == 0) return 0;
+    size_t rank = (size_t)ceil(p * series->count);
+    return series->values[rank > 0 ? rank - 1 : 0];
+}
+
+static bool gclog_is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// The JVM formats numbers with the process locale, so ',' may be the decimal separator
+static bool gclog_number(const char *p, double *out, const char **end) {
+    if (!gclog_is_digit(*p)) return false;
+    double value = 0;
+    for (; gclog_is_digit(*p); p++) {
+        value = value * 10 + (*p - '0');
+    }
+    if ((*p == '.' || *p == ',') && gclog_is_digit(p[1])) {
+        double scale = 0.1;
+        for (p++; gclog_is_digit(*p); p++, scale /= 10) {
+            value += (*p - '0') * scale;
+        }
+    }
+    *out = value;
+    if (end) *end = p;
+    return true;
+}
+
+// Number that follows a label, e.g. "Reaching safepoint: 12345 ns"
+static bool gclog_labelled_number(const char *line, const char *label, double *out) {
+    const char *p = strstr(line, label);
+    return p && gclog_number(p + strlen(label), out, NULL);
+}
+
+// Number that ends right before suffix, e.g. "0.0056 secs]", or before the
+// end of the line if the suffix must end it, e.g. "3.456ms"
+static bool gclog_number_before(const char *line, const char *suffix, bool atEnd, double *out) {
+    const char *end;
+    if (atEnd) {
+        size_t lineLength = strlen(line), suffixLength = strlen(suffix);
+        if (lineLength < suffixLength || strcmp(line + lineLength - suffixLength, suffix)) return false;
+        end = line + lineLength - suffixLength;
+    } else if (!(end = strstr(line, suffix))) {
+        return false;
+    }
+    const char *p = end;
+    while (p > line && (gclog_is_digit(p[-1]) || p[-1] == '.' || p[-1] == ',')) p--;
+    const char *numberEnd;
+    return gclog_number(p, out, &numberEnd) && numberEnd == end;
+}
+
+static bool gclog_size(const char *p, double *mb, const char **end) {
+    double value;
+    if (!gclog_number(p, &value, &p)) return false;
+    switch (*p) {
+        case 'B': *mb = value / (1024 * 1024); break;
+        case 'K': *mb = value / 1024; break;
+        case 'M': *mb = value; break;
+        case 'G': *mb = value * 1024; break;
+        default: return false;
+    }
+    *end = p + 1;
+    return true;
+}
+
+// "24M->4M(256M)" in either format
+static bool gclog_heap_transition(const char *line, double *before, double *after, double *capacity) {
+    const char *arrow = strstr(line, "->");
+    if (!arrow || arrow == line) return false;
+    const char *p = arrow - 1; // unit
+    while (p > line && (gclog_is_digit(p[-1]) || p[-1] == '.' || p[-1] == ',')) p--;
+    const char *end;
+    if (!gclog_size(p, before, &end) || end != arrow) return false;
+    if (!gclog_size(arrow + 2, after, &end) || *end != '(') return false;
+    return gclog_size(end + 1, capacity, &end);
+}
+
+// Decorations are padded, so a line logged with only the gc tag reads "[gc     ]"
+static bool gclog_has_tag(const char *line, const char *tag) {
+    size_t length = strlen(tag);
+    for (const char *p = line; (p = strchr(p, '[')); p++) {
+        if (strncmp(p + 1, tag, length)) continue;
+        const char *end = p + 1 + length;
+        while (*end == ' ') end++;
+        if (*end == ']') return true;
+    }
+    return false;
+}
+
+// "[1.234s]..." for unified logging, "1.234: ..." for Java 8
+static bool gclog_timestamp(const char *line, double *seconds) {
+    const char *end;
+    if (line[0] == '[') {
+        return gclog_number(line + 1, seconds, &end) && *end == 's';
+    }
+    return gclog_number(line, seconds, &end) && *end == ':';
+}
+
+int gclog_java_version(const char *javaHome) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/release", javaHome);
+    FILE *file = fopen(path, "r");
+    if (!file) return 0;
+    int version = 0;
+    char *line = NULL;
+    size_t lineSize = 0;
+    while (getline(&line, &lineSize, file) > 0) {
+        const char *p = line;
+        if (strncmp(p, "JAVA_VERSION=", 13)) continue;
+        p += 13;
+        if (*p == '"') p++;
+        char *end;
+        version = (int)strtol(p, &end, 10);
+        // Up to Java 8 the major version follows "1."
+        if (version == 1 && *end == '.') {
+            version = (int)strtol(end + 1, NULL, 10);
+        }
+        break;
+    }
+    free(line);
+    fclose(file);
+    return version > 0 ? version : 0;
+}
+
+bool gclog_args_set_logging(const char *args) {
+    // -Xlog covers -Xloggc as well
+    return args && (strstr(args, "-Xlog") || strstr(args, "-verbose:gc") || strstr(args, "PrintGC"));
+}
+
+void gclog_append_flags(const char *logPath, int javaVersion, int *argc, const char **argv) {
+    static char logFlag[1100];
+    if (javaVersion >= 9) {
+        // filecount=0 keeps a single file, the parser reads it before the next session overwrites it
+        snprintf(logFlag, sizeof(logFlag), "-Xlog:gc*,safepoint:file=\"%s\":uptime,level,tags:filecount=0", logPath);
+        argv[++*argc] = logFlag;
+    } else {
+        snprintf(logFlag, sizeof(logFlag), "-Xloggc:%s", logPath);
+        argv[++*argc] = logFlag;
+        argv[++*argc] = "-XX:+PrintGCApplicationStoppedTime";
+    }
+}
+
+bool gclog_parse(const char *logPath, gclog_stats_t *stats) {
+    FILE *file = fopen(logPath, "r");
+    if (!file) return false;
+    memset(stats, 0, sizeof(*stats));
+
+    gclog_series_t pauses = {0}, ttsp = {0};
+    double heapAfterTotal = 0;
+    int heapSamples = 0;
+    double allocatedMB = 0, firstGcTime = -1, lastGcTime = 0, lastAfter = -1;
+
+    char *line = NULL;
+    size_t lineSize = 0;
+    ssize_t length;
+    while ((length = getline(&line, &lineSize, file)) > 0) {
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+            line[--length] = '\0';
+        }
+        double time = 0;
+        bool hasTime = gclog_timestamp(line, &time);
+        if (hasTime && time > stats->uptimeSec) {
+            stats->uptimeSec = time;
+        }
+
+        double value;
+        if (gclog_labelled_number(line, "Reaching safepoint: ", &value)) {
+            // JDK 13+
+            gclog_series_push(&ttsp, value / 1e6);
+            continue;
+        } else if (gclog_labelled_number(line, "Stopping threads took: ", &value)) {
+            // Java 8 to JDK 12
+            gclog_series_push(&ttsp, value * 1e3);
+            continue;
+        }
+
+        double pauseMs;
+        bool full;
+        if (gclog_has_tag(line, "gc") && strstr(line, " Pause ") && gclog_number_before(line, "ms", true, &pauseMs)) {
+            full = strstr(line, " Pause Full") != NULL;
+        } else if ((strstr(line, "[GC") || strstr(line, "[Full GC")) && !strstr(line, "concurrent")
+            && gclog_number_before(line, " secs]", false, &pauseMs)) {
+            pauseMs *= 1e3;
+            full = strstr(line, "[Full GC") != NULL;
+        } else {
+            continue;
+        }
+        gclog_series_push(&pauses, pauseMs);
+        stats->pauseTotalMs += pauseMs;
+        if (full) stats->fullPauseCount++;
+
+        double before, after, capacity;
+        if (!gclog_heap_transition(line, &before, &after, &capacity)) continue;
+        heapAfterTotal += after;
+        heapSamples++;
+        if (after > stats->heapAfterMaxMB) stats->heapAfterMaxMB = after;
+        if (capacity > stats->heapCapacityMaxMB) stats->heapCapacityMaxMB = capacity;
+        if (hasTime) {
+            // Whatever the heap grew by since the last collection was allocated in between
+            if (lastAfter >= 0 && before > lastAfter) {
+                allocatedMB += before - lastAfter;
+            }
+            if (firstGcTime < 0) firstGcTime = time;
+            lastGcTime = time;
+            lastAfter = after;
+        }
+    }
+    free(line);
+    fclose(file);
+
+    if (pauses.count) qsort(pauses.values, pauses.count, sizeof(double), gclog_compare);
+    if (ttsp.count) qsort(ttsp.values, ttsp.count, sizeof(double), gclog_compare);
+    stats->pauseCount = (int)pauses.count;
+    stats->pauseP50Ms = gclog_percentile(&pauses, 0.50);
+    stats->pauseP95Ms = gclog_percentile(&pauses, 0.95);
+    stats->pauseP99Ms = gclog_percentile(&pauses, 0.99);
+    stats->pauseMaxMs = gclog_percentile(&pauses, 1);
+    stats->safepointCount = (int)ttsp.count;
+    stats->ttspP50Ms = gclog_percentile(&ttsp, 0.50);
+    stats->ttspP99Ms = gclog_percentile(&ttsp, 0.99);
+    stats->ttspMaxMs = gclog_percentile(&ttsp, 1);
+    if (heapSamples > 0) {
+        stats->heapAfterAvgMB = heapAfterTotal / heapSamples;
+    }
+    if (lastGcTime > firstGcTime && firstGcTime >= 0) {
+        stats->allocRateMBps = allocatedMB / (lastGcTime - firstGcTime);
+    }
+    free(pauses.values);
+    free(ttsp.values);
+    return stats->pauseCount > 0 || stats->safepointCount > 0;
+}
+
+bool gclog_append_session(const char *statsPath, const gclog_stats_t *stats, time_t sessionTime) {
+    FILE *file = fopen(statsPath, "a");
+    if (!file) return false;
+    fprintf(file, "{\"time\":%ld,\"uptimeSec\":%.1f,"
+        "\"pauseCount\":%d,\"fullPauseCount\":%d,\"pauseTotalMs\":%.1f,"
+        "\"pauseP50Ms\":%.2f,\"pauseP95Ms\":%.2f,\"pauseP99Ms\":%.2f,\"pauseMaxMs\":%.2f,"
+        "\"allocRateMBps\":%.1f,\"heapAfterAvgMB\":%.1f,\"heapAfterMaxMB\":%.1f,\"heapCapacityMaxMB\":%.1f,"
+        "\"safepointCount\":%d,\"ttspP50Ms\":%.3f,\"ttspP99Ms\":%.3f,\"ttspMaxMs\":%.3f}\n",
+        (long)sessionTime, stats->uptimeSec,
+        stats->pauseCount, stats->fullPauseCount, stats->pauseTotalMs,
+        stats->pauseP50Ms, stats->pauseP95Ms, stats->pauseP99Ms, stats->pauseMaxMs,
+        stats->allocRateMBps, stats->heapAfterAvgMB, stats->heapAfterMaxMB, stats->heapCapacityMaxMB,
+        stats->safepointCount, stats->ttspP50Ms, stats->ttspP99Ms, stats->ttspMaxMs);
+    return fclose(file) == 0;
+}
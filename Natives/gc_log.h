@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdbool.h>
+#include <time.h>
+
+// GC and safepoint logging for a game session, summarized once the session is
+// over. Understands the unified logging format of Java 9+ (-Xlog, with
+// uptime and tags decorators, in both the pre- and post-JDK 13 safepoint
+// styles) and the -Xloggc format of Java 8.
+
+typedef struct {
+    double uptimeSec;         // last timestamp in the log
+    int pauseCount;
+    int fullPauseCount;
+    double pauseTotalMs;
+    double pauseP50Ms, pauseP95Ms, pauseP99Ms, pauseMaxMs;
+    double allocRateMBps;     // heap allocated between collections over the time they span
+    double heapAfterAvgMB, heapAfterMaxMB;
+    double heapCapacityMaxMB;
+    int safepointCount;
+    double ttspP50Ms, ttspP99Ms, ttspMaxMs; // time to reach a safepoint
+} gclog_stats_t;
+
+// Major version from the runtime's release file ("1.8.0_392" is 8), 0 if unknown
+int gclog_java_version(const char *javaHome);
+// True if the arguments already configure GC logging, which the added flags would clash with
+bool gclog_args_set_logging(const char *args);
+// Appends the logging flags for the runtime, *argc is the index of the last argument.
+// Java 9+ rejects the Java 8 flags, so the version must be the runtime's own.
+void gclog_append_flags(const char *logPath, int javaVersion, int *argc, const char **argv);
+// Returns false if the log can't be read or has no GC or safepoint events
+bool gclog_parse(const char *logPath, gclog_stats_t *stats);
+// Appends the session as one JSON object per line
+bool gclog_append_session(const char *statsPath, const gclog_stats_t *stats, time_t sessionTime);
@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "icon_store.h"
+
+static const char iconStoreBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+bool icon_store_path(const char *storePath, const char *hash, unsigned size, char *path, size_t pathSize) {
+    if (strlen(hash) != SHA1_HEX_LENGTH) return false;
+    int length = snprintf(path, pathSize, "%s/%.2s/%s/%u.png", storePath, hash, hash + 2, size);
+    return length >= 0 && (size_t)length < pathSize;
+}
+
+bool icon_store_reference_hash(const char *icon, char hash[SHA1_HEX_LENGTH + 1]) {
+    size_t prefixLength = strlen(ICON_STORE_REFERENCE_PREFIX);
+    if (!icon || strncmp(icon, ICON_STORE_REFERENCE_PREFIX, prefixLength) != 0) return false;
+    icon += prefixLength;
+    if (strlen(icon) != SHA1_HEX_LENGTH || strspn(icon, "0123456789abcdef") != SHA1_HEX_LENGTH) return false;
+    memcpy(hash, icon, SHA1_HEX_LENGTH + 1);
+    return true;
+}
+
+uint8_t *icon_store_decode_data_url(const char *icon, size_t *length) {
+    if (!icon || strncmp(icon, "data:", 5) != 0) return NULL;
+    const char *payload = strstr(icon, ";base64,");
+    if (!payload) return NULL;
+    payload += 8;
+
+    uint8_t *data = malloc(strlen(payload) / 4 * 3 + 3);
+    size_t count = 0;
+    uint32_t bits = 0;
+    int pending = 0;
+    for (const char *p = payload; *p && *p != '='; p++) {
+        const char *digit = strchr(iconStoreBase64, *p);
+        if (!digit) continue;
+        bits = bits << 6 | (uint32_t)(digit - iconStoreBase64);
+        if (++pending == 4) {
+            data[count++] = bits >> 16;
+            data[count++] = bits >> 8;
+            data[count++] = bits;
+            bits = 0;
+            pending = 0;
+        }
+    }
+    if (pending == 1) {
+        // Six bits can't make a byte
+        free(data);
+        return NULL;
+    } else if (pending == 2) {
+        data[count++] = bits >> 4;
+    } else if (pending == 3) {
+        data[count++] = bits >> 10;
+        data[count++] = bits >> 2;
+    }
+    *length = count;
+    return data;
+}
+
+bool icon_store_data_url_hash(const char *icon, char hash[SHA1_HEX_LENGTH + 1]) {
+    size_t length;
+    uint8_t *data = icon_store_decode_data_url(icon, &length);
+    if (!data || length == 0) {
+        free(data);
+        return false;
+    }
+    sha1_hex(data, length, hash);
+    free(data);
+    return true;
+}
+
+char *icon_store_png_data_url(const uint8_t *png, size_t length) {
+    static const char prefix[] = "data:image/png;base64,";
+    char *url = malloc(sizeof(prefix) + (length + 2) / 3 * 4);
+    memcpy(url, prefix, sizeof(prefix) - 1);
+    char *out = url + sizeof(prefix) - 1;
+    for (size_t i = 0; i < length; i += 3) {
+        uint32_t bits = (uint32_t)png[i] << 16;
+        if (i + 1 < length) bits |= png[i + 1] << 8;
+        if (i + 2 < length) bits |= png[i + 2];
+        *out++ = iconStoreBase64[bits >> 18 & 63];
+        *out++ = iconStoreBase64[bits >> 12 & 63];
+        *out++ = i + 1 < length ? iconStoreBase64[bits >> 6 & 63] : '=';
+        *out++ = i + 2 < length ? iconStoreBase64[bits & 63] : '=';
+    }
+    *out = '\0';
+    return url;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sha1.h"
+
+// Layout and naming behind IconStore. An icon is named by the SHA-1 of its
+// image bytes, the same whether they came from a file or a profile's "data:"
+// URL, and each thumbnail size is kept at <store>/<2 hex>/<38 hex>/<size>.png.
+
+#define ICON_STORE_REFERENCE_PREFIX "iconstore:"
+
+// Returns false if path is too small
+bool icon_store_path(const char *storePath, const char *hash, unsigned size, char *path, size_t pathSize);
+
+// Hash of an "iconstore:<hash>" reference as written by earlier versions
+bool icon_store_reference_hash(const char *icon, char hash[SHA1_HEX_LENGTH + 1]);
+
+// Decodes the base64 payload of a "data:<type>;base64,..." URL, skipping
+// characters outside the alphabet like line breaks. NULL if icon is not one.
+uint8_t *icon_store_decode_data_url(const char *icon, size_t *length);
+// Hash of the image a data URL holds
+bool icon_store_data_url_hash(const char *icon, char hash[SHA1_HEX_LENGTH + 1]);
+// "data:image/png;base64,...", the form launcher_profiles.json uses; free() it
+char *icon_store_png_data_url(const uint8_t *png, size_t length);
@@ -1,3 +1,5 @@
+#include <os/lock.h>
+
 #import "ControllerInput.h"
 #import "../LauncherPreferences.h"
 #import "../PLProfiles.h"
@@ -5,55 +7,86 @@
 #import "../utils.h"
 
 #include "../glfw_keycodes.h"
+#include "gamepad_input.h"
 
-// Left thumbstick directions
-#define DIRECTION_EAST 0
-#define DIRECTION_NORTH_EAST 1
-//#define DIRECTION_NORTH 2
-#define DIRECTION_NORTH_WEST 3
-//#define DIRECTION_WEST 4
-#define DIRECTION_SOUTH_WEST 5
-//#define DIRECTION_SOUTH 6
-#define DIRECTION_SOUTH_EAST 7
 #define MOUSE_MAX_ACCELERATION 2
+// Stick polling rate, well above any display refresh
+#define CONTROLLER_POLL_RATE 250
 
 CFAbsoluteTime lastFrameTime;
 CGFloat lastXValue; // lastHorizontalValue
 CGFloat lastYValue; // lastVerticalValue
 
+// Written by the controller handlers on the main thread, read by the poller
+static gamepad_sticks_t sticks;
+static os_unfair_lock sticksLock = OS_UNFAIR_LOCK_INIT;
+static gamepad_poller_t poller;
+static CGFloat lookScale;
+
+static bool readSticks(void *context, gamepad_sticks_t *out, bool *grabbing) {
+    os_unfair_lock_lock(&sticksLock);
+    *out = sticks;
+    os_unfair_lock_unlock(&sticksLock);
+    *grabbing = isGrabbing;
+    return true;
+}
+
+// Without the event queue, callbacks go straight into the game and must come from the main thread
+static void sendMovementKey(void *context, int key, bool pressed) {
+    if (isUseStackQueueCall) {
+        CallbackBridge_nativeSendKey(key, 0, pressed, 0);
+    } else {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            CallbackBridge_nativeSendKey(key, 0, pressed, 0);
+        });
+    }
+}
+
+static void sendLook(void *context, double dx, double dy) {
+    if (isUseStackQueueCall) {
+        CallbackBridge_nativeSendCursorPos(ACTION_MOVE_MOTION, dx * lookScale, dy * lookScale);
+    } else {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            CallbackBridge_nativeSendCursorPos(ACTION_MOVE_MOTION, dx * lookScale, dy * lookScale);
+        });
+    }
+}
+
 @implementation ControllerInput
 
-NSMutableDictionary *gameMap, *menuMap;
+static gamepad_map_t keycodeMap;
+static BOOL keycodeMapLoaded;
 BOOL leftShiftHeld;
 
++ (void)compileMappingList:(NSArray<NSDictionary *> *)list layer:(int)layer {
+    for (NSDictionary *buttonDict in list) {
+        gamepad_map_set(&keycodeMap, layer, [buttonDict[@"gamepad_button"] intValue], [buttonDict[@"keycode"] intValue]);
+    }
+}
+
 + (void)initKeycodeTable {
-    if (gameMap && menuMap) {
+    if (keycodeMapLoaded) {
         return;
     }
     
+    // Unmapped until a mapping loads, so buttons do nothing rather than send keycode 0
+    gamepad_map_init(&keycodeMap);
     NSString *controlFile = [PLProfiles resolveKeyForCurrentProfile:@"defaultGamepadCtrl"];
     NSString *gamepadPath = [NSString stringWithFormat:@"%s/controlmap/gamepads/%@", getenv("POJAV_HOME"), controlFile];
     NSMutableDictionary *gamepadJSON = parseJSONFromFile(gamepadPath);
-    
-    gameMap = gamepadJSON[@"mGameMappingList"];
-    menuMap = gamepadJSON[@"mMenuMappingList"];
+    if (gamepadJSON[@"NSErrorObject"]) {
+        NSLog(@"[ControllerInput] Could not load %@: %@", controlFile, [gamepadJSON[@"NSErrorObject"] localizedDescription]);
+        return;
+    }
+
+    // Looked up on every button event, so resolve the lists into a table once
+    [self compileMappingList:gamepadJSON[@"mGameMappingList"] layer:GAMEPAD_LAYER_GAME];
+    [self compileMappingList:gamepadJSON[@"mMenuMappingList"] layer:GAMEPAD_LAYER_MENU];
+    keycodeMapLoaded = YES;
 }
 
 + (void)sendKeyEvent:(int)controllerKeycode pressed:(BOOL)pressed {
-    int keycode;
-    __block NSMutableDictionary *mapping;
-    if (isGrabbing) {
-        mapping = gameMap;
-    } else {
-        mapping = menuMap;
-    }
-    
-    for (NSMutableDictionary *buttonDict in mapping) {
-        if(controllerKeycode == [buttonDict[@"gamepad_button"] intValue]) {
-            keycode = [buttonDict[@"keycode"] intValue];
-        }
-    }
-
+    int keycode = gamepad_map_lookup(&keycodeMap, isGrabbing ? GAMEPAD_LAYER_GAME : GAMEPAD_LAYER_MENU, controllerKeycode);
     switch (keycode) {
         case GLFW_KEY_UNKNOWN:
             // Do nothing
@@ -140,49 +173,23 @@ BOOL leftShiftHeld;
         [self sendKeyEvent:GLFW_GAMEPAD_BUTTON_DPAD_RIGHT pressed:pressed];
     };
 
+    // In game the poller turns stick positions into movement and camera motion
     gamepad.leftThumbstick.valueChangedHandler = ^(GCControllerDirectionPad * _Nonnull dpad, float xValue, float yValue) {
+        os_unfair_lock_lock(&sticksLock);
+        sticks.leftX = xValue;
+        sticks.leftY = yValue;
+        os_unfair_lock_unlock(&sticksLock);
         if (!isGrabbing) {
             // Update virtual mouse position
             lastXValue = xValue;
             lastYValue = yValue;
-            return;
         }
-
-        static char lastLThumbDirection = -2;
-        char direction = -1;
-        if (xValue != 0 && yValue != 0) {
-            CGFloat degree = atan2f(yValue, xValue) * (180.0 / M_PI);
-            if (degree < 0) {
-                degree += 360;
-            }
-            direction = (int)((degree+22.5)/45.0) % 8;
-        }
-        if (lastLThumbDirection == direction) {
-            return;
-        }
-
-        // Update WASD states
-        CallbackBridge_nativeSendKey(GLFW_KEY_W, 0,
-            direction >= DIRECTION_NORTH_EAST &&
-            direction <= DIRECTION_NORTH_WEST, 0);
-        CallbackBridge_nativeSendKey(GLFW_KEY_A, 0,
-            direction >= DIRECTION_NORTH_WEST &&
-            direction <= DIRECTION_SOUTH_WEST, 0);
-        CallbackBridge_nativeSendKey(GLFW_KEY_S, 0,
-            direction >= DIRECTION_SOUTH_WEST &&
-            direction <= DIRECTION_SOUTH_EAST, 0);
-        CallbackBridge_nativeSendKey(GLFW_KEY_D, 0,
-            direction == DIRECTION_SOUTH_EAST ||
-            direction == DIRECTION_EAST ||
-            direction == DIRECTION_NORTH_EAST, 0);
-
-        lastLThumbDirection = direction;
     };
     gamepad.rightThumbstick.valueChangedHandler = ^(GCControllerDirectionPad * _Nonnull dpad, float xValue, float yValue) {
-        if (isGrabbing) {
-            lastXValue = xValue;
-            lastYValue = yValue;
-        }
+        os_unfair_lock_lock(&sticksLock);
+        sticks.rightX = xValue;
+        sticks.rightY = yValue;
+        os_unfair_lock_unlock(&sticksLock);
     };
     gamepad.leftThumbstickButton.pressedChangedHandler = ^(GCControllerButtonInput * _Nonnull button, float value, BOOL pressed) {
         [self sendKeyEvent:GLFW_GAMEPAD_BUTTON_LEFT_THUMB pressed:pressed];
@@ -190,17 +197,26 @@ BOOL leftShiftHeld;
     gamepad.rightThumbstickButton.pressedChangedHandler = ^(GCControllerButtonInput * _Nonnull button, float value, BOOL pressed) {
         [self sendKeyEvent:GLFW_GAMEPAD_BUTTON_RIGHT_THUMB pressed:pressed];
     };
+
+    // Same conversion as sendTouchPoint applies to camera motion
+    lookScale = UIWindow.mainWindow.screen.scale;
+    gamepad_poller_callbacks_t callbacks = {
+        .read = readSticks,
+        .movementKey = sendMovementKey,
+        .look = sendLook
+    };
+    gamepad_poller_start(&poller, CONTROLLER_POLL_RATE, &callbacks);
 }
 
 /**
- * Send the new mouse position, computing the delta
+ * Send the new virtual mouse position in menus, computing the delta
  */
 + (void)tick {
     // There isn't a convenient way to get ns, use ms at this point
     CGFloat frameTime = CACurrentMediaTime();
     // GameController automatically performs deadzone calculations
     // so we just take the raw input
-    if (lastFrameTime != 0 && (lastXValue != 0 || lastYValue != 0)) {
+    if (!isGrabbing && lastFrameTime != 0 && (lastXValue != 0 || lastYValue != 0)) {
         CGFloat acceleration = pow(MathUtils_dist(0, 0, lastXValue, lastYValue), MOUSE_MAX_ACCELERATION); // magnitude
         if (acceleration > 1) acceleration = 1;
 
@@ -218,6 +234,10 @@ BOOL leftShiftHeld;
 }
 
 + (void)unregisterControllerCallbacks:(GCController *)controller {
+    gamepad_poller_stop(&poller);
+    os_unfair_lock_lock(&sticksLock);
+    sticks = (gamepad_sticks_t){0};
+    os_unfair_lock_unlock(&sticksLock);
     GCExtendedGamepad *gamepad = controller.extendedGamepad;
     gamepad.leftShoulder.pressedChangedHandler = nil;
     gamepad.rightShoulder.pressedChangedHandler = nil;
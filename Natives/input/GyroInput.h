@@ -4,6 +4,8 @@
 
 + (void)updateOrientation;
 + (void)updateSensitivity:(int)sensitivity invertXAxis:(BOOL)invertX;
+// Low-pass time constant in ms and deadzone in degrees per second
++ (void)updateSmoothing:(int)smoothingMs deadzone:(int)deadzone;
 + (void)tick;
 
 @end
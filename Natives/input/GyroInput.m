@@ -1,16 +1,21 @@
 #import <CoreMotion/CoreMotion.h>
 #import <UIKit/UIKit.h>
+#include <os/lock.h>
 #import "GyroInput.h"
+#include "gyro_integrator.h"
 #import "../SurfaceViewController.h"
 #import "../utils.h"
 
 @implementation GyroInput
 
-static CGFloat lastXValue, lastYValue, lastFrameTime;
 static CGFloat gyroSensitivity;
 static int gyroInvertX;
 static BOOL gyroInvertAxis, gyroSwapAxis;
 static CMMotionManager* cmInstance;
+static NSOperationQueue *motionQueue;
+// Samples come in on motionQueue, frames take them on the main thread
+static gyro_integrator_t integrator;
+static os_unfair_lock integratorLock = OS_UNFAIR_LOCK_INIT;
 
 + (void)updateOrientation {
     UIInterfaceOrientation orientation = UIApplication.sharedApplication.windows[0].windowScene.interfaceOrientation;
@@ -24,48 +29,70 @@ static CMMotionManager* cmInstance;
 + (void)updateSensitivity:(int)sensitivity invertXAxis:(BOOL)invertX {
     if (cmInstance == nil) {
         cmInstance = [[CMMotionManager alloc] init];
+        // As fast as the sensor goes, Core Motion clamps it to the hardware rate
+        cmInstance.deviceMotionUpdateInterval = 1.0 / 200.0;
+        motionQueue = [[NSOperationQueue alloc] init];
+        motionQueue.name = @"GyroInput";
+        motionQueue.maxConcurrentOperationCount = 1;
+        motionQueue.qualityOfService = NSQualityOfServiceUserInteractive;
     }
     gyroSensitivity = sensitivity / 100.0;
     if (sensitivity > 0) {
         gyroInvertX = invertX ? 1 : -1;
         [self updateOrientation];
-        [cmInstance startDeviceMotionUpdates];
+        if (!cmInstance.deviceMotionActive) {
+            [cmInstance startDeviceMotionUpdatesToQueue:motionQueue withHandler:^(CMDeviceMotion *motion, NSError *error) {
+                if (!motion) return;
+                os_unfair_lock_lock(&integratorLock);
+                gyro_integrator_add_sample(&integrator, motion.timestamp, motion.rotationRate.x, motion.rotationRate.y);
+                os_unfair_lock_unlock(&integratorLock);
+            }];
+        }
     } else {
-        lastXValue = lastYValue = lastFrameTime = 0;
         [cmInstance stopDeviceMotionUpdates];
+        os_unfair_lock_lock(&integratorLock);
+        gyro_integrator_reset(&integrator);
+        os_unfair_lock_unlock(&integratorLock);
     }
 }
 
++ (void)updateSmoothing:(int)smoothingMs deadzone:(int)deadzone {
+    os_unfair_lock_lock(&integratorLock);
+    gyro_integrator_init(&integrator, (gyro_filter_t){
+        .smoothing = smoothingMs / 1000.0,
+        .deadzone = deadzone * M_PI / 180.0
+    });
+    os_unfair_lock_unlock(&integratorLock);
+}
+
 + (void)tick {
-    if (!isGrabbing || gyroSensitivity == 0) {
-        lastFrameTime = 0;
+    // Take the rotation even if it's unused, so none is left over when grabbing starts
+    double angleX, angleY;
+    os_unfair_lock_lock(&integratorLock);
+    gyro_integrator_take(&integrator, &angleX, &angleY);
+    os_unfair_lock_unlock(&integratorLock);
+    if (!isGrabbing || gyroSensitivity == 0 || (angleX == 0 && angleY == 0)) {
         return;
     }
 
-    // Compute delta since last tick time
-    CGFloat frameTime = CACurrentMediaTime();
-    CGFloat factor = gyroSensitivity;
-    if (lastFrameTime != 0) {
-        CGFloat deltaTimeScale = (frameTime - lastFrameTime) / (1.0/60.0); // Scale of 1 = 60Hz
-        factor *= deltaTimeScale;
-    }
-
-    // 100% sensitivity -> 1:1 ratio between real world and ingame camera
+    // 100% sensitivity -> 1:1 ratio between real world and ingame camera. This
+    // used to scale the rate by the frame time relative to 60Hz, so keep the
+    // same factor for the same feel.
+    CGFloat factor = gyroSensitivity * 60;
     if (gyroInvertAxis) {
         factor *= -1;
     }
+    CGFloat x, y;
     if (gyroSwapAxis) {
-        lastXValue = cmInstance.deviceMotion.rotationRate.y / (M_PI*90) * windowWidth * factor * gyroInvertX;
-        lastYValue = -cmInstance.deviceMotion.rotationRate.x / (M_PI*180) * windowHeight * factor;
+        x = angleY / (M_PI*90) * windowWidth * factor * gyroInvertX;
+        y = -angleX / (M_PI*180) * windowHeight * factor;
     } else {
-        lastXValue = cmInstance.deviceMotion.rotationRate.x / (M_PI*180) * windowWidth * factor * gyroInvertX;
-        lastYValue = cmInstance.deviceMotion.rotationRate.y / (M_PI*90) * windowHeight * factor;
+        x = angleX / (M_PI*180) * windowWidth * factor * gyroInvertX;
+        y = angleY / (M_PI*90) * windowHeight * factor;
     }
 
     SurfaceViewController *vc = (id)UIWindow.mainWindow.rootViewController;
-    [vc sendTouchPoint:CGPointMake(lastXValue, lastYValue) withEvent:ACTION_MOVE_MOTION];
-
-    lastFrameTime = frameTime;
+    [vc sendTouchPoint:CGPointMake(x, y) withEvent:ACTION_MOVE_MOTION];
 }
 
 @end
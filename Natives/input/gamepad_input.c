@@ -0,0 +1,148 @@
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#include "gamepad_input.h"
+#include "../glfw_keycodes.h"
+
+// Camera speed at full deflection, per 1/60 s
+#define GAMEPAD_LOOK_SPEED 18
+#define GAMEPAD_LOOK_ACCELERATION 2
+
+static int gamepad_map_slot(int button) {
+    if (button >= 0 && button <= GLFW_GAMEPAD_BUTTON_LAST) return button;
+    if (button == GLFW_GAMEPAD_BUTTON_LEFT_TRIGGER) return GLFW_GAMEPAD_BUTTON_LAST + 1;
+    if (button == GLFW_GAMEPAD_BUTTON_RIGHT_TRIGGER) return GLFW_GAMEPAD_BUTTON_LAST + 2;
+    return -1;
+}
+
+void gamepad_map_init(gamepad_map_t *map) {
+    for (int layer = 0; layer < 2; layer++) {
+        for (int slot = 0; slot < GAMEPAD_MAP_SLOTS; slot++) {
+            map->keycodes[layer][slot] = GLFW_KEY_UNKNOWN;
+        }
+    }
+}
+
+bool gamepad_map_set(gamepad_map_t *map, int layer, int button, int keycode) {
+    int slot = gamepad_map_slot(button);
+    if (slot < 0 || layer < 0 || layer > 1 || keycode < INT16_MIN || keycode > INT16_MAX) return false;
+    map->keycodes[layer][slot] = keycode;
+    return true;
+}
+
+int gamepad_map_lookup(const gamepad_map_t *map, int layer, int button) {
+    int slot = gamepad_map_slot(button);
+    return slot < 0 ? GLFW_KEY_UNKNOWN : map->keycodes[layer][slot];
+}
+
+int gamepad_stick_direction(float x, float y) {
+    if (x == 0 && y == 0) return -1;
+    double degree = atan2(y, x) * (180.0 / M_PI);
+    if (degree < 0) degree += 360;
+    return (int)((degree + 22.5) / 45.0) % 8;
+}
+
+// Which of W, A, S, D a direction holds, as bits in that order
+static int gamepad_direction_keys(int direction) {
+    switch (direction) {
+        case 0: return 8;      // east: D
+        case 1: return 1 | 8;  // north east: W D
+        case 2: return 1;
+        case 3: return 1 | 2;
+        case 4: return 2;
+        case 5: return 2 | 4;
+        case 6: return 4;
+        case 7: return 4 | 8;
+        default: return 0;
+    }
+}
+
+void gamepad_poller_step(gamepad_poller_t *poller, const gamepad_sticks_t *sticks, bool grabbing, double dt) {
+    static const int keys[] = {GLFW_KEY_W, GLFW_KEY_A, GLFW_KEY_S, GLFW_KEY_D};
+    const gamepad_poller_callbacks_t *callbacks = &poller->callbacks;
+
+    // Movement keys only apply in game, let go of them in menus
+    int direction = grabbing ? gamepad_stick_direction(sticks->leftX, sticks->leftY) : -1;
+    if (direction != poller->direction) {
+        int held = gamepad_direction_keys(poller->direction), next = gamepad_direction_keys(direction);
+        for (int i = 0; i < 4; i++) {
+            int bit = 1 << i;
+            if ((held ^ next) & bit) {
+                callbacks->movementKey(callbacks->context, keys[i], next & bit);
+            }
+        }
+        poller->direction = direction;
+    }
+
+    if (!grabbing || (sticks->rightX == 0 && sticks->rightY == 0)) return;
+    // The framework applies the deadzone, so positions are used as they are
+    double acceleration = pow(hypot(sticks->rightX, sticks->rightY), GAMEPAD_LOOK_ACCELERATION);
+    if (acceleration > 1) acceleration = 1;
+    double scale = acceleration * GAMEPAD_LOOK_SPEED * dt * 60;
+    callbacks->look(callbacks->context, sticks->rightX * scale, -sticks->rightY * scale);
+}
+
+static uint64_t gamepad_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void *gamepad_poller_main(void *arg) {
+    gamepad_poller_t *poller = arg;
+#ifdef __APPLE__
+    pthread_setname_np("Gamepad poller");
+#endif
+    uint64_t interval = 1000000000ull / poller->rateHz;
+    uint64_t deadline = gamepad_now_ns();
+    poller->lastPollNs = deadline;
+    while (atomic_load(&poller->running)) {
+        // Fixed deadlines so the rate doesn't drift with the time each poll takes
+        deadline += interval;
+        uint64_t now = gamepad_now_ns();
+        if (deadline > now) {
+            uint64_t wait = deadline - now;
+            struct timespec ts = {wait / 1000000000ull, wait % 1000000000ull};
+            nanosleep(&ts, NULL);
+        } else {
+            deadline = now;
+        }
+
+        now = gamepad_now_ns();
+        double dt = (now - poller->lastPollNs) / 1e9;
+        poller->lastPollNs = now;
+        gamepad_sticks_t sticks;
+        bool grabbing;
+        if (poller->callbacks.read(poller->callbacks.context, &sticks, &grabbing)) {
+            gamepad_poller_step(poller, &sticks, grabbing, dt);
+        } else {
+            memset(&sticks, 0, sizeof(sticks));
+            gamepad_poller_step(poller, &sticks, false, dt);
+        }
+    }
+
+    // Let go of movement keys, from this thread like every other poller event
+    gamepad_sticks_t centered = {0};
+    gamepad_poller_step(poller, &centered, false, 0);
+    return NULL;
+}
+
+bool gamepad_poller_start(gamepad_poller_t *poller, int rateHz, const gamepad_poller_callbacks_t *callbacks) {
+    if (atomic_load(&poller->running) || rateHz <= 0) return false;
+    poller->callbacks = *callbacks;
+    poller->rateHz = rateHz;
+    poller->direction = -1;
+    atomic_store(&poller->running, true);
+    if (pthread_create(&poller->thread, NULL, gamepad_poller_main, poller) != 0) {
+        atomic_store(&poller->running, false);
+        return false;
+    }
+    return true;
+}
+
+void gamepad_poller_stop(gamepad_poller_t *poller) {
+    if (!atomic_load(&poller->running)) return;
+    atomic_store(&poller->running, false);
+    pthread_join(poller->thread, NULL);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Gamepad handling that doesn't depend on the controller framework: the
+// button mapping, compiled into a table indexed by button, and a poller that
+// turns stick positions into movement keys and camera motion at a fixed rate
+// on its own thread, independent of the display refresh.
+
+#define GAMEPAD_LAYER_GAME 0
+#define GAMEPAD_LAYER_MENU 1
+// GLFW buttons 0 to GLFW_GAMEPAD_BUTTON_LAST, then the two triggers
+#define GAMEPAD_MAP_SLOTS 17
+
+typedef struct {
+    int16_t keycodes[2][GAMEPAD_MAP_SLOTS];
+} gamepad_map_t;
+
+// Every button starts unmapped (GLFW_KEY_UNKNOWN)
+void gamepad_map_init(gamepad_map_t *map);
+// Later entries for the same button replace earlier ones
+bool gamepad_map_set(gamepad_map_t *map, int layer, int button, int keycode);
+int gamepad_map_lookup(const gamepad_map_t *map, int layer, int button);
+
+typedef struct {
+    float leftX, leftY, rightX, rightY;
+} gamepad_sticks_t;
+
+typedef struct {
+    void *context;
+    // Latest stick positions; false when no controller is connected
+    bool (*read)(void *context, gamepad_sticks_t *sticks, bool *grabbing);
+    void (*movementKey)(void *context, int key, bool pressed);
+    // Camera motion in points, already scaled for the time since the last poll
+    void (*look)(void *context, double dx, double dy);
+} gamepad_poller_callbacks_t;
+
+typedef struct {
+    gamepad_poller_callbacks_t callbacks;
+    int rateHz;
+    int direction; // left stick, -1 when centered
+    uint64_t lastPollNs;
+    pthread_t thread;
+    atomic_bool running;
+} gamepad_poller_t;
+
+// Left stick direction in eighths counterclockwise from east, or -1
+int gamepad_stick_direction(float x, float y);
+// One poll; dt is the time since the previous one in seconds
+void gamepad_poller_step(gamepad_poller_t *poller, const gamepad_sticks_t *sticks, bool grabbing, double dt);
+bool gamepad_poller_start(gamepad_poller_t *poller, int rateHz, const gamepad_poller_callbacks_t *callbacks);
+void gamepad_poller_stop(gamepad_poller_t *poller);
@@ -0,0 +1,55 @@
+#include <math.h>
+#include <string.h>
+
+#include "gyro_integrator.h"
+
+// A longer gap means updates stopped; integrating across it would make the camera jump
+#define GYRO_MAX_SAMPLE_GAP 0.1
+
+void gyro_integrator_init(gyro_integrator_t *gyro, gyro_filter_t filter) {
+    memset(gyro, 0, sizeof(*gyro));
+    gyro->filter = filter;
+}
+
+void gyro_integrator_reset(gyro_integrator_t *gyro) {
+    gyro_integrator_init(gyro, gyro->filter);
+}
+
+// Scaled deadzone, rotation starts from zero right past it instead of jumping
+static double gyro_deadzone(double rate, double deadzone) {
+    double magnitude = fabs(rate) - deadzone;
+    return magnitude > 0 ? copysign(magnitude, rate) : 0;
+}
+
+void gyro_integrator_add_sample(gyro_integrator_t *gyro, double timestamp, double rateX, double rateY) {
+    double dt = timestamp - gyro->lastTimestamp;
+    if (!gyro->hasSample || dt <= 0 || dt > GYRO_MAX_SAMPLE_GAP) {
+        gyro->hasSample = true;
+        gyro->lastTimestamp = timestamp;
+        gyro->filteredX = rateX;
+        gyro->filteredY = rateY;
+        gyro->lastRateX = gyro_deadzone(rateX, gyro->filter.deadzone);
+        gyro->lastRateY = gyro_deadzone(rateY, gyro->filter.deadzone);
+        return;
+    }
+
+    // Time-based exponential smoothing, the same at any sample rate
+    double alpha = gyro->filter.smoothing > 0 ? dt / (gyro->filter.smoothing + dt) : 1;
+    gyro->filteredX += alpha * (rateX - gyro->filteredX);
+    gyro->filteredY += alpha * (rateY - gyro->filteredY);
+    double x = gyro_deadzone(gyro->filteredX, gyro->filter.deadzone);
+    double y = gyro_deadzone(gyro->filteredY, gyro->filter.deadzone);
+
+    // Trapezoidal rule
+    gyro->angleX += (gyro->lastRateX + x) / 2 * dt;
+    gyro->angleY += (gyro->lastRateY + y) / 2 * dt;
+    gyro->lastRateX = x;
+    gyro->lastRateY = y;
+    gyro->lastTimestamp = timestamp;
+}
+
+void gyro_integrator_take(gyro_integrator_t *gyro, double *angleX, double *angleY) {
+    *angleX = gyro->angleX;
+    *angleY = gyro->angleY;
+    gyro->angleX = gyro->angleY = 0;
+}
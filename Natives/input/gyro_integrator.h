@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stdbool.h>
+
+// Turns timestamped gyroscope rates into rotation. Every sample is filtered
+// and integrated as it arrives, so the rotation a frame picks up doesn't
+// depend on how often frames come or when they sample the sensor. Not thread
+// safe; the caller serializes adding samples and taking the rotation.
+
+typedef struct {
+    double smoothing; // low-pass time constant in seconds, 0 to disable
+    double deadzone;  // rates below this (rad/s) count as no rotation
+} gyro_filter_t;
+
+typedef struct {
+    gyro_filter_t filter;
+    bool hasSample;
+    double lastTimestamp;
+    double filteredX, filteredY; // rad/s after the low-pass
+    double lastRateX, lastRateY; // rad/s after the deadzone
+    double angleX, angleY;       // radians not taken yet
+} gyro_integrator_t;
+
+void gyro_integrator_init(gyro_integrator_t *gyro, gyro_filter_t filter);
+// Starts over, e.g. after updates were paused
+void gyro_integrator_reset(gyro_integrator_t *gyro);
+void gyro_integrator_add_sample(gyro_integrator_t *gyro, double timestamp, double rateX, double rateY);
+// Rotation since the last call
+void gyro_integrator_take(gyro_integrator_t *gyro, double *angleX, double *angleY);
@@ -0,0 +1,34 @@
+#include "input_event_queue.h"
+
+bool input_event_queue_push(input_event_queue_t *queue, const GLFWInputEvent *event) {
+    pthread_mutex_lock(&queue->lock);
+    size_t *count = &queue->counts[queue->writeIndex];
+    bool queued = *count < INPUT_EVENT_QUEUE_CAPACITY;
+    if (queued) {
+        queue->buffers[queue->writeIndex][(*count)++] = *event;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return queued;
+}
+
+size_t input_event_queue_take(input_event_queue_t *queue, const GLFWInputEvent **events) {
+    pthread_mutex_lock(&queue->lock);
+    if (!queue->taken) {
+        // Producers move on to the buffer that was delivered last time
+        queue->writeIndex ^= 1;
+        queue->counts[queue->writeIndex] = 0;
+        queue->taken = true;
+    }
+    int readIndex = queue->writeIndex ^ 1;
+    size_t count = queue->counts[readIndex];
+    pthread_mutex_unlock(&queue->lock);
+    // Nothing writes to the read buffer until the next take
+    *events = queue->buffers[readIndex];
+    return count;
+}
+
+void input_event_queue_rewind(input_event_queue_t *queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->taken = false;
+    pthread_mutex_unlock(&queue->lock);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// GLFW input events on their way to the game thread. The main thread and the
+// gamepad poller append to one buffer while glfwPollEvents delivers the other,
+// so an event queued during a pump waits for the next one instead of being
+// overwritten when the pump finishes.
+
+typedef struct {
+    short type;
+    union {
+        int i1;
+        float f1;
+    };
+    union {
+        int i2;
+        float f2;
+    };
+    short i3;
+    short i4;
+} GLFWInputEvent;
+
+#define INPUT_EVENT_QUEUE_CAPACITY 8000
+
+typedef struct {
+    pthread_mutex_t lock;
+    GLFWInputEvent buffers[2][INPUT_EVENT_QUEUE_CAPACITY];
+    size_t counts[2];
+    int writeIndex; // the buffer producers append to
+    bool taken;     // the other buffer is being delivered
+} input_event_queue_t;
+
+#define INPUT_EVENT_QUEUE_INITIALIZER { .lock = PTHREAD_MUTEX_INITIALIZER }
+
+// Returns false and drops the event when the queue is full
+bool input_event_queue_push(input_event_queue_t *queue, const GLFWInputEvent *event);
+// Events queued before the first call since the last rewind. Later calls
+// return the same events, so each window gets all of them.
+size_t input_event_queue_take(input_event_queue_t *queue, const GLFWInputEvent **events);
+// Done delivering, the next take picks up what was queued in the meantime
+void input_event_queue_rewind(input_event_queue_t *queue);
@@ -20,6 +20,7 @@
 #include "jni.h"
 #include "glfw_keycodes.h"
 #include "ios_uikit_bridge.h"
+#include "stall_watchdog.h"
 #include "utils.h"
 
 #include "JavaLauncher.h"
@@ -248,10 +249,15 @@ void handleFramebufferSizeJava(void* window, int w, int h) {
     (*runtimeJNIEnvPtr)->CallStaticVoidMethod(runtimeJNIEnvPtr, vmGlfwClass, method_internalWindowSizeChanged, (long)window, w, h);
 }
 
+// Events come from the main thread and from the gamepad poller
+static input_event_queue_t inputEvents = INPUT_EVENT_QUEUE_INITIALIZER;
+
 void pojavPumpEvents(void* window) {
+    // Also runs every frame when rendering with Vulkan, which never swaps through here
+    stall_watchdog_beat();
     CallbackBridge_nativeSetInputReady(YES);
-    //__android_log_print(ANDROID_LOG_INFO, "input_bridge_v3", "pojavPumpevents %d", eventCounter);
-    size_t counter = atomic_load_explicit(&eventCounter, memory_order_acquire);
+    const GLFWInputEvent *events;
+    size_t counter = input_event_queue_take(&inputEvents, &events);
     if((cLastX != cursorX || cLastY != cursorY) && GLFW_invoke_CursorPos) {
         cLastX = cursorX;
         cLastY = cursorY;
@@ -286,10 +292,9 @@ void pojavPumpEvents(void* window) {
                 break;
         }
     }
-    atomic_store_explicit(&eventCounter, counter, memory_order_release);
 }
 void pojavRewindEvents() {
-    atomic_store_explicit(&eventCounter, 0, memory_order_release);
+    input_event_queue_rewind(&inputEvents);
 }
 
 JNIEXPORT void JNICALL
@@ -314,29 +319,13 @@ Java_org_lwjgl_glfw_GLFW_glfwSetCursorPos(JNIEnv *env, jclass clazz, jlong windo
 }
 
 void sendData(short type, int i1, int i2, short i3, short i4) {
-    size_t counter = atomic_load_explicit(&eventCounter, memory_order_acquire);
-    if (counter < 7999) {
-        GLFWInputEvent *event = &events[counter++];
-        event->type = type;
-        event->i1 = i1;
-        event->i2 = i2;
-        event->i3 = i3;
-        event->i4 = i4;
-    }
-    atomic_store_explicit(&eventCounter, counter, memory_order_release);
+    GLFWInputEvent event = {.type = type, .i1 = i1, .i2 = i2, .i3 = i3, .i4 = i4};
+    input_event_queue_push(&inputEvents, &event);
 }
 
 void sendDataFloat(short type, float i1, float i2, short i3, short i4) {
-    size_t counter = atomic_load_explicit(&eventCounter, memory_order_acquire);
-    if (counter < 7999) {
-        GLFWInputEvent *event = &events[counter++];
-        event->type = type;
-        event->f1 = i1;
-        event->f2 = i2;
-        event->i3 = i3;
-        event->i4 = i4;
-    }
-    atomic_store_explicit(&eventCounter, counter, memory_order_release);
+    GLFWInputEvent event = {.type = type, .f1 = i1, .f2 = i2, .i3 = i3, .i4 = i4};
+    input_event_queue_push(&inputEvents, &event);
 }
 
 void closeGLFWWindow() {
@@ -1,6 +1,8 @@
 #import "AFNetworking.h"
 #import "ForgeInstallViewController.h"
 #import "LauncherNavigationController.h"
+#import "LauncherPreferences.h"
+#import "UnzipKit.h"
 #import "WFWorkflowProgressView.h"
 #import "ios_uikit_bridge.h"
 #import "utils.h"
@@ -174,8 +176,14 @@
                 return;
             }
             LauncherNavigationController *navVC = (id)((UISplitViewController *)self.presentingViewController).viewControllers[1];
+            NSDictionary *profile = getPrefBool(@"debug.debug_headless_forge_installer") ?
+                [self installProfileFromInstaller:outPath] : nil;
             [self dismissViewControllerAnimated:YES completion:^{
-                [navVC enterModInstallerWithPath:outPath hitEnterAfterWindowShown:YES];
+                if (profile) {
+                    [navVC enterModInstallerWithPath:outPath installProfile:profile];
+                } else {
+                    [navVC enterModInstallerWithPath:outPath hitEnterAfterWindowShown:YES];
+                }
             }];
         });
     }];
@@ -184,6 +192,30 @@
     });
 }
 
+// Installers for 1.13+ describe the install as processors, which run without
+// their GUI when debug_headless_forge_installer is on. Places the version JSON
+// so its libraries can be downloaded first.
+- (NSDictionary *)installProfileFromInstaller:(NSString *)path {
+    NSError *error;
+    UZKArchive *archive = [[UZKArchive alloc] initWithPath:path error:&error];
+    NSData *data = [archive extractDataFromFile:@"install_profile.json" error:&error];
+    NSDictionary *profile = data ? [NSJSONSerialization JSONObjectWithData:data options:0 error:&error] : nil;
+    if (![profile isKindOfClass:NSDictionary.class] || !profile[@"processors"] || !profile[@"json"] || !profile[@"version"]) {
+        NSLog(@"[Forge Installer] No processors in install profile, using the installer GUI");
+        return nil;
+    }
+
+    NSString *jsonName = [profile[@"json"] stringByTrimmingCharactersInSet:[NSCharacterSet characterSetWithCharactersInString:@"/"]];
+    NSData *versionData = [archive extractDataFromFile:jsonName error:&error];
+    NSString *jsonPath = [NSString stringWithFormat:@"%1$s/versions/%2$@/%2$@.json", getenv("POJAV_GAME_DIR"), profile[@"version"]];
+    [NSFileManager.defaultManager createDirectoryAtPath:jsonPath.stringByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:nil];
+    if (!versionData || ![versionData writeToFile:jsonPath options:NSDataWritingAtomic error:&error]) {
+        NSLog(@"[Forge Installer] Could not place %@: %@, using the installer GUI", jsonName, error.localizedDescription);
+        return nil;
+    }
+    return profile;
+}
+
 - (void)addVersionToList:(NSString *)version {
     if (![version containsString:@"-"]) {
         return;
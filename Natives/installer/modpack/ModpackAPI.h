@@ -17,5 +17,6 @@
 - (void)downloader:(MinecraftResourceDownloadTask *)downloader submitDownloadTasksFromPackage:(NSString *)packagePath toPath:(NSString *)destPath;
 
 - (id)getEndpoint:(NSString *)endpoint params:(NSDictionary *)params;
+- (id)postEndpoint:(NSString *)endpoint body:(NSDictionary *)body;
 
 @end
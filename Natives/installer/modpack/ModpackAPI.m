@@ -45,6 +45,25 @@
     return result;
 }
 
+- (id)postEndpoint:(NSString *)endpoint body:(NSDictionary *)body {
+    __block id result;
+    dispatch_group_t group = dispatch_group_create();
+    dispatch_group_enter(group);
+    NSString *url = [self.baseURL stringByAppendingPathComponent:endpoint];
+    AFHTTPSessionManager *manager = [AFHTTPSessionManager manager];
+    manager.requestSerializer = [AFJSONRequestSerializer serializer];
+    [manager POST:url parameters:body headers:nil progress:nil
+    success:^(NSURLSessionTask *task, id obj) {
+        result = obj;
+        dispatch_group_leave(group);
+    } failure:^(NSURLSessionTask *operation, NSError *error) {
+        self.lastError = error;
+        dispatch_group_leave(group);
+    }];
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    return result;
+}
+
 - (void)installModpackFromDetail:(NSDictionary *)modDetail atIndex:(NSUInteger)selectedVersion {
     // Pass details to LauncherNavigationController
     NSDictionary* userInfo = @{
@@ -1,3 +1,4 @@
+#import "IconStore.h"
 #import "MinecraftResourceDownloadTask.h"
 #import "ModrinthAPI.h"
 #import "PLProfiles.h"
@@ -211,14 +212,13 @@
 
     // Create profile
     NSString *tmpIconPath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"icon.png"];
-    PLProfiles.current.profiles[indexDict[@"name"]] = @{
+    NSMutableDictionary *profile = @{
         @"gameDir": [NSString stringWithFormat:@"./custom_gamedir/%@", destPath.lastPathComponent],
         @"name": indexDict[@"name"],
-        @"lastVersionId": depInfo[@"id"],
-        @"icon": [NSString stringWithFormat:@"data:image/png;base64,%@",
-            [[NSData dataWithContentsOfFile:tmpIconPath]
-            base64EncodedStringWithOptions:0]]
+        @"lastVersionId": depInfo[@"id"]
     }.mutableCopy;
+    profile[@"icon"] = [IconStore dataURLForImageAtPath:tmpIconPath];
+    PLProfiles.current.profiles[indexDict[@"name"]] = profile;
     PLProfiles.current.selectedProfileName = indexDict[@"name"];
 }
 
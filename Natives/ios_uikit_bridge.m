@@ -4,7 +4,9 @@
 #import "LauncherNavigationController.h"
 #import "LauncherPreferences.h"
 #import "LauncherSplitViewController.h"
+#import "PLDeferredWriter.h"
 #import "PLLogOutputView.h"
+#import "PLProfiles.h"
 #import "SurfaceViewController.h"
 
 #include <objc/runtime.h>
@@ -84,6 +86,32 @@ dispatch_async(dispatch_get_main_queue(), ^{
 });
 }
 
+static NSString *UIKit_stringFromJava(JNIEnv *env, jstring string) {
+    if (!string) return nil;
+    const char *string_c = (*env)->GetStringUTFChars(env, string, 0);
+    NSString *string_o = @(string_c);
+    (*env)->ReleaseStringUTFChars(env, string, string_c);
+    return string_o;
+}
+
+// From the headless Forge installer. PLProfiles holds launcher_profiles.json in
+// memory, so the profile goes through it; written before the JVM exits the app.
+JNIEXPORT void JNICALL Java_net_kdt_pojavlaunch_uikit_UIKit_addLauncherProfile(JNIEnv* env, jclass clazz, jstring name, jstring lastVersionId, jstring icon) {
+    NSString *name_o = UIKit_stringFromJava(env, name);
+    NSMutableDictionary *profile = @{
+        @"name": name_o,
+        @"type": @"custom",
+        @"lastVersionId": UIKit_stringFromJava(env, lastVersionId)
+    }.mutableCopy;
+    profile[@"icon"] = UIKit_stringFromJava(env, icon);
+    dispatch_sync(dispatch_get_main_queue(), ^{
+        PLProfiles.current.profiles[name_o] = profile;
+        [PLProfiles.current save];
+        [PLDeferredWriter flushAll];
+    });
+    NSLog(@"[ForgeInstaller] Added profile %@ for %@", name_o, profile[@"lastVersionId"]);
+}
+
 jstring UIKit_accessClipboard(JNIEnv* env, jint action, jbyteArray copySrc) {
     if (action == CLIPBOARD_PASTE) {
         // paste request
@@ -0,0 +1,321 @@
+#include <string.h>
+
+#include "json_cursor.h"
+
+void json_cursor_init(json_cursor_t *cursor, const void *data, size_t length) {
+    cursor->p = data;
+    cursor->end = cursor->p + length;
+}
+
+static inline void json_skip_whitespace(json_cursor_t *cursor) {
+    const char *p = cursor->p;
+    while (p < cursor->end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+        p++;
+    }
+    cursor->p = p;
+}
+
+json_type_t json_peek(json_cursor_t *cursor) {
+    json_skip_whitespace(cursor);
+    if (cursor->p >= cursor->end) return JSON_INVALID;
+    switch (*cursor->p) {
+        case '{': return JSON_OBJECT;
+        case '[': return JSON_ARRAY;
+        case '"': return JSON_STRING;
+        case 't': return JSON_TRUE;
+        case 'f': return JSON_FALSE;
+        case 'n': return JSON_NULL;
+        case '-': case '0': case '1': case '2': case '3': case '4':
+        case '5': case '6': case '7': case '8': case '9':
+            return JSON_NUMBER;
+        default: return JSON_INVALID;
+    }
+}
+
+// p points past the opening quote, returns the closing quote or NULL
+static const char *json_string_end(const char *p, const char *end) {
+    const char *start = p;
+    while (p < end) {
+        const char *quote = memchr(p, '"', end - p);
+        if (!quote) return NULL;
+        // Escaped if preceded by an odd run of backslashes
+        size_t backslashes = 0;
+        while (quote - backslashes > start && quote[-1 - (ptrdiff_t)backslashes] == '\\') {
+            backslashes++;
+        }
+        if (backslashes % 2 == 0) return quote;
+        p = quote + 1;
+    }
+    return NULL;
+}
+
+bool json_read_string(json_cursor_t *cursor, json_string_t *out) {
+    if (json_peek(cursor) != JSON_STRING) return false;
+    const char *start = cursor->p + 1;
+    const char *quote = json_string_end(start, cursor->end);
+    if (!quote) return false;
+    if (out) {
+        out->start = start;
+        out->length = quote - start;
+        out->hasEscapes = memchr(start, '\\', quote - start) != NULL;
+    }
+    cursor->p = quote + 1;
+    return true;
+}
+
+static bool json_skip_literal(json_cursor_t *cursor, const char *literal, size_t length) {
+    if ((size_t)(cursor->end - cursor->p) < length || memcmp(cursor->p, literal, length)) {
+        return false;
+    }
+    cursor->p += length;
+    return true;
+}
+
+static bool json_skip_container(json_cursor_t *cursor) {
+    const char *p = cursor->p, *end = cursor->end;
+    size_t depth = 0;
+    while (p < end) {
+        switch (*p) {
+            case '"':
+                p = json_string_end(p + 1, end);
+                if (!p) return false;
+                break;
+            case '{': case '[':
+                depth++;
+                break;
+            case '}': case ']':
+                if (--depth == 0) {
+                    cursor->p = p + 1;
+                    return true;
+                }
+                break;
+        }
+        p++;
+    }
+    return false;
+}
+
+bool json_skip_value(json_cursor_t *cursor) {
+    switch (json_peek(cursor)) {
+        case JSON_OBJECT:
+        case JSON_ARRAY:
+            return json_skip_container(cursor);
+        case JSON_STRING:
+            return json_read_string(cursor, NULL);
+        case JSON_NUMBER:
+            while (cursor->p < cursor->end && *cursor->p && strchr("+-0123456789.eE", *cursor->p)) {
+                cursor->p++;
+            }
+            return true;
+        case JSON_TRUE: return json_skip_literal(cursor, "true", 4);
+        case JSON_FALSE: return json_skip_literal(cursor, "false", 5);
+        case JSON_NULL: return json_skip_literal(cursor, "null", 4);
+        default: return false;
+    }
+}
+
+static inline bool json_is_digit(const char *p, const char *end) {
+    return p < end && *p >= '0' && *p <= '9';
+}
+
+static bool json_append_digit(uint64_t *value, unsigned digit) {
+    if (*value > (UINT64_MAX - digit) / 10) return false;
+    *value = *value * 10 + digit;
+    return true;
+}
+
+bool json_read_uint64(json_cursor_t *cursor, uint64_t *out) {
+    if (json_peek(cursor) != JSON_NUMBER || *cursor->p == '-') return false;
+    const char *p = cursor->p, *end = cursor->end;
+    const char *integer = p;
+    while (json_is_digit(p, end)) p++;
+    ptrdiff_t integerLength = p - integer;
+    const char *fraction = p;
+    ptrdiff_t fractionLength = 0;
+    if (p < end && *p == '.') {
+        fraction = ++p;
+        while (json_is_digit(p, end)) p++;
+        fractionLength = p - fraction;
+        if (fractionLength == 0) return false;
+    }
+    long exponent = 0;
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        bool negative = ++p < end && *p == '-';
+        if (p < end && (*p == '-' || *p == '+')) p++;
+        if (!json_is_digit(p, end)) return false;
+        while (json_is_digit(p, end)) {
+            // Anything past 20 digits either overflows or truncates to 0
+            if (exponent < 1000) exponent = exponent * 10 + (*p - '0');
+            p++;
+        }
+        if (negative) exponent = -exponent;
+    }
+
+    // Digits left of the point once the exponent moved it, the rest is truncated
+    ptrdiff_t kept = integerLength + exponent;
+    uint64_t value = 0;
+    for (ptrdiff_t i = 0; i < kept && i < integerLength + fractionLength; i++) {
+        char c = i < integerLength ? integer[i] : fraction[i - integerLength];
+        if (!json_append_digit(&value, c - '0')) return false;
+    }
+    for (ptrdiff_t i = integerLength + fractionLength; i < kept; i++) {
+        if (!json_append_digit(&value, 0)) return false;
+    }
+    cursor->p = p;
+    *out = value;
+    return true;
+}
+
+bool json_read_bool(json_cursor_t *cursor, bool *out) {
+    switch (json_peek(cursor)) {
+        case JSON_TRUE: *out = true; return json_skip_literal(cursor, "true", 4);
+        case JSON_FALSE: *out = false; return json_skip_literal(cursor, "false", 5);
+        default: return false;
+    }
+}
+
+static bool json_enter(json_cursor_t *cursor, json_type_t type) {
+    if (json_peek(cursor) != type) return false;
+    cursor->p++;
+    return true;
+}
+
+bool json_enter_object(json_cursor_t *cursor) {
+    return json_enter(cursor, JSON_OBJECT);
+}
+
+bool json_enter_array(json_cursor_t *cursor) {
+    return json_enter(cursor, JSON_ARRAY);
+}
+
+// Consumes the separator before the next member, false at the closing bracket
+static bool json_next_member(json_cursor_t *cursor, char close) {
+    json_skip_whitespace(cursor);
+    if (cursor->p < cursor->end && *cursor->p == ',') {
+        cursor->p++;
+        json_skip_whitespace(cursor);
+    }
+    if (cursor->p >= cursor->end) return false;
+    if (*cursor->p == close) {
+        cursor->p++;
+        return false;
+    }
+    return true;
+}
+
+bool json_next_key(json_cursor_t *cursor, json_string_t *key) {
+    if (!json_next_member(cursor, '}') || !json_read_string(cursor, key)) {
+        return false;
+    }
+    json_skip_whitespace(cursor);
+    if (cursor->p >= cursor->end || *cursor->p != ':') return false;
+    cursor->p++;
+    return true;
+}
+
+bool json_next_element(json_cursor_t *cursor) {
+    return json_next_member(cursor, ']');
+}
+
+bool json_find_key(json_cursor_t *cursor, const char *key) {
+    json_string_t name;
+    while (json_next_key(cursor, &name)) {
+        if (json_string_equals(name, key)) return true;
+        if (!json_skip_value(cursor)) return false;
+    }
+    return false;
+}
+
+bool json_string_equals(json_string_t string, const char *literal) {
+    size_t length = strlen(literal);
+    if (!string.hasEscapes) {
+        return string.length == length && !memcmp(string.start, literal, length);
+    }
+    char buffer[256];
+    return json_string_copy(string, buffer, sizeof(buffer)) == length && !memcmp(buffer, literal, length);
+}
+
+static int json_hex_value(const char *p) {
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return -1;
+    }
+    return value;
+}
+
+static size_t json_encode_utf8(uint32_t codepoint, char *out) {
+    if (codepoint < 0x80) {
+        out[0] = codepoint;
+        return 1;
+    } else if (codepoint < 0x800) {
+        out[0] = 0xC0 | (codepoint >> 6);
+        out[1] = 0x80 | (codepoint & 0x3F);
+        return 2;
+    } else if (codepoint < 0x10000) {
+        out[0] = 0xE0 | (codepoint >> 12);
+        out[1] = 0x80 | ((codepoint >> 6) & 0x3F);
+        out[2] = 0x80 | (codepoint & 0x3F);
+        return 3;
+    }
+    out[0] = 0xF0 | (codepoint >> 18);
+    out[1] = 0x80 | ((codepoint >> 12) & 0x3F);
+    out[2] = 0x80 | ((codepoint >> 6) & 0x3F);
+    out[3] = 0x80 | (codepoint & 0x3F);
+    return 4;
+}
+
+size_t json_string_copy(json_string_t string, char *buffer, size_t capacity) {
+    if (!string.hasEscapes) {
+        if (string.length >= capacity) return (size_t)-1;
+        memcpy(buffer, string.start, string.length);
+        buffer[string.length] = '\0';
+        return string.length;
+    }
+
+    const char *p = string.start, *end = string.start + string.length;
+    size_t length = 0;
+    while (p < end) {
+        // Worst case a single escape expands to 4 bytes
+        if (length + 4 >= capacity) return (size_t)-1;
+        if (*p != '\\') {
+            buffer[length++] = *p++;
+            continue;
+        }
+        if (++p >= end) return (size_t)-1;
+        char c = *p++;
+        switch (c) {
+            case 'b': buffer[length++] = '\b'; break;
+            case 'f': buffer[length++] = '\f'; break;
+            case 'n': buffer[length++] = '\n'; break;
+            case 'r': buffer[length++] = '\r'; break;
+            case 't': buffer[length++] = '\t'; break;
+            case 'u': {
+                if (end - p < 4) return (size_t)-1;
+                int unit = json_hex_value(p);
+                if (unit < 0) return (size_t)-1;
+                p += 4;
+                uint32_t codepoint = unit;
+                // Surrogate pair
+                if (unit >= 0xD800 && unit < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                    int low = json_hex_value(p + 2);
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        codepoint = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    }
+                }
+                length += json_encode_utf8(codepoint, buffer + length);
+                break;
+            }
+            default: // \" \\ \/
+                buffer[length++] = c;
+                break;
+        }
+    }
+    buffer[length] = '\0';
+    return length;
+}
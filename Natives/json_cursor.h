@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Forward-only, on-demand reader over a JSON document in memory (typically
+// mmap'ed). Nothing is allocated and nothing is materialized until asked for:
+// values that aren't wanted are skipped by scanning for their closing
+// delimiter, which for strings is a memchr over the bytes. Meant for large
+// read-mostly files such as asset indexes where only a few fields matter.
+// Input is trusted to be well-formed; malformed input makes calls return false.
+
+typedef enum {
+    JSON_INVALID,
+    JSON_OBJECT,
+    JSON_ARRAY,
+    JSON_STRING,
+    JSON_NUMBER,
+    JSON_TRUE,
+    JSON_FALSE,
+    JSON_NULL
+} json_type_t;
+
+typedef struct {
+    const char *p, *end;
+} json_cursor_t;
+
+// Raw bytes between the quotes, still escaped if hasEscapes is set
+typedef struct {
+    const char *start;
+    size_t length;
+    bool hasEscapes;
+} json_string_t;
+
+void json_cursor_init(json_cursor_t *cursor, const void *data, size_t length);
+json_type_t json_peek(json_cursor_t *cursor);
+bool json_skip_value(json_cursor_t *cursor);
+
+bool json_read_string(json_cursor_t *cursor, json_string_t *out);
+// Reads the whole number including any fraction and exponent, truncating
+// toward zero. False, with the cursor left on the value, for negative numbers
+// and anything above UINT64_MAX.
+bool json_read_uint64(json_cursor_t *cursor, uint64_t *out);
+bool json_read_bool(json_cursor_t *cursor, bool *out);
+
+// Objects: call json_enter_object, then json_next_key until it returns false;
+// after each key exactly one value must be read or skipped.
+bool json_enter_object(json_cursor_t *cursor);
+bool json_next_key(json_cursor_t *cursor, json_string_t *key);
+// Same for arrays with json_next_element
+bool json_enter_array(json_cursor_t *cursor);
+bool json_next_element(json_cursor_t *cursor);
+
+// Skips members of the current object up to key and leaves the cursor on its
+// value. On a miss the object has been consumed.
+bool json_find_key(json_cursor_t *cursor, const char *key);
+
+bool json_string_equals(json_string_t string, const char *literal);
+// Writes the unescaped, NUL-terminated string into buffer and returns its
+// length, or (size_t)-1 if it doesn't fit
+size_t json_string_copy(json_string_t string, char *buffer, size_t capacity);
@@ -0,0 +1,258 @@
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "library_resolver.h"
+
+typedef struct {
+    char *coordinate;   // NULL for an empty slot
+    uint64_t hash;
+    char *version;
+    int library;
+    int level;
+    size_t position;    // in the classpath order
+} library_entry_t;
+
+struct library_resolver {
+    library_entry_t *slots;
+    size_t capacity;    // power of two
+    size_t count;
+    int *order;         // library per position, -1 once overridden
+    size_t orderCount, orderCapacity;
+    int added;
+    int level;
+};
+
+typedef struct {
+    const char *start;
+    size_t length;      // 0 for the release that follows the last qualifier
+} library_token_t;
+
+static uint64_t library_hash(const char *coordinate) {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char *p = (const unsigned char *)coordinate; *p; p++) {
+        hash = (hash ^ *p) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static library_entry_t *library_find_slot(library_resolver_t *resolver, const char *coordinate, uint64_t hash) {
+    size_t mask = resolver->capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        library_entry_t *slot = &resolver->slots[i];
+        if (!slot->coordinate || (slot->hash == hash && !strcmp(slot->coordinate, coordinate))) {
+            return slot;
+        }
+    }
+}
+
+static void library_grow(library_resolver_t *resolver) {
+    library_entry_t *old = resolver->slots;
+    size_t oldCapacity = resolver->capacity;
+    resolver->capacity = oldCapacity ? oldCapacity * 2 : 64;
+    resolver->slots = calloc(resolver->capacity, sizeof(library_entry_t));
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (old[i].coordinate) {
+            *library_find_slot(resolver, old[i].coordinate, old[i].hash) = old[i];
+        }
+    }
+    free(old);
+}
+
+static size_t library_append(library_resolver_t *resolver, int library) {
+    if (resolver->orderCount == resolver->orderCapacity) {
+        resolver->orderCapacity = resolver->orderCapacity ? resolver->orderCapacity * 2 : 64;
+        resolver->order = realloc(resolver->order, resolver->orderCapacity * sizeof(int));
+    }
+    resolver->order[resolver->orderCount] = library;
+    return resolver->orderCount++;
+}
+
+library_resolver_t *library_resolver_create(void) {
+    return calloc(1, sizeof(library_resolver_t));
+}
+
+void library_resolver_free(library_resolver_t *resolver) {
+    if (!resolver) return;
+    for (size_t i = 0; i < resolver->capacity; i++) {
+        free(resolver->slots[i].coordinate);
+        free(resolver->slots[i].version);
+    }
+    free(resolver->slots);
+    free(resolver->order);
+    free(resolver);
+}
+
+void library_resolver_next_level(library_resolver_t *resolver) {
+    resolver->level++;
+}
+
+size_t library_coordinate(const char *name, char *buffer, size_t capacity) {
+    const char *at = strchr(name, '@');
+    size_t nameLength = at ? (size_t)(at - name) : strlen(name);
+    const char *extension = at ? at : "";
+    // group:artifact, then whatever follows the version
+    const char *versionStart = NULL, *versionEnd = NULL;
+    int colons = 0;
+    for (size_t i = 0; i < nameLength; i++) {
+        if (name[i] != ':') continue;
+        if (++colons == 2) versionStart = name + i;
+        else if (colons == 3) versionEnd = name + i;
+    }
+    if (colons < 2) {
+        versionStart = versionEnd = name + nameLength;
+    } else {
+        if (!versionEnd) versionEnd = name + nameLength;
+        // jar is the default, "@jar" names the same artifact
+        if (!strcmp(extension, "@jar")) extension = "";
+    }
+    size_t head = versionStart - name, tail = name + nameLength - versionEnd, extensionLength = strlen(extension);
+    size_t length = head + tail + extensionLength;
+    if (length >= capacity) return (size_t)-1;
+    memcpy(buffer, name, head);
+    memcpy(buffer + head, versionEnd, tail);
+    memcpy(buffer + head + tail, extension, extensionLength + 1);
+    return length;
+}
+
+static char *library_version(const char *name) {
+    const char *start = strchr(name, ':');
+    start = start ? strchr(start + 1, ':') : NULL;
+    if (!start) return strdup("");
+    start++;
+    size_t length = strcspn(start, ":@");
+    return strndup(start, length);
+}
+
+static bool library_is_separator(char c) {
+    return c == '.' || c == '-' || c == '_' || c == '+';
+}
+
+// "1.0rc1" is 1, 0, rc, 1
+static bool library_next_token(const char **p, library_token_t *token) {
+    const char *s = *p;
+    while (library_is_separator(*s)) s++;
+    *p = s;
+    if (!*s) return false;
+    bool digit = isdigit((unsigned char)*s);
+    while (*s && !library_is_separator(*s) && (bool)isdigit((unsigned char)*s) == digit) s++;
+    token->start = *p;
+    token->length = s - *p;
+    *p = s;
+    return true;
+}
+
+static bool library_token_is_number(library_token_t token) {
+    return token.length > 0 && isdigit((unsigned char)token.start[0]);
+}
+
+static bool library_token_equals(library_token_t token, const char *literal) {
+    return strlen(literal) == token.length && !strncasecmp(token.start, literal, token.length);
+}
+
+// Known pre-release qualifiers in order, then anything else alphabetically
+static int library_qualifier_rank(library_token_t token) {
+    static const char *qualifiers[] = {"alpha", "a", "beta", "b", "milestone", "m", "rc", "cr", "snapshot"};
+    const int count = sizeof(qualifiers) / sizeof(*qualifiers);
+    for (int i = 0; i < count; i++) {
+        if (library_token_equals(token, qualifiers[i])) {
+            return i == count - 1 ? i : i / 2;
+        }
+    }
+    return count + 1;
+}
+
+// Compares digits as numbers of any length, ignoring leading zeros
+static int library_compare_numbers(library_token_t a, library_token_t b) {
+    while (a.length > 1 && a.start[0] == '0') a.start++, a.length--;
+    while (b.length > 1 && b.start[0] == '0') b.start++, b.length--;
+    if (a.length != b.length) return a.length < b.length ? -1 : 1;
+    return memcmp(a.start, b.start, a.length);
+}
+
+static int library_compare_qualifiers(library_token_t a, library_token_t b) {
+    int result = library_qualifier_rank(a) - library_qualifier_rank(b);
+    for (size_t i = 0; !result && i < a.length && i < b.length; i++) {
+        result = tolower((unsigned char)a.start[i]) - tolower((unsigned char)b.start[i]);
+    }
+    if (!result && a.length != b.length) result = a.length < b.length ? -1 : 1;
+    return result;
+}
+
+int library_compare_versions(const char *a, const char *b) {
+    static const library_token_t zero = {"0", 1}, release = {"", 0};
+    while (true) {
+        library_token_t p, q;
+        bool hasP = library_next_token(&a, &p), hasQ = library_next_token(&b, &q);
+        if (!hasP && !hasQ) return 0;
+        // A missing part is 0 next to a number and a release next to a qualifier
+        if (!hasP) p = library_token_is_number(q) ? zero : release;
+        if (!hasQ) q = library_token_is_number(p) ? zero : release;
+        int result;
+        if (p.length == 0 || q.length == 0) {
+            result = p.length == 0 ? 1 : -1;
+        } else if (library_token_is_number(p) && library_token_is_number(q)) {
+            result = library_compare_numbers(p, q);
+        } else if (library_token_is_number(p) != library_token_is_number(q)) {
+            result = library_token_is_number(p) ? 1 : -1;
+        } else {
+            result = library_compare_qualifiers(p, q);
+        }
+        if (result) return result < 0 ? -1 : 1;
+    }
+}
+
+library_add_result_t library_resolver_add(library_resolver_t *resolver, const char *name, int *other) {
+    int library = resolver->added++;
+    size_t nameLength = strlen(name);
+    char *coordinate = malloc(nameLength + 1);
+    library_coordinate(name, coordinate, nameLength + 1);
+    // Keep the load factor under 3/4
+    if ((resolver->count + 1) * 4 > resolver->capacity * 3) {
+        library_grow(resolver);
+    }
+    uint64_t hash = library_hash(coordinate);
+    library_entry_t *slot = library_find_slot(resolver, coordinate, hash);
+    if (!slot->coordinate) {
+        *slot = (library_entry_t){
+            .coordinate = coordinate, .hash = hash, .version = library_version(name),
+            .library = library, .level = resolver->level, .position = library_append(resolver, library)
+        };
+        resolver->count++;
+        return LIBRARY_ADDED;
+    }
+    free(coordinate);
+
+    *other = slot->library;
+    char *version = library_version(name);
+    library_add_result_t result;
+    if (slot->level < resolver->level) {
+        resolver->order[slot->position] = -1;
+        slot->position = library_append(resolver, library);
+        result = LIBRARY_OVERRIDES;
+    } else if (library_compare_versions(version, slot->version) > 0) {
+        resolver->order[slot->position] = library;
+        result = LIBRARY_SUPERSEDES;
+    } else {
+        free(version);
+        return LIBRARY_SUPERSEDED;
+    }
+    free(slot->version);
+    slot->version = version;
+    slot->library = library;
+    slot->level = resolver->level;
+    return result;
+}
+
+size_t library_resolver_result(library_resolver_t *resolver, int *indices) {
+    size_t count = 0;
+    for (size_t i = 0; i < resolver->orderCount; i++) {
+        if (resolver->order[i] >= 0) {
+            indices[count++] = resolver->order[i];
+        }
+    }
+    return count;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Picks one library per coordinate, group:artifact[:classifier][@extension],
+// across an inheritance chain, with the same policy as the launcher's
+// ClasspathResolver. Versions are added from the base (vanilla) to the most
+// derived one:
+// - A version overrides what it inherits. If it lists a coordinate its parent
+//   already has, its own entry wins even if the version number is lower, and
+//   moves to the position it has in the derived version.
+// - Within a single version, the highest version of a coordinate wins and
+//   keeps the position of the first entry.
+// Libraries are identified by the order they were added in, starting at 0.
+
+typedef struct library_resolver library_resolver_t;
+
+typedef enum {
+    LIBRARY_ADDED,      // first of its coordinate
+    LIBRARY_OVERRIDES,  // replaced the inherited library *other
+    LIBRARY_SUPERSEDES, // replaced the lower version *other of the same version
+    LIBRARY_SUPERSEDED  // dropped for *other of the same version
+} library_add_result_t;
+
+library_resolver_t *library_resolver_create(void);
+void library_resolver_free(library_resolver_t *resolver);
+
+// Starts the libraries of the next version in the chain
+void library_resolver_next_level(library_resolver_t *resolver);
+// name is "group:artifact:version[:classifier][@extension]"
+library_add_result_t library_resolver_add(library_resolver_t *resolver, const char *name, int *other);
+// Writes the libraries that remain in classpath order, returns how many there are.
+// indices must hold as many entries as libraries were added.
+size_t library_resolver_result(library_resolver_t *resolver, int *indices);
+
+// Writes the coordinate of name and returns its length, or (size_t)-1 if it doesn't fit
+size_t library_coordinate(const char *name, char *buffer, size_t capacity);
+// Maven-like ordering: numeric parts compare as numbers and a number beats a
+// qualifier, so 1.0-alpha < 1.0-beta < 1.0-rc1 < 1.0-SNAPSHOT < 1.0 < 1.0.1
+int library_compare_versions(const char *a, const char *b);
@@ -0,0 +1,255 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log_store.h"
+
+// Longer lines are cut so a single line can't flush the whole arena
+#define LOG_STORE_MAX_LINE 4096
+
+typedef struct {
+    size_t offset;
+    uint32_t length;
+    uint8_t severity;
+    bool matched;
+} log_line_t;
+
+struct log_store {
+    char *arena;
+    size_t arenaSize, writePos;
+
+    log_line_t *lines;
+    size_t maxLines;
+    uint64_t firstSeq, endSeq;
+
+    char pending[LOG_STORE_MAX_LINE];
+    size_t pendingLength;
+    // The held line was cut, the rest of it is dropped up to its newline
+    bool pendingCut;
+
+    char *query;
+    size_t queryLength;
+    log_severity_t minSeverity;
+    // Ring of matching sequence numbers, ascending, never larger than maxLines
+    uint64_t *matches;
+    size_t matchHead, matchCount;
+};
+
+log_store_t *log_store_create(size_t arenaSize, size_t maxLines) {
+    log_store_t *store = calloc(1, sizeof(log_store_t));
+    store->arenaSize = arenaSize;
+    store->maxLines = maxLines;
+    store->arena = malloc(arenaSize);
+    store->lines = malloc(maxLines * sizeof(log_line_t));
+    store->matches = malloc(maxLines * sizeof(uint64_t));
+    return store;
+}
+
+void log_store_destroy(log_store_t *store) {
+    free(store->arena);
+    free(store->lines);
+    free(store->matches);
+    free(store->query);
+    free(store);
+}
+
+void log_store_clear(log_store_t *store) {
+    store->firstSeq = store->endSeq;
+    store->writePos = 0;
+    store->pendingLength = 0;
+    store->pendingCut = false;
+    store->matchCount = 0;
+}
+
+static inline log_line_t *log_store_entry(const log_store_t *store, uint64_t seq) {
+    return &store->lines[seq % store->maxLines];
+}
+
+static inline uint64_t log_store_match_at(const log_store_t *store, size_t i) {
+    return store->matches[(store->matchHead + i) % store->maxLines];
+}
+
+static void log_store_prune_matches(log_store_t *store) {
+    while (store->matchCount > 0 && store->matches[store->matchHead] < store->firstSeq) {
+        store->matchHead = (store->matchHead + 1) % store->maxLines;
+        store->matchCount--;
+    }
+}
+
+static log_severity_t log_store_classify(const log_store_t *store, const char *line) {
+    // Stack trace frames belong to the line that started the trace
+    if (!strncmp(line, "\tat ", 4) || !strncmp(line, "\t... ", 5)) {
+        if (store->endSeq > store->firstSeq) {
+            return log_store_entry(store, store->endSeq - 1)->severity;
+        }
+        return LOG_SEVERITY_ERROR;
+    }
+    // log4j prints "[12:34:56] [Render thread/WARN]: ..."
+    if (strstr(line, "/ERROR]") || strstr(line, "/FATAL]") || strstr(line, "[ERROR]") ||
+        strstr(line, "Exception in thread") || !strncmp(line, "Caused by: ", 11)) {
+        return LOG_SEVERITY_ERROR;
+    }
+    if (strstr(line, "/WARN]") || strstr(line, "[WARN]") || !strncmp(line, "WARNING:", 8)) {
+        return LOG_SEVERITY_WARN;
+    }
+    return LOG_SEVERITY_INFO;
+}
+
+static bool log_store_contains(const char *line, size_t length, const char *query, size_t queryLength) {
+    if (queryLength > length) return false;
+    for (size_t i = 0; i <= length - queryLength; i++) {
+        size_t j = 0;
+        while (j < queryLength && tolower((unsigned char)line[i + j]) == query[j]) j++;
+        if (j == queryLength) return true;
+    }
+    return false;
+}
+
+static void log_store_update_match(log_store_t *store, uint64_t seq) {
+    log_line_t *entry = log_store_entry(store, seq);
+    entry->matched = entry->severity >= store->minSeverity &&
+        log_store_contains(store->arena + entry->offset, entry->length, store->query, store->queryLength);
+    if (entry->matched) {
+        store->matches[(store->matchHead + store->matchCount) % store->maxLines] = seq;
+        store->matchCount++;
+    }
+}
+
+static inline void log_store_evict(log_store_t *store) {
+    store->firstSeq++;
+}
+
+void log_store_append_line(log_store_t *store, const char *line, size_t length) {
+    if (length > 0 && line[length - 1] == '\r') length--;
+    if (length > LOG_STORE_MAX_LINE) length = LOG_STORE_MAX_LINE;
+    size_t need = length + 1;
+    if (need > store->arenaSize) return;
+
+    if (store->endSeq - store->firstSeq == store->maxLines) {
+        log_store_evict(store);
+    }
+    if (store->endSeq == store->firstSeq) {
+        store->writePos = 0;
+    } else if (store->writePos + need > store->arenaSize) {
+        // Wrap around, lines left in the tail are the oldest ones
+        while (store->endSeq > store->firstSeq &&
+               log_store_entry(store, store->firstSeq)->offset >= store->writePos) {
+            log_store_evict(store);
+        }
+        store->writePos = 0;
+    }
+    // Make room by dropping the oldest lines in the way
+    while (store->endSeq > store->firstSeq) {
+        log_line_t *oldest = log_store_entry(store, store->firstSeq);
+        if (oldest->offset >= store->writePos + need ||
+            oldest->offset + oldest->length + 1 <= store->writePos) {
+            break;
+        }
+        log_store_evict(store);
+    }
+    log_store_prune_matches(store);
+
+    char *dest = store->arena + store->writePos;
+    memcpy(dest, line, length);
+    dest[length] = '\0';
+
+    log_line_t *entry = log_store_entry(store, store->endSeq);
+    entry->offset = store->writePos;
+    entry->length = (uint32_t)length;
+    entry->severity = log_store_classify(store, dest);
+    store->writePos += need;
+    log_store_update_match(store, store->endSeq++);
+}
+
+void log_store_append(log_store_t *store, const char *text, size_t length) {
+    while (length > 0) {
+        const char *newline = memchr(text, '\n', length);
+        size_t chunk = newline ? (size_t)(newline - text) : length;
+        if (store->pendingCut) {
+            store->pendingCut = !newline;
+        } else if (store->pendingLength > 0 || !newline) {
+            size_t copy = chunk;
+            if (copy > LOG_STORE_MAX_LINE - store->pendingLength) {
+                copy = LOG_STORE_MAX_LINE - store->pendingLength;
+            }
+            memcpy(store->pending + store->pendingLength, text, copy);
+            store->pendingLength += copy;
+            if (newline || store->pendingLength == LOG_STORE_MAX_LINE) {
+                log_store_append_line(store, store->pending, store->pendingLength);
+                store->pendingLength = 0;
+                store->pendingCut = !newline;
+            }
+        } else {
+            log_store_append_line(store, text, chunk);
+        }
+        if (!newline) break;
+        text += chunk + 1;
+        length -= chunk + 1;
+    }
+}
+
+uint64_t log_store_first_seq(const log_store_t *store) {
+    return store->firstSeq;
+}
+
+uint64_t log_store_end_seq(const log_store_t *store) {
+    return store->endSeq;
+}
+
+const char *log_store_line(const log_store_t *store, uint64_t seq, size_t *length, log_severity_t *severity) {
+    if (seq < store->firstSeq || seq >= store->endSeq) {
+        return NULL;
+    }
+    log_line_t *entry = log_store_entry(store, seq);
+    if (length) *length = entry->length;
+    if (severity) *severity = entry->severity;
+    return store->arena + entry->offset;
+}
+
+void log_store_set_query(log_store_t *store, const char *query, log_severity_t minSeverity) {
+    free(store->query);
+    store->queryLength = query ? strlen(query) : 0;
+    store->query = malloc(store->queryLength + 1);
+    for (size_t i = 0; i < store->queryLength; i++) {
+        store->query[i] = tolower((unsigned char)query[i]);
+    }
+    store->query[store->queryLength] = '\0';
+    store->minSeverity = minSeverity;
+
+    store->matchHead = store->matchCount = 0;
+    for (uint64_t seq = store->firstSeq; seq < store->endSeq; seq++) {
+        log_store_update_match(store, seq);
+    }
+}
+
+bool log_store_line_matches(const log_store_t *store, uint64_t seq) {
+    if (seq < store->firstSeq || seq >= store->endSeq) {
+        return false;
+    }
+    return log_store_entry(store, seq)->matched;
+}
+
+size_t log_store_match_count(log_store_t *store) {
+    log_store_prune_matches(store);
+    return store->matchCount;
+}
+
+uint64_t log_store_find_match(log_store_t *store, uint64_t seq, bool forward) {
+    log_store_prune_matches(store);
+    // First match after seq
+    size_t low = 0, high = store->matchCount;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (log_store_match_at(store, mid) <= seq) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (forward) {
+        return low < store->matchCount ? log_store_match_at(store, low) : UINT64_MAX;
+    }
+    // Step back over seq itself if it matched
+    while (low > 0 && log_store_match_at(store, low - 1) >= seq) low--;
+    return low > 0 ? log_store_match_at(store, low - 1) : UINT64_MAX;
+}
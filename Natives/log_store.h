@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Fixed-capacity store for log output. Line text lives in a single circular
+// arena and is indexed by a ring of offsets; the oldest lines are dropped once
+// either is full. Lines are addressed by a sequence number that keeps growing
+// across evictions, so callers can tell when a line they hold has gone away.
+// Not thread-safe, callers serialize access.
+
+typedef enum {
+    LOG_SEVERITY_INFO,
+    LOG_SEVERITY_WARN,
+    LOG_SEVERITY_ERROR
+} log_severity_t;
+
+typedef struct log_store log_store_t;
+
+log_store_t *log_store_create(size_t arenaSize, size_t maxLines);
+void log_store_destroy(log_store_t *store);
+void log_store_clear(log_store_t *store);
+
+// Splits raw output into lines; an unterminated tail is held until the next call
+void log_store_append(log_store_t *store, const char *text, size_t length);
+void log_store_append_line(log_store_t *store, const char *line, size_t length);
+
+uint64_t log_store_first_seq(const log_store_t *store);
+uint64_t log_store_end_seq(const log_store_t *store);
+// Returns the NUL-terminated line, or NULL if seq has been evicted
+const char *log_store_line(const log_store_t *store, uint64_t seq, size_t *length, log_severity_t *severity);
+
+// Sets the search query, case-insensitive; NULL or "" matches every line at or
+// above minSeverity. Matches are then kept up to date as lines are appended.
+void log_store_set_query(log_store_t *store, const char *query, log_severity_t minSeverity);
+bool log_store_line_matches(const log_store_t *store, uint64_t seq);
+size_t log_store_match_count(log_store_t *store);
+// Nearest matching line after (forward) or before seq, or UINT64_MAX if there is none
+uint64_t log_store_find_match(log_store_t *store, uint64_t seq, bool forward);
@@ -0,0 +1,100 @@
+#include <fcntl.h>
+#include <mach-o/fat.h>
+#include <mach-o/loader.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "macho_patch.h"
+
+static bool macho_patch_slice(const char *path, int fd, off_t sliceOffset, uint32_t platform) {
+    struct mach_header_64 header;
+    if (pread(fd, &header, sizeof(header), sliceOffset) != sizeof(header) ||
+        header.magic != MH_MAGIC_64 || header.cputype != CPU_TYPE_ARM64) {
+        return false;
+    }
+
+    off_t commandsOffset = sliceOffset + sizeof(struct mach_header_64);
+    uint8_t *commands = malloc(header.sizeofcmds);
+    if (!commands || pread(fd, commands, header.sizeofcmds, commandsOffset) != header.sizeofcmds) {
+        free(commands);
+        return false;
+    }
+
+    bool patched = false;
+    uint8_t *end = commands + header.sizeofcmds;
+    struct load_command *command = (struct load_command *)commands;
+    for (uint32_t i = 0; i < header.ncmds; i++) {
+        if ((uint8_t *)command + sizeof(struct load_command) > end ||
+            command->cmdsize < sizeof(struct load_command) || (uint8_t *)command + command->cmdsize > end) {
+            break; // malformed
+        }
+        if (command->cmd == LC_BUILD_VERSION) {
+            struct build_version_command *buildver = (struct build_version_command *)command;
+            if (buildver->platform == platform) break; // it is already set, stop
+            buildver->platform = platform;
+            patched = true;
+        } else if (command->cmd == LC_LOAD_DYLIB) {
+            struct dylib_command *dylib = (struct dylib_command *)command;
+            if (dylib->dylib.name.offset < command->cmdsize) {
+                char *dylibName = (char *)dylib + dylib->dylib.name.offset;
+                size_t nameLength = strnlen(dylibName, command->cmdsize - dylib->dylib.name.offset);
+                char *verPtr = memmem(dylibName, nameLength, "/Versions/", 10);
+                if (verPtr && verPtr + 11 <= dylibName + nameLength) {
+                    // Remove "/Versions/X"
+                    size_t lastComponentLen = nameLength - (verPtr - dylibName) - 11;
+                    memmove(verPtr, verPtr + 11, lastComponentLen);
+                    verPtr[lastComponentLen] = '\0';
+                    patched = true;
+                }
+            }
+        }
+        command = (struct load_command *)((uint8_t *)command + command->cmdsize);
+    }
+
+    if (patched) {
+        int wfd = open(path, O_WRONLY);
+        if (wfd == -1 || pwrite(wfd, commands, header.sizeofcmds, commandsOffset) != header.sizeofcmds) {
+            patched = false;
+        } else {
+            fsync(wfd);
+        }
+        if (wfd != -1) close(wfd);
+    }
+    free(commands);
+    return patched;
+}
+
+bool macho_patch_platform(const char *path, uint32_t platform) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return false;
+
+    bool patched = false;
+    uint32_t magic;
+    if (pread(fd, &magic, sizeof(magic), 0) != sizeof(magic)) {
+        close(fd);
+        return false;
+    }
+    if (magic == FAT_CIGAM) {
+        // Fat headers are big endian, find the arm64 slice
+        struct fat_header header;
+        uint32_t nfat_arch = 0;
+        if (pread(fd, &header, sizeof(header), 0) == sizeof(header)) {
+            nfat_arch = __builtin_bswap32(header.nfat_arch);
+        }
+        for (uint32_t i = 0; i < nfat_arch; i++) {
+            struct fat_arch arch;
+            if (pread(fd, &arch, sizeof(arch), sizeof(struct fat_header) + i * sizeof(struct fat_arch)) != sizeof(arch)) {
+                break;
+            }
+            if ((cpu_type_t)__builtin_bswap32(arch.cputype) == CPU_TYPE_ARM64) {
+                patched |= macho_patch_slice(path, fd, __builtin_bswap32(arch.offset), platform);
+            }
+        }
+    } else if (magic == MH_MAGIC_64) {
+        patched = macho_patch_slice(path, fd, 0, platform);
+    }
+
+    close(fd);
+    return patched;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Makes arm64 Mach-O files built for another Apple platform loadable here:
+// LC_BUILD_VERSION is set to the given platform and framework-style
+// "/Versions/X" dependencies are flattened. Load commands live right after
+// the header, so a slice is checked and patched with two small reads and at
+// most one write instead of mapping the whole (often multi-megabyte) file.
+
+// Returns true if the file was changed
+bool macho_patch_platform(const char *path, uint32_t platform);
@@ -178,9 +178,7 @@ void init_redirectStdio() {
                     filteredSessionID = true;
                 }
             }
-            if (canAppendToLog) {
-                [PLLogOutputView appendToLog:@(buf)];
-            }
+            [PLLogOutputView appendToLog:buf length:rsize];
             [file writeData:[NSData dataWithBytes:buf length:rsize]];
             [file synchronizeFile];
         }
@@ -5,6 +5,7 @@
 #import "utils.h"
 
 #include "external/fishhook/fishhook.h"
+#include "stall_watchdog.h"
 
 void (*orig_abort)();
 void (*orig_exit)(int code);
@@ -45,6 +46,8 @@ void hooked___assert_rtn(const char* func, const char* file, int line, const cha
 
 void hooked_exit(int code) {
     NSLog(@"exit(%d) called", code);
+    // Frames stop while the game shuts down or the crash is shown, neither is a stall
+    stall_watchdog_stop();
     if (code == 0) {
         dispatch_async(dispatch_get_main_queue(), ^{
             [UIApplication.sharedApplication performSelector:@selector(suspend)];
@@ -59,14 +62,20 @@ void hooked_exit(int code) {
 }
 
 void* hooked_dlopen(const char* path, int mode) {
+    // Libraries checked on this or a previous launch are loaded right away
+    struct stat st;
+    if (!path || stat(path, &st) != 0 || PLPatchedIndexContains(path, &st)) {
+        return orig_dlopen(path, mode);
+    }
+
     const char *home = getenv("HOME");
     // Only proceed to check if dylib is in the home dir
     char fullpath[PATH_MAX];
-    if (!path || !realpath(path, fullpath) || !strstr(fullpath, home)) {
-        return orig_dlopen(path, mode);
+    if (realpath(path, fullpath) && strstr(fullpath, home) && PLPatchMachOPlatformForFile(fullpath)) {
+        // Patching changed the modification time
+        stat(fullpath, &st);
     }
-
-    PLPatchMachOPlatformForFile(path);
+    PLPatchedIndexAdd(path, &st);
     return orig_dlopen(path, mode);
 }
 
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "memory_governor.h"
+
+#define ROUND_UP(x, to) ((((x) + (to) - 1) / (to)) * (to))
+
+static int memgov_base_heap(int mcMinorVersion) {
+    if (mcMinorVersion == 0) return 768;
+    if (mcMinorVersion < 13) return 512;
+    // The 1.13 world format rewrite roughly doubled chunk memory
+    if (mcMinorVersion < 17) return 768;
+    if (mcMinorVersion < 21) return 1024;
+    return 1152;
+}
+
+memgov_sizing_t memgov_compute_sizing(memgov_input_t input) {
+    memgov_sizing_t sizing;
+
+    // Mods beyond the first hundred are mostly small libraries
+    int modHeap = input.modCount <= 100 ? input.modCount * 20 : 2000 + (input.modCount - 100) * 12;
+    int heap = ROUND_UP(memgov_base_heap(input.mcMinorVersion) + modHeap, 64);
+    int cap = input.physicalMB * input.maxRatio;
+    if (heap > cap) heap = cap;
+    if (heap < 512) heap = cap < 512 ? cap : 512;
+    sizing.maxHeapMB = heap;
+
+    // Start at a quarter so small packs don't touch memory they never use
+    sizing.initialHeapMB = heap / 4;
+    if (sizing.initialHeapMB < 128) sizing.initialHeapMB = 128;
+    if (sizing.initialHeapMB > 512) sizing.initialHeapMB = 512;
+
+    // Initial metaspace high-water mark, avoids a chain of full GCs while
+    // mod classes are loaded. Not a limit.
+    sizing.metaspaceMB = ROUND_UP(64 + input.modCount * 3 / 2, 32);
+    if (sizing.metaspaceMB > 512) sizing.metaspaceMB = 512;
+
+    int nonHeap = sizing.metaspaceMB + 768;
+    sizing.jetsamLimitMB = heap + (nonHeap > 1024 ? nonHeap : 1024);
+    return sizing;
+}
+
+int memgov_parse_minor_version(const char *versionId) {
+    if (!versionId) return 0;
+    // Finds "1.X" in ids like "1.20.1", "fabric-loader-0.15.0-1.20.1" or "1.12.2-forge-14.23.5"
+    for (const char *p = versionId; (p = strstr(p, "1.")); p++) {
+        if (p != versionId && (p[-1] >= '0' && p[-1] <= '9')) continue;
+        if (p != versionId && p[-1] == '.') continue;
+        int minor = atoi(p + 2);
+        if (minor > 0) return minor;
+    }
+    // NeoForge ids carry the Minecraft version without its "1.": neoforge-21.1.77 is for 1.21.1
+    const char *neoforge = strstr(versionId, "neoforge-");
+    if (neoforge) {
+        int minor = atoi(neoforge + 9);
+        if (minor >= 20) return minor;
+    }
+    return 0;
+}
+
+bool memgov_args_set_gc(const char *args) {
+    if (!args) return false;
+    for (const char *p = args; (p = strstr(p, "-XX:")); p++) {
+        const char *name = p + 4;
+        if (*name == '+' || *name == '-') name++;
+        size_t length = strcspn(name, " =\t\n");
+        // -XX:+UseSerialGC, -XX:+UseZGC, -XX:-UseG1GC...
+        if (!strncmp(name, "Use", 3) && length > 5 && !strncmp(name + length - 2, "GC", 2)) return true;
+        if (!strncmp(name, "MaxGCPauseMillis", length) && length == 16) return true;
+        if (!strncmp(name, "G1", 2)) return true;
+    }
+    return false;
+}
+
+bool memgov_append_gc_flags(memgov_sizing_t sizing, int javaVersion, int *argc, const char **argv) {
+    static char metaspaceFlag[64];
+    snprintf(metaspaceFlag, sizeof(metaspaceFlag), "-XX:MetaspaceSize=%dM", sizing.metaspaceMB);
+    argv[++*argc] = metaspaceFlag;
+
+    bool concurrent = false;
+    if (sizing.maxHeapMB <= 768) {
+        // G1's remembered sets cost too much on heaps this small
+        argv[++*argc] = "-XX:+UseSerialGC";
+    } else {
+        argv[++*argc] = "-XX:+UseG1GC";
+        argv[++*argc] = "-XX:MaxGCPauseMillis=50";
+        if (javaVersion >= 12) {
+            // Return unused heap to the OS while the game idles (JEP 346)
+            argv[++*argc] = "-XX:G1PeriodicGCInterval=30000";
+            // G1 also shrinks the heap after a concurrent cycle since 12, so a
+            // trim request doesn't need a full stop-the-world collection
+            argv[++*argc] = "-XX:+ExplicitGCInvokesConcurrent";
+            concurrent = true;
+        }
+    }
+    // Let the heap shrink after a trim request instead of staying at its peak
+    argv[++*argc] = "-XX:MinHeapFreeRatio=10";
+    argv[++*argc] = "-XX:MaxHeapFreeRatio=30";
+    return concurrent;
+}
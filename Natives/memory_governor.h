@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdbool.h>
+
+typedef struct {
+    int physicalMB;     // device RAM
+    double maxRatio;    // share of the device RAM the heap may take
+    int mcMinorVersion; // the X in 1.X, 0 if unknown
+    int modCount;
+    int javaVersion;
+} memgov_input_t;
+
+typedef struct {
+    int maxHeapMB;
+    int initialHeapMB;
+    int metaspaceMB;
+    int jetsamLimitMB;  // whole process: heap, metaspace, native and GL
+} memgov_sizing_t;
+
+// Plain C sizing model, no platform dependencies
+memgov_sizing_t memgov_compute_sizing(memgov_input_t input);
+int memgov_parse_minor_version(const char *versionId);
+// True if the JVM arguments pick a collector or tune its pauses, e.g.
+// -XX:+UseZGC or -XX:MaxGCPauseMillis=20; the launcher then adds none
+bool memgov_args_set_gc(const char *args);
+// Appends GC tuning flags for the runtime, *argc is the index of the last argument.
+// Returns true if System.gc() then runs concurrently with the game.
+bool memgov_append_gc_flags(memgov_sizing_t sizing, int javaVersion, int *argc, const char **argv);
+
+// iOS side
+int memgov_count_mods(const char *gameDir);
+void memgov_apply_jetsam_limit(int limitMB);
+// Asks the JVM to trim its heap when the process gets close to its memory
+// limit. Without a concurrent System.gc() only when it is about to be killed.
+void memgov_start_monitor(bool concurrentTrim);
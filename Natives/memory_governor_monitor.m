@@ -0,0 +1,101 @@
+#include <dirent.h>
+#include <errno.h>
+#include <os/proc.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "environ.h"
+#include "memory_governor.h"
+#include "utils.h"
+
+int memorystatus_control(uint32_t command, int32_t pid, uint32_t flags, void *buffer, size_t buffersize);
+#define MEMORYSTATUS_CMD_SET_JETSAM_TASK_LIMIT        6
+
+// Below this much headroom the JVM is asked to collect and give memory back
+#define MEMGOV_TRIM_HEADROOM_MB 256
+// Below this much a stop-the-world collection beats being killed by Jetsam
+#define MEMGOV_CRITICAL_HEADROOM_MB 64
+#define MEMGOV_TRIM_COOLDOWN_SEC 30
+
+static dispatch_source_t pressureSource, pollTimer;
+static time_t lastTrimTime;
+static bool trimConcurrently;
+
+int memgov_count_mods(const char *gameDir) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/mods", gameDir);
+    DIR *dir = opendir(path);
+    if (!dir) return 0;
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        size_t len = strlen(entry->d_name);
+        if (len > 4 && !strcasecmp(entry->d_name + len - 4, ".jar")) {
+            count++;
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+void memgov_apply_jetsam_limit(int limitMB) {
+    if (!getEntitlementValue(@"com.apple.private.memorystatus")) {
+        return;
+    }
+    if (memorystatus_control(MEMORYSTATUS_CMD_SET_JETSAM_TASK_LIMIT, getpid(), limitMB, NULL, 0) == -1) {
+        NSLog(@"[MemoryGovernor] Failed to set Jetsam task limit: error: %s", strerror(errno));
+    } else {
+        NSLog(@"[MemoryGovernor] Jetsam task limit set to %d MB", limitMB);
+    }
+}
+
+static void memgov_trim(const char *reason, bool critical) {
+    // Without a concurrent System.gc() (Serial, G1 before Java 12 or a collector
+    // from the JVM arguments) it pauses the game for a full collection
+    if (!trimConcurrently && !critical) {
+        return;
+    }
+    time_t now = time(NULL);
+    if (!runtimeJavaVMPtr || now - lastTrimTime < MEMGOV_TRIM_COOLDOWN_SEC) {
+        return;
+    }
+    lastTrimTime = now;
+    NSLog(@"[MemoryGovernor] Requesting heap trim (%s, %zu MB available)", reason, os_proc_available_memory() >> 20);
+
+    JNIEnv *env;
+    (*runtimeJavaVMPtr)->AttachCurrentThread(runtimeJavaVMPtr, &env, NULL);
+    jclass systemClass = (*env)->FindClass(env, "java/lang/System");
+    jmethodID gcMethod = (*env)->GetStaticMethodID(env, systemClass, "gc", "()V");
+    (*env)->CallStaticVoidMethod(env, systemClass, gcMethod);
+    if ((*env)->ExceptionCheck(env)) {
+        (*env)->ExceptionClear(env);
+    }
+    (*env)->DeleteLocalRef(env, systemClass);
+    (*runtimeJavaVMPtr)->DetachCurrentThread(runtimeJavaVMPtr);
+}
+
+void memgov_start_monitor(bool concurrentTrim) {
+    if (pollTimer) return;
+    trimConcurrently = concurrentTrim;
+    dispatch_queue_t queue = dispatch_queue_create("MemoryGovernor", DISPATCH_QUEUE_SERIAL);
+
+    pressureSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE, 0,
+        DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL, queue);
+    dispatch_source_set_event_handler(pressureSource, ^{
+        memgov_trim("memory pressure", dispatch_source_get_data(pressureSource) & DISPATCH_MEMORYPRESSURE_CRITICAL);
+    });
+    dispatch_resume(pressureSource);
+
+    // The pressure notification is system-wide and often arrives too late,
+    // so also watch this process's own headroom
+    pollTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, queue);
+    dispatch_source_set_timer(pollTimer, dispatch_time(DISPATCH_TIME_NOW, 2 * NSEC_PER_SEC), 2 * NSEC_PER_SEC, NSEC_PER_SEC / 2);
+    dispatch_source_set_event_handler(pollTimer, ^{
+        size_t available = os_proc_available_memory();
+        // 0 means the limit is unknown (simulator, unsupported OS)
+        if (available > 0 && (available >> 20) < MEMGOV_TRIM_HEADROOM_MB) {
+            memgov_trim("low headroom", (available >> 20) < MEMGOV_CRITICAL_HEADROOM_MB);
+        }
+    });
+    dispatch_resume(pollTimer);
+}
@@ -0,0 +1,231 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "json_cursor.h"
+#include "mod_update.h"
+
+typedef struct {
+    char *data;
+    size_t length, capacity;
+} mod_update_buffer_t;
+
+static void mod_update_append(mod_update_buffer_t *buffer, const char *text) {
+    size_t length = strlen(text);
+    if (buffer->length + length + 1 > buffer->capacity) {
+        buffer->capacity = (buffer->length + length + 1) * 2;
+        buffer->data = realloc(buffer->data, buffer->capacity);
+    }
+    memcpy(buffer->data + buffer->length, text, length + 1);
+    buffer->length += length;
+}
+
+// Hashes are hex and loaders and game versions plain ASCII, but quotes and
+// backslashes would still break the body
+static void mod_update_append_string(mod_update_buffer_t *buffer, const char *text) {
+    mod_update_append(buffer, "\"");
+    for (const char *p = text; *p; p++) {
+        char escaped[8];
+        if (*p == '"' || *p == '\\') {
+            snprintf(escaped, sizeof(escaped), "\\%c", *p);
+        } else if ((unsigned char)*p < 0x20) {
+            snprintf(escaped, sizeof(escaped), "\\u%04x", *p);
+        } else {
+            snprintf(escaped, sizeof(escaped), "%c", *p);
+        }
+        mod_update_append(buffer, escaped);
+    }
+    mod_update_append(buffer, "\"");
+}
+
+static bool mod_update_same_loader(const char *a, const char *b) {
+    return a == b || (a && b && !strcmp(a, b));
+}
+
+static char *mod_update_copy(json_string_t string) {
+    char *copy = malloc(string.length + 1);
+    json_string_copy(string, copy, string.length + 1);
+    return copy;
+}
+
+// Reads one version object of a response into mod, or only whether it lists
+// the file's own hash if files is false
+static bool mod_update_read_version(json_cursor_t *cursor, mod_update_entry_t *mod, bool files) {
+    json_string_t key, value, latestVersion = {0}, url = {0}, fileName = {0};
+    bool isCurrent = false, hasPrimary = false;
+    if (!json_enter_object(cursor)) return false;
+    while (json_next_key(cursor, &key)) {
+        if (json_string_equals(key, "version_number") && json_peek(cursor) == JSON_STRING) {
+            json_read_string(cursor, &latestVersion);
+        } else if (files && json_string_equals(key, "files") && json_enter_array(cursor)) {
+            while (json_next_element(cursor)) {
+                json_string_t fileURL = {0}, name = {0};
+                bool primary = false, matches = false;
+                if (!json_enter_object(cursor)) return false;
+                while (json_next_key(cursor, &key)) {
+                    if (json_string_equals(key, "url") && json_peek(cursor) == JSON_STRING) {
+                        json_read_string(cursor, &fileURL);
+                    } else if (json_string_equals(key, "filename") && json_peek(cursor) == JSON_STRING) {
+                        json_read_string(cursor, &name);
+                    } else if (json_string_equals(key, "primary") &&
+                               (json_peek(cursor) == JSON_TRUE || json_peek(cursor) == JSON_FALSE)) {
+                        json_read_bool(cursor, &primary);
+                    } else if (json_string_equals(key, "hashes") && json_peek(cursor) == JSON_OBJECT) {
+                        if (!json_enter_object(cursor)) return false;
+                        while (json_next_key(cursor, &key)) {
+                            if (json_string_equals(key, "sha1") && json_peek(cursor) == JSON_STRING) {
+                                json_read_string(cursor, &value);
+                                matches = json_string_equals(value, mod->sha1);
+                            } else if (!json_skip_value(cursor)) {
+                                return false;
+                            }
+                        }
+                    } else if (!json_skip_value(cursor)) {
+                        return false;
+                    }
+                }
+                isCurrent |= matches;
+                // The primary file, or else the first one
+                if (!url.start || (primary && !hasPrimary)) {
+                    url = fileURL;
+                    fileName = name;
+                    hasPrimary = primary;
+                }
+            }
+        } else if (!json_skip_value(cursor)) {
+            return false;
+        }
+    }
+
+    free(mod->latestVersion);
+    mod->latestVersion = latestVersion.start ? mod_update_copy(latestVersion) : NULL;
+    if (!files) {
+        mod->status = MOD_UPDATE_UP_TO_DATE;
+        return true;
+    }
+    mod->status = isCurrent ? MOD_UPDATE_UP_TO_DATE : MOD_UPDATE_OUTDATED;
+    free(mod->downloadURL);
+    free(mod->fileName);
+    mod->downloadURL = url.start ? mod_update_copy(url) : NULL;
+    mod->fileName = fileName.start ? mod_update_copy(fileName) : NULL;
+    return true;
+}
+
+// Applies a response keyed by hash to every mod with that hash
+static bool mod_update_read_response(const char *response, size_t length, mod_update_entry_t *mods, size_t count, bool *found, bool files) {
+    json_cursor_t cursor;
+    json_cursor_init(&cursor, response, length);
+    json_string_t key;
+    if (!json_enter_object(&cursor)) return false;
+    while (json_next_key(&cursor, &key)) {
+        size_t first = count;
+        for (size_t i = 0; i < count; i++) {
+            if (mods[i].sha1 && json_string_equals(key, mods[i].sha1)) {
+                first = i;
+                break;
+            }
+        }
+        if (first == count || json_peek(&cursor) != JSON_OBJECT) {
+            if (!json_skip_value(&cursor)) return false;
+            continue;
+        }
+        json_cursor_t version = cursor;
+        if (!mod_update_read_version(&cursor, &mods[first], files)) return false;
+        found[first] = true;
+        // The same jar copied under another name
+        for (size_t i = first + 1; i < count; i++) {
+            if (mods[i].sha1 && !strcmp(mods[i].sha1, mods[first].sha1)) {
+                json_cursor_t again = version;
+                mod_update_read_version(&again, &mods[i], files);
+                found[i] = true;
+            }
+        }
+    }
+    return true;
+}
+
+static bool mod_update_request(const char *endpoint, mod_update_buffer_t *body, mod_update_post_t post, void *context,
+    mod_update_entry_t *mods, size_t count, bool *found, bool files) {
+    size_t length;
+    char *response = post(context, endpoint, body->data, &length);
+    free(body->data);
+    *body = (mod_update_buffer_t){0};
+    if (!response) return false;
+    bool read = mod_update_read_response(response, length, mods, count, found, files);
+    free(response);
+    return read;
+}
+
+bool mod_update_check(mod_update_entry_t *mods, size_t count, const char *gameVersion, mod_update_post_t post, void *context) {
+    // Work on copies so a failed check leaves the entries alone
+    mod_update_entry_t *results = calloc(count ? count : 1, sizeof(mod_update_entry_t));
+    bool *found = calloc(count ? count : 1, sizeof(bool));
+    bool *sent = calloc(count ? count : 1, sizeof(bool));
+    for (size_t i = 0; i < count; i++) {
+        results[i].sha1 = mods[i].sha1;
+        results[i].loader = mods[i].loader;
+    }
+
+    bool ok = true;
+    mod_update_buffer_t body = {0};
+    for (size_t i = 0; i < count && ok; i++) {
+        if (sent[i] || !mods[i].sha1) continue;
+        // Every hashed mod of this loader in one request
+        const char *loader = mods[i].loader;
+        mod_update_append(&body, "{\"algorithm\":\"sha1\",\"hashes\":[");
+        for (size_t j = i; j < count; j++) {
+            if (sent[j] || !mods[j].sha1 || !mod_update_same_loader(mods[j].loader, loader)) continue;
+            if (j > i) mod_update_append(&body, ",");
+            mod_update_append_string(&body, mods[j].sha1);
+            sent[j] = true;
+        }
+        mod_update_append(&body, "]");
+        if (loader) {
+            mod_update_append(&body, ",\"loaders\":[");
+            mod_update_append_string(&body, loader);
+            mod_update_append(&body, "]");
+        }
+        if (gameVersion) {
+            mod_update_append(&body, ",\"game_versions\":[");
+            mod_update_append_string(&body, gameVersion);
+            mod_update_append(&body, "]");
+        }
+        mod_update_append(&body, "}");
+        ok = mod_update_request("version_files/update", &body, post, context, results, count, found, true);
+    }
+
+    // The rest, only to tell known files from unknown ones
+    bool missing = false;
+    for (size_t i = 0; i < count && ok; i++) {
+        if (!mods[i].sha1 || found[i]) continue;
+        mod_update_append(&body, missing ? "," : "{\"algorithm\":\"sha1\",\"hashes\":[");
+        mod_update_append_string(&body, mods[i].sha1);
+        missing = true;
+    }
+    if (ok && missing) {
+        mod_update_append(&body, "]}");
+        ok = mod_update_request("version_files", &body, post, context, results, count, found, false);
+    }
+    free(body.data);
+
+    for (size_t i = 0; i < count; i++) {
+        if (ok) {
+            mod_update_entry_free(&mods[i]);
+            mods[i] = results[i];
+        } else {
+            mod_update_entry_free(&results[i]);
+        }
+    }
+    free(results);
+    free(found);
+    free(sent);
+    return ok;
+}
+
+void mod_update_entry_free(mod_update_entry_t *mod) {
+    free(mod->latestVersion);
+    free(mod->downloadURL);
+    free(mod->fileName);
+    mod->latestVersion = mod->downloadURL = mod->fileName = NULL;
+    mod->status = MOD_UPDATE_UNKNOWN;
+}
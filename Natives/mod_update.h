@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Update check of a mods folder against Modrinth: one version_files/update
+// request per loader, so a Forge jar is never offered a Fabric build, then a
+// single version_files lookup of the files left without a compatible update,
+// which tells files Modrinth knows apart from ones it has never seen.
+
+typedef enum {
+    MOD_UPDATE_UNKNOWN,
+    MOD_UPDATE_UP_TO_DATE,
+    MOD_UPDATE_OUTDATED
+} mod_update_status_t;
+
+typedef struct {
+    // NULL if the jar couldn't be hashed
+    const char *sha1;
+    // Modrinth's loader name, NULL if the jar carries no loader metadata
+    const char *loader;
+
+    // Set by mod_update_check, the strings are released by mod_update_entry_free
+    mod_update_status_t status;
+    char *latestVersion;
+    char *downloadURL, *fileName;
+} mod_update_entry_t;
+
+// POSTs the JSON body to endpoint, relative to the API base URL. Returns the
+// response body (free() it), or NULL if the request failed.
+typedef char *(*mod_update_post_t)(void *context, const char *endpoint, const char *body, size_t *length);
+
+// gameVersion may be NULL. False if a request failed, the entries are then
+// left as they were.
+bool mod_update_check(mod_update_entry_t *mods, size_t count, const char *gameVersion, mod_update_post_t post, void *context);
+void mod_update_entry_free(mod_update_entry_t *mod);
@@ -0,0 +1,210 @@
+#include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "file_stamp.h"
+#include "patched_index.h"
+
+#define PATCHED_INDEX_MAX_SKIPS 4
+
+typedef struct {
+    char *path;         // NULL for an empty slot
+    uint64_t hash;
+    uint64_t inode, size;
+    int64_t mtime;
+} patched_entry_t;
+
+struct patched_index {
+    pthread_mutex_t lock;
+    patched_entry_t *slots;
+    size_t capacity;    // power of two
+    size_t count;
+    FILE *file;         // appended to, NULL when in memory only
+    char *skips[PATCHED_INDEX_MAX_SKIPS];
+    int skipCount;
+};
+
+static uint64_t patched_hash(const char *path) {
+    // FNV-1a
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++) {
+        hash = (hash ^ *p) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static patched_entry_t *patched_find_slot(patched_index_t *index, const char *path, uint64_t hash) {
+    size_t mask = index->capacity - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        patched_entry_t *slot = &index->slots[i];
+        if (!slot->path || (slot->hash == hash && !strcmp(slot->path, path))) {
+            return slot;
+        }
+    }
+}
+
+static void patched_grow(patched_index_t *index) {
+    patched_entry_t *old = index->slots;
+    size_t oldCapacity = index->capacity;
+    index->capacity = oldCapacity ? oldCapacity * 2 : 64;
+    index->slots = calloc(index->capacity, sizeof(patched_entry_t));
+    for (size_t i = 0; i < oldCapacity; i++) {
+        if (old[i].path) {
+            *patched_find_slot(index, old[i].path, old[i].hash) = old[i];
+        }
+    }
+    free(old);
+}
+
+static bool patched_stamp_matches(const patched_entry_t *entry, const struct stat *st) {
+    return entry->inode == (uint64_t)st->st_ino && entry->size == (uint64_t)st->st_size &&
+        entry->mtime == file_stamp_mtime_ns(st);
+}
+
+// Returns true if the path was new or its stamp changed
+static bool patched_put(patched_index_t *index, const char *path, uint64_t inode, uint64_t size, int64_t mtime) {
+    // Keep the load factor under 3/4
+    if ((index->count + 1) * 4 > index->capacity * 3) {
+        patched_grow(index);
+    }
+    uint64_t hash = patched_hash(path);
+    patched_entry_t *slot = patched_find_slot(index, path, hash);
+    if (slot->path && slot->inode == inode && slot->size == size && slot->mtime == mtime) {
+        return false;
+    }
+    if (!slot->path) {
+        slot->path = strdup(path);
+        slot->hash = hash;
+        index->count++;
+    }
+    slot->inode = inode;
+    slot->size = size;
+    slot->mtime = mtime;
+    return true;
+}
+
+static void patched_write_entry(FILE *file, const patched_entry_t *entry) {
+    fprintf(file, "%llu %llu %lld %s\n", (unsigned long long)entry->inode,
+        (unsigned long long)entry->size, (long long)entry->mtime, entry->path);
+}
+
+// Reads the file, keeping entries that still describe their file. Returns
+// true if anything was dropped and the file needs compacting.
+static bool patched_load(patched_index_t *index, FILE *file) {
+    bool stale = false;
+    char *line = NULL;
+    size_t lineCapacity = 0;
+    ssize_t length;
+    while ((length = getline(&line, &lineCapacity, file)) > 0) {
+        if (line[length - 1] == '\n') line[length - 1] = '\0';
+        unsigned long long inode, size;
+        long long mtime;
+        int pathOffset = 0;
+        struct stat st;
+        if (sscanf(line, "%llu %llu %lld %n", &inode, &size, &mtime, &pathOffset) != 3 || !pathOffset ||
+            stat(line + pathOffset, &st) != 0 || st.st_ino != inode || (uint64_t)st.st_size != size ||
+            file_stamp_mtime_ns(&st) != mtime) {
+            stale = true;
+            continue;
+        }
+        // A later line for the same path replaces the earlier one
+        if (!patched_put(index, line + pathOffset, inode, size, mtime)) {
+            stale = true;
+        }
+    }
+    free(line);
+    return stale;
+}
+
+static FILE *patched_compact(patched_index_t *index, const char *file) {
+    char tmpPath[PATH_MAX];
+    if (snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", file) >= (int)sizeof(tmpPath)) return NULL;
+    FILE *out = fopen(tmpPath, "w");
+    if (!out) return NULL;
+    for (size_t i = 0; i < index->capacity; i++) {
+        if (index->slots[i].path) {
+            patched_write_entry(out, &index->slots[i]);
+        }
+    }
+    if (fclose(out) != 0 || rename(tmpPath, file) != 0) {
+        unlink(tmpPath);
+        return NULL;
+    }
+    return fopen(file, "a");
+}
+
+patched_index_t *patched_index_open(const char *file) {
+    patched_index_t *index = calloc(1, sizeof(patched_index_t));
+    pthread_mutex_init(&index->lock, NULL);
+    patched_grow(index);
+
+    FILE *in = fopen(file, "r");
+    bool stale = in && patched_load(index, in);
+    if (in) fclose(in);
+    index->file = stale ? patched_compact(index, file) : NULL;
+    if (!index->file) {
+        index->file = fopen(file, "a");
+    }
+    return index;
+}
+
+void patched_index_close(patched_index_t *index) {
+    if (!index) return;
+    if (index->file) fclose(index->file);
+    for (size_t i = 0; i < index->capacity; i++) {
+        free(index->slots[i].path);
+    }
+    for (int i = 0; i < index->skipCount; i++) {
+        free(index->skips[i]);
+    }
+    free(index->slots);
+    pthread_mutex_destroy(&index->lock);
+    free(index);
+}
+
+void patched_index_skip_prefix(patched_index_t *index, const char *prefix) {
+    if (!prefix || !*prefix) return;
+    pthread_mutex_lock(&index->lock);
+    if (index->skipCount < PATCHED_INDEX_MAX_SKIPS) {
+        index->skips[index->skipCount++] = strdup(prefix);
+    }
+    pthread_mutex_unlock(&index->lock);
+}
+
+bool patched_index_contains(patched_index_t *index, const char *path, const struct stat *st) {
+    uint64_t hash = patched_hash(path);
+    pthread_mutex_lock(&index->lock);
+    patched_entry_t *slot = patched_find_slot(index, path, hash);
+    bool found = slot->path && patched_stamp_matches(slot, st);
+    pthread_mutex_unlock(&index->lock);
+    return found;
+}
+
+void patched_index_add(patched_index_t *index, const char *path, const struct stat *st) {
+    // The line format can't hold these, and they would not be found again
+    if (strchr(path, '\n') || path[0] != '/') return;
+    pthread_mutex_lock(&index->lock);
+    for (int i = 0; i < index->skipCount; i++) {
+        if (!strncmp(path, index->skips[i], strlen(index->skips[i]))) {
+            pthread_mutex_unlock(&index->lock);
+            return;
+        }
+    }
+    if (patched_put(index, path, st->st_ino, st->st_size, file_stamp_mtime_ns(st)) && index->file) {
+        patched_entry_t *slot = patched_find_slot(index, path, patched_hash(path));
+        patched_write_entry(index->file, slot);
+        fflush(index->file);
+    }
+    pthread_mutex_unlock(&index->lock);
+}
+
+size_t patched_index_count(patched_index_t *index) {
+    pthread_mutex_lock(&index->lock);
+    size_t count = index->count;
+    pthread_mutex_unlock(&index->lock);
+    return count;
+}
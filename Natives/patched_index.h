@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/stat.h>
+
+// Libraries hooked_dlopen has already checked for a foreign platform, so the
+// next dlopen of the same file skips opening it. Entries are keyed by path
+// and stamped with inode, size and modification time; a replaced or updated
+// file no longer matches and is checked again. One entry per path in a hash
+// table, persisted as one line per entry:
+//   <inode> <size> <mtime ns> <path>
+// On open, entries whose file is gone or changed are dropped and the file is
+// rewritten without them, so it only grows with the libraries that exist.
+
+typedef struct patched_index patched_index_t;
+
+// Never returns NULL; without a readable or writable file the index only
+// lives in memory
+patched_index_t *patched_index_open(const char *file);
+void patched_index_close(patched_index_t *index);
+
+// Paths under prefix are never recorded, e.g. temp directories where
+// natives are extracted anew on every launch
+void patched_index_skip_prefix(patched_index_t *index, const char *prefix);
+
+// st is the current stat of path
+bool patched_index_contains(patched_index_t *index, const char *path, const struct stat *st);
+void patched_index_add(patched_index_t *index, const char *path, const struct stat *st);
+size_t patched_index_count(patched_index_t *index);
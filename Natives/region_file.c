@@ -0,0 +1,57 @@
+#include <stdlib.h>
+
+#include "region_file.h"
+
+static int region_segment_compare(const void *a, const void *b) {
+    uint64_t x = ((const region_segment_t *)a)->offset;
+    uint64_t y = ((const region_segment_t *)b)->offset;
+    return x < y ? -1 : x > y;
+}
+
+size_t region_split_segments(const uint8_t *header, uint64_t fileSize, region_segment_t *segments) {
+    if (fileSize <= REGION_HEADER_SIZE) {
+        segments[0] = (region_segment_t){0, fileSize};
+        return fileSize > 0;
+    }
+
+    // Collect chunk extents after the header slot so they can be sorted in place
+    region_segment_t *chunks = segments + 1;
+    size_t chunkCount = 0;
+    for (int i = 0; i < 1024; i++) {
+        const uint8_t *entry = header + i * 4;
+        uint64_t offset = ((uint64_t)entry[0] << 16 | entry[1] << 8 | entry[2]) * REGION_SECTOR_SIZE;
+        uint64_t length = (uint64_t)entry[3] * REGION_SECTOR_SIZE;
+        if (length == 0 || offset < REGION_HEADER_SIZE || offset >= fileSize) {
+            continue;
+        }
+        if (offset + length > fileSize) {
+            length = fileSize - offset;
+        }
+        chunks[chunkCount++] = (region_segment_t){offset, length};
+    }
+    qsort(chunks, chunkCount, sizeof(region_segment_t), region_segment_compare);
+
+    // The output interleaves gaps into the same buffer, so work from a copy
+    region_segment_t *sorted = malloc(chunkCount * sizeof(region_segment_t));
+    for (size_t i = 0; i < chunkCount; i++) sorted[i] = chunks[i];
+
+    size_t count = 0;
+    uint64_t cursor = REGION_HEADER_SIZE;
+    segments[count++] = (region_segment_t){0, REGION_HEADER_SIZE};
+    for (size_t i = 0; i < chunkCount; i++) {
+        uint64_t start = sorted[i].offset, end = start + sorted[i].length;
+        // A corrupt table can claim overlapping sectors, keep what isn't covered yet
+        if (end <= cursor) continue;
+        if (start < cursor) start = cursor;
+        if (start > cursor) {
+            segments[count++] = (region_segment_t){cursor, start - cursor};
+        }
+        segments[count++] = (region_segment_t){start, end - start};
+        cursor = end;
+    }
+    if (cursor < fileSize) {
+        segments[count++] = (region_segment_t){cursor, fileSize - cursor};
+    }
+    free(sorted);
+    return count;
+}
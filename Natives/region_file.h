@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Anvil region files (.mca) start with an 8 KiB header: 1024 chunk locations
+// then 1024 timestamps. Each chunk occupies a run of 4 KiB sectors.
+#define REGION_HEADER_SIZE 8192
+#define REGION_SECTOR_SIZE 4096
+#define REGION_MAX_SEGMENTS (1 + 1024 * 2 + 1)
+
+typedef struct {
+    uint64_t offset;
+    uint64_t length;
+} region_segment_t;
+
+// Splits a region file into its header, each chunk's sector run and the gaps
+// between them, in file order and covering the whole file. A chunk that was
+// not rewritten keeps the same bytes, so it hashes the same across backups.
+// segments must hold REGION_MAX_SEGMENTS entries, returns the count.
+size_t region_split_segments(const uint8_t *header, uint64_t fileSize, region_segment_t *segments);
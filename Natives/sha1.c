@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __APPLE__
+#include <CommonCrypto/CommonDigest.h>
+#endif
+
+#include "sha1.h"
+
+#ifdef __APPLE__
+
+void sha1_digest(const void *data, size_t length, uint8_t digest[SHA1_DIGEST_LENGTH]) {
+    CC_SHA1(data, (CC_LONG)length, digest);
+}
+
+#else
+
+static inline uint32_t sha1_rotate(uint32_t x, int n) {
+    return x << n | x >> (32 - n);
+}
+
+static void sha1_block(uint32_t state[5], const uint8_t *block) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[i * 4] << 24 | block[i * 4 + 1] << 16 | block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = sha1_rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = sha1_rotate(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = sha1_rotate(b, 30);
+        b = a;
+        a = t;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+void sha1_digest(const void *data, size_t length, uint8_t digest[SHA1_DIGEST_LENGTH]) {
+    uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    const uint8_t *bytes = data;
+    size_t remaining = length;
+    for (; remaining >= 64; remaining -= 64, bytes += 64) {
+        sha1_block(state, bytes);
+    }
+
+    // The tail, a 1 bit, zeros and the length in bits fill one or two blocks
+    uint8_t tail[128] = {0};
+    memcpy(tail, bytes, remaining);
+    tail[remaining] = 0x80;
+    size_t tailLength = remaining < 56 ? 64 : 128;
+    uint64_t bits = (uint64_t)length * 8;
+    for (int i = 0; i < 8; i++) {
+        tail[tailLength - 1 - i] = (uint8_t)(bits >> (i * 8));
+    }
+    sha1_block(state, tail);
+    if (tailLength == 128) sha1_block(state, tail + 64);
+
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4] = state[i] >> 24;
+        digest[i * 4 + 1] = state[i] >> 16;
+        digest[i * 4 + 2] = state[i] >> 8;
+        digest[i * 4 + 3] = state[i];
+    }
+}
+
+#endif
+
+void sha1_hex(const void *data, size_t length, char *hex) {
+    uint8_t digest[SHA1_DIGEST_LENGTH];
+    sha1_digest(data, length, digest);
+    for (int i = 0; i < SHA1_DIGEST_LENGTH; i++) {
+        snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA1_DIGEST_LENGTH 20
+#define SHA1_HEX_LENGTH (SHA1_DIGEST_LENGTH * 2)
+
+void sha1_digest(const void *data, size_t length, uint8_t digest[SHA1_DIGEST_LENGTH]);
+// Lowercase, the way Mojang and Modrinth list hashes; hex holds
+// SHA1_HEX_LENGTH + 1 bytes
+void sha1_hex(const void *data, size_t length, char *hex);
@@ -0,0 +1,166 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stall_watchdog.h"
+
+static atomic_uint_fast64_t lastBeatNs, beatCount;
+static atomic_bool paused, gameThreadKnown;
+static pthread_t gameThread, watchdogThread;
+static pthread_mutex_t stateLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stopCondition = PTHREAD_COND_INITIALIZER;
+static bool started, stopping;
+static stall_watchdog_config_t config;
+static char reportDir[PATH_MAX];
+
+static uint64_t stall_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+void stall_watchdog_beat(void) {
+    if (!atomic_load_explicit(&gameThreadKnown, memory_order_acquire)) {
+        gameThread = pthread_self();
+        atomic_store_explicit(&gameThreadKnown, true, memory_order_release);
+    }
+    atomic_store_explicit(&lastBeatNs, stall_now_ns(), memory_order_relaxed);
+    atomic_fetch_add_explicit(&beatCount, 1, memory_order_relaxed);
+}
+
+void stall_watchdog_set_paused(bool value) {
+    if (!value) {
+        // Time spent paused doesn't count towards the next stall
+        atomic_store_explicit(&lastBeatNs, stall_now_ns(), memory_order_relaxed);
+    }
+    atomic_store(&paused, value);
+}
+
+static bool stall_write_report(uint64_t stalledMs, uint64_t beats, char *path, size_t pathSize) {
+    mkdir(reportDir, 0755);
+    time_t now = time(NULL);
+    char date[32];
+    strftime(date, sizeof(date), "%Y-%m-%d_%H.%M.%S", localtime(&now));
+    int pathLength = snprintf(path, pathSize, "%s/stall-%s.txt", reportDir, date);
+    if (pathLength < 0 || (size_t)pathLength >= pathSize) {
+        fprintf(stderr, "[StallWatchdog] Report path in %s is too long\n", reportDir);
+        return false;
+    }
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "[StallWatchdog] Could not write %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    dprintf(fd, "Game thread stalled at %s: no frame for %llu ms (threshold %d ms)\n",
+        date, (unsigned long long)stalledMs, config.thresholdMs);
+    dprintf(fd, "Frames before the stall: %llu\n\n", (unsigned long long)beats);
+    // Pairs with the store of the first beat
+    if (config.capture && atomic_load_explicit(&gameThreadKnown, memory_order_acquire)) {
+        config.capture(config.context, fd, gameThread);
+    }
+    close(fd);
+    return true;
+}
+
+// Sleeps for the interval, returns false once the watchdog is being stopped
+static bool stall_wait(uint64_t intervalNs) {
+    // Condition variables time out on the realtime clock, stalls are measured on the monotonic one
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    uint64_t ns = deadline.tv_nsec + intervalNs;
+    deadline.tv_sec += ns / 1000000000;
+    deadline.tv_nsec = ns % 1000000000;
+    pthread_mutex_lock(&stateLock);
+    while (!stopping && pthread_cond_timedwait(&stopCondition, &stateLock, &deadline) != ETIMEDOUT);
+    bool running = !stopping;
+    pthread_mutex_unlock(&stateLock);
+    return running;
+}
+
+static void *stall_watchdog_main(void *arg) {
+    (void)arg;
+#ifdef __APPLE__
+    pthread_setname_np("Stall watchdog");
+#endif
+    uint64_t thresholdNs = config.thresholdMs * 1000000ull;
+    // Checking four times per threshold reports a stall at most 25% late
+    uint64_t intervalNs = thresholdNs / 4;
+    uint64_t stalledAtBeat = 0, stallStartNs = 0;
+    bool stalled = false;
+    char reportPath[PATH_MAX] = "";
+    while (stall_wait(intervalNs)) {
+        uint64_t beats = atomic_load_explicit(&beatCount, memory_order_relaxed);
+        // Nothing rendered yet, or rendering is suspended on purpose
+        if (beats == 0 || atomic_load(&paused)) continue;
+
+        uint64_t now = stall_now_ns();
+        uint64_t lastBeat = atomic_load_explicit(&lastBeatNs, memory_order_relaxed);
+        if (stalled) {
+            if (beats == stalledAtBeat) continue;
+            stalled = false;
+            uint64_t stalledMs = (lastBeat - stallStartNs) / 1000000;
+            fprintf(stderr, "[StallWatchdog] Game thread recovered after about %llu ms\n", (unsigned long long)stalledMs);
+            FILE *report = reportPath[0] ? fopen(reportPath, "a") : NULL;
+            if (report) {
+                fprintf(report, "\nRecovered after about %llu ms\n", (unsigned long long)stalledMs);
+                fclose(report);
+            }
+        } else if (now > lastBeat && now - lastBeat >= thresholdNs) {
+            stalled = true;
+            stalledAtBeat = beats;
+            stallStartNs = lastBeat;
+            uint64_t stalledMs = (now - lastBeat) / 1000000;
+            fprintf(stderr, "[StallWatchdog] No frame for %llu ms, writing a stall report\n", (unsigned long long)stalledMs);
+            if (stall_write_report(stalledMs, beats, reportPath, sizeof(reportPath))) {
+                fprintf(stderr, "[StallWatchdog] Stall report written to %s\n", reportPath);
+            } else {
+                reportPath[0] = '\0';
+            }
+        }
+    }
+    return NULL;
+}
+
+bool stall_watchdog_start(const stall_watchdog_config_t *newConfig) {
+    if (newConfig->thresholdMs <= 0 || strlen(newConfig->reportDir) >= sizeof(reportDir)) return false;
+    pthread_mutex_lock(&stateLock);
+    bool ok = !started;
+    if (ok) {
+        config = *newConfig;
+        snprintf(reportDir, sizeof(reportDir), "%s", newConfig->reportDir);
+        config.reportDir = reportDir;
+        // Beats from an earlier run don't count, nor does the time before the first frame
+        atomic_store(&beatCount, 0);
+        atomic_store(&paused, false);
+        stopping = false;
+        ok = started = pthread_create(&watchdogThread, NULL, stall_watchdog_main, NULL) == 0;
+    }
+    pthread_mutex_unlock(&stateLock);
+    return ok;
+}
+
+void stall_watchdog_stop(void) {
+    pthread_mutex_lock(&stateLock);
+    bool wasStarted = started && !stopping;
+    stopping = true;
+    pthread_cond_signal(&stopCondition);
+    pthread_mutex_unlock(&stateLock);
+    if (!wasStarted) return;
+
+    // exit() may be called from inside a capture, e.g. a crash while writing the report
+    if (!pthread_equal(pthread_self(), watchdogThread)) {
+        pthread_join(watchdogThread, NULL);
+    } else {
+        pthread_detach(watchdogThread);
+    }
+    pthread_mutex_lock(&stateLock);
+    started = false;
+    pthread_mutex_unlock(&stateLock);
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+
+// Detects a stuck game thread. The game thread beats once per frame; a
+// watchdog thread writes a report when no beat came for longer than the
+// threshold, and notes in it when frames resume. What goes into the report
+// besides timing (native stacks, a Java thread dump) is up to the platform.
+
+typedef struct {
+    int thresholdMs;
+    const char *reportDir;
+    void *context;
+    // Appends details to the report being written to fd
+    void (*capture)(void *context, int fd, pthread_t gameThread);
+} stall_watchdog_config_t;
+
+// Called by the game thread every frame, cheap enough for any frame rate
+void stall_watchdog_beat(void);
+// While paused, e.g. in the background, missing frames are not a stall
+void stall_watchdog_set_paused(bool paused);
+bool stall_watchdog_start(const stall_watchdog_config_t *config);
+// Disarms the watchdog once the game is shutting down, waits for a report
+// being written to finish. The watchdog can be started again afterwards.
+void stall_watchdog_stop(void);
+
+// iOS side: reports go to reportDir with native stacks of all threads and a
+// Java thread dump in the log
+void stall_watchdog_start_monitor(const char *reportDir, int thresholdMs);
@@ -0,0 +1,137 @@
+#include <dlfcn.h>
+#include <libgen.h>
+#include <mach/mach.h>
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+#if __has_feature(ptrauth_calls)
+#include <ptrauth.h>
+#endif
+
+#import <UIKit/UIKit.h>
+#include "stall_watchdog.h"
+
+#define STALL_MAX_FRAMES 64
+
+static uintptr_t stall_strip_pointer(uintptr_t address) {
+#if __has_feature(ptrauth_calls)
+    return (uintptr_t)ptrauth_strip((void *)address, ptrauth_key_return_address);
+#else
+    return address;
+#endif
+}
+
+// Walks the frame pointer chain of a suspended thread. Nothing here may take a
+// lock the thread could be holding, so memory is read through the kernel and
+// symbols are resolved only after the thread runs again.
+static int stall_sample_thread(thread_act_t thread, uintptr_t *frames) {
+    int count = 0;
+#if defined(__arm64__)
+    arm_thread_state64_t state;
+    mach_msg_type_number_t stateCount = ARM_THREAD_STATE64_COUNT;
+    if (thread_get_state(thread, ARM_THREAD_STATE64, (thread_state_t)&state, &stateCount) != KERN_SUCCESS) {
+        return 0;
+    }
+    frames[count++] = stall_strip_pointer(arm_thread_state64_get_pc(state));
+    frames[count++] = stall_strip_pointer(arm_thread_state64_get_lr(state));
+    uintptr_t fp = arm_thread_state64_get_fp(state);
+    while (fp && count < STALL_MAX_FRAMES) {
+        uintptr_t record[2]; // saved fp, return address
+        vm_size_t size;
+        if (vm_read_overwrite(mach_task_self(), fp, sizeof(record), (vm_address_t)record, &size) != KERN_SUCCESS) {
+            break;
+        }
+        if (!record[1]) break;
+        frames[count++] = stall_strip_pointer(record[1]);
+        // Stacks grow down, a frame further up must be at a higher address
+        if (record[0] <= fp) break;
+        fp = record[0];
+    }
+#endif
+    return count;
+}
+
+static void stall_write_thread(int fd, thread_act_t thread, bool isGameThread) {
+    char name[64] = "";
+    pthread_t pthread = pthread_from_mach_thread_np(thread);
+    if (pthread) {
+        pthread_getname_np(pthread, name, sizeof(name));
+    }
+
+    uintptr_t frames[STALL_MAX_FRAMES];
+    int count = 0;
+    if (thread_suspend(thread) == KERN_SUCCESS) {
+        count = stall_sample_thread(thread, frames);
+        thread_resume(thread);
+    }
+
+    dprintf(fd, "Thread %u \"%s\"%s\n", thread, name, isGameThread ? " (game thread)" : "");
+    for (int i = 0; i < count; i++) {
+        Dl_info info = {0};
+        dladdr((void *)frames[i], &info);
+        if (info.dli_sname) {
+            dprintf(fd, "  %2d 0x%016lx %s + %lu (%s)\n", i, frames[i], info.dli_sname,
+                frames[i] - (uintptr_t)info.dli_saddr, info.dli_fname ? basename((char *)info.dli_fname) : "?");
+        } else if (info.dli_fname) {
+            dprintf(fd, "  %2d 0x%016lx %s + %lu\n", i, frames[i], basename((char *)info.dli_fname),
+                frames[i] - (uintptr_t)info.dli_fbase);
+        } else {
+            // Most likely JIT-compiled Java code, see the Java thread dump
+            dprintf(fd, "  %2d 0x%016lx ?\n", i, frames[i]);
+        }
+    }
+    dprintf(fd, "\n");
+}
+
+static void stall_capture(void *context, int fd, pthread_t gameThread) {
+    thread_act_t game = pthread_mach_thread_np(gameThread);
+    thread_act_t self = mach_thread_self();
+    thread_act_array_t threads;
+    mach_msg_type_number_t count;
+
+    dprintf(fd, "Native stacks:\n\n");
+    stall_write_thread(fd, game, true);
+    if (task_threads(mach_task_self(), &threads, &count) == KERN_SUCCESS) {
+        for (mach_msg_type_number_t i = 0; i < count; i++) {
+            if (threads[i] != self && threads[i] != game) {
+                stall_write_thread(fd, threads[i], false);
+            }
+            mach_port_deallocate(mach_task_self(), threads[i]);
+        }
+        vm_deallocate(mach_task_self(), (vm_address_t)threads, count * sizeof(thread_act_t));
+    }
+    mach_port_deallocate(mach_task_self(), self);
+
+    // HotSpot prints all Java stacks to stdout, which ends up in latestlog.txt.
+    // The dump is a VM operation and waits for a safepoint like any other, so
+    // if the stalled thread never reaches one it doesn't appear and the native
+    // stacks above are all there is.
+    dprintf(fd, "Java thread dump requested, see latestlog.txt around this time. "
+        "It is missing if the VM can't reach a safepoint, the native stacks above still apply.\n");
+    kill(getpid(), SIGQUIT);
+}
+
+void stall_watchdog_start_monitor(const char *reportDir, int thresholdMs) {
+    stall_watchdog_config_t config = {
+        .thresholdMs = thresholdMs,
+        .reportDir = reportDir,
+        .capture = stall_capture
+    };
+    if (!stall_watchdog_start(&config)) {
+        return;
+    }
+    NSLog(@"[StallWatchdog] Watching for game thread stalls over %d ms", thresholdMs);
+
+    // The game stops rendering in the background, that's not a stall
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        [NSNotificationCenter.defaultCenter addObserverForName:UIApplicationDidEnterBackgroundNotification
+            object:nil queue:nil usingBlock:^(NSNotification *note) {
+            stall_watchdog_set_paused(true);
+        }];
+        [NSNotificationCenter.defaultCenter addObserverForName:UIApplicationWillEnterForegroundNotification
+            object:nil queue:nil usingBlock:^(NSNotification *note) {
+            stall_watchdog_set_paused(false);
+        }];
+    });
+}
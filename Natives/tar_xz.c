@@ -0,0 +1,367 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <lzma.h>
+
+#include "tar_xz.h"
+
+// Large enough that decoding and writing aren't dominated by per-call overhead
+#define TAR_XZ_CHUNK (256 * 1024)
+#define TAR_BLOCK 512
+
+// https://www.gnu.org/software/tar/manual/html_node/Standard.html
+typedef struct {
+    char name[100];
+    char mode[8];
+    char uid[8];
+    char gid[8];
+    char size[12];
+    char mtime[12];
+    char checksum[8];
+    char typeflag;
+    char linkname[100];
+    char magic[6];
+    char version[2];
+    char uname[32];
+    char gname[32];
+    char devmajor[8];
+    char devminor[8];
+    char prefix[155];
+    char pad[12];
+} tar_header_t;
+
+typedef struct {
+    int rootFd;
+    const tar_xz_callbacks_t *callbacks;
+    char *error;
+    size_t errorSize;
+
+    union {
+        tar_header_t header;
+        uint8_t block[TAR_BLOCK];
+    };
+    size_t headerFill;
+    // Data left in the current entry, then padding up to the next block
+    uint64_t remaining, padding;
+    int fd; // -1 when the data is skipped
+    uint64_t fileDone;
+    char name[PATH_MAX];
+    bool finished;
+} tar_state_t;
+
+static const char *tar_xz_lzma_error(lzma_ret ret) {
+    switch (ret) {
+        case LZMA_MEM_ERROR: return "Memory allocation failed";
+        case LZMA_FORMAT_ERROR: return "The input is not in the .xz format";
+        case LZMA_OPTIONS_ERROR: return "Unsupported compression options";
+        case LZMA_DATA_ERROR: return "Compressed file is corrupt";
+        case LZMA_BUF_ERROR: return "Compressed file is truncated or otherwise corrupt";
+        default: return "Unknown error, possibly a bug";
+    }
+}
+
+static uint64_t tar_parse_octal(const char *field, size_t length) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < length && field[i]; i++) {
+        if (field[i] >= '0' && field[i] <= '7') {
+            value = value * 8 + (field[i] - '0');
+        } else if (field[i] != ' ') {
+            break;
+        }
+    }
+    return value;
+}
+
+// Splits an entry name into the components below the destination, leaving out
+// "." and empty ones. Names that are absolute or contain ".." anywhere are
+// rejected, so no entry can name a path outside the destination.
+static int tar_split_path(char *name, char **components, int maxComponents) {
+    if (name[0] == '/') return -1;
+    int count = 0;
+    char *saved;
+    for (char *part = strtok_r(name, "/", &saved); part; part = strtok_r(NULL, "/", &saved)) {
+        if (!strcmp(part, ".")) continue;
+        if (!strcmp(part, "..") || count == maxComponents) return -1;
+        components[count++] = part;
+    }
+    return count;
+}
+
+// A symlink may only point into the destination: the target is relative, and
+// any ".." come first and climb no higher than the link's own depth. Since a
+// ".." can't follow a name, another symlink can't take the target elsewhere.
+static bool tar_symlink_target_ok(const char *target, int depth) {
+    if (target[0] == '\0' || target[0] == '/') return false;
+    bool climbing = true;
+    for (const char *part = target; *part;) {
+        size_t length = strcspn(part, "/");
+        if (length == 2 && !memcmp(part, "..", 2)) {
+            if (!climbing || --depth < 0) return false;
+        } else if (length > 0 && !(length == 1 && part[0] == '.')) {
+            climbing = false;
+        }
+        part += length;
+        if (*part == '/') part++;
+    }
+    return true;
+}
+
+// Opens the directory made of the given components, creating missing ones.
+// Every component is opened with O_NOFOLLOW relative to the previous one, so
+// a symlink extracted earlier can't redirect a later entry.
+static int tar_open_dir(tar_state_t *state, char **components, int count) {
+    int fd = dup(state->rootFd);
+    for (int i = 0; i < count && fd >= 0; i++) {
+        if (mkdirat(fd, components[i], 0755) != 0 && errno != EEXIST) {
+            close(fd);
+            return -1;
+        }
+        int next = openat(fd, components[i], O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+        close(fd);
+        fd = next;
+    }
+    return fd;
+}
+
+static bool tar_finish_file(tar_state_t *state) {
+    if (state->fd >= 0) {
+        close(state->fd);
+        state->fd = -1;
+        if (state->callbacks->fileEnd && !state->callbacks->fileEnd(state->callbacks->context, state->name)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool tar_begin_entry(tar_state_t *state) {
+    const tar_header_t *header = &state->header;
+    if (header->name[0] == '\0') {
+        // End-of-archive block
+        state->finished = true;
+        return true;
+    }
+
+    int nameLength;
+    if (!memcmp(header->magic, "ustar", 5) && header->prefix[0]) {
+        nameLength = snprintf(state->name, sizeof(state->name), "%.*s/%.*s",
+            (int)strnlen(header->prefix, sizeof(header->prefix)), header->prefix,
+            (int)strnlen(header->name, sizeof(header->name)), header->name);
+    } else {
+        nameLength = snprintf(state->name, sizeof(state->name), "%.*s",
+            (int)strnlen(header->name, sizeof(header->name)), header->name);
+    }
+    if (nameLength < 0 || (size_t)nameLength >= sizeof(state->name)) {
+        snprintf(state->error, state->errorSize, "Entry name is too long");
+        return false;
+    }
+
+    char path[PATH_MAX];
+    char *components[PATH_MAX / 2];
+    memcpy(path, state->name, nameLength + 1);
+    int count = tar_split_path(path, components, sizeof(components) / sizeof(*components));
+    if (count < 0) {
+        snprintf(state->error, state->errorSize, "%s: path escapes the destination", state->name);
+        return false;
+    }
+
+    uint64_t size = tar_parse_octal(header->size, sizeof(header->size));
+    state->remaining = size;
+    state->padding = (TAR_BLOCK - size % TAR_BLOCK) % TAR_BLOCK;
+    state->fileDone = 0;
+
+    bool isFile = header->typeflag == '0' || header->typeflag == '\0' || header->typeflag == '7';
+    bool isSymlink = header->typeflag == '2';
+    if (header->typeflag == '5') { // Folder
+        int fd = tar_open_dir(state, components, count);
+        if (fd < 0) {
+            snprintf(state->error, state->errorSize, "%s: %s", state->name, strerror(errno));
+            return false;
+        }
+        close(fd);
+        return true;
+    } else if (!(isFile || isSymlink) || count == 0) {
+        // Ignore everything else, along with its data
+        return true;
+    }
+
+    const char *leaf = components[count - 1];
+    int dirFd = tar_open_dir(state, components, count - 1);
+    if (dirFd < 0) {
+        snprintf(state->error, state->errorSize, "%s: %s", state->name, strerror(errno));
+        return false;
+    }
+    if (isSymlink) {
+        char target[sizeof(header->linkname) + 1];
+        snprintf(target, sizeof(target), "%.*s",
+            (int)strnlen(header->linkname, sizeof(header->linkname)), header->linkname);
+        if (!tar_symlink_target_ok(target, count - 1)) {
+            snprintf(state->error, state->errorSize, "%s: link to %s escapes the destination", state->name, target);
+            close(dirFd);
+            return false;
+        }
+        unlinkat(dirFd, leaf, 0);
+        int result = symlinkat(target, dirFd, leaf);
+        close(dirFd);
+        if (result != 0) {
+            snprintf(state->error, state->errorSize, "%s: %s", state->name, strerror(errno));
+            return false;
+        }
+        return true;
+    }
+
+    // O_NOFOLLOW: never write through a symlink that has the same name
+    mode_t mode = (tar_parse_octal(header->mode, sizeof(header->mode)) & 0777) | 0600;
+    state->fd = openat(dirFd, leaf, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, mode);
+    close(dirFd);
+    if (state->fd < 0) {
+        snprintf(state->error, state->errorSize, "%s: %s", state->name, strerror(errno));
+        return false;
+    }
+    if (state->callbacks->fileBegin) {
+        state->callbacks->fileBegin(state->callbacks->context, state->name, size);
+    }
+    if (size == 0) {
+        return tar_finish_file(state);
+    }
+    return true;
+}
+
+static bool tar_process(tar_state_t *state, const uint8_t *data, size_t length) {
+    while (length > 0 && !state->finished) {
+        if (state->remaining > 0) {
+            size_t count = state->remaining < length ? (size_t)state->remaining : length;
+            if (state->fd >= 0) {
+                for (size_t written = 0; written < count;) {
+                    ssize_t result = write(state->fd, data + written, count - written);
+                    if (result < 0) {
+                        if (errno == EINTR) continue;
+                        snprintf(state->error, state->errorSize, "%s: %s", state->name, strerror(errno));
+                        return false;
+                    }
+                    written += result;
+                }
+                state->fileDone += count;
+            }
+            data += count;
+            length -= count;
+            state->remaining -= count;
+            if (state->remaining == 0 && !tar_finish_file(state)) {
+                return false;
+            }
+        } else if (state->padding > 0) {
+            size_t count = state->padding < length ? (size_t)state->padding : length;
+            data += count;
+            length -= count;
+            state->padding -= count;
+        } else {
+            size_t count = TAR_BLOCK - state->headerFill;
+            if (count > length) count = length;
+            memcpy(state->block + state->headerFill, data, count);
+            data += count;
+            length -= count;
+            state->headerFill += count;
+            if (state->headerFill == TAR_BLOCK) {
+                state->headerFill = 0;
+                if (!tar_begin_entry(state)) return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Reference: https://github.com/xz-mirror/xz/blob/master/doc/examples/02_decompress.c
+bool tar_xz_extract(const char *inPath, const char *outDir, const tar_xz_callbacks_t *callbacks, char *error, size_t errorSize) {
+    error[0] = '\0';
+    int in = open(inPath, O_RDONLY);
+    if (in < 0) {
+        snprintf(error, errorSize, "%s: %s", inPath, strerror(errno));
+        return false;
+    }
+
+    lzma_stream strm = LZMA_STREAM_INIT;
+    lzma_ret ret = lzma_stream_decoder(&strm, UINT64_MAX, LZMA_CONCATENATED);
+    if (ret != LZMA_OK) {
+        snprintf(error, errorSize, "%s", tar_xz_lzma_error(ret));
+        close(in);
+        return false;
+    }
+
+    mkdir(outDir, 0755);
+    int rootFd = open(outDir, O_RDONLY | O_DIRECTORY);
+    if (rootFd < 0) {
+        snprintf(error, errorSize, "%s: %s", outDir, strerror(errno));
+        lzma_end(&strm);
+        close(in);
+        return false;
+    }
+
+    tar_state_t *state = calloc(1, sizeof(tar_state_t));
+    state->rootFd = rootFd;
+    state->callbacks = callbacks;
+    state->error = error;
+    state->errorSize = errorSize;
+    state->fd = -1;
+
+    uint8_t *inbuf = malloc(TAR_XZ_CHUNK), *outbuf = malloc(TAR_XZ_CHUNK);
+    lzma_action action = LZMA_RUN;
+    bool ok = true;
+    while (ok) {
+        if (callbacks->cancelled && callbacks->cancelled(callbacks->context)) {
+            ok = false;
+            break;
+        }
+        if (strm.avail_in == 0 && action == LZMA_RUN) {
+            ssize_t count = read(in, inbuf, TAR_XZ_CHUNK);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                snprintf(error, errorSize, "%s: %s", inPath, strerror(errno));
+                ok = false;
+                break;
+            }
+            strm.next_in = inbuf;
+            strm.avail_in = count;
+            if (count == 0) {
+                action = LZMA_FINISH;
+            }
+        }
+
+        strm.next_out = outbuf;
+        strm.avail_out = TAR_XZ_CHUNK;
+        ret = lzma_code(&strm, action);
+        size_t produced = TAR_XZ_CHUNK - strm.avail_out;
+        if (produced > 0) {
+            ok = tar_process(state, outbuf, produced);
+            if (ok && state->fd >= 0 && callbacks->progress) {
+                callbacks->progress(callbacks->context, state->fileDone, strm.total_in);
+            }
+        }
+        if (!ok || state->finished || ret == LZMA_STREAM_END) {
+            break;
+        } else if (ret != LZMA_OK) {
+            snprintf(error, errorSize, "%s", tar_xz_lzma_error(ret));
+            ok = false;
+        }
+    }
+    if (ok && !state->finished && (state->remaining > 0 || state->headerFill > 0)) {
+        snprintf(error, errorSize, "%s", tar_xz_lzma_error(LZMA_BUF_ERROR));
+        ok = false;
+    }
+
+    if (state->fd >= 0) {
+        close(state->fd);
+    }
+    free(state);
+    close(rootFd);
+    free(inbuf);
+    free(outbuf);
+    lzma_end(&strm);
+    close(in);
+    return ok;
+}
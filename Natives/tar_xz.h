@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Streaming extraction of .tar.xz archives (Java runtimes) with liblzma and
+// plain POSIX I/O: the archive is decoded in large chunks and file contents
+// go straight from the decoder's buffer to write(2). Only regular files,
+// directories and symlinks are created; other entries, including pax and GNU
+// long-name headers, are skipped together with their data. Nothing is created
+// or written outside outDir: names with ".." are rejected, symlinks must point
+// inside it, and paths are opened without following symlinks.
+
+typedef struct {
+    void *context;
+    // A regular file is about to be written
+    void (*fileBegin)(void *context, const char *name, uint64_t size);
+    // Progress within the current file and through the compressed input
+    void (*progress)(void *context, uint64_t fileDone, uint64_t inputDone);
+    // The current file is complete; returning false stops extraction
+    bool (*fileEnd)(void *context, const char *name);
+    bool (*cancelled)(void *context);
+} tar_xz_callbacks_t;
+
+// Returns false on failure with a message in error, or with an empty message
+// if a callback cancelled or stopped it
+bool tar_xz_extract(const char *inPath, const char *outDir, const tar_xz_callbacks_t *callbacks, char *error, size_t errorSize);
@@ -0,0 +1,150 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "asset_index.h"
+#include "fixtures.h"
+#include "test.h"
+
+#define OBJECT_COUNT 10000
+
+static char dir[PATH_MAX], jsonPath[PATH_MAX], binPath[PATH_MAX];
+
+static void hash_of(int i, uint8_t hash[20]) {
+    char hex[41];
+    fixture_asset_hash(i, hex);
+    for (int j = 0; j < 20; j++) {
+        sscanf(hex + j * 2, "%2hhx", &hash[j]);
+    }
+}
+
+static void write_json(const char *content) {
+    FILE *file = fopen(jsonPath, "w");
+    fputs(content, file);
+    fclose(file);
+}
+
+static asset_index_t *compile_and_open(void) {
+    CHECK_EQ_INT(asset_index_compile(jsonPath, binPath), 0);
+    asset_index_t *index = asset_index_open(binPath, jsonPath);
+    CHECK(index != NULL);
+    return index;
+}
+
+static void test_large_index(void) {
+    CHECK(fixture_write_asset_index(jsonPath, OBJECT_COUNT));
+    CHECK(asset_index_open(binPath, jsonPath) == NULL);
+    asset_index_t *index = compile_and_open();
+    if (!index) return;
+    CHECK_EQ_INT(asset_index_count(index), OBJECT_COUNT);
+    CHECK_EQ_INT(asset_index_flags(index), 0);
+
+    // Sorted by hash, every object found with its own name and size
+    for (size_t i = 1; i < asset_index_count(index); i++) {
+        CHECK(memcmp(asset_index_object(index, i - 1)->hash, asset_index_object(index, i)->hash, 20) < 0);
+    }
+    char expected[128];
+    for (int i = 0; i < OBJECT_COUNT; i++) {
+        uint8_t hash[20];
+        hash_of(i, hash);
+        const asset_object_t *object = asset_index_find(index, hash);
+        CHECK(object != NULL);
+        if (!object) continue;
+        snprintf(expected, sizeof(expected), "minecraft/sounds/block/%d/step%d.ogg", i / 100, i % 100);
+        CHECK(!strcmp(asset_index_name(index, object), expected));
+        CHECK_EQ_INT(object->nameLength, strlen(expected));
+        CHECK_EQ_INT(object->size, 1000 + i);
+    }
+    uint8_t missing[20] = {0};
+    CHECK(asset_index_find(index, missing) == NULL);
+    char hex[41];
+    asset_hash_to_hex(asset_index_object(index, 0)->hash, hex);
+    CHECK_EQ_INT(strlen(hex), 40);
+
+    // Verified bits go back to the file through the mapping
+    for (size_t i = 0; i < OBJECT_COUNT; i += 3) {
+        asset_index_set_verified(index, i, true);
+    }
+    asset_index_set_verified(index, 3, false);
+    asset_index_close(index);
+    index = asset_index_open(binPath, jsonPath);
+    CHECK(index != NULL);
+    if (!index) return;
+    CHECK(asset_index_is_verified(index, 0));
+    CHECK(!asset_index_is_verified(index, 1));
+    CHECK(!asset_index_is_verified(index, 3));
+    CHECK(asset_index_is_verified(index, OBJECT_COUNT - 1 - (OBJECT_COUNT - 1) % 3));
+    asset_index_close(index);
+}
+
+static void test_stale_table(void) {
+    // Re-downloaded within the same second with the same size
+    struct stat st;
+    stat(jsonPath, &st);
+    char *json = fixture_read_path(jsonPath, NULL);
+    char *hash = strstr(json, "\"hash\": \"") + 9;
+    hash[0] = hash[0] == 'a' ? 'b' : 'a';
+    write_json(json);
+    free(json);
+    struct timespec times[2] = {st.st_atim, {st.st_mtim.tv_sec, (st.st_mtim.tv_nsec + 1) % 1000000000}};
+    utimensat(AT_FDCWD, jsonPath, times, 0);
+    CHECK(asset_index_open(binPath, jsonPath) == NULL);
+
+    // Damaged tables aren't mapped
+    asset_index_close(compile_and_open());
+    truncate(binPath, 100);
+    CHECK(asset_index_open(binPath, jsonPath) == NULL);
+    write_json("{}");
+    CHECK(asset_index_open(binPath, jsonPath) == NULL);
+    CHECK(asset_index_open(binPath, "/nonexistent.json") == NULL);
+}
+
+static void test_small_indexes(void) {
+    // Pre-1.7 layout; objects without a valid hash are left out
+    write_json("{\"map_to_resources\": true, \"objects\": {"
+        "\"sound/a.ogg\": {\"hash\": \"00112233445566778899aabbccddeeff00112233\", \"size\": 5.0},"
+        "\"sound/b\\u00e9.ogg\": {\"size\": 6e1, \"hash\": \"ffeeddccbbaa99887766554433221100ffeeddcc\"},"
+        "\"sound/short.ogg\": {\"hash\": \"abc\", \"size\": 1},"
+        "\"sound/none.ogg\": {\"size\": 1, \"extra\": [1, {\"x\": null}]}}}");
+    asset_index_t *index = compile_and_open();
+    if (index) {
+        CHECK_EQ_INT(asset_index_count(index), 2);
+        CHECK_EQ_INT(asset_index_flags(index), ASSET_INDEX_MAP_TO_RESOURCES);
+        CHECK(!strcmp(asset_index_name(index, asset_index_object(index, 0)), "sound/a.ogg"));
+        CHECK_EQ_INT(asset_index_object(index, 0)->size, 5);
+        CHECK(!strcmp(asset_index_name(index, asset_index_object(index, 1)), "sound/b\xc3\xa9.ogg"));
+        CHECK_EQ_INT(asset_index_object(index, 1)->size, 60);
+        asset_index_close(index);
+    }
+
+    write_json("{\"objects\": {}}");
+    index = compile_and_open();
+    if (index) {
+        CHECK_EQ_INT(asset_index_count(index), 0);
+        asset_index_close(index);
+    }
+
+    write_json("{\"objects\": [1, 2]}");
+    CHECK_EQ_INT(asset_index_compile(jsonPath, binPath), EINVAL);
+    write_json("");
+    CHECK(asset_index_compile(jsonPath, binPath) != 0);
+    CHECK_EQ_INT(asset_index_compile("/nonexistent.json", binPath), ENOENT);
+}
+
+int main(void) {
+    char *temp = fixture_temp_dir("asset_index");
+    strcpy(dir, temp);
+    free(temp);
+    snprintf(jsonPath, sizeof(jsonPath), "%s/1.20.json", dir);
+    snprintf(binPath, sizeof(binPath), "%s/1.20.bin", dir);
+
+    test_large_index();
+    test_stale_table();
+    test_small_indexes();
+
+    fixture_remove_tree(dir);
+    return TEST_RESULT();
+}
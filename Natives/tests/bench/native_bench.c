@@ -0,0 +1,514 @@
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "external/gl4es/string_utils.h"
+#include "fixtures.h"
+#include "input/gamepad_input.h"
+#include "input/input_event_queue.h"
+#include "json_cursor.h"
+#include "macho_patch.h"
+#include "patched_index.h"
+#include "stubs/stub_gl.h"
+#include "tar_xz.h"
+
+// Timings for the hot paths of the portable cores, on fixed inputs so runs
+// can be compared. --quick runs a few iterations only, as a smoke test.
+
+static int scale = 10;
+
+static void report(const char *name, double value, const char *unit) {
+    printf("%-32s %12.2f %s\n", name, value, unit);
+}
+
+static const char *shaderFixtures[] = {
+    "shaders/rendertype_solid.vsh",
+    "shaders/gbuffers_terrain.fsh",
+    "shaders/legacy_fog.fsh"
+};
+#define SHADER_COUNT (sizeof(shaderFixtures) / sizeof(*shaderFixtures))
+
+static void bench_string_utils(void) {
+    // One big shader made of all fixtures, like an uber-shader after #includes
+    char *parts[SHADER_COUNT];
+    size_t total = 1;
+    for (size_t i = 0; i < SHADER_COUNT; i++) {
+        parts[i] = fixture_read(shaderFixtures[i], NULL);
+        total += parts[i] ? strlen(parts[i]) * 20 : 0;
+    }
+    char *source = calloc(1, total);
+    for (int copy = 0; copy < 20; copy++) {
+        for (size_t i = 0; i < SHADER_COUNT; i++) {
+            if (parts[i]) strcat(source, parts[i]);
+        }
+    }
+
+    int iterations = 20 * scale;
+    double start = fixture_now();
+    for (int i = 0; i < iterations; i++) {
+        int size = (int)strlen(source) + 1;
+        char *buffer = malloc(size);
+        memcpy(buffer, source, size);
+        buffer = InplaceReplace(buffer, &size, "texture2D", "texture");
+        buffer = InplaceReplace(buffer, &size, "varying", "in");
+        free(buffer);
+    }
+    double elapsed = fixture_now() - start;
+    report("string_utils InplaceReplace", elapsed / iterations * 1e6, "us/pass");
+    report("string_utils throughput", strlen(source) * 2.0 * iterations / elapsed / 1e6, "MB/s");
+
+    for (size_t i = 0; i < SHADER_COUNT; i++) free(parts[i]);
+    free(source);
+}
+
+static void bench_shader_rewrite(void) {
+    char *sources[SHADER_COUNT];
+    for (size_t i = 0; i < SHADER_COUNT; i++) {
+        sources[i] = fixture_read(shaderFixtures[i], NULL);
+        if (!sources[i]) return;
+    }
+    int iterations = 500 * scale;
+    double start = fixture_now();
+    for (int i = 0; i < iterations; i++) {
+        const GLchar *source = sources[i % SHADER_COUNT];
+        glShaderSource(1, 1, &source, NULL);
+    }
+    report("glShaderSource rewrite", (fixture_now() - start) / iterations * 1e6, "us/shader");
+    stub_gl_reset_stats();
+    for (size_t i = 0; i < SHADER_COUNT; i++) free(sources[i]);
+}
+
+static void bench_tar_xz(const char *dir) {
+    // A runtime-shaped archive: many mid-sized files, some text-like data
+    enum { FILES = 240, FILE_SIZE = 96 * 1024 };
+    char *data = malloc(FILE_SIZE);
+    uint32_t seed = 43;
+    for (int i = 0; i < FILE_SIZE; i++) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = "abcdefghijklmnopqrstuvwxyz \n{}();"[(seed >> 16) % 33];
+    }
+    fixture_tar_entry_t entries[FILES + 2];
+    char names[FILES][64];
+    entries[0] = (fixture_tar_entry_t){"./lib/", '5'};
+    for (int i = 0; i < FILES; i++) {
+        snprintf(names[i], sizeof(names[i]), "./lib/module-%03d/classes.jsa", i);
+        entries[i + 1] = (fixture_tar_entry_t){names[i], '0', NULL, data, FILE_SIZE};
+    }
+    entries[FILES + 1] = (fixture_tar_entry_t){"./lib/current", '2', "module-000"};
+
+    char archive[PATH_MAX], out[PATH_MAX];
+    snprintf(archive, sizeof(archive), "%s/runtime.tar.xz", dir);
+    if (!fixture_write_tar_xz(archive, entries, FILES + 2)) {
+        fprintf(stderr, "Could not write %s\n", archive);
+        free(data);
+        return;
+    }
+    int iterations = scale >= 10 ? 5 : 1;
+    double elapsed = 0;
+    for (int i = 0; i < iterations; i++) {
+        snprintf(out, sizeof(out), "%s/runtime-%d", dir, i);
+        char error[512];
+        tar_xz_callbacks_t callbacks = {0};
+        double start = fixture_now();
+        if (!tar_xz_extract(archive, out, &callbacks, error, sizeof(error))) {
+            fprintf(stderr, "tar_xz_extract: %s\n", error);
+        }
+        elapsed += fixture_now() - start;
+        fixture_remove_tree(out);
+    }
+    report("tar_xz_extract", (double)FILES * FILE_SIZE * iterations / elapsed / 1e6, "MB/s");
+    free(data);
+}
+
+static void bench_macho_patch(const char *dir) {
+    int files = 50 * scale;
+    char path[PATH_MAX];
+    for (int i = 0; i < files; i++) {
+        snprintf(path, sizeof(path), "%s/lib%d.dylib", dir, i);
+        fixture_write_macho(path, 1, "/System/Library/Frameworks/Foundation.framework/Versions/C/Foundation", i % 2);
+    }
+    // First pass patches, the second only reads the load commands
+    for (int pass = 0; pass < 2; pass++) {
+        double start = fixture_now();
+        for (int i = 0; i < files; i++) {
+            snprintf(path, sizeof(path), "%s/lib%d.dylib", dir, i);
+            macho_patch_platform(path, 2);
+        }
+        report(pass ? "macho_patch_platform (clean)" : "macho_patch_platform (patch)",
+            (fixture_now() - start) / files * 1e6, "us/file");
+    }
+}
+
+// Runs after bench_macho_patch, over the libraries it wrote
+static bool bench_patched_index(const char *dir) {
+    int files = 50 * scale;
+    char path[PATH_MAX], indexPath[PATH_MAX];
+    snprintf(indexPath, sizeof(indexPath), "%s/.patched_dylibs", dir);
+    struct stat *stats = calloc(files, sizeof(struct stat));
+    patched_index_t *index = patched_index_open(indexPath);
+    for (int i = 0; i < files; i++) {
+        snprintf(path, sizeof(path), "%s/lib%d.dylib", dir, i);
+        stat(path, &stats[i]);
+        patched_index_add(index, path, &stats[i]);
+    }
+    patched_index_close(index);
+
+    // Opening stats every entry to drop stale ones
+    double start = fixture_now();
+    index = patched_index_open(indexPath);
+    report("patched_index_open", (fixture_now() - start) / files * 1e6, "us/entry");
+
+    int lookups = 20000 * scale;
+    int found = 0;
+    start = fixture_now();
+    for (int i = 0; i < lookups; i++) {
+        snprintf(path, sizeof(path), "%s/lib%d.dylib", dir, i % files);
+        found += patched_index_contains(index, path, &stats[i % files]);
+    }
+    report("patched_index_contains", (fixture_now() - start) / lookups * 1e9, "ns/lookup");
+    if (found != lookups) {
+        fprintf(stderr, "patched index: %d of %d libraries found\n", found, lookups);
+    }
+    patched_index_close(index);
+    free(stats);
+    return found == lookups;
+}
+
+static int json_cursor_hashes(const char *json, size_t length) {
+    int found = 0;
+    json_cursor_t cursor;
+    json_cursor_init(&cursor, json, length);
+    json_enter_object(&cursor);
+    json_find_key(&cursor, "objects");
+    json_enter_object(&cursor);
+    json_string_t key, field, hash;
+    while (json_next_key(&cursor, &key)) {
+        json_enter_object(&cursor);
+        while (json_next_key(&cursor, &field)) {
+            uint64_t size;
+            if (json_string_equals(field, "hash") && json_read_string(&cursor, &hash)) {
+                found++;
+            } else if (!json_string_equals(field, "size") || !json_read_uint64(&cursor, &size)) {
+                json_skip_value(&cursor);
+            }
+        }
+    }
+    return found;
+}
+
+// The whole document as a tree, the way NSJSONSerialization hands it over
+typedef struct json_node {
+    json_type_t type;
+    char *string;
+    double number;
+    // Members of objects and arrays, keys only for objects
+    struct json_node **children;
+    char **keys;
+    size_t count;
+} json_node_t;
+
+static char *json_node_string(json_string_t string) {
+    char *copy = malloc(string.length + 1);
+    json_string_copy(string, copy, string.length + 1);
+    return copy;
+}
+
+static json_node_t *json_node_parse(json_cursor_t *cursor) {
+    json_node_t *node = calloc(1, sizeof(json_node_t));
+    node->type = json_peek(cursor);
+    json_string_t string;
+    size_t capacity = 0;
+    switch (node->type) {
+        case JSON_OBJECT:
+            json_enter_object(cursor);
+            while (json_next_key(cursor, &string)) {
+                if (node->count == capacity) {
+                    capacity = capacity ? capacity * 2 : 4;
+                    node->children = realloc(node->children, capacity * sizeof(json_node_t *));
+                    node->keys = realloc(node->keys, capacity * sizeof(char *));
+                }
+                node->keys[node->count] = json_node_string(string);
+                node->children[node->count++] = json_node_parse(cursor);
+            }
+            break;
+        case JSON_ARRAY:
+            json_enter_array(cursor);
+            while (json_next_element(cursor)) {
+                if (node->count == capacity) {
+                    capacity = capacity ? capacity * 2 : 4;
+                    node->children = realloc(node->children, capacity * sizeof(json_node_t *));
+                }
+                node->children[node->count++] = json_node_parse(cursor);
+            }
+            break;
+        case JSON_STRING:
+            json_read_string(cursor, &string);
+            node->string = json_node_string(string);
+            break;
+        case JSON_NUMBER:
+            node->number = strtod(cursor->p, NULL);
+            json_skip_value(cursor);
+            break;
+        default:
+            json_skip_value(cursor);
+            break;
+    }
+    return node;
+}
+
+static json_node_t *json_node_get(const json_node_t *node, const char *key) {
+    for (size_t i = 0; node->keys && i < node->count; i++) {
+        if (!strcmp(node->keys[i], key)) return node->children[i];
+    }
+    return NULL;
+}
+
+static void json_node_free(json_node_t *node) {
+    for (size_t i = 0; i < node->count; i++) {
+        json_node_free(node->children[i]);
+        if (node->keys) free(node->keys[i]);
+    }
+    free(node->children);
+    free(node->keys);
+    free(node->string);
+    free(node);
+}
+
+static int materialized_hashes(const char *json, size_t length) {
+    json_cursor_t cursor;
+    json_cursor_init(&cursor, json, length);
+    json_node_t *root = json_node_parse(&cursor);
+    json_node_t *objects = json_node_get(root, "objects");
+    int found = 0;
+    for (size_t i = 0; objects && i < objects->count; i++) {
+        json_node_t *hash = json_node_get(objects->children[i], "hash");
+        found += hash && hash->type == JSON_STRING;
+    }
+    json_node_free(root);
+    return found;
+}
+
+// Each way of reading runs in its own process so the peak RSS is its own
+static bool bench_json_reader(const char *name, const char *path, int objects, int (*read)(const char *, size_t)) {
+    fflush(stdout);
+    pid_t child = fork();
+    if (child == 0) {
+        size_t length;
+        char *json = fixture_read_path(path, &length);
+        if (!json) _exit(1);
+        int iterations = 5 * scale, found = 0;
+        double start = fixture_now();
+        for (int i = 0; i < iterations; i++) {
+            found += read(json, length);
+        }
+        double elapsed = fixture_now() - start;
+        char label[64];
+        snprintf(label, sizeof(label), "%s asset index", name);
+        report(label, elapsed / iterations * 1e3, "ms/parse");
+        snprintf(label, sizeof(label), "%s throughput", name);
+        report(label, length * (double)iterations / elapsed / 1e6, "MB/s");
+        fflush(stdout);
+        if (found != objects * iterations) {
+            fprintf(stderr, "%s: %d of %d hashes read\n", name, found, objects * iterations);
+            _exit(1);
+        }
+        _exit(0);
+    }
+
+    int status;
+    struct rusage usage;
+    if (child == -1 || wait4(child, &status, 0, &usage) != child) return false;
+#ifdef __APPLE__
+    double peakMB = usage.ru_maxrss / 1048576.0;
+#else
+    double peakMB = usage.ru_maxrss / 1024.0;
+#endif
+    char label[64];
+    snprintf(label, sizeof(label), "%s peak RSS", name);
+    report(label, peakMB, "MB");
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Streaming the asset index against building it whole first, as the launcher
+// did before json_cursor
+static bool bench_json_cursor(const char *dir) {
+    int objects = 10000;
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/index.json", dir);
+    if (!fixture_write_asset_index(path, objects)) return false;
+    bool ok = bench_json_reader("json_cursor", path, objects, json_cursor_hashes);
+    return bench_json_reader("materialized", path, objects, materialized_hashes) && ok;
+}
+
+typedef struct {
+    GLFWInputEvent *events;
+    size_t count;
+    int repeats;
+    input_event_queue_t *queue;
+} trace_replay_t;
+
+static void *replay_producer(void *arg) {
+    trace_replay_t *replay = arg;
+    for (int r = 0; r < replay->repeats; r++) {
+        for (size_t i = 0; i < replay->count; i++) {
+            while (!input_event_queue_push(replay->queue, &replay->events[i])) {}
+        }
+    }
+    return NULL;
+}
+
+static bool bench_input_queue(void) {
+    char *trace = fixture_read("input_trace.txt", NULL);
+    if (!trace) return false;
+    size_t capacity = 1024, count = 0;
+    GLFWInputEvent *events = malloc(capacity * sizeof(GLFWInputEvent));
+    for (char *line = strtok(trace, "\n"); line; line = strtok(NULL, "\n")) {
+        long time;
+        int type, i1, i2, i3, i4;
+        if (line[0] == '#' || sscanf(line, "%ld %d %d %d %d %d", &time, &type, &i1, &i2, &i3, &i4) != 6) continue;
+        if (count == capacity) events = realloc(events, (capacity *= 2) * sizeof(GLFWInputEvent));
+        GLFWInputEvent *event = &events[count++];
+        *event = (GLFWInputEvent){.type = type, .i1 = i1, .i2 = i2, .i3 = i3, .i4 = i4};
+        if (type == 1007) { // scroll
+            event->f1 = i1;
+            event->f2 = i2;
+        }
+    }
+    free(trace);
+
+    static input_event_queue_t queue = INPUT_EVENT_QUEUE_INITIALIZER;
+    trace_replay_t replay = {events, count, 100 * scale, &queue};
+    size_t expected = count * replay.repeats, delivered = 0, mismatched = 0;
+    long pumps = 0;
+    double start = fixture_now();
+    pthread_t producer;
+    pthread_create(&producer, NULL, replay_producer, &replay);
+    while (delivered < expected) {
+        const GLFWInputEvent *batch;
+        size_t n = input_event_queue_take(&queue, &batch);
+        for (size_t i = 0; i < n; i++) {
+            mismatched += batch[i].type != events[(delivered + i) % count].type;
+        }
+        delivered += n;
+        input_event_queue_rewind(&queue);
+        pumps++;
+    }
+    pthread_join(producer, NULL);
+    double elapsed = fixture_now() - start;
+    report("input queue replay", expected / elapsed / 1e6, "M events/s");
+    report("input queue events per pump", (double)delivered / pumps, "events");
+    if (mismatched) {
+        fprintf(stderr, "input queue: %zu events out of order\n", mismatched);
+    }
+    free(events);
+    return mismatched == 0;
+}
+
+typedef struct {
+    gamepad_sticks_t sticks;
+    pthread_mutex_t lock;
+    // When the stick last moved, and the latency of each change seen
+    double movedAt;
+    double *latencies;
+    int capacity;
+    atomic_int seen;
+} stick_latency_t;
+
+static bool stick_read(void *context, gamepad_sticks_t *sticks, bool *grabbing) {
+    stick_latency_t *latency = context;
+    pthread_mutex_lock(&latency->lock);
+    *sticks = latency->sticks;
+    pthread_mutex_unlock(&latency->lock);
+    *grabbing = true;
+    return true;
+}
+
+static void stick_key(void *context, int key, bool pressed) {
+    stick_latency_t *latency = context;
+    // Only the press of the new direction, not the release of the old one
+    if (!pressed || atomic_load(&latency->seen) == latency->capacity) return;
+    pthread_mutex_lock(&latency->lock);
+    latency->latencies[atomic_load(&latency->seen)] = fixture_now() - latency->movedAt;
+    pthread_mutex_unlock(&latency->lock);
+    atomic_fetch_add(&latency->seen, 1);
+}
+
+static void stick_look(void *context, double dx, double dy) {}
+
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Time from a stick moving to its movement key, at the poller's rate on iOS
+static bool bench_gamepad_latency(void) {
+    int moves = 20 * scale;
+    stick_latency_t latency = {.lock = PTHREAD_MUTEX_INITIALIZER, .latencies = calloc(moves, sizeof(double)), .capacity = moves};
+    gamepad_poller_t poller = {0};
+    gamepad_poller_callbacks_t callbacks = {&latency, stick_read, stick_key, stick_look};
+    if (!gamepad_poller_start(&poller, 250, &callbacks)) return false;
+
+    // Alternates north and south, at times unrelated to the poll interval
+    bool timedOut = false;
+    for (int i = 0; i < moves && !timedOut; i++) {
+        struct timespec pause = {0, (1000 + (i * 7919) % 9000) * 1000};
+        nanosleep(&pause, NULL);
+        pthread_mutex_lock(&latency.lock);
+        latency.sticks.leftY = i % 2 ? -1 : 1;
+        latency.movedAt = fixture_now();
+        pthread_mutex_unlock(&latency.lock);
+        double start = fixture_now();
+        while (atomic_load(&latency.seen) <= i) {
+            if (fixture_now() - start > 1) {
+                timedOut = true;
+                break;
+            }
+            sched_yield();
+        }
+    }
+    gamepad_poller_stop(&poller);
+
+    int seen = atomic_load(&latency.seen);
+    qsort(latency.latencies, seen, sizeof(double), compare_doubles);
+    double total = 0;
+    for (int i = 0; i < seen; i++) total += latency.latencies[i];
+    if (seen > 0) {
+        report("gamepad stick to key, mean", total / seen * 1e3, "ms");
+        report("gamepad stick to key, p99", latency.latencies[(int)ceil(seen * 0.99) - 1] * 1e3, "ms");
+    }
+    free(latency.latencies);
+    if (seen != moves) {
+        fprintf(stderr, "gamepad: %d of %d stick moves turned into keys\n", seen, moves);
+    }
+    return seen == moves;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && !strcmp(argv[1], "--quick")) {
+        scale = 1;
+    }
+    char *dir = fixture_temp_dir("native_bench");
+    if (!dir) return 1;
+
+    bench_string_utils();
+    bench_shader_rewrite();
+    bench_tar_xz(dir);
+    bench_macho_patch(dir);
+    bool ok = bench_patched_index(dir);
+    ok = bench_json_cursor(dir) && ok;
+    ok = bench_input_queue() && ok;
+    ok = bench_gamepad_latency() && ok;
+
+    fixture_remove_tree(dir);
+    free(dir);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,178 @@
+#include <string.h>
+
+#include "customcontrols/control_batch.h"
+#include "test.h"
+
+// Renders the batch into an offscreen bitmap the way ControlBatchLayer does:
+// a full redraw once, then only the dirty regions. After any sequence of
+// changes the bitmap has to match a full redraw of the final state.
+
+#define WIDTH 320
+#define HEIGHT 200
+
+static uint32_t fullCanvas[HEIGHT][WIDTH], partialCanvas[HEIGHT][WIDTH];
+
+static bool rect_contains(control_rect_t rect, float x, float y) {
+    return x >= rect.x && x < rect.x + rect.width && y >= rect.y && y < rect.y + rect.height;
+}
+
+static control_rect_t rect_outset(control_rect_t rect, float outset) {
+    return (control_rect_t){rect.x - outset, rect.y - outset, rect.width + outset * 2, rect.height + outset * 2};
+}
+
+// Pixels whose centers fall in the clip are cleared and drawn again, items in z-order
+static void draw(const control_batch_t *batch, uint32_t canvas[HEIGHT][WIDTH], control_rect_t clip) {
+    for (int y = 0; y < HEIGHT; y++) {
+        for (int x = 0; x < WIDTH; x++) {
+            float cx = x + 0.5f, cy = y + 0.5f;
+            if (!rect_contains(clip, cx, cy)) continue;
+            uint32_t pixel = 0;
+            for (size_t i = 0; i < batch->count; i++) {
+                const control_item_t *item = &batch->items[i];
+                if (!control_item_visible(item)) continue;
+                float half = item->strokeWidth / 2;
+                bool inFill = rect_contains(item->frame, cx, cy);
+                bool inStroke = half > 0 && rect_contains(rect_outset(item->frame, half), cx, cy) &&
+                    !rect_contains(rect_outset(item->frame, -half), cx, cy);
+                uint32_t shade = (uint32_t)(item->opacity * 255) << 24 ^ (item->flags & CONTROL_ITEM_HIGHLIGHTED ? 0x5a5a5a : 0);
+                if (inStroke) {
+                    pixel = item->strokeColor ^ shade;
+                } else if (inFill) {
+                    pixel = item->fillColor ^ shade;
+                }
+            }
+            canvas[y][x] = pixel;
+        }
+    }
+}
+
+static const control_rect_t everything = {0, 0, WIDTH, HEIGHT};
+
+static int flush(control_batch_t *batch) {
+    control_rect_t dirty[CONTROL_BATCH_MAX_DIRTY];
+    size_t count = control_batch_take_dirty(batch, dirty);
+    for (size_t i = 0; i < count; i++) {
+        draw(batch, partialCanvas, dirty[i]);
+    }
+    return (int)count;
+}
+
+static bool canvases_match(const control_batch_t *batch) {
+    draw(batch, fullCanvas, everything);
+    return !memcmp(fullCanvas, partialCanvas, sizeof(fullCanvas));
+}
+
+static uint32_t seed = 12345;
+static uint32_t next_random(uint32_t bound) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 8) % bound;
+}
+
+static control_item_t random_item(void) {
+    control_item_t item = {
+        .frame = {next_random(WIDTH) - 20.0f, next_random(HEIGHT) - 20.0f, 8 + next_random(60), 8 + next_random(60)},
+        .fillColor = 0x80000000 | next_random(0xFFFFFF),
+        .strokeColor = 0xFF000000 | next_random(0xFFFFFF),
+        .strokeWidth = next_random(4),
+        .cornerRadius = next_random(10),
+        .opacity = next_random(4) / 3.0f,
+        .flags = next_random(5) == 0 ? CONTROL_ITEM_HIDDEN : 0
+    };
+    // Half-point positions, like buttons on a 2x screen
+    item.frame.x += next_random(2) * 0.5f;
+    return item;
+}
+
+static void test_changes(void) {
+    control_batch_t batch;
+    control_batch_init(&batch);
+    for (int i = 0; i < 40; i++) {
+        size_t index = control_batch_add(&batch);
+        control_item_t item = random_item();
+        control_batch_update(&batch, index, &item);
+    }
+    flush(&batch);
+    draw(&batch, partialCanvas, everything);
+    CHECK(canvases_match(&batch));
+
+    for (int round = 0; round < 300; round++) {
+        int changes = 1 + next_random(6);
+        for (int c = 0; c < changes; c++) {
+            size_t index = next_random(batch.count);
+            control_item_t item = batch.items[index];
+            switch (next_random(5)) {
+                case 0: // dragged
+                    item.frame.x += (float)next_random(41) - 20;
+                    item.frame.y += (float)next_random(41) - 20;
+                    break;
+                case 1: item = random_item(); break;
+                case 2: item.flags ^= CONTROL_ITEM_HIDDEN; break;
+                case 3: item.strokeWidth = next_random(6); break;
+                case 4:
+                    control_batch_set_flag(&batch, index, CONTROL_ITEM_HIGHLIGHTED, next_random(2));
+                    continue;
+            }
+            control_batch_update(&batch, index, &item);
+        }
+        CHECK(flush(&batch) <= CONTROL_BATCH_MAX_DIRTY);
+        if (!canvases_match(&batch)) {
+            fprintf(stderr, "round %d: partial redraw differs\n", round);
+            test_failures++;
+            break;
+        }
+    }
+
+    // Nothing that shows changed, nothing to redraw
+    control_item_t hidden = batch.items[0];
+    hidden.flags |= CONTROL_ITEM_HIDDEN;
+    control_batch_update(&batch, 0, &hidden);
+    flush(&batch);
+    control_batch_update(&batch, 0, &hidden);
+    hidden.frame.x += 30;
+    control_batch_update(&batch, 0, &hidden);
+    CHECK_EQ_INT(flush(&batch), 0);
+    control_item_t same = batch.items[1];
+    control_batch_update(&batch, 1, &same);
+    CHECK_EQ_INT(flush(&batch), 0);
+
+    control_batch_remove_all(&batch);
+    flush(&batch);
+    CHECK_EQ_INT(batch.count, 0);
+    CHECK(canvases_match(&batch));
+    control_batch_destroy(&batch);
+}
+
+static void test_dirty_regions(void) {
+    control_batch_t batch;
+    control_batch_init(&batch);
+    // Far apart: one region each until the limit, then merged with the nearest
+    for (int i = 0; i < 12; i++) {
+        control_batch_invalidate(&batch, (control_rect_t){i * 25.0f, (i % 3) * 60.0f, 10, 10});
+    }
+    CHECK_EQ_INT(batch.dirtyCount, CONTROL_BATCH_MAX_DIRTY);
+    control_rect_t dirty[CONTROL_BATCH_MAX_DIRTY];
+    size_t count = control_batch_take_dirty(&batch, dirty);
+    for (int i = 0; i < 12; i++) {
+        control_rect_t rect = {i * 25.0f + 5, (i % 3) * 60.0f + 5, 0, 0};
+        bool covered = false;
+        for (size_t j = 0; j < count; j++) {
+            covered |= rect_contains(dirty[j], rect.x, rect.y);
+        }
+        CHECK(covered);
+    }
+    // Overlapping ones merge, also through a third that bridges them
+    control_batch_invalidate(&batch, (control_rect_t){0, 0, 10, 10});
+    control_batch_invalidate(&batch, (control_rect_t){20, 0, 10, 10});
+    control_batch_invalidate(&batch, (control_rect_t){5, 0, 20, 5});
+    CHECK_EQ_INT(control_batch_take_dirty(&batch, dirty), 1);
+    CHECK(dirty[0].x == 0 && dirty[0].width == 30);
+    control_batch_invalidate(&batch, (control_rect_t){0, 0, 0, 10});
+    CHECK_EQ_INT(batch.dirtyCount, 0);
+    control_batch_destroy(&batch);
+}
+
+int main(void) {
+    test_changes();
+    test_dirty_regions();
+    return TEST_RESULT();
+}
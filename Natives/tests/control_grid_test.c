@@ -0,0 +1,151 @@
+#include <string.h>
+
+#include "customcontrols/control_grid.h"
+#include "fixtures.h"
+#include "test.h"
+
+// Replays the key and mouse presses of the input trace as taps on a layout
+// like the default one (844x390 points), and checks every lookup against a
+// linear scan from the top of the z-order, which is what UIKit's own
+// hitTest: does.
+
+typedef struct {
+    int key;              // GLFW key, or -1 - mouse button
+    control_rect_t frame;
+    bool inGame;          // hidden while a screen (chat, inventory) is open
+} layout_control_t;
+
+static const layout_control_t layout[] = {
+    // Movement pad, overlapping the sprint toggle like the default layout
+    {87, {94, 226, 50, 50}, true},   // W
+    {65, {44, 276, 50, 50}, true},   // A
+    {83, {94, 326, 50, 50}, true},   // S
+    {68, {144, 276, 50, 50}, true},  // D
+    {341, {134, 216, 40, 40}, true}, // sprint
+    {32, {754, 300, 60, 60}, true},  // jump
+    {340, {94, 276, 50, 50}, true},  // sneak, between the arrows
+    {-1, {684, 300, 60, 60}, true},  // attack
+    {-2, {754, 230, 60, 60}, true},  // use
+    {69, {790, 10, 44, 34}, true},   // inventory
+    {84, {10, 10, 44, 34}, false},   // chat
+    {256, {380, 10, 84, 34}, false}, // pause menu
+    {257, {724, 10, 60, 34}, false}, // enter, shown with the chat
+    {294, {60, 10, 44, 34}, true},   // third person
+    {258, {110, 10, 44, 34}, true},  // player list
+    {81, {684, 230, 60, 60}, true},  // drop
+    // A full-width hotbar strip under everything else
+    {49, {200, 350, 444, 40}, true},
+};
+#define CONTROL_COUNT (sizeof(layout) / sizeof(*layout))
+
+static bool screenOpen;
+
+static bool visible(size_t index, void *context) {
+    return layout[index].inGame != screenOpen;
+}
+
+static long linear_hit(float x, float y) {
+    for (size_t i = CONTROL_COUNT; i-- > 0;) {
+        control_rect_t r = layout[i].frame;
+        if (x >= r.x && x < r.x + r.width && y >= r.y && y < r.y + r.height && visible(i, NULL)) {
+            return (long)i;
+        }
+    }
+    return -1;
+}
+
+static control_grid_t grid;
+
+static void build(float cellSize) {
+    control_rect_t rects[CONTROL_COUNT];
+    for (size_t i = 0; i < CONTROL_COUNT; i++) rects[i] = layout[i].frame;
+    control_grid_build(&grid, rects, CONTROL_COUNT, cellSize);
+}
+
+static int mismatches;
+
+static void check_tap(float x, float y) {
+    long expected = linear_hit(x, y);
+    long actual = control_grid_hit(&grid, x, y, visible, NULL);
+    if (actual != expected) {
+        if (mismatches++ < 10) {
+            fprintf(stderr, "tap at %.2f,%.2f: grid %ld, scan %ld\n", x, y, actual, expected);
+        }
+        test_failures++;
+    }
+}
+
+static void replay_trace(void) {
+    char *trace = fixture_read("input_trace.txt", NULL);
+    CHECK(trace != NULL);
+    if (!trace) return;
+    int taps = 0, hitsOwnControl = 0;
+    uint32_t jitter = 1;
+    for (char *line = strtok(trace, "\n"); line; line = strtok(NULL, "\n")) {
+        long time;
+        int type, i1, i2, i3, i4;
+        if (line[0] == '#' || sscanf(line, "%ld %d %d %d %d %d", &time, &type, &i1, &i2, &i3, &i4) != 6) continue;
+        int key;
+        if (type == 1005 && i3 == 1) key = i1;
+        else if (type == 1006 && i2 == 1) key = -1 - i1;
+        else continue;
+
+        for (size_t i = 0; i < CONTROL_COUNT; i++) {
+            if (layout[i].key != key) continue;
+            // Somewhere on the control, edges included, as a finger lands
+            control_rect_t r = layout[i].frame;
+            jitter = jitter * 1103515245 + 12345;
+            float x = r.x + (jitter >> 8) % 1000 / 1000.0f * r.width;
+            float y = r.y + (jitter >> 18) % 1000 / 1000.0f * r.height;
+            check_tap(x, y);
+            check_tap(r.x, r.y);
+            check_tap(r.x + r.width, r.y + r.height - 0.5f);
+            hitsOwnControl += control_grid_hit(&grid, x, y, visible, NULL) == (long)i;
+            taps++;
+        }
+        // T opens the chat and Enter sends it
+        if (key == 84) screenOpen = true;
+        if (key == 257) screenOpen = false;
+    }
+    free(trace);
+    CHECK(taps > 100);
+    // Overlaps send a few taps to the control on top, but not most of them
+    CHECK(hitsOwnControl > taps * 3 / 4);
+}
+
+int main(void) {
+    control_grid_init(&grid);
+    CHECK_EQ_INT(control_grid_hit(&grid, 10, 10, NULL, NULL), -1);
+
+    // Cells smaller and larger than the controls, and one cell for everything
+    const float cellSizes[] = {48, 7, 200, 5000, 0.1f};
+    for (size_t c = 0; c < sizeof(cellSizes) / sizeof(*cellSizes); c++) {
+        build(cellSizes[c]);
+        screenOpen = false;
+        replay_trace();
+        // Sweep the screen too, including outside the grid
+        for (float y = -10; y < 400; y += 3.7f) {
+            for (float x = -10; x < 860; x += 3.3f) {
+                check_tap(x, y);
+            }
+        }
+    }
+
+    // Without a test only the frames count
+    build(48);
+    CHECK_EQ_INT(control_grid_hit(&grid, 119, 301, NULL, NULL), 6);
+    CHECK_EQ_INT(control_grid_hit(&grid, 300, 360, NULL, NULL), 16);
+    CHECK_EQ_INT(control_grid_hit(&grid, 300, 200, NULL, NULL), -1);
+
+    // Rebuilt with fewer, moved and empty frames
+    control_rect_t moved[] = {{0, 0, 10, 10}, {5, 5, 0, 10}, {5, 5, 10, 10}};
+    control_grid_build(&grid, moved, 3, 48);
+    CHECK_EQ_INT(control_grid_hit(&grid, 7, 7, NULL, NULL), 2);
+    CHECK_EQ_INT(control_grid_hit(&grid, 2, 2, NULL, NULL), 0);
+    CHECK_EQ_INT(control_grid_hit(&grid, 15, 15, NULL, NULL), -1);
+    control_grid_build(&grid, NULL, 0, 48);
+    CHECK_EQ_INT(control_grid_hit(&grid, 2, 2, NULL, NULL), -1);
+
+    control_grid_destroy(&grid);
+    return TEST_RESULT();
+}
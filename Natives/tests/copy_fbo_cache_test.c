@@ -0,0 +1,109 @@
+#include "stubs/stub_gl.h"
+#include "test.h"
+
+// tinygl4angle's glCopyTexSubImage2D against the stub driver: the copy goes
+// through a cached FBO per context, which must not leak or cross contexts.
+
+static void copy(GLuint texture, GLint internalformat) {
+    stub_gl_set_texture_format(texture, internalformat);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 4, 8, 0, 0, 16, 16);
+}
+
+static EGLContext make_context(void) {
+    EGLContext context = eglCreateContext(EGL_NO_DISPLAY, NULL, EGL_NO_CONTEXT, NULL);
+    CHECK(context != EGL_NO_CONTEXT);
+    return context;
+}
+
+int main(void) {
+    EGLContext a = make_context(), b = make_context();
+
+    // Blit into the destination, scissor off during the blit, bindings restored
+    eglMakeCurrent(EGL_NO_DISPLAY, NULL, NULL, a);
+    glGenFramebuffers(1, &(GLuint){0});
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 1);
+    glEnable(GL_SCISSOR_TEST);
+    stub_gl_reset_stats();
+    copy(10, GL_RGBA8);
+    CHECK_EQ_INT(stub_gl_stats.blits, 1);
+    CHECK_EQ_INT(stub_gl_stats.lastBlitMask, GL_COLOR_BUFFER_BIT);
+    CHECK_EQ_INT(stub_gl_stats.lastBlitDst[0], 4);
+    CHECK_EQ_INT(stub_gl_stats.lastBlitDst[3], 24);
+    GLint drawFB;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFB);
+    CHECK_EQ_INT(drawFB, 1);
+    CHECK(glIsEnabled(GL_SCISSOR_TEST));
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+    // Depth formats blit the depth buffer from the depth attachment
+    copy(11, GL_DEPTH_COMPONENT24);
+    CHECK_EQ_INT(stub_gl_stats.lastBlitMask, GL_DEPTH_BUFFER_BIT);
+    copy(12, GL_DEPTH24_STENCIL8);
+    CHECK_EQ_INT(stub_gl_stats.lastBlitMask, GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+    CHECK_EQ_INT(stub_gl_stats.errors, 0);
+
+    // Switching contexts back and forth reuses each context's FBOs
+    int before = stub_gl_framebuffer_count(a);
+    stub_gl_reset_stats();
+    for (int i = 0; i < 50; i++) {
+        eglMakeCurrent(EGL_NO_DISPLAY, NULL, NULL, i & 1 ? b : a);
+        copy(10, GL_RGBA8);
+    }
+    CHECK_EQ_INT(stub_gl_framebuffer_count(a), before);
+    CHECK_EQ_INT(stub_gl_framebuffer_count(b), 1);
+    CHECK_EQ_INT(stub_gl_stats.framebuffersGenerated, 1);
+    CHECK_EQ_INT(stub_gl_stats.blits, 50);
+    CHECK_EQ_INT(stub_gl_stats.errors, 0);
+
+    // Many destinations evict instead of growing past the cache size
+    eglMakeCurrent(EGL_NO_DISPLAY, NULL, NULL, b);
+    for (GLuint texture = 100; texture < 140; texture++) {
+        copy(texture, GL_RGBA8);
+    }
+    CHECK(stub_gl_framebuffer_count(b) <= 8);
+    CHECK_EQ_INT(stub_gl_stats.errors, 0);
+
+    // A format that can't be attached falls back to the driver's copy
+    stub_gl_reset_stats();
+    copy(20, GL_LUMINANCE);
+    CHECK_EQ_INT(stub_gl_stats.blits, 0);
+    CHECK_EQ_INT(stub_gl_stats.copyTexSubImageCalls, 1);
+
+    // Deleting a texture detaches it from the cached FBOs
+    GLuint deleted = 139;
+    glDeleteTextures(1, &deleted);
+    for (GLuint fbo = 1; fbo < 16; fbo++) {
+        CHECK(stub_gl_framebuffer_attachment(fbo, GL_COLOR_ATTACHMENT0) != deleted);
+    }
+
+    // A destroyed context's handle may come back; its cache must not
+    eglMakeCurrent(EGL_NO_DISPLAY, NULL, NULL, EGL_NO_CONTEXT);
+    CHECK(eglDestroyContext(EGL_NO_DISPLAY, b));
+    EGLContext reused = make_context();
+    CHECK(reused == b);
+    eglMakeCurrent(EGL_NO_DISPLAY, NULL, NULL, reused);
+    stub_gl_reset_stats();
+    copy(10, GL_RGBA8);
+    CHECK_EQ_INT(stub_gl_stats.errors, 0);
+    CHECK_EQ_INT(stub_gl_stats.blits, 1);
+    CHECK_EQ_INT(stub_gl_framebuffer_count(reused), 1);
+
+    // With every cache taken, the copy uses an FBO that is deleted right after
+    EGLContext extra[4];
+    for (int i = 0; i < 4; i++) {
+        extra[i] = make_context();
+        eglMakeCurrent(EGL_NO_DISPLAY, NULL, NULL, extra[i]);
+        stub_gl_reset_stats();
+        copy(10, GL_RGBA8);
+        CHECK_EQ_INT(stub_gl_stats.blits, 1);
+        CHECK_EQ_INT(stub_gl_stats.errors, 0);
+    }
+    CHECK_EQ_INT(stub_gl_framebuffer_count(extra[3]), 0);
+    CHECK_EQ_INT(stub_gl_framebuffer_count(extra[1]), 1);
+
+    eglMakeCurrent(EGL_NO_DISPLAY, NULL, NULL, EGL_NO_CONTEXT);
+    for (int i = 0; i < 4; i++) eglDestroyContext(EGL_NO_DISPLAY, extra[i]);
+    return TEST_RESULT();
+}
@@ -0,0 +1,171 @@
+#include <math.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "deferred_write.h"
+#include "fixtures.h"
+#include "test.h"
+
+// PLDeferredWriter's coalescing on a virtual clock, and its file replacement
+// under a writer that gets killed halfway through.
+
+// The writer's timer and the file it writes, driven by hand
+typedef struct {
+    deferred_write_t state;
+    deferred_file_t file;
+    const char *path;
+    char contents[64];
+    double timerAt;
+} fake_writer_t;
+
+static void fire_until(fake_writer_t *writer, double now) {
+    if (writer->timerAt > now) return;
+    writer->timerAt = INFINITY;
+    if (deferred_write_take(&writer->state)) {
+        CHECK(deferred_file_write(&writer->file, writer->path, writer->contents, strlen(writer->contents)));
+    }
+}
+
+static void change(fake_writer_t *writer, double now, const char *contents) {
+    fire_until(writer, now);
+    snprintf(writer->contents, sizeof(writer->contents), "%s", contents);
+    writer->timerAt = deferred_write_changed(&writer->state, now);
+}
+
+static bool file_is(const char *path, const char *expected) {
+    size_t length;
+    char *contents = fixture_read_path(path, &length);
+    bool same = contents && length == strlen(expected) && !memcmp(contents, expected, length);
+    if (!same) fprintf(stderr, "%s has \"%s\", expected \"%s\"\n", path, contents ? contents : "(missing)", expected);
+    free(contents);
+    return same;
+}
+
+static void test_storm(const char *dir) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/launcher_preferences_v2.plist", dir);
+    fake_writer_t writer = {.path = path, .timerAt = INFINITY};
+    deferred_write_init(&writer.state, 0.5, 2);
+
+    // A slider dragged for 9 seconds, reporting at 120 Hz
+    char value[64];
+    double now = 0;
+    for (int i = 0; i < 1080; i++) {
+        now = i / 120.0;
+        snprintf(value, sizeof(value), "resolution=%d", 25 + i % 126);
+        change(&writer, now, value);
+    }
+    fire_until(&writer, INFINITY);
+    // Every 2 seconds while it moves, then half a second after it stops
+    CHECK_EQ_INT(writer.file.writeCount, 5);
+    CHECK(file_is(path, value));
+
+    // Toggles a second apart are each written half a second later
+    unsigned long before = writer.file.writeCount;
+    for (int i = 0; i < 10; i++) {
+        now += 1;
+        change(&writer, now, i % 2 ? "hardware_hide=1" : "hardware_hide=0");
+        fire_until(&writer, now + 0.49);
+        CHECK_EQ_INT(writer.file.writeCount, before + i);
+        fire_until(&writer, now + 0.5);
+        CHECK_EQ_INT(writer.file.writeCount, before + i + 1);
+    }
+
+    // Setting the same value again doesn't touch the disk
+    before = writer.file.writeCount;
+    for (int i = 0; i < 100; i++) {
+        now += 1;
+        change(&writer, now, "hardware_hide=1");
+        fire_until(&writer, now + 1);
+    }
+    CHECK_EQ_INT(writer.file.writeCount, before);
+
+    // Unless someone else rewrote the file meanwhile
+    FILE *other = fopen(path, "w");
+    fputs("rewritten elsewhere", other);
+    fclose(other);
+    change(&writer, now + 1, "hardware_hide=1");
+    fire_until(&writer, INFINITY);
+    CHECK_EQ_INT(writer.file.writeCount, before + 1);
+    CHECK(file_is(path, "hardware_hide=1"));
+
+    // Resetting isolated preferences: the pending change is dropped before the
+    // file goes, and the next one writes it anew even with the same contents
+    change(&writer, now + 2, "renderer=zink");
+    deferred_write_cancel(&writer.state);
+    deferred_file_forget(&writer.file);
+    CHECK(unlink(path) == 0);
+    fire_until(&writer, INFINITY);
+    CHECK(access(path, F_OK) != 0);
+    change(&writer, now + 3, "hardware_hide=1");
+    fire_until(&writer, INFINITY);
+    CHECK(file_is(path, "hardware_hide=1"));
+    deferred_file_forget(&writer.file);
+
+    // A directory that isn't there fails the write
+    deferred_file_t missing = {0};
+    snprintf(path, sizeof(path), "%s/missing/prefs.plist", dir);
+    CHECK(!deferred_file_write(&missing, path, "x", 1));
+    CHECK_EQ_INT(missing.writeCount, 0);
+}
+
+// Alternates between two versions of the file until killed
+static void rewrite_forever(const char *path, const char *a, const char *b, size_t length) {
+    deferred_file_t file = {0};
+    for (int i = 0;; i++) {
+        deferred_file_write(&file, path, i % 2 ? b : a, length - (i % 2) * 4096);
+    }
+}
+
+static void test_kill_mid_flush(const char *dir) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/launcher_profiles.json", dir);
+    const size_t length = 512 * 1024;
+    char *a = malloc(length), *b = malloc(length);
+    memset(a, 'a', length);
+    memset(b, 'b', length);
+    deferred_file_t file = {0};
+    CHECK(deferred_file_write(&file, path, a, length));
+    deferred_file_forget(&file);
+
+    int seenA = 0, seenB = 0, damaged = 0;
+    srand((unsigned)time(NULL));
+    for (int i = 0; i < 40; i++) {
+        pid_t child = fork();
+        if (child == 0) {
+            rewrite_forever(path, a, b, length);
+            _exit(0);
+        }
+        usleep(1000 + rand() % 20000);
+        kill(child, SIGKILL);
+        waitpid(child, NULL, 0);
+
+        size_t readLength;
+        char *contents = fixture_read_path(path, &readLength);
+        if (contents && readLength == length && !memcmp(contents, a, length)) {
+            seenA++;
+        } else if (contents && readLength == length - 4096 && !memcmp(contents, b, readLength)) {
+            seenB++;
+        } else {
+            damaged++;
+        }
+        free(contents);
+    }
+    CHECK_EQ_INT(damaged, 0);
+    CHECK_EQ_INT(seenA + seenB, 40);
+    printf("killed mid-flush 40 times: %d left the first version, %d the second\n", seenA, seenB);
+    free(a);
+    free(b);
+}
+
+int main(void) {
+    char *dir = fixture_temp_dir("deferred_write");
+    test_storm(dir);
+    test_kill_mid_flush(dir);
+    fixture_remove_tree(dir);
+    free(dir);
+    return TEST_RESULT();
+}
@@ -0,0 +1,173 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "dir_snapshot.h"
+#include "dir_watch.h"
+#include "fixtures.h"
+#include "test.h"
+
+// The listing the DirectoryWatcher keeps, and the watch that tells it when
+// to rescan: inotify here, kqueue on device.
+
+static char dir[PATH_MAX];
+
+// Alternates between two buffers so both rename() arguments can be built
+static const char *entry_path(const char *name) {
+    static char paths[2][PATH_MAX];
+    static int next;
+    char *path = paths[next ^= 1];
+    snprintf(path, PATH_MAX, "%s/%s", dir, name);
+    return path;
+}
+
+static void write_file(const char *name, const char *content) {
+    FILE *file = fopen(entry_path(name), "w");
+    fputs(content, file);
+    fclose(file);
+}
+
+typedef struct {
+    int added, removed, modified;
+    char lastName[64];
+} changes_t;
+
+static void count_change(void *context, dir_change_t change, const dir_entry_t *entry) {
+    changes_t *changes = context;
+    switch (change) {
+        case DIR_CHANGE_ADDED: changes->added++; break;
+        case DIR_CHANGE_REMOVED: changes->removed++; break;
+        case DIR_CHANGE_MODIFIED: changes->modified++; break;
+    }
+    snprintf(changes->lastName, sizeof(changes->lastName), "%s", entry->name);
+}
+
+// Rescans and returns what changed since *snapshot, which is replaced
+static changes_t rescan(dir_snapshot_t *snapshot) {
+    dir_snapshot_t next;
+    CHECK_EQ_INT(dir_snapshot_scan(dir, snapshot, &next), 0);
+    changes_t changes = {0};
+    dir_snapshot_diff(snapshot, &next, count_change, &changes);
+    dir_snapshot_free(snapshot);
+    *snapshot = next;
+    return changes;
+}
+
+static int wait_for_events(dir_watch_t *watch) {
+    struct pollfd pfd = {.fd = dir_watch_fd(watch), .events = POLLIN};
+    if (poll(&pfd, 1, 2000) != 1) return 0;
+    return dir_watch_read(watch);
+}
+
+static void test_snapshot(void) {
+    write_file("b.jar", "bb");
+    write_file("a.jar", "a");
+    mkdir(entry_path("config"), 0755);
+    symlink("missing", entry_path("dangling"));
+
+    dir_snapshot_t snapshot = {0};
+    changes_t changes = rescan(&snapshot);
+    CHECK_EQ_INT(changes.added, 4);
+    CHECK_EQ_INT(snapshot.count, 4);
+    CHECK(!strcmp(snapshot.entries[0].name, "a.jar"));
+    CHECK_EQ_INT(dir_snapshot_find(&snapshot, "b.jar")->size, 2);
+    CHECK(dir_snapshot_find(&snapshot, "config")->isDirectory);
+    CHECK(dir_snapshot_find(&snapshot, "dangling") != NULL);
+    CHECK(dir_snapshot_find(&snapshot, "c.jar") == NULL);
+
+    // Nothing changed, nothing reported
+    changes = rescan(&snapshot);
+    CHECK_EQ_INT(changes.added + changes.removed + changes.modified, 0);
+
+    // Rewritten in place within the same second: same name, inode and size
+    struct stat st;
+    stat(entry_path("a.jar"), &st);
+    write_file("a.jar", "A");
+    struct timespec times[2] = {st.st_atim, {st.st_mtim.tv_sec, (st.st_mtim.tv_nsec + 1) % 1000000000}};
+    utimensat(AT_FDCWD, entry_path("a.jar"), times, 0);
+    changes = rescan(&snapshot);
+    CHECK_EQ_INT(changes.modified, 1);
+    CHECK(!strcmp(changes.lastName, "a.jar"));
+
+    // Grown in place
+    write_file("b.jar", "bbbb");
+    changes = rescan(&snapshot);
+    CHECK_EQ_INT(changes.modified, 1);
+    CHECK_EQ_INT(dir_snapshot_find(&snapshot, "b.jar")->size, 4);
+
+    unlink(entry_path("b.jar"));
+    write_file("c.jar", "c");
+    changes = rescan(&snapshot);
+    CHECK_EQ_INT(changes.added, 1);
+    CHECK_EQ_INT(changes.removed, 1);
+    CHECK_EQ_INT(changes.modified, 0);
+    dir_snapshot_free(&snapshot);
+
+    dir_snapshot_t missing;
+    CHECK_EQ_INT(dir_snapshot_scan(entry_path("nope"), NULL, &missing), ENOENT);
+    CHECK_EQ_INT(missing.count, 0);
+}
+
+static void test_watch(void) {
+    mkdir(entry_path("mods"), 0755);
+    dir_watch_t *watch = dir_watch_open(entry_path("mods"));
+    CHECK(watch != NULL);
+    if (!watch) return;
+    CHECK_EQ_INT(dir_watch_read(watch), 0);
+
+    write_file("mods/sodium.jar", "s");
+    CHECK(wait_for_events(watch) & DIR_WATCH_CHANGED);
+    // Drained, nothing left pending
+    CHECK_EQ_INT(dir_watch_read(watch), 0);
+
+    rename(entry_path("mods/sodium.jar"), entry_path("mods/sodium.jar.disabled"));
+    CHECK_EQ_INT(wait_for_events(watch), DIR_WATCH_CHANGED);
+
+    unlink(entry_path("mods/sodium.jar.disabled"));
+    rmdir(entry_path("mods"));
+    CHECK(wait_for_events(watch) & DIR_WATCH_GONE);
+    // Silent once gone, even if the directory comes back
+    mkdir(entry_path("mods"), 0755);
+    write_file("mods/lithium.jar", "l");
+    CHECK_EQ_INT(dir_watch_read(watch), 0);
+    dir_watch_close(watch);
+
+    // A moved directory is gone as well
+    watch = dir_watch_open(entry_path("mods"));
+    rename(entry_path("mods"), entry_path("mods.old"));
+    CHECK(wait_for_events(watch) & DIR_WATCH_GONE);
+    write_file("mods.old/phosphor.jar", "p");
+    CHECK_EQ_INT(dir_watch_read(watch), 0);
+    dir_watch_close(watch);
+
+    errno = 0;
+    CHECK(dir_watch_open(entry_path("mods")) == NULL);
+    CHECK_EQ_INT(errno, ENOENT);
+    CHECK(dir_watch_open(entry_path("mods.old/phosphor.jar")) == NULL);
+
+    // Opening and closing many watches doesn't leak descriptors
+    int before = dup(0);
+    close(before);
+    for (int i = 0; i < 2000; i++) {
+        dir_watch_close(dir_watch_open(dir));
+    }
+    int after = dup(0);
+    close(after);
+    CHECK_EQ_INT(after, before);
+}
+
+int main(void) {
+    char *temp = fixture_temp_dir("dir_snapshot");
+    strcpy(dir, temp);
+    free(temp);
+
+    test_snapshot();
+    test_watch();
+
+    fixture_remove_tree(dir);
+    return TEST_RESULT();
+}
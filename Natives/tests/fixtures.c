@@ -0,0 +1,217 @@
+#include <dirent.h>
+#include <fcntl.h>
+#include <lzma.h>
+#include <mach-o/fat.h>
+#include <mach-o/loader.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fixtures.h"
+
+#define TAR_BLOCK 512
+
+static void tar_put_octal(char *field, size_t size, uint64_t value) {
+    snprintf(field, size, "%0*llo", (int)size - 1, (unsigned long long)value);
+}
+
+static bool xz_append(lzma_stream *strm, FILE *out, const void *data, size_t size, lzma_action action) {
+    uint8_t buffer[64 * 1024];
+    if (size == 0 && action == LZMA_RUN) return true;
+    strm->next_in = data;
+    strm->avail_in = size;
+    while (true) {
+        strm->next_out = buffer;
+        strm->avail_out = sizeof(buffer);
+        lzma_ret ret = lzma_code(strm, action);
+        fwrite(buffer, 1, sizeof(buffer) - strm->avail_out, out);
+        if (ret == LZMA_STREAM_END) return true;
+        if (ret != LZMA_OK) return false;
+        if (strm->avail_in == 0 && strm->avail_out != 0 && action == LZMA_RUN) return true;
+    }
+}
+
+bool fixture_write_tar_xz(const char *path, const fixture_tar_entry_t *entries, int count) {
+    FILE *out = fopen(path, "wb");
+    if (!out) return false;
+    lzma_stream strm = LZMA_STREAM_INIT;
+    if (lzma_easy_encoder(&strm, 1, LZMA_CHECK_CRC64) != LZMA_OK) {
+        fclose(out);
+        return false;
+    }
+
+    bool ok = true;
+    static const uint8_t zeros[TAR_BLOCK * 2];
+    for (int i = 0; i < count && ok; i++) {
+        const fixture_tar_entry_t *entry = &entries[i];
+        char header[TAR_BLOCK] = {0};
+        size_t nameLength = strlen(entry->name);
+        if (nameLength > 100) {
+            // Split into the ustar prefix and name fields
+            const char *slash = strchr(entry->name + nameLength - 100, '/');
+            memcpy(header + 345, entry->name, slash - entry->name);
+            strncpy(header, slash + 1, 100);
+        } else {
+            memcpy(header, entry->name, nameLength);
+        }
+        tar_put_octal(header + 100, 8, entry->type == '5' ? 0755 : 0644);
+        tar_put_octal(header + 108, 8, 0);
+        tar_put_octal(header + 116, 8, 0);
+        tar_put_octal(header + 124, 12, entry->type == '0' ? entry->size : 0);
+        tar_put_octal(header + 136, 12, 0);
+        header[156] = entry->type;
+        if (entry->linkname) strncpy(header + 157, entry->linkname, 100);
+        memcpy(header + 257, "ustar", 6);
+        memcpy(header + 263, "00", 2);
+        memset(header + 148, ' ', 8);
+        unsigned checksum = 0;
+        for (int j = 0; j < TAR_BLOCK; j++) checksum += (uint8_t)header[j];
+        snprintf(header + 148, 8, "%06o", checksum);
+
+        ok = xz_append(&strm, out, header, TAR_BLOCK, LZMA_RUN);
+        if (ok && entry->type == '0' && entry->size) {
+            ok = xz_append(&strm, out, entry->data, entry->size, LZMA_RUN) &&
+                xz_append(&strm, out, zeros, (TAR_BLOCK - entry->size % TAR_BLOCK) % TAR_BLOCK, LZMA_RUN);
+        }
+    }
+    ok = ok && xz_append(&strm, out, zeros, sizeof(zeros), LZMA_FINISH);
+    lzma_end(&strm);
+    return fclose(out) == 0 && ok;
+}
+
+bool fixture_write_macho(const char *path, uint32_t platform, const char *dependency, bool fat) {
+    uint8_t commands[256] = {0};
+    struct build_version_command *build = (void *)commands;
+    build->cmd = LC_BUILD_VERSION;
+    build->cmdsize = sizeof(*build);
+    build->platform = platform;
+    struct dylib_command *dylib = (void *)(commands + sizeof(*build));
+    size_t dylibSize = (sizeof(*dylib) + strlen(dependency) + 1 + 7) & ~7;
+    dylib->cmd = LC_LOAD_DYLIB;
+    dylib->cmdsize = dylibSize;
+    dylib->dylib.name.offset = sizeof(*dylib);
+    strcpy((char *)dylib + sizeof(*dylib), dependency);
+
+    struct mach_header_64 header = {
+        .magic = MH_MAGIC_64,
+        .cputype = CPU_TYPE_ARM64,
+        .filetype = MH_DYLIB,
+        .ncmds = 2,
+        .sizeofcmds = sizeof(*build) + dylibSize
+    };
+
+    FILE *out = fopen(path, "wb");
+    if (!out) return false;
+    uint32_t sliceOffset = 0;
+    if (fat) {
+        // One arm64 slice, page aligned like real fat files
+        sliceOffset = 0x4000;
+        struct fat_header fatHeader = {__builtin_bswap32(FAT_MAGIC), __builtin_bswap32(1)};
+        struct fat_arch arch = {
+            .cputype = (cpu_type_t)__builtin_bswap32(CPU_TYPE_ARM64),
+            .offset = __builtin_bswap32(sliceOffset),
+            .size = __builtin_bswap32(sizeof(header) + header.sizeofcmds),
+            .align = __builtin_bswap32(14)
+        };
+        fwrite(&fatHeader, sizeof(fatHeader), 1, out);
+        fwrite(&arch, sizeof(arch), 1, out);
+        fseek(out, sliceOffset, SEEK_SET);
+    }
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(commands, header.sizeofcmds, 1, out);
+    // Some code after the headers, which patching must not touch
+    uint8_t text[4096];
+    memset(text, 0xd5, sizeof(text));
+    fwrite(text, sizeof(text), 1, out);
+    return fclose(out) == 0;
+}
+
+void fixture_asset_hash(int i, char hex[41]) {
+    // Spread like real SHA-1s, so sorting by hash shuffles the names
+    uint64_t x = (uint64_t)i * 0x9E3779B97F4A7C15ull + 1;
+    for (int j = 0; j < 40; j++) {
+        x ^= x >> 29;
+        x *= 0xBF58476D1CE4E5B9ull;
+        hex[j] = "0123456789abcdef"[x >> 60];
+    }
+    hex[40] = '\0';
+}
+
+bool fixture_write_asset_index(const char *path, int count) {
+    FILE *file = fopen(path, "w");
+    if (!file) return false;
+    fputs("{\"objects\": {", file);
+    for (int i = 0; i < count; i++) {
+        char hex[41];
+        fixture_asset_hash(i, hex);
+        fprintf(file, "%s\n    \"minecraft/sounds/block/%d/step%d.ogg\": {\n      \"hash\": \"%s\",\n      \"size\": %d\n    }",
+            i ? "," : "", i / 100, i % 100, hex, 1000 + i);
+    }
+    fputs("\n  }\n}\n", file);
+    return fclose(file) == 0;
+}
+
+char *fixture_read(const char *name, size_t *length) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s", FIXTURE_DIR, name);
+    char *data = fixture_read_path(path, length);
+    if (!data) {
+        fprintf(stderr, "Missing fixture %s\n", path);
+    }
+    return data;
+}
+
+char *fixture_read_path(const char *path, size_t *length) {
+    FILE *in = fopen(path, "rb");
+    if (!in) {
+        return NULL;
+    }
+    fseek(in, 0, SEEK_END);
+    long size = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    char *data = malloc(size + 1);
+    size_t read = fread(data, 1, size, in);
+    data[read] = '\0';
+    fclose(in);
+    if (length) *length = read;
+    return data;
+}
+
+char *fixture_temp_dir(const char *prefix) {
+    const char *tmp = getenv("TMPDIR");
+    char *path = malloc(4096);
+    snprintf(path, 4096, "%s/%s.XXXXXX", tmp && tmp[0] ? tmp : "/tmp", prefix);
+    if (!mkdtemp(path)) {
+        free(path);
+        return NULL;
+    }
+    return path;
+}
+
+void fixture_remove_tree(const char *path) {
+    struct stat st;
+    if (lstat(path, &st) != 0) return;
+    if (S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(path);
+        struct dirent *entry;
+        while (dir && (entry = readdir(dir))) {
+            if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..")) continue;
+            char child[4096];
+            snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+            fixture_remove_tree(child);
+        }
+        if (dir) closedir(dir);
+        rmdir(path);
+    } else {
+        unlink(path);
+    }
+}
+
+double fixture_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
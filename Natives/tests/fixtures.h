@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Reproducible inputs for the host tests and benchmarks. Text fixtures live
+// in FIXTURE_DIR; binary ones (archives, Mach-O files) are generated here so
+// each test can also build the malformed variants it needs.
+
+typedef struct {
+    const char *name;
+    char type;            // tar typeflag: '0' file, '2' symlink, '5' directory
+    const char *linkname; // symlink target
+    const void *data;
+    size_t size;
+} fixture_tar_entry_t;
+
+// Writes a ustar archive of the entries, xz-compressed
+bool fixture_write_tar_xz(const char *path, const fixture_tar_entry_t *entries, int count);
+
+// Writes an arm64 dylib header with an LC_BUILD_VERSION for platform and an
+// LC_LOAD_DYLIB of dependency, optionally inside a fat file
+bool fixture_write_macho(const char *path, uint32_t platform, const char *dependency, bool fat);
+
+// Writes an asset index shaped like Mojang's: count objects named
+// minecraft/sounds/block/<i / 100>/step<i % 100>.ogg, each of size 1000 + i
+// and hash fixture_asset_hash(i)
+bool fixture_write_asset_index(const char *path, int count);
+void fixture_asset_hash(int i, char hex[41]);
+
+// Reads FIXTURE_DIR/name, NUL-terminated; free() the result
+char *fixture_read(const char *name, size_t *length);
+// Same for any file, NULL if it can't be read
+char *fixture_read_path(const char *path, size_t *length);
+
+// A fresh empty directory under the system temp dir; free() the result
+char *fixture_temp_dir(const char *prefix);
+// rm -rf
+void fixture_remove_tree(const char *path);
+
+double fixture_now(void);
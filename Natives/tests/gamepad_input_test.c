@@ -0,0 +1,249 @@
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "glfw_keycodes.h"
+#include "input/gamepad_input.h"
+#include "test.h"
+
+// The button table and the stick poller against recording callbacks. The
+// poller thread test reads sticks from a fake controller that a test can
+// move or disconnect.
+
+static const int wasd[] = {GLFW_KEY_W, GLFW_KEY_A, GLFW_KEY_S, GLFW_KEY_D};
+// Mouse buttons are mapped as negative keycodes, see SPECIALBTN_* in utils.h
+#define MOUSE_PRIMARY -3
+#define MOUSE_SECONDARY -4
+
+typedef struct {
+    // Pressed state of W, A, S, D and how often each changed
+    atomic_bool held[4];
+    atomic_int changes[4];
+    // Bogus events: a key outside WASD, a release of a key not held
+    atomic_int unexpected;
+    double lookX, lookY;
+    int looks;
+
+    // The fake controller
+    gamepad_sticks_t sticks;
+    atomic_bool grabbing, connected;
+    atomic_int polls;
+} recorder_t;
+
+static int wasd_index(int key) {
+    for (int i = 0; i < 4; i++) {
+        if (wasd[i] == key) return i;
+    }
+    return -1;
+}
+
+static void record_key(void *context, int key, bool pressed) {
+    recorder_t *recorder = context;
+    int i = wasd_index(key);
+    if (i < 0 || atomic_load(&recorder->held[i]) == pressed) {
+        atomic_fetch_add(&recorder->unexpected, 1);
+        return;
+    }
+    atomic_store(&recorder->held[i], pressed);
+    atomic_fetch_add(&recorder->changes[i], 1);
+}
+
+static void record_look(void *context, double dx, double dy) {
+    recorder_t *recorder = context;
+    recorder->lookX += dx;
+    recorder->lookY += dy;
+    recorder->looks++;
+}
+
+static bool read_fake(void *context, gamepad_sticks_t *sticks, bool *grabbing) {
+    recorder_t *recorder = context;
+    atomic_fetch_add(&recorder->polls, 1);
+    *sticks = recorder->sticks;
+    *grabbing = atomic_load(&recorder->grabbing);
+    return atomic_load(&recorder->connected);
+}
+
+static int held_mask(recorder_t *recorder) {
+    int mask = 0;
+    for (int i = 0; i < 4; i++) mask |= atomic_load(&recorder->held[i]) << i;
+    return mask;
+}
+
+static void test_map(void) {
+    gamepad_map_t map;
+    memset(&map, 0x55, sizeof(map));
+    gamepad_map_init(&map);
+    for (int layer = 0; layer < 2; layer++) {
+        for (int button = 0; button <= GLFW_GAMEPAD_BUTTON_LAST; button++) {
+            CHECK_EQ_INT(gamepad_map_lookup(&map, layer, button), GLFW_KEY_UNKNOWN);
+        }
+        CHECK_EQ_INT(gamepad_map_lookup(&map, layer, GLFW_GAMEPAD_BUTTON_LEFT_TRIGGER), GLFW_KEY_UNKNOWN);
+        CHECK_EQ_INT(gamepad_map_lookup(&map, layer, GLFW_GAMEPAD_BUTTON_RIGHT_TRIGGER), GLFW_KEY_UNKNOWN);
+    }
+
+    // Later entries for the same button win, like the lists were read before
+    CHECK(gamepad_map_set(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_A, GLFW_KEY_SPACE));
+    CHECK(gamepad_map_set(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_A, GLFW_KEY_E));
+    CHECK_EQ_INT(gamepad_map_lookup(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_A), GLFW_KEY_E);
+    // Layers are separate
+    CHECK_EQ_INT(gamepad_map_lookup(&map, GAMEPAD_LAYER_MENU, GLFW_GAMEPAD_BUTTON_A), GLFW_KEY_UNKNOWN);
+    CHECK(gamepad_map_set(&map, GAMEPAD_LAYER_MENU, GLFW_GAMEPAD_BUTTON_A, MOUSE_PRIMARY));
+    CHECK_EQ_INT(gamepad_map_lookup(&map, GAMEPAD_LAYER_MENU, GLFW_GAMEPAD_BUTTON_A), MOUSE_PRIMARY);
+    CHECK_EQ_INT(gamepad_map_lookup(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_A), GLFW_KEY_E);
+
+    // Triggers are numbered past the keyboard keys but get slots of their own
+    CHECK(gamepad_map_set(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_LEFT_TRIGGER, MOUSE_SECONDARY));
+    CHECK(gamepad_map_set(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_RIGHT_TRIGGER, MOUSE_PRIMARY));
+    CHECK(gamepad_map_set(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_DPAD_LEFT, GLFW_KEY_Q));
+    CHECK_EQ_INT(gamepad_map_lookup(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_LEFT_TRIGGER), MOUSE_SECONDARY);
+    CHECK_EQ_INT(gamepad_map_lookup(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_RIGHT_TRIGGER), MOUSE_PRIMARY);
+    CHECK_EQ_INT(gamepad_map_lookup(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_DPAD_LEFT), GLFW_KEY_Q);
+    CHECK_EQ_INT(gamepad_map_lookup(&map, GAMEPAD_LAYER_MENU, GLFW_GAMEPAD_BUTTON_RIGHT_TRIGGER), GLFW_KEY_UNKNOWN);
+    // The toggle for sneaking is stored negated
+    CHECK(gamepad_map_set(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_RIGHT_THUMB, -GLFW_KEY_LEFT_SHIFT));
+    CHECK_EQ_INT(gamepad_map_lookup(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_RIGHT_THUMB), -GLFW_KEY_LEFT_SHIFT);
+
+    // Buttons and layers that don't exist are refused and read as unmapped
+    CHECK(!gamepad_map_set(&map, GAMEPAD_LAYER_GAME, -1, GLFW_KEY_E));
+    CHECK(!gamepad_map_set(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_LAST + 1, GLFW_KEY_E));
+    CHECK(!gamepad_map_set(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_RIGHT_TRIGGER + 1, GLFW_KEY_E));
+    CHECK(!gamepad_map_set(&map, 2, GLFW_GAMEPAD_BUTTON_A, GLFW_KEY_E));
+    CHECK(!gamepad_map_set(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_A, 40000));
+    CHECK_EQ_INT(gamepad_map_lookup(&map, GAMEPAD_LAYER_GAME, GLFW_GAMEPAD_BUTTON_LAST + 1), GLFW_KEY_UNKNOWN);
+    CHECK_EQ_INT(gamepad_map_lookup(&map, GAMEPAD_LAYER_GAME, 12345), GLFW_KEY_UNKNOWN);
+}
+
+// The keys ControllerInput held for each direction before the poller existed
+static int legacy_direction_keys(int direction) {
+    int mask = 0;
+    if (direction >= 1 && direction <= 3) mask |= 1;                      // W
+    if (direction >= 3 && direction <= 5) mask |= 2;                      // A
+    if (direction >= 5 && direction <= 7) mask |= 4;                      // S
+    if (direction == 7 || direction == 0 || direction == 1) mask |= 8;    // D
+    return mask;
+}
+
+static void test_directions(void) {
+    // Stick up is positive y, as the controller framework reports it
+    CHECK_EQ_INT(gamepad_stick_direction(1, 0), 0);
+    CHECK_EQ_INT(gamepad_stick_direction(0, 1), 2);
+    CHECK_EQ_INT(gamepad_stick_direction(-1, 0), 4);
+    CHECK_EQ_INT(gamepad_stick_direction(0, -1), 6);
+    CHECK_EQ_INT(gamepad_stick_direction(0.7f, 0.7f), 1);
+    CHECK_EQ_INT(gamepad_stick_direction(0.7f, -0.7f), 7);
+    CHECK_EQ_INT(gamepad_stick_direction(0, 0), -1);
+    // Just below east wraps to east, not to south east
+    CHECK_EQ_INT(gamepad_stick_direction(1, -0.1f), 0);
+
+    recorder_t recorder = {0};
+    gamepad_poller_t poller = {.callbacks = {&recorder, read_fake, record_key, record_look}, .direction = -1};
+    const struct { float x, y; int mask; } cardinal[] = {
+        {0, 1, 1},  // north: W
+        {-1, 0, 2}, // west: A
+        {0, -1, 4}, // south: S
+        {1, 0, 8}   // east: D
+    };
+    for (int i = 0; i < 4; i++) {
+        gamepad_sticks_t sticks = {.leftX = cardinal[i].x, .leftY = cardinal[i].y};
+        gamepad_poller_step(&poller, &sticks, true, 0.004);
+        CHECK_EQ_INT(held_mask(&recorder), cardinal[i].mask);
+    }
+
+    // Every direction around the circle, by angle, holds what it used to
+    for (int step = 0; step < 64; step++) {
+        double angle = step * 2 * M_PI / 64;
+        gamepad_sticks_t sticks = {.leftX = (float)cos(angle), .leftY = (float)sin(angle)};
+        int direction = gamepad_stick_direction(sticks.leftX, sticks.leftY);
+        gamepad_poller_step(&poller, &sticks, true, 0.004);
+        if (held_mask(&recorder) != legacy_direction_keys(direction)) {
+            fprintf(stderr, "angle %d/64: direction %d holds %x, used to hold %x\n",
+                step, direction, held_mask(&recorder), legacy_direction_keys(direction));
+            CHECK(false);
+        }
+    }
+    // Releasing the stick lets go of everything
+    gamepad_sticks_t centered = {0};
+    gamepad_poller_step(&poller, &centered, true, 0.004);
+    CHECK_EQ_INT(held_mask(&recorder), 0);
+    CHECK_EQ_INT(atomic_load(&recorder.unexpected), 0);
+
+    // Staying in one direction doesn't repeat the key
+    gamepad_sticks_t north = {.leftY = 1};
+    for (int i = 0; i < 10; i++) gamepad_poller_step(&poller, &north, true, 0.004);
+    int changes = atomic_load(&recorder.changes[0]);
+    gamepad_poller_step(&poller, &north, true, 0.004);
+    CHECK_EQ_INT(atomic_load(&recorder.changes[0]), changes);
+}
+
+static void test_ungrab(void) {
+    recorder_t recorder = {0};
+    gamepad_poller_t poller = {.callbacks = {&recorder, read_fake, record_key, record_look}, .direction = -1};
+
+    // Holding north east while a menu opens
+    gamepad_sticks_t sticks = {.leftX = 0.7f, .leftY = 0.7f, .rightX = 0.5f};
+    gamepad_poller_step(&poller, &sticks, true, 1 / 60.0);
+    CHECK_EQ_INT(held_mask(&recorder), 1 | 8);
+    CHECK_EQ_INT(recorder.looks, 1);
+    gamepad_poller_step(&poller, &sticks, false, 1 / 60.0);
+    CHECK_EQ_INT(held_mask(&recorder), 0);
+    // Neither the camera moves nor keys come back while the menu is open
+    gamepad_poller_step(&poller, &sticks, false, 1 / 60.0);
+    CHECK_EQ_INT(held_mask(&recorder), 0);
+    CHECK_EQ_INT(recorder.looks, 1);
+    // Back in game the held direction applies again
+    gamepad_poller_step(&poller, &sticks, true, 1 / 60.0);
+    CHECK_EQ_INT(held_mask(&recorder), 1 | 8);
+    CHECK_EQ_INT(atomic_load(&recorder.unexpected), 0);
+
+    // Camera motion follows the time between polls, not the number of them
+    recorder_t fast = {0}, slow = {0};
+    gamepad_poller_t fastPoller = {.callbacks = {&fast, read_fake, record_key, record_look}, .direction = -1};
+    gamepad_poller_t slowPoller = {.callbacks = {&slow, read_fake, record_key, record_look}, .direction = -1};
+    gamepad_sticks_t look = {.rightX = 1, .rightY = 0.5f};
+    for (int i = 0; i < 250; i++) gamepad_poller_step(&fastPoller, &look, true, 1 / 250.0);
+    for (int i = 0; i < 60; i++) gamepad_poller_step(&slowPoller, &look, true, 1 / 60.0);
+    CHECK(fabs(fast.lookX - slow.lookX) < 1e-6 * fabs(slow.lookX));
+    CHECK(fabs(fast.lookY - slow.lookY) < 1e-6 * fabs(slow.lookY));
+    // Stick up looks up, which is negative y on screen
+    CHECK(slow.lookX > 0 && slow.lookY < 0);
+}
+
+static void test_thread(void) {
+    recorder_t recorder = {0};
+    atomic_store(&recorder.connected, true);
+    atomic_store(&recorder.grabbing, true);
+    recorder.sticks.leftY = 1;
+    gamepad_poller_t poller = {0};
+    gamepad_poller_callbacks_t callbacks = {&recorder, read_fake, record_key, record_look};
+    CHECK(!gamepad_poller_start(&poller, 0, &callbacks));
+    CHECK(gamepad_poller_start(&poller, 250, &callbacks));
+    CHECK(!gamepad_poller_start(&poller, 250, &callbacks));
+    usleep(100000);
+    CHECK(atomic_load(&recorder.held[0]));
+    // About 25 polls in 100 ms
+    int polls = atomic_load(&recorder.polls);
+    CHECK(polls >= 10 && polls <= 30);
+
+    // A controller that goes away lets go of its keys
+    atomic_store(&recorder.connected, false);
+    usleep(20000);
+    CHECK_EQ_INT(held_mask(&recorder), 0);
+    atomic_store(&recorder.connected, true);
+    usleep(20000);
+    CHECK(atomic_load(&recorder.held[0]));
+
+    // So does stopping the poller
+    gamepad_poller_stop(&poller);
+    CHECK_EQ_INT(held_mask(&recorder), 0);
+    gamepad_poller_stop(&poller);
+    CHECK_EQ_INT(atomic_load(&recorder.unexpected), 0);
+}
+
+int main(void) {
+    test_map();
+    test_directions();
+    test_ungrab();
+    test_thread();
+    return TEST_RESULT();
+}
@@ -0,0 +1,134 @@
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "fixtures.h"
+#include "gc_log.h"
+#include "test.h"
+
+static char dir[PATH_MAX];
+
+static const char *temp_path(const char *name) {
+    static char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    return path;
+}
+
+static void write_file(const char *name, const char *content) {
+    FILE *file = fopen(temp_path(name), "w");
+    fputs(content, file);
+    fclose(file);
+}
+
+// A runtime directory with only the release file
+static const char *java_home(const char *name, const char *release) {
+    char releaseName[PATH_MAX];
+    mkdir(temp_path(name), 0755);
+    snprintf(releaseName, sizeof(releaseName), "%s/release", name);
+    write_file(releaseName, release);
+    return temp_path(name);
+}
+
+static bool near(double value, double expected) {
+    return fabs(value - expected) < 0.01;
+}
+
+// The flags the launcher passes for the runtime in javaHome
+static int flags_for(const char *javaHome, const char **argv) {
+    int argc = 0;
+    gclog_append_flags("/tmp/gc.log", gclog_java_version(javaHome), &argc, argv);
+    return argc;
+}
+
+int main(void) {
+    char *temp = fixture_temp_dir("gc_log");
+    strcpy(dir, temp);
+    free(temp);
+
+    // Versions come from the release file, not the minimum the game asked for
+    CHECK_EQ_INT(gclog_java_version(java_home("jre8", "IMPLEMENTOR=\"Azul Systems, Inc.\"\nJAVA_VERSION=\"1.8.0_392\"\n")), 8);
+    CHECK_EQ_INT(gclog_java_version(java_home("jre17", "JAVA_VERSION_DATE=\"2023-07-18\"\nJAVA_VERSION=\"17.0.8\"\n")), 17);
+    CHECK_EQ_INT(gclog_java_version(java_home("jre21", "JAVA_VERSION=\"21\"\r\n")), 21);
+    CHECK_EQ_INT(gclog_java_version(java_home("broken", "JAVA_VERSION=\"\"\n")), 0);
+    CHECK_EQ_INT(gclog_java_version(temp_path("missing")), 0);
+
+    // Java 8 gets -Xloggc, anything newer only unified logging since it rejects the Java 8 flags
+    const char *argv[8] = {0};
+    CHECK_EQ_INT(flags_for(temp_path("jre8"), argv), 2);
+    CHECK(!strcmp(argv[1], "-Xloggc:/tmp/gc.log"));
+    CHECK(!strcmp(argv[2], "-XX:+PrintGCApplicationStoppedTime"));
+    for (int i = 0; i < 2; i++) {
+        const char *home = temp_path(i ? "jre21" : "jre17");
+        memset(argv, 0, sizeof(argv));
+        CHECK_EQ_INT(flags_for(home, argv), 1);
+        CHECK(!strncmp(argv[1], "-Xlog:gc*,safepoint:file=\"/tmp/gc.log\"", 38));
+        CHECK(!strstr(argv[1], "PrintGC"));
+    }
+
+    // Logging the user already configured is left alone
+    CHECK(!gclog_args_set_logging(NULL));
+    CHECK(!gclog_args_set_logging(" -XX:+UseZGC -Dfoo=bar"));
+    CHECK(gclog_args_set_logging(" -XX:+UseZGC -Xlog:gc:file=gc.txt"));
+    CHECK(gclog_args_set_logging("-Xloggc:gc.txt"));
+    CHECK(gclog_args_set_logging("-verbose:gc"));
+    CHECK(gclog_args_set_logging("-XX:+PrintGCDetails"));
+
+    // Unified logging, with padded tags and a JDK 13+ safepoint line
+    write_file("gc17.log",
+        "[0.012s][info][gc          ] Using G1\n"
+        "[1.000s][info][gc          ] GC(0) Pause Young (Normal) (G1 Evacuation Pause) 24M->4M(256M) 3.000ms\n"
+        "[1.001s][info][safepoint   ] Safepoint \"G1CollectForAllocation\", Time since last: 1000 ns, Reaching safepoint: 200000 ns, At safepoint: 3000000 ns, Total: 3200000 ns\n"
+        "[1.500s][info][gc,heap     ] GC(1) Eden regions: 10->0(12)\n"
+        "[2.000s][info][gc          ] GC(1) Pause Young (Normal) (G1 Evacuation Pause) 40M->6M(256M) 5.000ms\n"
+        "[3.000s][info][gc          ] GC(2) Pause Full (System.gc()) 30M->5M(512M) 20.000ms\n"
+        "[4.500s][info][gc,stringtable] Cleaned string table\n");
+    gclog_stats_t stats;
+    CHECK(gclog_parse(temp_path("gc17.log"), &stats));
+    CHECK_EQ_INT(stats.pauseCount, 3);
+    CHECK_EQ_INT(stats.fullPauseCount, 1);
+    CHECK(near(stats.pauseTotalMs, 28));
+    CHECK(near(stats.pauseP50Ms, 5));
+    CHECK(near(stats.pauseMaxMs, 20));
+    CHECK(near(stats.uptimeSec, 4.5));
+    // 36M grown before GC(1) and 24M before GC(2), over the 2s between the first and last
+    CHECK(near(stats.allocRateMBps, 30));
+    CHECK(near(stats.heapAfterMaxMB, 6));
+    CHECK(near(stats.heapCapacityMaxMB, 512));
+    CHECK_EQ_INT(stats.safepointCount, 1);
+    CHECK(near(stats.ttspMaxMs, 0.2));
+
+    // Java 8 with a ',' decimal separator from the process locale
+    write_file("gc8.log",
+        "1,000: [GC (Allocation Failure)  24576K->4096K(262144K), 0,0040 secs]\n"
+        "1,004: Total time for which application threads were stopped: 0,0045 secs, Stopping threads took: 0,0005 secs\n"
+        "2,000: [Full GC (Ergonomics)  20480K->2048K(262144K), 0,0300 secs]\n");
+    CHECK(gclog_parse(temp_path("gc8.log"), &stats));
+    CHECK_EQ_INT(stats.pauseCount, 2);
+    CHECK_EQ_INT(stats.fullPauseCount, 1);
+    CHECK(near(stats.pauseTotalMs, 34));
+    CHECK(near(stats.heapCapacityMaxMB, 256));
+    CHECK_EQ_INT(stats.safepointCount, 1);
+    CHECK(near(stats.ttspMaxMs, 0.5));
+
+    // Nothing to summarize
+    write_file("empty.log", "[0.012s][info][gc] Using G1\n");
+    CHECK(!gclog_parse(temp_path("empty.log"), &stats));
+    CHECK(!gclog_parse(temp_path("missing.log"), &stats));
+
+    // Sessions are appended one per line
+    CHECK(gclog_parse(temp_path("gc17.log"), &stats));
+    CHECK(gclog_append_session(temp_path("gc_stats.jsonl"), &stats, 1700000000));
+    CHECK(gclog_append_session(temp_path("gc_stats.jsonl"), &stats, 1700000100));
+    size_t length;
+    char *text = fixture_read_path(temp_path("gc_stats.jsonl"), &length);
+    int lines = 0;
+    for (size_t i = 0; text && i < length; i++) lines += text[i] == '\n';
+    CHECK_EQ_INT(lines, 2);
+    CHECK(text && strstr(text, "{\"time\":1700000000,") == text);
+    CHECK(text && strstr(text, "\"pauseCount\":3,\"fullPauseCount\":1,"));
+    free(text);
+
+    fixture_remove_tree(dir);
+    return TEST_RESULT();
+}
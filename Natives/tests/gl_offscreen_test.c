@@ -0,0 +1,140 @@
+#include <pthread.h>
+#include <semaphore.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "ctxbridges/gl_offscreen.h"
+#include "test.h"
+
+// Worker contexts the way mods use them, on Mesa's surfaceless platform:
+// shared with the game's context, made current on a worker thread and
+// destroyed by the game while still current there.
+
+static EGLDisplay display;
+static egl_library egl;
+
+static gl_render_window_t *worker;
+static sem_t workerCurrent, workerDestroyed;
+static bool stillCurrent, released;
+
+static gl_render_window_t *create(EGLConfig config, gl_render_window_t *share, bool standalone) {
+    gl_render_window_t *bundle = calloc(1, sizeof(gl_render_window_t));
+    bundle->config = config;
+    bundle->offscreen = true;
+    bundle->standalone = standalone;
+    if (!gl_offscreen_create_context(bundle, share)) {
+        free(bundle);
+        return NULL;
+    }
+    return bundle;
+}
+
+static void *worker_main(void *arg) {
+    CHECK(gl_offscreen_make_current(worker, NULL));
+    sem_post(&workerCurrent);
+    sem_wait(&workerDestroyed);
+    // Destroyed meanwhile, yet the worker may finish its upload first
+    stillCurrent = eglGetCurrentContext() == worker->context && worker->destroyPending;
+    released = gl_offscreen_make_current(NULL, worker);
+    return NULL;
+}
+
+int main(void) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    display = getPlatformDisplay ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL) : EGL_NO_DISPLAY;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+        fprintf(stderr, "No Mesa surfaceless EGL, skipping\n");
+        return TEST_SKIPPED;
+    }
+    const EGLint attribs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT, EGL_NONE};
+    EGLConfig configs[2];
+    EGLint count = 0;
+    if (!eglChooseConfig(display, attribs, configs, 2, &count) || count == 0 || !eglBindAPI(EGL_OPENGL_ES_API)) {
+        fprintf(stderr, "No GLES 3 pbuffer config, skipping\n");
+        return TEST_SKIPPED;
+    }
+    egl.eglCreateContext = eglCreateContext;
+    egl.eglCreatePbufferSurface = eglCreatePbufferSurface;
+    egl.eglDestroyContext = eglDestroyContext;
+    egl.eglDestroySurface = eglDestroySurface;
+    egl.eglMakeCurrent = eglMakeCurrent;
+    // Without surfaceless contexts, like ANGLE on older iOS versions
+    gl_offscreen_init(&egl, display, false);
+
+    // The game's context, standalone like the renderer probe's
+    gl_render_window_t *game = create(configs[0], NULL, true);
+    CHECK(game && game->surface != EGL_NO_SURFACE);
+    if (!game) return TEST_RESULT();
+    CHECK(gl_offscreen_make_current(game, NULL));
+
+    // A worker shares it and is current on its own thread
+    worker = create(configs[0], game, false);
+    CHECK(worker && worker->surface != EGL_NO_SURFACE && worker->surface != game->surface);
+    if (!worker) return TEST_RESULT();
+    EGLSurface workerSurface = worker->surface;
+    sem_init(&workerCurrent, 0, 0);
+    sem_init(&workerDestroyed, 0, 0);
+    pthread_t thread;
+    pthread_create(&thread, NULL, worker_main, NULL);
+    sem_wait(&workerCurrent);
+    CHECK(worker->hasOwner);
+
+    // Destroyed by the game while current there: deferred to the worker thread
+    CHECK(!gl_offscreen_destroy(worker));
+    CHECK(eglGetCurrentContext() == game->context);
+    sem_post(&workerDestroyed);
+    pthread_join(thread, NULL);
+    CHECK(stillCurrent);
+    CHECK(released);
+
+    // The worker thread freed it, its pbuffer went back to the pool
+    gl_render_window_t *next = create(configs[0], game, false);
+    CHECK(next && next->surface == workerSurface);
+    // Not current anywhere, destroyed right away
+    CHECK(next && gl_offscreen_make_current(next, game));
+    CHECK(next && gl_offscreen_make_current(game, next));
+    CHECK(next && !next->hasOwner);
+    CHECK(next && gl_offscreen_destroy(next));
+
+    // Surfaces are only handed to contexts of the same config
+    if (count > 1) {
+        gl_render_window_t *other = create(configs[1], game, false);
+        CHECK(other && other->surface != workerSurface);
+        if (other) {
+            CHECK(gl_offscreen_make_current(other, game));
+            CHECK(gl_offscreen_make_current(game, other));
+            CHECK(gl_offscreen_destroy(other));
+        }
+    }
+    next = create(configs[0], game, false);
+    CHECK(next && next->surface == workerSurface);
+
+    // Five workers at once: four pbuffers come back, the oldest is dropped
+    gl_render_window_t *many[5];
+    EGLSurface surfaces[5];
+    many[0] = next;
+    for (int i = 1; i < 5; i++) many[i] = create(configs[0], game, false);
+    for (int i = 0; i < 5; i++) {
+        CHECK(many[i] != NULL);
+        surfaces[i] = many[i] ? many[i]->surface : EGL_NO_SURFACE;
+        if (many[i]) CHECK(gl_offscreen_destroy(many[i]));
+    }
+    int reused = 0;
+    for (int i = 0; i < 5; i++) {
+        many[i] = create(configs[0], game, false);
+        for (int j = 1; j < 5; j++) {
+            reused += many[i] && many[i]->surface == surfaces[j];
+        }
+    }
+    CHECK_EQ_INT(reused, 4);
+    for (int i = 0; i < 5; i++) {
+        if (many[i]) CHECK(gl_offscreen_destroy(many[i]));
+    }
+
+    CHECK(gl_offscreen_make_current(NULL, game));
+    CHECK(gl_offscreen_destroy(game));
+    gl_offscreen_terminate();
+    eglTerminate(display);
+    return TEST_RESULT();
+}
@@ -0,0 +1,97 @@
+#include <math.h>
+
+#include "input/gyro_integrator.h"
+#include "test.h"
+
+// Rates in rad/s at time t of a turn: still, then 2 rad/s for a second, then still
+static double turn_rate(double t) {
+    return t >= 0.5 && t < 1.5 ? 2 : 0;
+}
+
+// Feeds the turn at sampleHz and takes the rotation at frameHz, returns the total
+static double replay_turn(gyro_filter_t filter, double sampleHz, double frameHz) {
+    gyro_integrator_t gyro;
+    gyro_integrator_init(&gyro, filter);
+    double total = 0, nextFrame = 0, x, y;
+    int samples = (int)(2.5 * sampleHz);
+    for (int i = 0; i <= samples; i++) {
+        double t = i / sampleHz;
+        gyro_integrator_add_sample(&gyro, t, turn_rate(t), -turn_rate(t));
+        if (t >= nextFrame) {
+            gyro_integrator_take(&gyro, &x, &y);
+            CHECK(fabs(x + y) < 1e-9);
+            total += x;
+            nextFrame += 1 / frameHz;
+        }
+    }
+    gyro_integrator_take(&gyro, &x, &y);
+    return total + x;
+}
+
+static bool near(double value, double expected, double tolerance) {
+    if (fabs(value - expected) <= tolerance) return true;
+    fprintf(stderr, "%f is not %f +- %f\n", value, expected, tolerance);
+    return false;
+}
+
+int main(void) {
+    gyro_integrator_t gyro;
+    double x, y;
+
+    // Constant rate, integrated exactly between the first and the last sample
+    gyro_integrator_init(&gyro, (gyro_filter_t){0});
+    for (int i = 0; i <= 100; i++) {
+        gyro_integrator_add_sample(&gyro, 10 + i / 100.0, 1, -0.5);
+    }
+    gyro_integrator_take(&gyro, &x, &y);
+    CHECK(near(x, 1, 1e-9));
+    CHECK(near(y, -0.5, 1e-9));
+    // Taken once
+    gyro_integrator_take(&gyro, &x, &y);
+    CHECK(x == 0 && y == 0);
+
+    // The same turn ends at the same angle whatever the sample and frame rates
+    gyro_filter_t raw = {0}, smoothed = {.smoothing = 0.05};
+    CHECK(near(replay_turn(raw, 100, 60), 2, 0.02));
+    CHECK(near(replay_turn(raw, 1000, 30), 2, 0.002));
+    CHECK(near(replay_turn(raw, 100, 144), replay_turn(raw, 100, 20), 1e-9));
+    double slow = replay_turn(smoothed, 50, 60), fast = replay_turn(smoothed, 800, 60);
+    CHECK(near(slow, 2, 0.05));
+    CHECK(near(fast, 2, 0.01));
+    CHECK(near(slow, fast, 0.05));
+
+    // Rates inside the deadzone are no rotation, the rest starts from zero
+    gyro_integrator_init(&gyro, (gyro_filter_t){.deadzone = 0.1});
+    for (int i = 0; i <= 100; i++) {
+        gyro_integrator_add_sample(&gyro, i / 100.0, 0.05, i < 50 ? -0.08 : -1.1);
+    }
+    gyro_integrator_take(&gyro, &x, &y);
+    CHECK(near(x, 0, 1e-9));
+    // Half a second at -1.0 past the deadzone, plus half of the step's sample interval
+    CHECK(near(y, -0.5, 0.006));
+
+    // Sensor updates that stopped for a while don't make the camera jump
+    gyro_integrator_init(&gyro, (gyro_filter_t){0});
+    for (int i = 0; i <= 10; i++) {
+        gyro_integrator_add_sample(&gyro, i / 100.0, 1, 0);
+    }
+    gyro_integrator_add_sample(&gyro, 5, 1, 0);
+    gyro_integrator_add_sample(&gyro, 5.01, 1, 0);
+    gyro_integrator_take(&gyro, &x, &y);
+    CHECK(near(x, 0.11, 1e-9));
+    // Nor do timestamps going backwards
+    gyro_integrator_add_sample(&gyro, 4, 1, 0);
+    gyro_integrator_add_sample(&gyro, 4.01, 1, 0);
+    gyro_integrator_take(&gyro, &x, &y);
+    CHECK(near(x, 0.01, 1e-9));
+
+    // Reset drops whatever wasn't taken and starts over from the next sample
+    gyro_integrator_add_sample(&gyro, 4.02, 3, 3);
+    gyro_integrator_reset(&gyro);
+    gyro_integrator_add_sample(&gyro, 4.03, 1, 1);
+    gyro_integrator_take(&gyro, &x, &y);
+    CHECK(x == 0 && y == 0);
+    CHECK(gyro.filter.deadzone == 0);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,177 @@
+#include <string.h>
+#include <zlib.h>
+
+#include "icon_store.h"
+#include "test.h"
+
+// Icon naming and layout with synthetic PNGs: a profile's data URL and the
+// image file it came from must land on the same thumbnails.
+
+static void put_u32(uint8_t *p, uint32_t value) {
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+static size_t put_chunk(uint8_t *out, const char *type, const uint8_t *data, uint32_t length) {
+    put_u32(out, length);
+    memcpy(out + 4, type, 4);
+    if (length) memcpy(out + 8, data, length);
+    put_u32(out + 8 + length, (uint32_t)crc32(0, out + 4, 4 + length));
+    return 12 + length;
+}
+
+// An RGBA PNG filled with a gradient seeded by shade
+static uint8_t *make_png(uint32_t width, uint32_t height, uint8_t shade, size_t *length) {
+    size_t rawLength = (size_t)height * (1 + width * 4);
+    uint8_t *raw = malloc(rawLength);
+    for (uint32_t y = 0; y < height; y++) {
+        uint8_t *row = raw + y * (1 + width * 4);
+        row[0] = 0;
+        for (uint32_t x = 0; x < width * 4; x++) row[1 + x] = (uint8_t)(shade + x * 7 + y * 13);
+    }
+    uLongf idatLength = compressBound(rawLength);
+    uint8_t *idat = malloc(idatLength);
+    compress(idat, &idatLength, raw, rawLength);
+
+    uint8_t *png = malloc(8 + 25 + 12 + idatLength + 12);
+    memcpy(png, "\x89PNG\r\n\x1a\n", 8);
+    uint8_t ihdr[13] = {0};
+    put_u32(ihdr, width);
+    put_u32(ihdr + 4, height);
+    ihdr[8] = 8;
+    ihdr[9] = 6;
+    size_t offset = 8;
+    offset += put_chunk(png + offset, "IHDR", ihdr, 13);
+    offset += put_chunk(png + offset, "IDAT", idat, (uint32_t)idatLength);
+    offset += put_chunk(png + offset, "IEND", NULL, 0);
+    free(raw);
+    free(idat);
+    *length = offset;
+    return png;
+}
+
+static void test_paths(void) {
+    char path[4096];
+    const char *hash = "a9993e364706816aba3e25717850c26c9cd0d89d";
+    CHECK(icon_store_path("/var/mobile/icons", hash, 64, path, sizeof(path)));
+    CHECK(!strcmp(path, "/var/mobile/icons/a9/993e364706816aba3e25717850c26c9cd0d89d/64.png"));
+    CHECK(icon_store_path("/var/mobile/icons", hash, 128, path, sizeof(path)));
+    CHECK(!strcmp(path, "/var/mobile/icons/a9/993e364706816aba3e25717850c26c9cd0d89d/128.png"));
+    // Names that aren't hashes never reach the file system
+    CHECK(!icon_store_path("/icons", "a9993e", 64, path, sizeof(path)));
+    CHECK(!icon_store_path("/icons", hash, 64, path, 20));
+
+    char referenced[SHA1_HEX_LENGTH + 1];
+    CHECK(icon_store_reference_hash("iconstore:a9993e364706816aba3e25717850c26c9cd0d89d", referenced));
+    CHECK(!strcmp(referenced, hash));
+    CHECK(!icon_store_reference_hash("iconstore:a9993e", referenced));
+    CHECK(!icon_store_reference_hash("iconstore:A9993E364706816ABA3E25717850C26C9CD0D89D", referenced));
+    CHECK(!icon_store_reference_hash("iconstore:../../../../etc/passwd/a9993e364706816a", referenced));
+    CHECK(!icon_store_reference_hash("https://cdn.modrinth.com/icon.png", referenced));
+    CHECK(!icon_store_reference_hash(NULL, referenced));
+}
+
+static void test_base64(void) {
+    // The three ways a payload can end
+    const struct { const char *bytes, *url; } cases[] = {
+        {"Man", "data:image/png;base64,TWFu"},
+        {"Ma", "data:image/png;base64,TWE="},
+        {"M", "data:image/png;base64,TQ=="},
+        {"", "data:image/png;base64,"}
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+        char *url = icon_store_png_data_url((const uint8_t *)cases[i].bytes, strlen(cases[i].bytes));
+        CHECK(!strcmp(url, cases[i].url));
+        free(url);
+        size_t length;
+        uint8_t *bytes = icon_store_decode_data_url(cases[i].url, &length);
+        CHECK(bytes && length == strlen(cases[i].bytes) && !memcmp(bytes, cases[i].bytes, length));
+        free(bytes);
+    }
+
+    size_t length;
+    CHECK(icon_store_decode_data_url("https://example.com/icon.png", &length) == NULL);
+    CHECK(icon_store_decode_data_url("data:image/png,raw", &length) == NULL);
+    CHECK(icon_store_decode_data_url("data:image/png;base64,TWFuT", &length) == NULL);
+    CHECK(icon_store_decode_data_url(NULL, &length) == NULL);
+    char hash[SHA1_HEX_LENGTH + 1];
+    CHECK(!icon_store_data_url_hash("data:image/png;base64,", hash));
+}
+
+static void test_pngs(void) {
+    // Sizes picked so the PNGs end on every base64 boundary
+    const uint32_t sizes[][2] = {{1, 1}, {3, 2}, {16, 16}, {64, 64}, {5, 7}, {128, 1}};
+    bool residues[3] = {false};
+    char hashes[6][SHA1_HEX_LENGTH + 1];
+    for (int i = 0; i < 6; i++) {
+        size_t length;
+        uint8_t *png = make_png(sizes[i][0], sizes[i][1], (uint8_t)(i * 40), &length);
+        residues[length % 3] = true;
+
+        // What storing the image file names it
+        char fileHash[SHA1_HEX_LENGTH + 1];
+        sha1_hex(png, length, fileHash);
+
+        // The same image as a profile's data URL
+        char *url = icon_store_png_data_url(png, length);
+        CHECK(icon_store_data_url_hash(url, hashes[i]));
+        CHECK(!strcmp(hashes[i], fileHash));
+        size_t decodedLength;
+        uint8_t *decoded = icon_store_decode_data_url(url, &decodedLength);
+        CHECK(decoded && decodedLength == length && !memcmp(decoded, png, length));
+        free(decoded);
+
+        // Wrapped at 76 columns with CRLF, like some launchers write it
+        size_t prefix = strlen("data:image/png;base64,"), payload = strlen(url) - prefix;
+        char *wrapped = malloc(strlen(url) + payload / 76 * 2 + 1);
+        memcpy(wrapped, url, prefix);
+        char *out = wrapped + prefix;
+        for (size_t j = 0; j < payload; j++) {
+            if (j > 0 && j % 76 == 0) {
+                *out++ = '\r';
+                *out++ = '\n';
+            }
+            *out++ = url[prefix + j];
+        }
+        *out = '\0';
+        char wrappedHash[SHA1_HEX_LENGTH + 1];
+        CHECK(icon_store_data_url_hash(wrapped, wrappedHash));
+        CHECK(!strcmp(wrappedHash, fileHash));
+
+        // Another media type names the same image the same
+        char *jpegLabel = malloc(strlen(url) + 2);
+        snprintf(jpegLabel, strlen(url) + 2, "data:image/jpeg;base64,%s", url + prefix);
+        CHECK(icon_store_data_url_hash(jpegLabel, wrappedHash));
+        CHECK(!strcmp(wrappedHash, fileHash));
+
+        free(jpegLabel);
+        free(wrapped);
+        free(url);
+        free(png);
+    }
+    CHECK(residues[0] && residues[1] && residues[2]);
+
+    // Different images never share a directory, the same image always does
+    for (int i = 0; i < 6; i++) {
+        for (int j = i + 1; j < 6; j++) CHECK(strcmp(hashes[i], hashes[j]) != 0);
+    }
+    size_t length;
+    uint8_t *png = make_png(16, 16, 80, &length);
+    char *url = icon_store_png_data_url(png, length);
+    char again[SHA1_HEX_LENGTH + 1], first[4096], second[4096];
+    CHECK(icon_store_data_url_hash(url, again));
+    CHECK(icon_store_path("/icons", again, 64, first, sizeof(first)));
+    CHECK(icon_store_path("/icons", hashes[2], 64, second, sizeof(second)));
+    CHECK(!strcmp(first, second));
+    free(url);
+    free(png);
+}
+
+int main(void) {
+    test_paths();
+    test_base64();
+    test_pngs();
+    return TEST_RESULT();
+}
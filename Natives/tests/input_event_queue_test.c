@@ -0,0 +1,90 @@
+#include <pthread.h>
+#include <string.h>
+
+#include "input/input_event_queue.h"
+#include "test.h"
+
+static input_event_queue_t queue = INPUT_EVENT_QUEUE_INITIALIZER;
+
+static void push(int value) {
+    GLFWInputEvent event = {.type = 1, .i1 = value};
+    input_event_queue_push(&queue, &event);
+}
+
+static void test_pump_cycle(void) {
+    const GLFWInputEvent *events;
+    push(1);
+    push(2);
+    CHECK_EQ_INT(input_event_queue_take(&queue, &events), 2);
+    CHECK_EQ_INT(events[0].i1, 1);
+    CHECK_EQ_INT(events[1].i1, 2);
+
+    // Queued during the pump: not part of this one, not lost either
+    push(3);
+    CHECK_EQ_INT(input_event_queue_take(&queue, &events), 2); // second window
+    CHECK_EQ_INT(events[1].i1, 2);
+    input_event_queue_rewind(&queue);
+
+    CHECK_EQ_INT(input_event_queue_take(&queue, &events), 1);
+    CHECK_EQ_INT(events[0].i1, 3);
+    input_event_queue_rewind(&queue);
+    CHECK_EQ_INT(input_event_queue_take(&queue, &events), 0);
+    input_event_queue_rewind(&queue);
+}
+
+static void test_capacity(void) {
+    const GLFWInputEvent *events;
+    GLFWInputEvent event = {0};
+    int accepted = 0;
+    for (int i = 0; i < INPUT_EVENT_QUEUE_CAPACITY + 10; i++) {
+        accepted += input_event_queue_push(&queue, &event);
+    }
+    CHECK_EQ_INT(accepted, INPUT_EVENT_QUEUE_CAPACITY);
+    CHECK_EQ_INT(input_event_queue_take(&queue, &events), INPUT_EVENT_QUEUE_CAPACITY);
+    input_event_queue_rewind(&queue);
+    CHECK_EQ_INT(input_event_queue_take(&queue, &events), 0);
+    input_event_queue_rewind(&queue);
+}
+
+// A poller thread sends key presses and releases while the game thread
+// pumps; every release has to arrive, after its press.
+#define STRESS_KEYS 200000
+
+static void *stress_producer(void *arg) {
+    for (int i = 0; i < STRESS_KEYS; i++) {
+        GLFWInputEvent press = {.type = 1, .i1 = i, .i3 = 1};
+        GLFWInputEvent release = {.type = 1, .i1 = i, .i3 = 0};
+        while (!input_event_queue_push(&queue, &press)) {}
+        while (!input_event_queue_push(&queue, &release)) {}
+    }
+    return NULL;
+}
+
+static void test_concurrent_pumps(void) {
+    pthread_t producer;
+    pthread_create(&producer, NULL, stress_producer, NULL);
+    long next = 0;
+    bool pressed = false, ordered = true;
+    while (next < STRESS_KEYS) {
+        const GLFWInputEvent *events;
+        size_t count = input_event_queue_take(&queue, &events);
+        for (size_t i = 0; i < count; i++) {
+            if (events[i].i1 != next || events[i].i3 != !pressed) ordered = false;
+            pressed = events[i].i3;
+            if (!pressed) next++;
+        }
+        input_event_queue_rewind(&queue);
+        if (!ordered) break;
+    }
+    pthread_join(producer, NULL);
+    CHECK(ordered);
+    CHECK_EQ_INT(next, STRESS_KEYS);
+    CHECK(!pressed);
+}
+
+int main(void) {
+    test_pump_cycle();
+    test_capacity();
+    test_concurrent_pumps();
+    return TEST_RESULT();
+}
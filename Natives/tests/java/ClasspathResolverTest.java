@@ -0,0 +1,67 @@
+import com.google.gson.Gson;
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.Paths;
+import java.util.ArrayList;
+import java.util.List;
+import net.kdt.pojavlaunch.JMinecraftVersionList;
+import net.kdt.pojavlaunch.utils.ClasspathResolver;
+import net.kdt.pojavlaunch.value.DependentLibrary;
+
+/**
+ * The launcher's ClasspathResolver on the chains library_resolver_test
+ * resolves, against the same classpath.txt. Run with the fixture directory:
+ *   java -cp <classes>:gson.jar ClasspathResolverTest Natives/tests/fixtures
+ */
+public class ClasspathResolverTest {
+    private static final String[] CHAINS = {"modpack-1.0", "1.20.1-forge-47.2.0", "neoforge-21.1.77"};
+
+    public static void main(String[] args) throws IOException {
+        Path versions = Paths.get(args[0], "versions");
+        Gson gson = new Gson();
+        int failures = 0;
+        for (String id : CHAINS) {
+            // Most derived first, walked like Tools.getVersionInfo does
+            List<JMinecraftVersionList.Version> chain = new ArrayList<>();
+            for (String name = id; name != null; ) {
+                String json = new String(Files.readAllBytes(versions.resolve(name).resolve(name + ".json")), StandardCharsets.UTF_8);
+                JMinecraftVersionList.Version version = gson.fromJson(json, JMinecraftVersionList.Version.class);
+                chain.add(version);
+                name = version.inheritsFrom;
+            }
+
+            List<String> expected = Files.readAllLines(versions.resolve(id).resolve("classpath.txt"), StandardCharsets.UTF_8);
+            List<String> actual = new ArrayList<>();
+            for (DependentLibrary library : ClasspathResolver.resolveChain(chain)) {
+                actual.add(library.name);
+            }
+            for (int i = 0; i < Math.max(expected.size(), actual.size()); i++) {
+                String got = i < actual.size() ? actual.get(i) : "(none)";
+                String want = i < expected.size() ? expected.get(i) : "(none)";
+                if (!got.equals(want)) {
+                    System.err.println(id + ": classpath[" + i + "] is " + got + ", expected " + want);
+                    failures++;
+                    break;
+                }
+            }
+        }
+
+        // The ascending list library_resolver_test checks library_compare_versions with
+        String[] ordered = {
+            "1.0-alpha", "1.0-alpha2", "1.0-beta", "1.0-m1", "1.0-rc1", "1.0rc2", "1.0-SNAPSHOT",
+            "1.0", "1.0.1", "1.0.2-jre", "1.0.10", "1.2", "2.0.0-beta.9", "2", "10", "010.1"
+        };
+        for (int i = 0; i < ordered.length; i++) {
+            for (int j = 0; j < ordered.length; j++) {
+                int expected = Integer.signum(i - j);
+                if (Integer.signum(ClasspathResolver.compareVersions(ordered[i], ordered[j])) != expected) {
+                    System.err.println(ordered[i] + " vs " + ordered[j] + " is not " + expected);
+                    failures++;
+                }
+            }
+        }
+        System.exit(failures == 0 ? 0 : 1);
+    }
+}
@@ -0,0 +1,30 @@
+import java.io.IOException;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.Paths;
+import java.util.HashMap;
+import java.util.Map;
+
+/**
+ * Stands in for Forge's binarypatcher in the fixture installer: the output is
+ * the clean jar followed by the patch, so its SHA1 is known up front.
+ */
+public class FixtureProcessor {
+    public static void main(String[] args) throws IOException {
+        Map<String, String> options = new HashMap<>();
+        for (int i = 0; i + 1 < args.length; i += 2) {
+            options.put(args[i], args[i + 1]);
+        }
+        if (!"client".equals(options.get("--side"))) {
+            throw new IllegalArgumentException("Unexpected side " + options.get("--side"));
+        }
+        Path output = Paths.get(options.get("--output"));
+        Files.createDirectories(output.getParent());
+        byte[] clean = Files.readAllBytes(Paths.get(options.get("--clean")));
+        byte[] patch = Files.readAllBytes(Paths.get(options.get("--patch")));
+        byte[] patched = new byte[clean.length + patch.length];
+        System.arraycopy(clean, 0, patched, 0, clean.length);
+        System.arraycopy(patch, 0, patched, clean.length, patch.length);
+        Files.write(output, patched);
+    }
+}
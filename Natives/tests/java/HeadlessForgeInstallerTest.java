@@ -0,0 +1,144 @@
+import com.google.gson.JsonObject;
+import com.google.gson.JsonParser;
+import java.io.ByteArrayOutputStream;
+import java.io.File;
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.Paths;
+import java.security.MessageDigest;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Comparator;
+import java.util.List;
+import java.util.jar.Attributes;
+import java.util.jar.JarEntry;
+import java.util.jar.JarOutputStream;
+import java.util.jar.Manifest;
+import java.util.stream.Collectors;
+import java.util.stream.Stream;
+import net.kdt.pojavlaunch.HeadlessForgeInstaller;
+
+/**
+ * Runs the headless installer on a small Forge installer packed from
+ * fixtures/forge_installer: one client processor, a server one that must be
+ * skipped, an [artifact] data entry and a /data/ file inside the jar. The
+ * versions and libraries trees it leaves must match expected_tree.txt, the
+ * files the installer GUI writes for this profile ("*" is the processor jar
+ * bundled in maven/). Run with the fixture directory:
+ *   java -cp <classes>:gson.jar HeadlessForgeInstallerTest Natives/tests/fixtures
+ */
+public class HeadlessForgeInstallerTest {
+    private static final String VERSION = "1.20.1-forge-47.2.0";
+    private static final String PATCHED = "libraries/net/minecraftforge/forge/1.20.1-47.2.0/forge-1.20.1-47.2.0-client.jar";
+    private static int failures;
+
+    public static void main(String[] args) throws Throwable {
+        Path fixtures = Paths.get(args[0], "forge_installer");
+        Path work = Files.createTempDirectory("forge_installer_test");
+        Path gameDir = work.resolve("game");
+        Path installer = work.resolve("forge-1.20.1-47.2.0-installer.jar");
+        byte[] processorJar = processorJar();
+        packInstaller(fixtures.resolve("installer"), processorJar, installer);
+        // The launcher downloads the client before the installer runs
+        Path clientJar = gameDir.resolve("versions/1.20.1/1.20.1.jar");
+        Files.createDirectories(clientJar.getParent());
+        Files.copy(fixtures.resolve("client.jar"), clientJar);
+
+        // What -installForge does, with the profile written to the file
+        // instead of handed to the app
+        HeadlessForgeInstaller.main(new String[]{installer.toString(), gameDir.toString()});
+        List<String> expected = Files.readAllLines(fixtures.resolve("expected_tree.txt"), StandardCharsets.UTF_8);
+        checkTree(gameDir, expected, processorJar);
+
+        JsonObject profiles = JsonParser.parseString(new String(Files.readAllBytes(gameDir.resolve("launcher_profiles.json")),
+            StandardCharsets.UTF_8)).getAsJsonObject().getAsJsonObject("profiles");
+        JsonObject profile = profiles.getAsJsonObject("forge");
+        check(profile != null, "no forge profile in launcher_profiles.json");
+        if (profile != null) {
+            check(VERSION.equals(profile.get("lastVersionId").getAsString()), "profile has version " + profile.get("lastVersionId"));
+            check("custom".equals(profile.get("type").getAsString()), "profile has type " + profile.get("type"));
+            check(profile.has("icon"), "profile has no icon");
+        }
+
+        // Installing again finds the processor output up to date
+        File patched = gameDir.resolve(PATCHED).toFile();
+        long stamp = 1000000000000L;
+        check(patched.setLastModified(stamp), "could not stamp " + patched);
+        new HeadlessForgeInstaller(installer.toFile(), gameDir.toFile()).install();
+        check(patched.lastModified() == stamp, "the processor ran again");
+        checkTree(gameDir, expected, processorJar);
+
+        try (Stream<Path> paths = Files.walk(work)) {
+            paths.sorted(Comparator.reverseOrder()).map(Path::toFile).forEach(File::delete);
+        }
+        System.exit(failures == 0 ? 0 : 1);
+    }
+
+    private static void check(boolean condition, String message) {
+        if (!condition) {
+            System.err.println("FAIL: " + message);
+            failures++;
+        }
+    }
+
+    // Every file under versions/ and libraries/, as "path sha1" lines
+    private static void checkTree(Path gameDir, List<String> expected, byte[] processorJar) throws Exception {
+        List<String> actual = new ArrayList<>();
+        for (String dir : new String[]{"libraries", "versions"}) {
+            try (Stream<Path> paths = Files.walk(gameDir.resolve(dir))) {
+                for (Path path : paths.filter(Files::isRegularFile).collect(Collectors.toList())) {
+                    byte[] contents = Files.readAllBytes(path);
+                    String relative = gameDir.relativize(path).toString().replace(File.separatorChar, '/');
+                    actual.add(relative + " " + (Arrays.equals(contents, processorJar) ? "*" : sha1(contents)));
+                }
+            }
+        }
+        actual.sort(null);
+        check(actual.equals(expected), "installed tree differs\n  got:      " + actual + "\n  expected: " + expected);
+    }
+
+    private static byte[] processorJar() throws IOException {
+        Manifest manifest = new Manifest();
+        manifest.getMainAttributes().put(Attributes.Name.MANIFEST_VERSION, "1.0");
+        manifest.getMainAttributes().put(Attributes.Name.MAIN_CLASS, FixtureProcessor.class.getName());
+        ByteArrayOutputStream jar = new ByteArrayOutputStream();
+        try (JarOutputStream out = new JarOutputStream(jar, manifest);
+             InputStream in = FixtureProcessor.class.getResourceAsStream("FixtureProcessor.class")) {
+            out.putNextEntry(new JarEntry("FixtureProcessor.class"));
+            copy(in, out);
+        }
+        return jar.toByteArray();
+    }
+
+    private static void packInstaller(Path dir, byte[] processorJar, Path installer) throws IOException {
+        try (JarOutputStream out = new JarOutputStream(Files.newOutputStream(installer));
+             Stream<Path> paths = Files.walk(dir)) {
+            for (Path path : paths.filter(Files::isRegularFile).sorted().collect(Collectors.toList())) {
+                out.putNextEntry(new JarEntry(dir.relativize(path).toString().replace(File.separatorChar, '/')));
+                Files.copy(path, out);
+            }
+            out.putNextEntry(new JarEntry("maven/net/minecraftforge/fixture-processor/1.0/fixture-processor-1.0.jar"));
+            out.write(processorJar);
+        }
+    }
+
+    private static void copy(InputStream in, OutputStream out) throws IOException {
+        byte[] buffer = new byte[8192];
+        int length;
+        while ((length = in.read(buffer)) != -1) {
+            out.write(buffer, 0, length);
+        }
+    }
+
+    private static String sha1(byte[] contents) throws Exception {
+        StringBuilder hex = new StringBuilder();
+        for (byte b : MessageDigest.getInstance("SHA-1").digest(contents)) {
+            hex.append(String.format("%02x", b));
+        }
+        return hex.toString();
+    }
+}
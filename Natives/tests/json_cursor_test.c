@@ -0,0 +1,121 @@
+#include <string.h>
+
+#include "json_cursor.h"
+#include "test.h"
+
+static json_cursor_t cursor_of(const char *json) {
+    json_cursor_t cursor;
+    json_cursor_init(&cursor, json, strlen(json));
+    return cursor;
+}
+
+// Reads "n" of every element of an array like [{"n": 1, "s": "x"}, ...]
+static int read_sizes(const char *json, uint64_t *sizes, int capacity) {
+    json_cursor_t cursor = cursor_of(json);
+    int count = 0;
+    if (!json_enter_array(&cursor)) return -1;
+    while (json_next_element(&cursor)) {
+        if (!json_enter_object(&cursor)) return -1;
+        json_string_t key;
+        while (json_next_key(&cursor, &key)) {
+            uint64_t value;
+            if (json_string_equals(key, "n") && json_read_uint64(&cursor, &value)) {
+                if (count < capacity) sizes[count] = value;
+                count++;
+            } else if (!json_skip_value(&cursor)) {
+                return -1;
+            }
+        }
+    }
+    return count;
+}
+
+static void test_numbers(void) {
+    uint64_t sizes[8];
+    // The rest of the object is still read after a fraction or exponent
+    CHECK_EQ_INT(read_sizes("[{\"n\": 12.75, \"s\": \"a\"}, {\"n\": 3e2}, {\"n\": 1.5E+3, \"s\": 1}, {\"n\": 25e-1}]", sizes, 8), 4);
+    CHECK_EQ_INT(sizes[0], 12);
+    CHECK_EQ_INT(sizes[1], 300);
+    CHECK_EQ_INT(sizes[2], 1500);
+    CHECK_EQ_INT(sizes[3], 2);
+
+    uint64_t value = 1;
+    json_cursor_t cursor = cursor_of("18446744073709551615,");
+    CHECK(json_read_uint64(&cursor, &value));
+    CHECK(value == UINT64_MAX);
+    CHECK_EQ_INT(*cursor.p, ',');
+    cursor = cursor_of("0.000001e6 ");
+    CHECK(json_read_uint64(&cursor, &value));
+    CHECK_EQ_INT(value, 1);
+    CHECK_EQ_INT(*cursor.p, ' ');
+    cursor = cursor_of("0e99999");
+    CHECK(json_read_uint64(&cursor, &value));
+    CHECK_EQ_INT(value, 0);
+
+    // Rejected without moving, so the value can still be skipped
+    const char *rejected[] = {"18446744073709551616", "99999999999999999999", "1e20", "-1", "1.", "2e", "2e+"};
+    for (size_t i = 0; i < sizeof(rejected) / sizeof(*rejected); i++) {
+        cursor = cursor_of(rejected[i]);
+        CHECK(!json_read_uint64(&cursor, &value));
+        CHECK(cursor.p == rejected[i]);
+    }
+    CHECK_EQ_INT(read_sizes("[{\"n\": -4, \"s\": 2}, {\"n\": 1e30}, {\"n\": 7}]", sizes, 8), 1);
+    CHECK_EQ_INT(sizes[0], 7);
+}
+
+static void test_strings(void) {
+    json_cursor_t cursor = cursor_of("{\"a\\\"b\": \"tab\\there \\u00e9\\ud83d\\ude00\", \"c\\\\\": \"\"}");
+    CHECK(json_enter_object(&cursor));
+    json_string_t key, value;
+    CHECK(json_next_key(&cursor, &key));
+    CHECK(json_string_equals(key, "a\"b"));
+    CHECK(json_read_string(&cursor, &value));
+    CHECK(value.hasEscapes);
+    char buffer[32];
+    CHECK_EQ_INT(json_string_copy(value, buffer, sizeof(buffer)), 15);
+    CHECK(!strcmp(buffer, "tab\there \xc3\xa9\xf0\x9f\x98\x80"));
+    CHECK_EQ_INT(json_string_copy(value, buffer, 8), -1);
+    // The closing quote after an escaped backslash ends the key
+    CHECK(json_next_key(&cursor, &key));
+    CHECK(json_string_equals(key, "c\\"));
+    CHECK(json_read_string(&cursor, &value));
+    CHECK_EQ_INT(value.length, 0);
+    CHECK(!json_next_key(&cursor, &key));
+}
+
+static void test_skip_and_find(void) {
+    const char *json = "{\"skip\": {\"nested\": [1, {\"x\": \"}]\"}, [true, false, null]]}, \"n\": null, "
+        "\"flag\": true, \"target\": 42}";
+    json_cursor_t cursor = cursor_of(json);
+    CHECK(json_enter_object(&cursor));
+    CHECK(json_find_key(&cursor, "flag"));
+    bool flag = false;
+    CHECK(json_read_bool(&cursor, &flag));
+    CHECK(flag);
+    CHECK(json_find_key(&cursor, "target"));
+    uint64_t value;
+    CHECK(json_read_uint64(&cursor, &value));
+    CHECK_EQ_INT(value, 42);
+    CHECK_EQ_INT(json_peek(&cursor), JSON_INVALID);
+
+    cursor = cursor_of(json);
+    CHECK(json_enter_object(&cursor));
+    CHECK(!json_find_key(&cursor, "missing"));
+    CHECK(cursor.p == json + strlen(json));
+
+    // Truncated input fails instead of reading past the end
+    cursor = cursor_of("{\"a\": [1, 2");
+    CHECK(json_enter_object(&cursor));
+    CHECK(!json_find_key(&cursor, "b"));
+    cursor = cursor_of("\"open");
+    CHECK(!json_read_string(&cursor, NULL));
+    cursor = cursor_of("tru");
+    CHECK(!json_skip_value(&cursor));
+}
+
+int main(void) {
+    test_numbers();
+    test_strings();
+    test_skip_and_find();
+    return TEST_RESULT();
+}
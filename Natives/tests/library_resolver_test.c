@@ -0,0 +1,244 @@
+#include <string.h>
+
+#include "fixtures.h"
+#include "json_cursor.h"
+#include "library_resolver.h"
+#include "test.h"
+
+// Resolves the fixture versions the way the launcher does for a modpack on
+// top of Fabric on top of vanilla, and for Forge and NeoForge, see
+// fixtures/versions. The expected classpath.txt of each chain is shared with
+// java/ClasspathResolverTest.
+
+#define MAX_LIBRARIES 64
+
+typedef struct {
+    char names[MAX_LIBRARIES][128];
+    int count;
+} library_list_t;
+
+// Appends the version's libraries to list, returns the version it inherits from or ""
+static const char *read_version(const char *id, library_list_t *list) {
+    static char parent[128];
+    char path[256];
+    snprintf(path, sizeof(path), "versions/%s/%s.json", id, id);
+    size_t length;
+    char *data = fixture_read(path, &length);
+    CHECK(data != NULL);
+    parent[0] = '\0';
+    if (!data) return parent;
+
+    json_cursor_t cursor;
+    json_cursor_init(&cursor, data, length);
+    json_string_t key, value;
+    CHECK(json_enter_object(&cursor));
+    while (json_next_key(&cursor, &key)) {
+        if (json_string_equals(key, "inheritsFrom") && json_read_string(&cursor, &value)) {
+            json_string_copy(value, parent, sizeof(parent));
+        } else if (json_string_equals(key, "libraries") && json_enter_array(&cursor)) {
+            while (json_next_element(&cursor)) {
+                CHECK(json_enter_object(&cursor));
+                while (json_next_key(&cursor, &key)) {
+                    if (json_string_equals(key, "name") && json_read_string(&cursor, &value)) {
+                        json_string_copy(value, list->names[list->count++], sizeof(list->names[0]));
+                    } else {
+                        CHECK(json_skip_value(&cursor));
+                    }
+                }
+            }
+        } else {
+            CHECK(json_skip_value(&cursor));
+        }
+    }
+    free(data);
+    return parent;
+}
+
+// Resolves the chain from id up to its base and writes the classpath to out
+static int resolve_chain(const char *id, library_list_t *out) {
+    // Most derived first, as the chain is discovered
+    static library_list_t levels[8];
+    int levelCount = 0;
+    char current[128];
+    snprintf(current, sizeof(current), "%s", id);
+    while (current[0] && levelCount < 8) {
+        levels[levelCount].count = 0;
+        snprintf(current, sizeof(current), "%s", read_version(current, &levels[levelCount++]));
+    }
+
+    library_list_t all = {0};
+    library_resolver_t *resolver = library_resolver_create();
+    for (int level = levelCount - 1; level >= 0; level--) {
+        for (int i = 0; i < levels[level].count; i++) {
+            int other;
+            library_resolver_add(resolver, levels[level].names[i], &other);
+            strcpy(all.names[all.count++], levels[level].names[i]);
+        }
+        library_resolver_next_level(resolver);
+    }
+    int order[MAX_LIBRARIES];
+    out->count = (int)library_resolver_result(resolver, order);
+    for (int i = 0; i < out->count; i++) {
+        strcpy(out->names[i], all.names[order[i]]);
+    }
+    library_resolver_free(resolver);
+    return levelCount;
+}
+
+static void test_chain(void) {
+    static library_list_t classpath;
+    CHECK_EQ_INT(resolve_chain("modpack-1.0", &classpath), 3);
+    const char *expected[] = {
+        "com.mojang:blocklist:1.0.10",
+        // The higher version within vanilla, in place of the first one
+        "net.java.dev.jna:jna:5.13.0",
+        // Classifiers are separate artifacts
+        "org.lwjgl:lwjgl:3.3.1",
+        "org.lwjgl:lwjgl:3.3.1:natives-macos",
+        "org.lwjgl:lwjgl:3.3.1:natives-macos-arm64",
+        "org.slf4j:slf4j-api:2.0.1",
+        "org.ow2.asm:asm-tree:9.5",
+        "net.fabricmc:intermediary:1.20.1",
+        // The most derived version wins over Fabric and vanilla, even when lower
+        "org.ow2.asm:asm:9.4",
+        "com.google.guava:guava:31.1-jre",
+        "net.fabricmc:fabric-loader:0.14.22@jar",
+        "io.github.example:pack-core:1.0"
+    };
+    int count = sizeof(expected) / sizeof(*expected);
+    CHECK_EQ_INT(classpath.count, count);
+    for (int i = 0; i < count && i < classpath.count; i++) {
+        if (strcmp(classpath.names[i], expected[i])) {
+            fprintf(stderr, "classpath[%d] is %s, expected %s\n", i, classpath.names[i], expected[i]);
+            CHECK(false);
+        }
+    }
+
+    // Applying one level at a time onto the resolved parent, like the launcher, ends the same
+    static library_list_t parent, derived, all;
+    resolve_chain("fabric-loader-0.14.22-1.20.1", &parent);
+    read_version("modpack-1.0", &derived);
+    library_resolver_t *resolver = library_resolver_create();
+    for (int level = 0; level < 2; level++) {
+        library_list_t *list = level ? &derived : &parent;
+        for (int i = 0; i < list->count; i++) {
+            int other;
+            library_resolver_add(resolver, list->names[i], &other);
+            strcpy(all.names[all.count++], list->names[i]);
+        }
+        library_resolver_next_level(resolver);
+    }
+    int order[MAX_LIBRARIES];
+    CHECK_EQ_INT(library_resolver_result(resolver, order), count);
+    for (int i = 0; i < count; i++) {
+        CHECK(!strcmp(all.names[order[i]], expected[i]));
+    }
+    library_resolver_free(resolver);
+}
+
+static void test_loader_chains(void) {
+    const char *chains[] = {"modpack-1.0", "1.20.1-forge-47.2.0", "neoforge-21.1.77"};
+    for (int c = 0; c < 3; c++) {
+        static library_list_t classpath;
+        CHECK_EQ_INT(resolve_chain(chains[c], &classpath), c == 0 ? 3 : 2);
+        char path[256];
+        snprintf(path, sizeof(path), "versions/%s/classpath.txt", chains[c]);
+        char *expected = fixture_read(path, NULL);
+        CHECK(expected != NULL);
+        if (!expected) continue;
+        int count = 0;
+        for (char *line = strtok(expected, "\n"); line; line = strtok(NULL, "\n"), count++) {
+            if (count >= classpath.count || strcmp(classpath.names[count], line)) {
+                fprintf(stderr, "%s: classpath[%d] is %s, expected %s\n", chains[c], count,
+                    count < classpath.count ? classpath.names[count] : "(none)", line);
+                CHECK(false);
+                break;
+            }
+        }
+        CHECK_EQ_INT(classpath.count, count);
+        free(expected);
+    }
+}
+
+static void test_add_results(void) {
+    library_resolver_t *resolver = library_resolver_create();
+    int other = -1;
+    CHECK_EQ_INT(library_resolver_add(resolver, "a:b:1.0", &other), LIBRARY_ADDED);
+    CHECK_EQ_INT(library_resolver_add(resolver, "a:b:1.1", &other), LIBRARY_SUPERSEDES);
+    CHECK_EQ_INT(other, 0);
+    CHECK_EQ_INT(library_resolver_add(resolver, "a:b:0.9", &other), LIBRARY_SUPERSEDED);
+    CHECK_EQ_INT(other, 1);
+    library_resolver_next_level(resolver);
+    CHECK_EQ_INT(library_resolver_add(resolver, "a:b:0.1", &other), LIBRARY_OVERRIDES);
+    CHECK_EQ_INT(other, 1);
+    // Within the derived level the usual ordering applies again
+    CHECK_EQ_INT(library_resolver_add(resolver, "a:b:0.2", &other), LIBRARY_SUPERSEDES);
+    CHECK_EQ_INT(other, 3);
+    int order[8];
+    CHECK_EQ_INT(library_resolver_result(resolver, order), 1);
+    CHECK_EQ_INT(order[0], 4);
+    library_resolver_free(resolver);
+
+    // Many libraries, one entry each
+    resolver = library_resolver_create();
+    char name[64];
+    for (int i = 0; i < 5000; i++) {
+        snprintf(name, sizeof(name), "group%d:artifact:1.%d", i % 2500, i);
+        library_resolver_add(resolver, name, &other);
+    }
+    int *many = malloc(5000 * sizeof(int));
+    CHECK_EQ_INT(library_resolver_result(resolver, many), 2500);
+    CHECK_EQ_INT(many[0], 2500);
+    CHECK_EQ_INT(many[2499], 4999);
+    free(many);
+    library_resolver_free(resolver);
+}
+
+static void test_coordinates(void) {
+    char buffer[64];
+    struct { const char *name, *coordinate; } cases[] = {
+        {"org.lwjgl:lwjgl:3.3.1", "org.lwjgl:lwjgl"},
+        {"org.lwjgl:lwjgl:3.3.1:natives-macos", "org.lwjgl:lwjgl:natives-macos"},
+        {"net.fabricmc:fabric-loader:0.14.22@jar", "net.fabricmc:fabric-loader"},
+        {"de.oceanlabs.mcp:mcp_config:1.20.1@zip", "de.oceanlabs.mcp:mcp_config@zip"},
+        {"a:b:1:c:d@zip", "a:b:c:d@zip"},
+        {"a:b", "a:b"}
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+        CHECK_EQ_INT(library_coordinate(cases[i].name, buffer, sizeof(buffer)), strlen(cases[i].coordinate));
+        CHECK(!strcmp(buffer, cases[i].coordinate));
+    }
+    CHECK(library_coordinate("org.lwjgl:lwjgl:3.3.1", buffer, 15) == (size_t)-1);
+}
+
+static void test_versions(void) {
+    // Ascending
+    const char *ordered[] = {
+        "1.0-alpha", "1.0-alpha2", "1.0-beta", "1.0-m1", "1.0-rc1", "1.0rc2", "1.0-SNAPSHOT",
+        "1.0", "1.0.1", "1.0.2-jre", "1.0.10", "1.2", "2.0.0-beta.9", "2", "10", "010.1"
+    };
+    int count = sizeof(ordered) / sizeof(*ordered);
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < count; j++) {
+            int expected = (i > j) - (i < j);
+            if (library_compare_versions(ordered[i], ordered[j]) != expected) {
+                fprintf(stderr, "%s vs %s is not %d\n", ordered[i], ordered[j], expected);
+                CHECK(false);
+            }
+        }
+    }
+    CHECK_EQ_INT(library_compare_versions("1.0", "1.0.0"), 0);
+    CHECK_EQ_INT(library_compare_versions("1.0-RC1", "1.0-rc1"), 0);
+    CHECK_EQ_INT(library_compare_versions("", ""), 0);
+    // Numbers of any length
+    CHECK_EQ_INT(library_compare_versions("20230101000000000000", "9"), 1);
+}
+
+int main(void) {
+    test_chain();
+    test_loader_chains();
+    test_add_results();
+    test_coordinates();
+    test_versions();
+    return TEST_RESULT();
+}
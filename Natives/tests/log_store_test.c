@@ -0,0 +1,237 @@
+#include <string.h>
+
+#include "log_store.h"
+#include "test.h"
+
+// The log view's store at the size the app uses, and small ones to make
+// eviction and the match ring easy to follow.
+
+#define ARENA_SIZE (4 << 20)
+#define MAX_LINES 32768
+
+static void append_string(log_store_t *store, const char *text) {
+    log_store_append(store, text, strlen(text));
+}
+
+static bool line_is(log_store_t *store, uint64_t seq, const char *expected) {
+    size_t length;
+    const char *line = log_store_line(store, seq, &length, NULL);
+    if (line && length == strlen(expected) && !strcmp(line, expected)) return true;
+    fprintf(stderr, "line %llu is \"%s\", expected \"%s\"\n", (unsigned long long)seq, line ? line : "(evicted)", expected);
+    return false;
+}
+
+static log_severity_t severity_of(log_store_t *store, uint64_t seq) {
+    log_severity_t severity = -1;
+    log_store_line(store, seq, NULL, &severity);
+    return severity;
+}
+
+static void test_line_limit(void) {
+    log_store_t *store = log_store_create(ARENA_SIZE, MAX_LINES);
+    char line[64];
+    for (int i = 0; i < 40000; i++) {
+        int length = snprintf(line, sizeof(line), "line %d", i);
+        log_store_append_line(store, line, length);
+    }
+    // Short lines fill the ring long before the arena
+    CHECK_EQ_INT(log_store_end_seq(store), 40000);
+    CHECK_EQ_INT(log_store_first_seq(store), 40000 - MAX_LINES);
+    CHECK(log_store_line(store, 40000 - MAX_LINES - 1, NULL, NULL) == NULL);
+    CHECK(line_is(store, 40000 - MAX_LINES, "line 7232"));
+    CHECK(line_is(store, 39999, "line 39999"));
+    CHECK(log_store_line(store, 40000, NULL, NULL) == NULL);
+    log_store_destroy(store);
+}
+
+static void test_arena_wrap(void) {
+    log_store_t *store = log_store_create(ARENA_SIZE, MAX_LINES);
+    // 200 bytes plus the NUL per line, about 20867 of them fit in 4 MB
+    char line[201];
+    const int count = 50000;
+    for (int i = 0; i < count; i++) {
+        snprintf(line, sizeof(line), "%08d", i);
+        memset(line + 8, 'a' + i % 26, 192);
+        line[200] = '\0';
+        log_store_append_line(store, line, 200);
+
+        uint64_t live = log_store_end_seq(store) - log_store_first_seq(store);
+        if (live * 201 > ARENA_SIZE || live > MAX_LINES) {
+            fprintf(stderr, "%llu lines live after %d\n", (unsigned long long)live, i);
+            CHECK(false);
+            break;
+        }
+    }
+    uint64_t first = log_store_first_seq(store), end = log_store_end_seq(store);
+    CHECK_EQ_INT(end, count);
+    // Wrapping drops the lines left in the tail, so a little less than full
+    CHECK(end - first > ARENA_SIZE / 201 - 30);
+    CHECK(end - first <= ARENA_SIZE / 201);
+    // Every line that survived the wraps reads back intact
+    int damaged = 0;
+    for (uint64_t seq = first; seq < end; seq++) {
+        size_t length;
+        const char *text = log_store_line(store, seq, &length, NULL);
+        snprintf(line, sizeof(line), "%08d", (int)seq);
+        memset(line + 8, 'a' + (int)(seq % 26), 192);
+        damaged += !text || length != 200 || memcmp(text, line, 201);
+    }
+    CHECK_EQ_INT(damaged, 0);
+
+    // Overlong lines are cut to 4096 bytes
+    char *longLine = malloc(10000);
+    memset(longLine, 'x', 10000);
+    log_store_append_line(store, longLine, 10000);
+    size_t length;
+    CHECK(log_store_line(store, end, &length, NULL) != NULL);
+    CHECK_EQ_INT(length, 4096);
+    log_store_destroy(store);
+
+    // A line that can't fit the arena at all is dropped
+    store = log_store_create(1024, 16);
+    log_store_append_line(store, longLine, 2000);
+    CHECK_EQ_INT(log_store_end_seq(store), 0);
+    // Lines as big as a third of the arena evict as needed
+    for (int i = 0; i < 10; i++) {
+        memset(longLine, '0' + i, 300);
+        log_store_append_line(store, longLine, 300);
+        CHECK(log_store_line(store, i, &length, NULL) && length == 300);
+        CHECK(log_store_end_seq(store) - log_store_first_seq(store) <= 3);
+    }
+    free(longLine);
+    log_store_destroy(store);
+}
+
+static void test_split_appends(void) {
+    log_store_t *store = log_store_create(16384, 64);
+    append_string(store, "hel");
+    CHECK_EQ_INT(log_store_end_seq(store), 0);
+    append_string(store, "lo\nwor");
+    append_string(store, "ld\r\n");
+    append_string(store, "\nlast");
+    CHECK_EQ_INT(log_store_end_seq(store), 3);
+    CHECK(line_is(store, 0, "hello"));
+    CHECK(line_is(store, 1, "world"));
+    CHECK(line_is(store, 2, ""));
+    // The unterminated tail waits for its newline
+    append_string(store, " one");
+    CHECK_EQ_INT(log_store_end_seq(store), 3);
+    append_string(store, "\n");
+    CHECK(line_is(store, 3, "last one"));
+
+    // An overlong line split across appends is cut like a whole one, shown
+    // once it reaches 4096 bytes and the rest dropped up to its newline
+    char *chunk = malloc(3000);
+    memset(chunk, 'y', 3000);
+    log_store_append(store, chunk, 3000);
+    log_store_append(store, chunk, 3000);
+    CHECK_EQ_INT(log_store_end_seq(store), 5);
+    size_t length;
+    CHECK(log_store_line(store, 4, &length, NULL) && length == 4096);
+    log_store_append(store, chunk, 3000);
+    append_string(store, "\nafter\n");
+    CHECK_EQ_INT(log_store_end_seq(store), 6);
+    CHECK(line_is(store, 5, "after"));
+    free(chunk);
+
+    // Clearing drops the held tail too
+    append_string(store, "half");
+    log_store_clear(store);
+    append_string(store, "new\n");
+    CHECK_EQ_INT(log_store_first_seq(store), 6);
+    CHECK(line_is(store, 6, "new"));
+    log_store_destroy(store);
+}
+
+static void test_classification(void) {
+    log_store_t *store = log_store_create(4096, 64);
+    // A stack frame with nothing before it belongs to an error
+    append_string(store, "\tat java.lang.Thread.run(Thread.java:833)\n");
+    append_string(store, "[12:34:56] [Render thread/INFO]: Reloading ResourceManager\n");
+    append_string(store, "[12:34:56] [Render thread/WARN]: Missing sound for event\n");
+    append_string(store, "[12:34:57] [Worker-Main-3/ERROR]: Failed to load texture\n");
+    append_string(store, "[12:34:57] [main/FATAL]: Unreported exception thrown!\n");
+    append_string(store, "Exception in thread \"main\" java.lang.NullPointerException\n");
+    append_string(store, "\tat net.minecraft.client.main.Main.main(Main.java:214)\n");
+    append_string(store, "\t... 5 more\n");
+    append_string(store, "Caused by: java.io.IOException: Broken pipe\n");
+    append_string(store, "WARNING: An illegal reflective access operation has occurred\n");
+    // Frames after a warning are part of the warning
+    append_string(store, "\tat org.lwjgl.system.Library.loadSystem(Library.java:162)\n");
+    append_string(store, "[Forge] [ERROR] Mod file is invalid\n");
+    append_string(store, "Setting user: Player\n");
+    log_severity_t expected[] = {
+        LOG_SEVERITY_ERROR, LOG_SEVERITY_INFO, LOG_SEVERITY_WARN, LOG_SEVERITY_ERROR, LOG_SEVERITY_ERROR,
+        LOG_SEVERITY_ERROR, LOG_SEVERITY_ERROR, LOG_SEVERITY_ERROR, LOG_SEVERITY_ERROR, LOG_SEVERITY_WARN,
+        LOG_SEVERITY_WARN, LOG_SEVERITY_ERROR, LOG_SEVERITY_INFO
+    };
+    int count = sizeof(expected) / sizeof(*expected);
+    CHECK_EQ_INT(log_store_end_seq(store), count);
+    for (int i = 0; i < count; i++) {
+        if (severity_of(store, i) != expected[i]) {
+            fprintf(stderr, "line %d has severity %d, expected %d\n", i, severity_of(store, i), expected[i]);
+            CHECK(false);
+        }
+    }
+
+    // Filtering by severity alone
+    log_store_set_query(store, NULL, LOG_SEVERITY_WARN);
+    CHECK_EQ_INT(log_store_match_count(store), 11);
+    log_store_set_query(store, "", LOG_SEVERITY_ERROR);
+    CHECK_EQ_INT(log_store_match_count(store), 8);
+    CHECK(!log_store_line_matches(store, 2));
+    CHECK(log_store_line_matches(store, 3));
+    log_store_destroy(store);
+}
+
+static void test_search_after_eviction(void) {
+    // Room for 16 lines
+    log_store_t *store = log_store_create(4096, 16);
+    log_store_set_query(store, "NeedLE", LOG_SEVERITY_INFO);
+    char line[64];
+    for (int i = 0; i < 100; i++) {
+        int length = snprintf(line, sizeof(line), i % 3 == 0 ? "line %d with a needle" : "line %d", i);
+        log_store_append_line(store, line, length);
+    }
+    // Lines 84-99 are left, of which 84, 87, ..., 99 match
+    CHECK_EQ_INT(log_store_first_seq(store), 84);
+    CHECK_EQ_INT(log_store_match_count(store), 6);
+    CHECK(!log_store_line_matches(store, 81));
+    CHECK(log_store_line_matches(store, 84));
+    CHECK(!log_store_line_matches(store, 85));
+
+    // Searching from an evicted line lands on the first one still there
+    CHECK_EQ_INT(log_store_find_match(store, 0, true), 84);
+    CHECK_EQ_INT(log_store_find_match(store, 84, true), 87);
+    CHECK_EQ_INT(log_store_find_match(store, 85, true), 87);
+    CHECK_EQ_INT(log_store_find_match(store, 99, true), UINT64_MAX);
+    CHECK_EQ_INT(log_store_find_match(store, 99, false), 96);
+    CHECK_EQ_INT(log_store_find_match(store, 98, false), 96);
+    CHECK_EQ_INT(log_store_find_match(store, 84, false), UINT64_MAX);
+    CHECK_EQ_INT(log_store_find_match(store, UINT64_MAX - 1, false), 99);
+
+    // More lines push earlier matches out of the ring as well
+    for (int i = 100; i < 110; i++) {
+        int length = snprintf(line, sizeof(line), "line %d", i);
+        log_store_append_line(store, line, length);
+    }
+    CHECK_EQ_INT(log_store_first_seq(store), 94);
+    CHECK_EQ_INT(log_store_match_count(store), 2);
+    CHECK_EQ_INT(log_store_find_match(store, 50, true), 96);
+    CHECK_EQ_INT(log_store_find_match(store, 109, false), 99);
+
+    // A new query is applied to what is left
+    log_store_set_query(store, "line 10", LOG_SEVERITY_INFO);
+    CHECK_EQ_INT(log_store_match_count(store), 10);
+    CHECK_EQ_INT(log_store_find_match(store, 0, true), 100);
+    log_store_destroy(store);
+}
+
+int main(void) {
+    test_line_limit();
+    test_arena_wrap();
+    test_split_appends();
+    test_classification();
+    test_search_after_eviction();
+    return TEST_RESULT();
+}
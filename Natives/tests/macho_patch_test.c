@@ -0,0 +1,81 @@
+#include <limits.h>
+#include <mach-o/fat.h>
+#include <mach-o/loader.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fixtures.h"
+#include "macho_patch.h"
+#include "test.h"
+
+#define PLATFORM_OTHER 1  // macOS
+#define PLATFORM_ACTIVE 2 // iOS
+
+static void check_patched(const char *path, uint32_t sliceOffset) {
+    size_t length;
+    FILE *in = fopen(path, "rb");
+    CHECK(in != NULL);
+    if (!in) return;
+    uint8_t data[0x8000];
+    length = fread(data, 1, sizeof(data), in);
+    fclose(in);
+    CHECK(length > sliceOffset + sizeof(struct mach_header_64));
+
+    struct mach_header_64 *header = (void *)(data + sliceOffset);
+    struct build_version_command *build = (void *)(header + 1);
+    CHECK_EQ_INT(build->platform, PLATFORM_ACTIVE);
+    struct dylib_command *dylib = (void *)((uint8_t *)build + build->cmdsize);
+    const char *name = (char *)dylib + dylib->dylib.name.offset;
+    CHECK(!strcmp(name, "/System/Library/Frameworks/Cocoa.framework/Cocoa"));
+    // Code after the load commands is untouched
+    CHECK_EQ_INT(data[sliceOffset + sizeof(*header) + header->sizeofcmds], 0xd5);
+}
+
+static void test_file(const char *dir, bool fat) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s.dylib", dir, fat ? "fat" : "thin");
+    CHECK(fixture_write_macho(path, PLATFORM_OTHER, "/System/Library/Frameworks/Cocoa.framework/Versions/A/Cocoa", fat));
+    CHECK(macho_patch_platform(path, PLATFORM_ACTIVE));
+    check_patched(path, fat ? 0x4000 : 0);
+    // Already patched, nothing to write
+    CHECK(!macho_patch_platform(path, PLATFORM_ACTIVE));
+}
+
+static void test_rejects(const char *dir) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/not-macho", dir);
+    FILE *out = fopen(path, "wb");
+    fputs("\x7f" "ELF and some more bytes to read as a header", out);
+    fclose(out);
+    CHECK(!macho_patch_platform(path, PLATFORM_ACTIVE));
+    CHECK(!macho_patch_platform("/nonexistent/lib.dylib", PLATFORM_ACTIVE));
+
+    // Load commands that claim more than sizeofcmds
+    snprintf(path, sizeof(path), "%s/malformed.dylib", dir);
+    CHECK(fixture_write_macho(path, PLATFORM_OTHER, "/usr/lib/libSystem.B.dylib", false));
+    FILE *file = fopen(path, "r+b");
+    struct load_command command;
+    fseek(file, sizeof(struct mach_header_64), SEEK_SET);
+    fread(&command, sizeof(command), 1, file);
+    command.cmdsize = 0x10000;
+    fseek(file, sizeof(struct mach_header_64), SEEK_SET);
+    fwrite(&command, sizeof(command), 1, file);
+    fclose(file);
+    CHECK(!macho_patch_platform(path, PLATFORM_ACTIVE));
+
+    // Cut inside the load commands
+    snprintf(path, sizeof(path), "%s/truncated.dylib", dir);
+    CHECK(fixture_write_macho(path, PLATFORM_OTHER, "/usr/lib/libSystem.B.dylib", false));
+    CHECK(truncate(path, sizeof(struct mach_header_64) + 8) == 0);
+    CHECK(!macho_patch_platform(path, PLATFORM_ACTIVE));
+}
+
+int main(void) {
+    char *dir = fixture_temp_dir("macho_patch_test");
+    test_file(dir, false);
+    test_file(dir, true);
+    test_rejects(dir);
+    fixture_remove_tree(dir);
+    free(dir);
+    return TEST_RESULT();
+}
@@ -0,0 +1,147 @@
+#include <string.h>
+
+#include "memory_governor.h"
+#include "test.h"
+
+static bool has_flag(int argc, const char **argv, const char *flag) {
+    for (int i = 0; i <= argc; i++) {
+        if (!strcmp(argv[i], flag)) return true;
+    }
+    return false;
+}
+
+static void test_minor_versions(void) {
+    struct { const char *id; int minor; } cases[] = {
+        {"1.20.1", 20},
+        {"1.7.10", 7},
+        {"fabric-loader-0.15.0-1.20.1", 20},
+        {"fabric-loader-0.14.21-1.20.1", 20},
+        {"quilt-loader-0.19.2-1.20.1", 20},
+        {"1.12.2-forge-14.23.5.2860", 12},
+        {"1.20.1-forge-47.2.0", 20},
+        // NeoForge numbers its releases after the Minecraft version without "1."
+        {"neoforge-21.1.77", 21},
+        {"neoforge-20.4.237", 20},
+        {"neoforge-20.2.86", 20},
+        // The 1.20.1 fork still named after Forge
+        {"1.20.1-neoforge-47.1.106", 20},
+        {"23w31a", 0},
+        {"modpack", 0},
+        {"", 0}
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+        int minor = memgov_parse_minor_version(cases[i].id);
+        if (minor != cases[i].minor) {
+            fprintf(stderr, "%s is 1.%d, expected 1.%d\n", cases[i].id, minor, cases[i].minor);
+            CHECK(false);
+        }
+    }
+    CHECK_EQ_INT(memgov_parse_minor_version(NULL), 0);
+}
+
+static void test_sizing(void) {
+    // Vanilla 1.20 on an 8 GB device without the memorystatus entitlement
+    memgov_sizing_t sizing = memgov_compute_sizing((memgov_input_t){
+        .physicalMB = 8192, .maxRatio = 0.25, .mcMinorVersion = 20, .javaVersion = 17});
+    CHECK_EQ_INT(sizing.maxHeapMB, 1024);
+    CHECK_EQ_INT(sizing.initialHeapMB, 256);
+    CHECK_EQ_INT(sizing.metaspaceMB, 64);
+    CHECK_EQ_INT(sizing.jetsamLimitMB, 2048);
+
+    // The same pack on NeoForge gets the 1.21 base, not the unknown one
+    memgov_sizing_t neoforge = memgov_compute_sizing((memgov_input_t){
+        .physicalMB = 8192, .maxRatio = 0.25,
+        .mcMinorVersion = memgov_parse_minor_version("neoforge-21.1.77"), .modCount = 10});
+    CHECK_EQ_INT(neoforge.maxHeapMB, 1408);
+    memgov_sizing_t unknown = memgov_compute_sizing((memgov_input_t){
+        .physicalMB = 8192, .maxRatio = 0.25, .mcMinorVersion = 0, .modCount = 10});
+    CHECK_EQ_INT(unknown.maxHeapMB, 1024);
+
+    // Big packs are held to the device's share, in steps of 64 MB below it
+    sizing = memgov_compute_sizing((memgov_input_t){
+        .physicalMB = 6144, .maxRatio = 0.4, .mcMinorVersion = 20, .modCount = 300});
+    CHECK_EQ_INT(sizing.maxHeapMB, (int)(6144 * 0.4));
+    CHECK_EQ_INT(sizing.initialHeapMB, 512);
+    CHECK_EQ_INT(sizing.metaspaceMB, 512);
+    CHECK_EQ_INT(sizing.jetsamLimitMB, sizing.maxHeapMB + 1280);
+    sizing = memgov_compute_sizing((memgov_input_t){
+        .physicalMB = 16384, .maxRatio = 0.4, .mcMinorVersion = 16, .modCount = 150});
+    CHECK_EQ_INT(sizing.maxHeapMB, 3392);
+    CHECK_EQ_INT(sizing.metaspaceMB, 320);
+
+    // At least 512 MB unless the device can't spare it
+    sizing = memgov_compute_sizing((memgov_input_t){.physicalMB = 4096, .maxRatio = 0.25, .mcMinorVersion = 8});
+    CHECK_EQ_INT(sizing.maxHeapMB, 512);
+    CHECK_EQ_INT(sizing.initialHeapMB, 128);
+    sizing = memgov_compute_sizing((memgov_input_t){.physicalMB = 1536, .maxRatio = 0.25, .mcMinorVersion = 20});
+    CHECK_EQ_INT(sizing.maxHeapMB, 384);
+}
+
+static void test_gc_flags(void) {
+    const char *argv[16];
+    int argc = -1;
+
+    // Small heaps get Serial, and a trim request would pause the game
+    memgov_sizing_t small = {.maxHeapMB = 768, .metaspaceMB = 64};
+    CHECK(!memgov_append_gc_flags(small, 17, &argc, argv));
+    CHECK(has_flag(argc, argv, "-XX:MetaspaceSize=64M"));
+    CHECK(has_flag(argc, argv, "-XX:+UseSerialGC"));
+    CHECK(!has_flag(argc, argv, "-XX:+UseG1GC"));
+    CHECK(has_flag(argc, argv, "-XX:MaxHeapFreeRatio=30"));
+
+    // G1 collects concurrently on System.gc() and shrinks the heap afterwards since 12
+    memgov_sizing_t large = {.maxHeapMB = 2048, .metaspaceMB = 128};
+    argc = -1;
+    CHECK(memgov_append_gc_flags(large, 17, &argc, argv));
+    CHECK(has_flag(argc, argv, "-XX:+UseG1GC"));
+    CHECK(has_flag(argc, argv, "-XX:+ExplicitGCInvokesConcurrent"));
+    CHECK(has_flag(argc, argv, "-XX:G1PeriodicGCInterval=30000"));
+    CHECK(!has_flag(argc, argv, "-XX:+UseSerialGC"));
+    argc = -1;
+    CHECK(!memgov_append_gc_flags(large, 8, &argc, argv));
+    CHECK(has_flag(argc, argv, "-XX:+UseG1GC"));
+    CHECK(!has_flag(argc, argv, "-XX:+ExplicitGCInvokesConcurrent"));
+    CHECK(!has_flag(argc, argv, "-XX:G1PeriodicGCInterval=30000"));
+}
+
+static void test_args_set_gc(void) {
+    const char *picked[] = {
+        "-XX:+UseZGC",
+        "-Xmx2G -XX:+UseShenandoahGC -Dfoo=bar",
+        "-XX:-UseG1GC -XX:+UseParallelGC",
+        "-XX:MaxGCPauseMillis=20",
+        "-XX:G1NewSizePercent=20 -XX:G1ReservePercent=20"
+    };
+    for (size_t i = 0; i < sizeof(picked) / sizeof(*picked); i++) {
+        if (!memgov_args_set_gc(picked[i])) {
+            fprintf(stderr, "%s doesn't set the collector\n", picked[i]);
+            CHECK(false);
+        }
+    }
+    // Merely mentioning GC is not picking a collector
+    const char *notPicked[] = {
+        "",
+        "-Dsodium.GCThreshold=1",
+        "-XX:+PrintGCDetails",
+        "-XX:+DisableExplicitGC",
+        "-XX:+UseGCOverheadLimit",
+        "-XX:+UseStringDeduplication",
+        "-Xlog:gc*:file=gc.log",
+        "-XX:MaxGCPauseMillisExtra=1"
+    };
+    for (size_t i = 0; i < sizeof(notPicked) / sizeof(*notPicked); i++) {
+        if (memgov_args_set_gc(notPicked[i])) {
+            fprintf(stderr, "%s sets the collector\n", notPicked[i]);
+            CHECK(false);
+        }
+    }
+    CHECK(!memgov_args_set_gc(NULL));
+}
+
+int main(void) {
+    test_minor_versions();
+    test_sizing();
+    test_gc_flags();
+    test_args_set_gc();
+    return TEST_RESULT();
+}
@@ -0,0 +1,239 @@
+#include <string.h>
+
+#include "fixtures.h"
+#include "json_cursor.h"
+#include "mod_update.h"
+#include "test.h"
+
+// The mods folder update check against a fake Modrinth that answers
+// version_files/update and version_files from the request it is given.
+
+#define MOD_COUNT 300
+
+static const char *loaders[] = {"fabric", "fabric", "forge", "neoforge", NULL};
+
+typedef struct {
+    int updateRequests, lookupRequests;
+    // Update requests by loader, the last one counting those without
+    int perLoader[4];
+    int hashesSent;
+    bool wrongLoader, wrongGameVersion;
+    // Fails the request with this number, counting from 1
+    int failAt;
+    const char *canned;
+} fake_modrinth_t;
+
+static int mod_number(json_string_t hash) {
+    char text[64];
+    json_string_copy(hash, text, sizeof(text));
+    return atoi(text);
+}
+
+static const char *mod_loader(int i) {
+    return loaders[i % 5];
+}
+
+static void append(char **response, size_t *length, const char *text) {
+    size_t add = strlen(text);
+    *response = realloc(*response, *length + add + 1);
+    memcpy(*response + *length, text, add + 1);
+    *length += add;
+}
+
+// Mod i has an update if i % 4 == 0 and is current if i % 4 == 1. Of the
+// rest, Modrinth knows the ones with i % 4 == 2.
+static char *fake_post(void *context, const char *endpoint, const char *body, size_t *length) {
+    fake_modrinth_t *fake = context;
+    bool update = !strcmp(endpoint, "version_files/update");
+    CHECK(update || !strcmp(endpoint, "version_files"));
+    if (update) {
+        fake->updateRequests++;
+    } else {
+        fake->lookupRequests++;
+    }
+    if (fake->updateRequests + fake->lookupRequests == fake->failAt) {
+        return NULL;
+    }
+    if (fake->canned) {
+        const char *canned = update ? fake->canned : "{}";
+        *length = strlen(canned);
+        return strdup(canned);
+    }
+
+    json_cursor_t cursor;
+    json_cursor_init(&cursor, body, strlen(body));
+    json_string_t key, value;
+    int numbers[MOD_COUNT], count = 0;
+    const char *loader = NULL;
+    CHECK(json_enter_object(&cursor));
+    while (json_next_key(&cursor, &key)) {
+        if (json_string_equals(key, "hashes")) {
+            CHECK(json_enter_array(&cursor));
+            while (json_next_element(&cursor) && json_read_string(&cursor, &value) && count < MOD_COUNT) {
+                numbers[count++] = mod_number(value);
+            }
+        } else if (json_string_equals(key, "loaders")) {
+            CHECK(update && json_enter_array(&cursor) && json_next_element(&cursor));
+            json_read_string(&cursor, &value);
+            for (int i = 0; i < 4; i++) {
+                if (loaders[i] && json_string_equals(value, loaders[i])) loader = loaders[i];
+            }
+            CHECK(loader != NULL);
+            CHECK(!json_next_element(&cursor));
+        } else if (json_string_equals(key, "game_versions")) {
+            CHECK(json_enter_array(&cursor) && json_next_element(&cursor) && json_read_string(&cursor, &value));
+            fake->wrongGameVersion |= !json_string_equals(value, "1.20.1");
+            CHECK(!json_next_element(&cursor));
+        } else if (json_string_equals(key, "algorithm")) {
+            CHECK(json_read_string(&cursor, &value) && json_string_equals(value, "sha1"));
+        } else {
+            CHECK(false);
+            json_skip_value(&cursor);
+        }
+    }
+    if (update) {
+        fake->hashesSent += count;
+        fake->perLoader[loader == loaders[2] ? 1 : loader == loaders[3] ? 2 : loader ? 0 : 3]++;
+    }
+
+    char *response = NULL, entry[1024];
+    *length = 0;
+    append(&response, length, "{");
+    bool first = true;
+    for (int k = 0; k < count; k++) {
+        int i = numbers[k];
+        fake->wrongLoader |= update && mod_loader(i) != loader;
+        if (update && i % 4 == 0) {
+            // The update's own file is listed second and primary
+            snprintf(entry, sizeof(entry),
+                "%s\"%040d\":{\"version_number\":\"2.0.%d\",\"files\":["
+                "{\"hashes\":{\"sha1\":\"%040d\"},\"url\":\"https://cdn/%d-sources.jar\",\"filename\":\"mod%d-sources.jar\",\"primary\":false},"
+                "{\"hashes\":{\"sha512\":\"00\",\"sha1\":\"%040d\"},\"url\":\"https://cdn/%d.jar\",\"filename\":\"mod%d-2.0.jar\",\"primary\":true,\"size\":1}]}",
+                first ? "" : ",", i, i, 100000 + i, i, i, 200000 + i, i, i);
+        } else if (update && i % 4 == 1) {
+            snprintf(entry, sizeof(entry),
+                "%s\"%040d\":{\"version_number\":\"1.0.%d\",\"files\":[{\"hashes\":{\"sha1\":\"%040d\"},\"url\":\"https://cdn/%d.jar\",\"filename\":\"mod%d.jar\",\"primary\":true}]}",
+                first ? "" : ",", i, i, i, i, i);
+        } else if (!update && i % 4 == 2) {
+            snprintf(entry, sizeof(entry), "%s\"%040d\":{\"version_number\":\"0.9.%d\",\"files\":[]}", first ? "" : ",", i, i);
+        } else {
+            // Not in this response
+            CHECK(i % 4 >= 2);
+            continue;
+        }
+        append(&response, length, entry);
+        first = false;
+    }
+    append(&response, length, "}");
+    return response;
+}
+
+static void make_mods(mod_update_entry_t *mods, char (*hashes)[41]) {
+    memset(mods, 0, MOD_COUNT * sizeof(mod_update_entry_t));
+    for (int i = 0; i < MOD_COUNT; i++) {
+        snprintf(hashes[i], 41, "%040d", i);
+        // A few jars couldn't be read
+        mods[i].sha1 = i % 50 == 49 ? NULL : hashes[i];
+        mods[i].loader = mod_loader(i);
+    }
+    // The same jar twice, under another name
+    mods[298].sha1 = hashes[0];
+    mods[298].loader = mod_loader(0);
+}
+
+static void test_folder(void) {
+    static char hashes[MOD_COUNT][41];
+    mod_update_entry_t mods[MOD_COUNT];
+    make_mods(mods, hashes);
+    fake_modrinth_t fake = {0};
+    CHECK(mod_update_check(mods, MOD_COUNT, "1.20.1", fake_post, &fake));
+
+    // One update request per loader and a single lookup of the rest
+    CHECK_EQ_INT(fake.updateRequests, 4);
+    for (int i = 0; i < 4; i++) CHECK_EQ_INT(fake.perLoader[i], 1);
+    CHECK_EQ_INT(fake.lookupRequests, 1);
+    CHECK_EQ_INT(fake.hashesSent, MOD_COUNT - 6);
+    CHECK(!fake.wrongLoader);
+    CHECK(!fake.wrongGameVersion);
+
+    int wrong = 0;
+    char expected[64];
+    for (int i = 0; i < MOD_COUNT; i++) {
+        int n = i == 298 ? 0 : i;
+        mod_update_entry_t *mod = &mods[i];
+        if (!mod->sha1 || n % 4 == 3) {
+            wrong += mod->status != MOD_UPDATE_UNKNOWN || mod->latestVersion;
+        } else if (n % 4 == 0) {
+            snprintf(expected, sizeof(expected), "https://cdn/%d.jar", n);
+            wrong += mod->status != MOD_UPDATE_OUTDATED || !mod->downloadURL || strcmp(mod->downloadURL, expected);
+            snprintf(expected, sizeof(expected), "mod%d-2.0.jar", n);
+            wrong += !mod->fileName || strcmp(mod->fileName, expected);
+            snprintf(expected, sizeof(expected), "2.0.%d", n);
+            wrong += !mod->latestVersion || strcmp(mod->latestVersion, expected);
+        } else if (n % 4 == 1) {
+            snprintf(expected, sizeof(expected), "1.0.%d", n);
+            wrong += mod->status != MOD_UPDATE_UP_TO_DATE || !mod->latestVersion || strcmp(mod->latestVersion, expected);
+        } else {
+            // Known to Modrinth without a compatible update
+            snprintf(expected, sizeof(expected), "0.9.%d", n);
+            wrong += mod->status != MOD_UPDATE_UP_TO_DATE || !mod->latestVersion || strcmp(mod->latestVersion, expected) || mod->downloadURL;
+        }
+        if (wrong) {
+            fprintf(stderr, "mod %d: status %d, version %s\n", i, mod->status, mod->latestVersion ? mod->latestVersion : "(none)");
+            CHECK(false);
+            break;
+        }
+    }
+
+    // A failed request leaves the previous results alone
+    fake = (fake_modrinth_t){.failAt = 3};
+    CHECK(!mod_update_check(mods, MOD_COUNT, "1.20.1", fake_post, &fake));
+    CHECK_EQ_INT(fake.updateRequests, 3);
+    CHECK_EQ_INT(mods[0].status, MOD_UPDATE_OUTDATED);
+    CHECK(mods[1].latestVersion && !strcmp(mods[1].latestVersion, "1.0.1"));
+    fake = (fake_modrinth_t){.failAt = 5};
+    CHECK(!mod_update_check(mods, MOD_COUNT, NULL, fake_post, &fake));
+    CHECK_EQ_INT(fake.lookupRequests, 1);
+    CHECK_EQ_INT(mods[2].status, MOD_UPDATE_UP_TO_DATE);
+    for (int i = 0; i < MOD_COUNT; i++) mod_update_entry_free(&mods[i]);
+
+    // Nothing to look up, nothing sent
+    fake = (fake_modrinth_t){0};
+    mod_update_entry_t unhashed = {.loader = "fabric"};
+    CHECK(mod_update_check(&unhashed, 1, "1.20.1", fake_post, &fake));
+    CHECK_EQ_INT(fake.updateRequests + fake.lookupRequests, 0);
+    CHECK(mod_update_check(NULL, 0, NULL, fake_post, &fake));
+}
+
+static void test_modrinth_response(void) {
+    // Sodium has an update whose primary file is listed last, Lithium is current
+    mod_update_entry_t mods[] = {
+        {.sha1 = "9c9f3d4b5a8e3e0f1c2d7a6b5c4d3e2f1a0b9c8d", .loader = "fabric"},
+        {.sha1 = "5e4d3c2b1a09f8e7d6c5b4a3928170f6e5d4c3b2", .loader = "fabric"},
+        {.sha1 = "0000000000000000000000000000000000000000", .loader = "fabric"}
+    };
+    size_t length;
+    fake_modrinth_t fake = {.canned = fixture_read("modrinth/version_files_update.json", &length)};
+    CHECK(fake.canned != NULL);
+    if (!fake.canned) return;
+    CHECK(mod_update_check(mods, 3, "1.20.1", fake_post, &fake));
+    CHECK_EQ_INT(fake.updateRequests, 1);
+    CHECK_EQ_INT(fake.lookupRequests, 1);
+
+    CHECK_EQ_INT(mods[0].status, MOD_UPDATE_OUTDATED);
+    CHECK(mods[0].latestVersion && !strcmp(mods[0].latestVersion, "mc1.20.1-0.5.11"));
+    CHECK(mods[0].fileName && !strcmp(mods[0].fileName, "sodium-fabric-0.5.11+mc1.20.1.jar"));
+    CHECK(mods[0].downloadURL && !strcmp(mods[0].downloadURL,
+        "https://cdn.modrinth.com/data/AANobbMI/versions/OihdIimA/sodium-fabric-0.5.11%2Bmc1.20.1.jar"));
+    CHECK_EQ_INT(mods[1].status, MOD_UPDATE_UP_TO_DATE);
+    CHECK(mods[1].latestVersion && !strcmp(mods[1].latestVersion, "mc1.20.1-0.11.2"));
+    CHECK_EQ_INT(mods[2].status, MOD_UPDATE_UNKNOWN);
+    for (int i = 0; i < 3; i++) mod_update_entry_free(&mods[i]);
+    free((char *)fake.canned);
+}
+
+int main(void) {
+    test_folder();
+    test_modrinth_response();
+    return TEST_RESULT();
+}
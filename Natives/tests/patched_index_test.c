@@ -0,0 +1,146 @@
+#include <limits.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fixtures.h"
+#include "patched_index.h"
+#include "test.h"
+
+static char dir[PATH_MAX], indexPath[PATH_MAX];
+
+static const char *lib_path(const char *name) {
+    static char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    return path;
+}
+
+static void write_lib(const char *name, const char *content) {
+    FILE *file = fopen(lib_path(name), "w");
+    fputs(content, file);
+    fclose(file);
+}
+
+static bool contains(patched_index_t *index, const char *name) {
+    struct stat st;
+    const char *path = lib_path(name);
+    return stat(path, &st) == 0 && patched_index_contains(index, path, &st);
+}
+
+static void add(patched_index_t *index, const char *name) {
+    struct stat st;
+    const char *path = lib_path(name);
+    CHECK(stat(path, &st) == 0);
+    patched_index_add(index, path, &st);
+}
+
+static int count_lines(const char *path) {
+    size_t length;
+    char *text = fixture_read_path(path, &length);
+    int lines = 0;
+    for (size_t i = 0; text && i < length; i++) lines += text[i] == '\n';
+    free(text);
+    return lines;
+}
+
+int main(void) {
+    char *temp = fixture_temp_dir("patched_index");
+    strcpy(dir, temp);
+    free(temp);
+    snprintf(indexPath, sizeof(indexPath), "%s/.patched_dylibs", dir);
+    write_lib("liba.dylib", "a");
+    write_lib("libb.dylib", "b");
+    write_lib("libc.dylib", "c");
+
+    patched_index_t *index = patched_index_open(indexPath);
+    CHECK(!contains(index, "liba.dylib"));
+    add(index, "liba.dylib");
+    add(index, "libb.dylib");
+    add(index, "libc.dylib");
+    CHECK(contains(index, "liba.dylib"));
+    CHECK(contains(index, "libb.dylib"));
+
+    // Loading the same library again does not grow the file
+    add(index, "liba.dylib");
+    add(index, "liba.dylib");
+    CHECK_EQ_INT(patched_index_count(index), 3);
+    CHECK_EQ_INT(count_lines(indexPath), 3);
+
+    // Rewritten within the same second, with the same size
+    struct stat st;
+    stat(lib_path("libb.dylib"), &st);
+    write_lib("libb.dylib", "B");
+    struct timespec times[2] = {st.st_atim, {st.st_mtim.tv_sec, (st.st_mtim.tv_nsec + 1) % 1000000000}};
+    utimensat(AT_FDCWD, lib_path("libb.dylib"), times, 0);
+    CHECK(!contains(index, "libb.dylib"));
+    // Replaced by a different file
+    unlink(lib_path("libc.dylib"));
+    write_lib("libc.dylib", "c");
+    write_lib("other", "x");
+    rename(lib_path("other"), lib_path("libc.dylib"));
+    CHECK(!contains(index, "libc.dylib"));
+
+    // Re-checked and recorded again: one entry per path, the file has the update appended
+    add(index, "libb.dylib");
+    CHECK(contains(index, "libb.dylib"));
+    CHECK_EQ_INT(patched_index_count(index), 3);
+    CHECK_EQ_INT(count_lines(indexPath), 4);
+
+    // Temp directories and relative paths are not recorded
+    patched_index_skip_prefix(index, lib_path("tmp/"));
+    mkdir(lib_path("tmp"), 0755);
+    write_lib("tmp/libjna.dylib", "j");
+    add(index, "tmp/libjna.dylib");
+    CHECK(!contains(index, "tmp/libjna.dylib"));
+    stat(lib_path("liba.dylib"), &st);
+    patched_index_add(index, "liba.dylib", &st);
+    CHECK_EQ_INT(patched_index_count(index), 3);
+    patched_index_close(index);
+
+    // Reopened: the changed libc entry and the superseded libb line are dropped
+    // and the file is compacted
+    unlink(lib_path("liba.dylib"));
+    index = patched_index_open(indexPath);
+    CHECK(!contains(index, "liba.dylib"));
+    CHECK(contains(index, "libb.dylib"));
+    CHECK(!contains(index, "libc.dylib"));
+    CHECK_EQ_INT(patched_index_count(index), 1);
+    CHECK_EQ_INT(count_lines(indexPath), 1);
+
+    // Garbage lines are dropped as well
+    FILE *file = fopen(indexPath, "a");
+    fputs("not an entry\n12 34\n", file);
+    fclose(file);
+    patched_index_close(index);
+    index = patched_index_open(indexPath);
+    CHECK_EQ_INT(patched_index_count(index), 1);
+    CHECK_EQ_INT(count_lines(indexPath), 1);
+
+    // Many libraries, still one line and one lookup each
+    char name[64];
+    for (int i = 0; i < 2000; i++) {
+        snprintf(name, sizeof(name), "lib%d.dylib", i);
+        write_lib(name, name);
+        add(index, name);
+    }
+    CHECK_EQ_INT(patched_index_count(index), 2001);
+    for (int i = 0; i < 2000; i += 97) {
+        snprintf(name, sizeof(name), "lib%d.dylib", i);
+        CHECK(contains(index, name));
+    }
+    patched_index_close(index);
+    index = patched_index_open(indexPath);
+    CHECK_EQ_INT(patched_index_count(index), 2001);
+    CHECK_EQ_INT(count_lines(indexPath), 2001);
+    patched_index_close(index);
+
+    // Without a writable file it still works in memory
+    index = patched_index_open("/nonexistent/dir/.patched_dylibs");
+    add(index, "libb.dylib");
+    CHECK(contains(index, "libb.dylib"));
+    patched_index_close(index);
+
+    fixture_remove_tree(dir);
+    return TEST_RESULT();
+}
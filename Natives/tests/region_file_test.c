@@ -0,0 +1,306 @@
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "backup_store.h"
+#include "fixtures.h"
+#include "region_file.h"
+#include "test.h"
+
+// World backups over synthetic .mca files: the header and every chunk
+// become their own segment, so a chunk the game didn't rewrite is stored once
+// across snapshots, and a restore gives back the same bytes.
+
+#define SECTOR REGION_SECTOR_SIZE
+
+typedef struct {
+    int index, sector, count;
+    uint32_t seed;
+} test_chunk_t;
+
+static uint32_t next_random(uint32_t *state) {
+    *state = *state * 1664525 + 1013904223;
+    return *state >> 8;
+}
+
+// A region file of the given size in sectors, chunk data is noise filling
+// its sectors like compressed data that doesn't compress any further
+static uint8_t *build_region(size_t sectors, const test_chunk_t *chunks, size_t count) {
+    uint8_t *file = calloc(sectors, SECTOR);
+    for (size_t i = 0; i < count; i++) {
+        const test_chunk_t *chunk = &chunks[i];
+        uint8_t *entry = file + chunk->index * 4;
+        entry[0] = chunk->sector >> 16;
+        entry[1] = chunk->sector >> 8;
+        entry[2] = chunk->sector;
+        entry[3] = chunk->count;
+        uint8_t *timestamp = file + 4096 + chunk->index * 4;
+        timestamp[3] = (uint8_t)chunk->seed;
+        if ((size_t)(chunk->sector + chunk->count) > sectors) continue;
+
+        uint8_t *data = file + (size_t)chunk->sector * SECTOR;
+        uint32_t length = chunk->count * SECTOR - 4;
+        data[0] = length >> 24;
+        data[1] = length >> 16;
+        data[2] = length >> 8;
+        data[3] = length;
+        data[4] = 2;
+        uint32_t state = chunk->seed;
+        for (uint32_t j = 5; j < length + 4; j++) data[j] = next_random(&state);
+    }
+    return file;
+}
+
+static void write_file(const char *path, const uint8_t *bytes, size_t length) {
+    FILE *file = fopen(path, "wb");
+    CHECK(file && fwrite(bytes, 1, length, file) == length);
+    if (file) fclose(file);
+}
+
+static int count_objects(const char *storePath) {
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/objects", storePath);
+    DIR *objects = opendir(path);
+    if (!objects) return 0;
+    int count = 0;
+    struct dirent *prefix;
+    while ((prefix = readdir(objects))) {
+        if (prefix->d_name[0] == '.') continue;
+        char prefixPath[4096 + 256];
+        snprintf(prefixPath, sizeof(prefixPath), "%s/%s", path, prefix->d_name);
+        DIR *dir = opendir(prefixPath);
+        struct dirent *object;
+        while (dir && (object = readdir(dir))) {
+            count += object->d_name[0] != '.' && !strchr(object->d_name, '.');
+        }
+        if (dir) closedir(dir);
+    }
+    closedir(objects);
+    return count;
+}
+
+static uint8_t object_type(const char *storePath, const char *hash) {
+    char path[4096];
+    backup_object_path(storePath, hash, path, sizeof(path));
+    size_t length;
+    uint8_t *object = (uint8_t *)fixture_read_path(path, &length);
+    uint8_t type = object && length > 0 ? object[0] : 0xff;
+    free(object);
+    return type;
+}
+
+static void test_sha1(void) {
+    char hex[SHA1_HEX_LENGTH + 1];
+    sha1_hex("", 0, hex);
+    CHECK(!strcmp(hex, "da39a3ee5e6b4b0d3255bfef95601890afd80709"));
+    sha1_hex("abc", 3, hex);
+    CHECK(!strcmp(hex, "a9993e364706816aba3e25717850c26c9cd0d89d"));
+    // 56 bytes, the length needs a second padding block
+    const char *twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    sha1_hex(twoBlocks, strlen(twoBlocks), hex);
+    CHECK(!strcmp(hex, "84983e441c3bd26ebaae4aa1f95129e5e54670f1"));
+    char *million = malloc(1000000);
+    memset(million, 'a', 1000000);
+    sha1_hex(million, 1000000, hex);
+    CHECK(!strcmp(hex, "34aa973cd4c4daa4f61eeb2bdbad27316534016f"));
+    free(million);
+}
+
+static bool segments_are(const region_segment_t *segments, size_t count, const uint64_t (*expected)[2], size_t expectedCount) {
+    bool same = count == expectedCount;
+    for (size_t i = 0; same && i < count; i++) {
+        same = segments[i].offset == expected[i][0] && segments[i].length == expected[i][1];
+    }
+    if (!same) {
+        fprintf(stderr, "segments:");
+        for (size_t i = 0; i < count; i++) {
+            fprintf(stderr, " %llu+%llu", (unsigned long long)segments[i].offset, (unsigned long long)segments[i].length);
+        }
+        fprintf(stderr, "\n");
+    }
+    return same;
+}
+
+static void test_split(void) {
+    region_segment_t segments[REGION_MAX_SEGMENTS];
+
+    // Chunks listed out of file order, a free sector between them and trailing bytes
+    test_chunk_t chunks[] = {
+        {.index = 0, .sector = 5, .count = 2, .seed = 1},
+        {.index = 1, .sector = 2, .count = 1, .seed = 2},
+        {.index = 32, .sector = 3, .count = 1, .seed = 3}
+    };
+    uint8_t *file = build_region(8, chunks, 3);
+    const uint64_t expected[][2] = {
+        {0, 8192}, {8192, 4096}, {12288, 4096}, {16384, 4096}, {20480, 8192}, {28672, 4096}
+    };
+    size_t count = region_split_segments(file, 8 * SECTOR, segments);
+    CHECK(segments_are(segments, count, expected, 6));
+    free(file);
+
+    // A damaged table: entries inside the header, past the end, overlapping
+    // another chunk, and a last chunk cut short
+    test_chunk_t damaged[] = {
+        {.index = 0, .sector = 2, .count = 2, .seed = 1},
+        {.index = 1, .sector = 1, .count = 1, .seed = 2},
+        {.index = 2, .sector = 40, .count = 1, .seed = 3},
+        {.index = 3, .sector = 3, .count = 2, .seed = 4},
+        {.index = 4, .sector = 4, .count = 1, .seed = 5},
+        {.index = 5, .sector = 6, .count = 4, .seed = 6}
+    };
+    file = build_region(8, damaged, 6);
+    const uint64_t expectedDamaged[][2] = {
+        {0, 8192}, {8192, 8192}, {16384, 4096}, {20480, 4096}, {24576, 8192}
+    };
+    count = region_split_segments(file, 8 * SECTOR, segments);
+    CHECK(segments_are(segments, count, expectedDamaged, 5));
+    free(file);
+
+    // Nothing past the header, or not even all of it
+    uint8_t header[REGION_HEADER_SIZE] = {0};
+    const uint64_t headerOnly[][2] = {{0, 8192}};
+    count = region_split_segments(header, REGION_HEADER_SIZE, segments);
+    CHECK(segments_are(segments, count, headerOnly, 1));
+    CHECK_EQ_INT(region_split_segments(header, 0, segments), 0);
+
+    // Every chunk of a full region, segments cover the file in order
+    test_chunk_t full[1024];
+    for (int i = 0; i < 1024; i++) {
+        full[i] = (test_chunk_t){.index = i, .sector = 2 + (1023 - i) * 2, .count = 1 + i % 2, .seed = i};
+    }
+    file = build_region(2 + 2048, full, 1024);
+    count = region_split_segments(file, (2 + 2048) * SECTOR, segments);
+    CHECK(count <= REGION_MAX_SEGMENTS);
+    CHECK_EQ_INT(count, 1 + 1024 + 512);
+    uint64_t cursor = 0;
+    for (size_t i = 0; i < count; i++) {
+        CHECK(segments[i].offset == cursor && segments[i].length > 0);
+        cursor += segments[i].length;
+    }
+    CHECK_EQ_INT(cursor, (2 + 2048) * SECTOR);
+    free(file);
+}
+
+static void test_backup(void) {
+    char *temp = fixture_temp_dir("region_file");
+    char store[4096], world[4096], restored[4096];
+    snprintf(store, sizeof(store), "%s/store", temp);
+    snprintf(world, sizeof(world), "%s/r.0.0.mca", temp);
+    snprintf(restored, sizeof(restored), "%s/restored.mca", temp);
+    mkdir(store, 0755);
+    // As WorldBackupManager's initializer leaves it
+    strcat(store, "/objects");
+    mkdir(store, 0755);
+    store[strlen(store) - strlen("/objects")] = '\0';
+
+    // 64 chunks of one or two sectors
+    test_chunk_t chunks[64];
+    int sector = 2;
+    for (int i = 0; i < 64; i++) {
+        chunks[i] = (test_chunk_t){.index = i * 7 % 1024, .sector = sector, .count = 1 + i % 2, .seed = 100 + i};
+        sector += chunks[i].count;
+    }
+    size_t fileSize = (size_t)sector * SECTOR;
+    uint8_t *file = build_region(sector, chunks, 64);
+    write_file(world, file, fileSize);
+
+    size_t count, plainCount;
+    uint64_t added = 0;
+    backup_hash_t *first = backup_store_file(store, world, true, &count, &added);
+    CHECK(first != NULL);
+    if (!first) return;
+    CHECK_EQ_INT(count, 65);
+    CHECK_EQ_INT(count_objects(store), 65);
+    // The mostly empty header compresses, chunk data already is
+    CHECK_EQ_INT(object_type(store, first[0]), BACKUP_OBJECT_ZLIB);
+    CHECK_EQ_INT(object_type(store, first[1]), BACKUP_OBJECT_RAW);
+    CHECK(added > fileSize - 8192 && added < fileSize);
+
+    // Backed up again unchanged, nothing is written
+    added = 0;
+    size_t againCount;
+    backup_hash_t *again = backup_store_file(store, world, true, &againCount, &added);
+    CHECK(again && againCount == count && !memcmp(again, first, count * sizeof(backup_hash_t)));
+    CHECK_EQ_INT(added, 0);
+    free(again);
+
+    // The game rewrote two chunks in place: only those and the header are new
+    chunks[10].seed = 1000;
+    chunks[41].seed = 1001;
+    free(file);
+    file = build_region(sector, chunks, 64);
+    write_file(world, file, fileSize);
+    added = 0;
+    backup_hash_t *second = backup_store_file(store, world, true, &againCount, &added);
+    CHECK(second && againCount == count);
+    if (!second) return;
+    CHECK_EQ_INT(count_objects(store), 68);
+    int changed = 0;
+    for (size_t i = 0; i < count; i++) {
+        changed += strcmp(first[i], second[i]) != 0;
+    }
+    CHECK_EQ_INT(changed, 3);
+    CHECK(strcmp(first[0], second[0]) && strcmp(first[11], second[11]) && strcmp(first[42], second[42]));
+    CHECK(added < 4 * 2 * SECTOR);
+
+    // Both snapshots restore byte for byte
+    const char *hashes[65];
+    for (size_t i = 0; i < count; i++) hashes[i] = second[i];
+    CHECK(backup_restore_file(store, hashes, count, restored));
+    size_t length;
+    char *bytes = fixture_read_path(restored, &length);
+    CHECK(bytes && length == fileSize && !memcmp(bytes, file, fileSize));
+    free(bytes);
+    for (size_t i = 0; i < count; i++) hashes[i] = first[i];
+    CHECK(backup_restore_file(store, hashes, count, restored));
+    chunks[10].seed = 110;
+    chunks[41].seed = 141;
+    uint8_t *original = build_region(sector, chunks, 64);
+    bytes = fixture_read_path(restored, &length);
+    CHECK(bytes && length == fileSize && !memcmp(bytes, original, fileSize));
+    free(bytes);
+    free(original);
+
+    // Other files are cut every megabyte
+    snprintf(world, sizeof(world), "%s/level.dat", temp);
+    size_t plainSize = BACKUP_SEGMENT_SIZE * 5 / 2;
+    uint8_t *plainBytes = calloc(1, plainSize);
+    write_file(world, plainBytes, plainSize);
+    backup_hash_t *plain = backup_store_file(store, world, false, &plainCount, &added);
+    CHECK(plain && plainCount == 3);
+    if (plain) {
+        // The first two are the same megabyte of zeros
+        CHECK(!strcmp(plain[0], plain[1]) && strcmp(plain[1], plain[2]));
+        const char *plainHashes[] = {plain[0], plain[1], plain[2]};
+        CHECK(backup_restore_file(store, plainHashes, 3, restored));
+        bytes = fixture_read_path(restored, &length);
+        CHECK(bytes && length == plainSize && !memcmp(bytes, plainBytes, plainSize));
+        free(bytes);
+        CHECK(backup_restore_file(store, hashes, count, restored));
+    }
+    free(plain);
+    free(plainBytes);
+
+    // A missing segment fails the restore and leaves the old file alone
+    hashes[0] = "0000000000000000000000000000000000000000";
+    CHECK(!backup_restore_file(store, hashes, 65, restored));
+    bytes = fixture_read_path(restored, &length);
+    CHECK(bytes && length == fileSize);
+    free(bytes);
+    snprintf(world, sizeof(world), "%s/restored.mca.restore.tmp", temp);
+    CHECK(access(world, F_OK) != 0);
+
+    free(first);
+    free(second);
+    free(file);
+    fixture_remove_tree(temp);
+    free(temp);
+}
+
+int main(void) {
+    test_sha1();
+    test_split();
+    test_backup();
+    return TEST_RESULT();
+}
@@ -0,0 +1,91 @@
+#include <dlfcn.h>
+#include <math.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include "ctxbridges/renderer_bench.h"
+#include "test.h"
+
+// The renderer probe workload on Mesa's surfaceless platform (llvmpipe):
+// desktop GL runs it, GLES rejects the core profile shaders like a renderer
+// the game couldn't use.
+
+static EGLDisplay display;
+static EGLSurface surface;
+
+static EGLContext make_current(EGLenum api, const EGLint *contextAttribs) {
+    EGLint renderable = api == EGL_OPENGL_API ? EGL_OPENGL_BIT : EGL_OPENGL_ES3_BIT;
+    const EGLint attribs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, renderable, EGL_NONE};
+    EGLConfig config;
+    EGLint count = 0;
+    if (!eglChooseConfig(display, attribs, &config, 1, &count) || count == 0 || !eglBindAPI(api)) {
+        return EGL_NO_CONTEXT;
+    }
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT) return EGL_NO_CONTEXT;
+    // The same 1x1 pbuffer the probe's standalone context gets from gl_bridge
+    const EGLint pbufferAttribs[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE};
+    surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+    if (surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context)) {
+        if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+        eglDestroyContext(display, context);
+        return EGL_NO_CONTEXT;
+    }
+    return context;
+}
+
+static void release(EGLContext context) {
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroySurface(display, surface);
+    eglDestroyContext(display, context);
+}
+
+int main(void) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    display = getPlatformDisplay ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL) : EGL_NO_DISPLAY;
+    void *desktopGL = dlopen("libOpenGL.so.0", RTLD_NOW | RTLD_LOCAL);
+    void *gles = dlopen("libGLESv2.so.2", RTLD_NOW | RTLD_LOCAL);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL) || !desktopGL || !gles) {
+        fprintf(stderr, "No Mesa surfaceless EGL, skipping\n");
+        return TEST_SKIPPED;
+    }
+
+    // A library without GL is not a candidate
+    renderer_bench_gl_t gl;
+    void *libc = dlopen("libc.so.6", RTLD_NOW | RTLD_LOCAL);
+    CHECK(!renderer_bench_load(libc, &gl));
+
+    // Core profile desktop GL, as with ANGLE's desktop GL frontend
+    const EGLint coreAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 2,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = make_current(EGL_OPENGL_API, coreAttribs);
+    CHECK(context != EGL_NO_CONTEXT);
+    CHECK(renderer_bench_load(desktopGL, &gl));
+    renderer_bench_result_t result = {0};
+    if (context != EGL_NO_CONTEXT) {
+        CHECK(renderer_bench_run(&gl, &result));
+        CHECK(result.compile > 0 && result.upload > 0 && result.draw > 0);
+        CHECK(fabs(result.score - (result.draw + (result.upload + result.compile) / 4)) < 1e-9);
+        printf("llvmpipe: compile %.1f ms, upload %.1f ms, draw %.1f ms, score %.1f\n",
+            result.compile, result.upload, result.draw, result.score);
+        release(context);
+    }
+
+    // "#version 150" doesn't compile on ES, the renderer is reported unusable
+    const EGLint esAttribs[] = {EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE};
+    context = make_current(EGL_OPENGL_ES_API, esAttribs);
+    CHECK(context != EGL_NO_CONTEXT);
+    CHECK(renderer_bench_load(gles, &gl));
+    if (context != EGL_NO_CONTEXT) {
+        CHECK(!renderer_bench_run(&gl, &result));
+        release(context);
+    }
+
+    eglTerminate(display);
+    return TEST_RESULT();
+}
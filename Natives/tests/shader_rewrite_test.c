@@ -0,0 +1,52 @@
+#include <string.h>
+
+#include "fixtures.h"
+#include "stubs/stub_gl.h"
+#include "test.h"
+
+// Runs a fixture through tinygl4angle's glShaderSource, returns what reached the driver
+static const char *rewrite(const char *fixture) {
+    char *source = fixture_read(fixture, NULL);
+    CHECK(source != NULL);
+    if (!source) return "";
+    stub_gl_reset_stats();
+    const GLchar *sources[] = {source};
+    glShaderSource(1, 1, sources, NULL);
+    free(source);
+    return stub_gl_stats.lastShaderSource;
+}
+
+static int line_of(const char *text, const char *needle) {
+    const char *found = strstr(text, needle);
+    if (!found) return -1;
+    int line = 1;
+    for (const char *p = text; p < found; p++) line += *p == '\n';
+    return line;
+}
+
+int main(void) {
+    // 1.30 to 1.50 run as 3.30, with the extensions right after #version
+    const char *vertex = rewrite("shaders/rendertype_solid.vsh");
+    CHECK(vertex && !strncmp(vertex, "#version 330\n", 13));
+    CHECK(vertex && line_of(vertex, "#extension GL_EXT_blend_func_extended") == 2);
+    CHECK(vertex && strstr(vertex, "vertexColor = Color * minecraft_sample_lightmap(Sampler2, UV2);"));
+
+    // No "core", separate color outputs become gl_FragData
+    const char *terrain = rewrite("shaders/gbuffers_terrain.fsh");
+    CHECK(terrain && !strncmp(terrain, "#version 330", 12));
+    CHECK(terrain && !strstr(terrain, "core\n"));
+    CHECK(terrain && strstr(terrain, "#define outColor0 gl_FragData[0]"));
+    CHECK(terrain && strstr(terrain, "#define outColor2 gl_FragData[2]"));
+    CHECK(terrain && !strstr(terrain, "out vec4 outColor"));
+
+    // No #version means 1.20
+    const char *legacy = rewrite("shaders/legacy_fog.fsh");
+    CHECK(legacy && !strncmp(legacy, "#version 120\n", 13));
+    CHECK(legacy && strstr(legacy, "gl_FragColor = vec4(mix(gl_Fog.color.rgb, color.rgb, fog), color.a);"));
+
+    // ES shaders are gl4es' business and never reach the driver here
+    CHECK(rewrite("shaders/blit_es.fsh") == NULL);
+
+    stub_gl_reset_stats();
+    return TEST_RESULT();
+}
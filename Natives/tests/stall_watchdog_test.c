@@ -0,0 +1,142 @@
+#include <dirent.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fixtures.h"
+#include "stall_watchdog.h"
+#include "test.h"
+
+// The watchdog against a fake game thread that beats every few milliseconds
+// until told to hang. Thresholds are short so the test runs in about a second.
+
+#define THRESHOLD_MS 80
+
+static char dir[PATH_MAX];
+static atomic_bool hanging, quit;
+static atomic_int captures;
+static pthread_t capturedThread;
+
+static void capture(void *context, int fd, pthread_t gameThread) {
+    capturedThread = gameThread;
+    dprintf(fd, "%s\n", (const char *)context);
+    atomic_fetch_add(&captures, 1);
+}
+
+static void *game_main(void *arg) {
+    while (!atomic_load(&quit)) {
+        if (!atomic_load(&hanging)) stall_watchdog_beat();
+        usleep(2000);
+    }
+    return NULL;
+}
+
+static void sleep_ms(int ms) {
+    usleep(ms * 1000);
+}
+
+// Path of the only report, NULL if there is none or several
+static const char *find_report(void) {
+    static char path[PATH_MAX];
+    DIR *handle = opendir(dir);
+    if (!handle) return NULL;
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(handle))) {
+        if (strncmp(entry->d_name, "stall-", 6)) continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        count++;
+    }
+    closedir(handle);
+    return count == 1 ? path : NULL;
+}
+
+static void clear_reports(void) {
+    fixture_remove_tree(dir);
+    atomic_store(&captures, 0);
+}
+
+int main(void) {
+    char *temp = fixture_temp_dir("stall_watchdog");
+    snprintf(dir, sizeof(dir), "%s/logs", temp);
+    free(temp);
+    stall_watchdog_config_t config = {
+        .thresholdMs = THRESHOLD_MS,
+        .reportDir = dir,
+        .context = "native stacks here",
+        .capture = capture
+    };
+    CHECK(!stall_watchdog_start(&(stall_watchdog_config_t){.thresholdMs = 0, .reportDir = dir}));
+    // A directory that doesn't fit a path
+    char longDir[PATH_MAX + 16];
+    memset(longDir, 'a', sizeof(longDir) - 1);
+    longDir[sizeof(longDir) - 1] = '\0';
+    CHECK(!stall_watchdog_start(&(stall_watchdog_config_t){.thresholdMs = THRESHOLD_MS, .reportDir = longDir}));
+    CHECK(stall_watchdog_start(&config));
+    CHECK(!stall_watchdog_start(&config));
+
+    // Nothing is reported before the first frame
+    sleep_ms(THRESHOLD_MS * 3);
+    CHECK_EQ_INT(atomic_load(&captures), 0);
+
+    pthread_t game;
+    pthread_create(&game, NULL, game_main, NULL);
+    sleep_ms(THRESHOLD_MS * 2);
+    CHECK_EQ_INT(atomic_load(&captures), 0);
+
+    // A hang is reported once, with the platform's details about the game thread
+    atomic_store(&hanging, true);
+    sleep_ms(THRESHOLD_MS * 3);
+    CHECK_EQ_INT(atomic_load(&captures), 1);
+    CHECK(pthread_equal(capturedThread, game));
+    atomic_store(&hanging, false);
+    sleep_ms(THRESHOLD_MS);
+    const char *report = find_report();
+    CHECK(report != NULL);
+    size_t length;
+    char *text = report ? fixture_read_path(report, &length) : NULL;
+    CHECK(text && strstr(text, "Game thread stalled at ") == text);
+    CHECK(text && strstr(text, "(threshold 80 ms)"));
+    CHECK(text && strstr(text, "native stacks here\n"));
+    CHECK(text && strstr(text, "\nRecovered after about "));
+    free(text);
+    clear_reports();
+
+    // Paused, e.g. in the background, missing frames don't count, also right after resuming
+    stall_watchdog_set_paused(true);
+    atomic_store(&hanging, true);
+    sleep_ms(THRESHOLD_MS * 3);
+    stall_watchdog_set_paused(false);
+    atomic_store(&hanging, false);
+    sleep_ms(THRESHOLD_MS);
+    CHECK_EQ_INT(atomic_load(&captures), 0);
+
+    // Once stopped, the game may stop rendering for as long as it takes to exit
+    double start = fixture_now();
+    stall_watchdog_stop();
+    CHECK(fixture_now() - start < THRESHOLD_MS / 1000.0);
+    stall_watchdog_stop();
+    atomic_store(&hanging, true);
+    sleep_ms(THRESHOLD_MS * 3);
+    CHECK_EQ_INT(atomic_load(&captures), 0);
+    CHECK(find_report() == NULL);
+
+    // Started again, it watches again from the next frame
+    CHECK(stall_watchdog_start(&config));
+    sleep_ms(THRESHOLD_MS * 3);
+    CHECK_EQ_INT(atomic_load(&captures), 0);
+    atomic_store(&hanging, false);
+    sleep_ms(THRESHOLD_MS);
+    atomic_store(&hanging, true);
+    sleep_ms(THRESHOLD_MS * 3);
+    CHECK_EQ_INT(atomic_load(&captures), 1);
+    stall_watchdog_stop();
+
+    atomic_store(&quit, true);
+    pthread_join(game, NULL);
+    fixture_remove_tree(dir);
+    dir[strlen(dir) - 5] = '\0';
+    fixture_remove_tree(dir);
+    return TEST_RESULT();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// The parts of <mach-o/fat.h> used by macho_patch.c, for non-Apple hosts.
+// Fat headers are stored big endian.
+
+#include <mach-o/loader.h>
+
+#define FAT_MAGIC 0xcafebabe
+#define FAT_CIGAM 0xbebafeca
+
+struct fat_header {
+    uint32_t magic;
+    uint32_t nfat_arch;
+};
+
+struct fat_arch {
+    cpu_type_t cputype;
+    cpu_subtype_t cpusubtype;
+    uint32_t offset;
+    uint32_t size;
+    uint32_t align;
+};
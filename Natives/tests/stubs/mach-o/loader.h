@@ -0,0 +1,64 @@
+#pragma once
+
+// The parts of <mach-o/loader.h> used by macho_patch.c, for non-Apple hosts.
+// Layouts follow the Mach-O format as documented in Apple's headers.
+
+#include <stdint.h>
+
+typedef int cpu_type_t;
+typedef int cpu_subtype_t;
+
+#define CPU_ARCH_ABI64 0x01000000
+#define CPU_TYPE_ARM 12
+#define CPU_TYPE_ARM64 (CPU_TYPE_ARM | CPU_ARCH_ABI64)
+
+#define MH_MAGIC_64 0xfeedfacf
+#define MH_DYLIB 0x6
+
+struct mach_header_64 {
+    uint32_t magic;
+    cpu_type_t cputype;
+    cpu_subtype_t cpusubtype;
+    uint32_t filetype;
+    uint32_t ncmds;
+    uint32_t sizeofcmds;
+    uint32_t flags;
+    uint32_t reserved;
+};
+
+struct load_command {
+    uint32_t cmd;
+    uint32_t cmdsize;
+};
+
+#define LC_LOAD_DYLIB 0xc
+#define LC_BUILD_VERSION 0x32
+
+union lc_str {
+    uint32_t offset;
+};
+
+struct dylib {
+    union lc_str name;
+    uint32_t timestamp;
+    uint32_t current_version;
+    uint32_t compatibility_version;
+};
+
+struct dylib_command {
+    uint32_t cmd;
+    uint32_t cmdsize;
+    struct dylib dylib;
+};
+
+#define PLATFORM_MACOS 1
+#define PLATFORM_IOS 2
+
+struct build_version_command {
+    uint32_t cmd;
+    uint32_t cmdsize;
+    uint32_t platform;
+    uint32_t minos;
+    uint32_t sdk;
+    uint32_t ntools;
+};
@@ -0,0 +1,257 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "stub_gl.h"
+
+#define STUB_MAX_CONTEXTS 16
+#define STUB_MAX_FRAMEBUFFERS 256
+#define STUB_MAX_TEXTURES 1024
+
+typedef struct {
+    bool alive;
+    bool framebufferLive[STUB_MAX_FRAMEBUFFERS];
+    // Color 0, depth, depth-stencil
+    GLuint attachments[STUB_MAX_FRAMEBUFFERS][3];
+    GLuint drawFramebuffer, readFramebuffer, texture2D;
+    bool scissor;
+} stub_context_t;
+
+stub_gl_stats_t stub_gl_stats;
+static stub_context_t contexts[STUB_MAX_CONTEXTS];
+static GLint textureFormats[STUB_MAX_TEXTURES];
+static __thread int currentContext; // index + 1, 0 for none
+
+static stub_context_t *stub_current(void) {
+    if (!currentContext) {
+        stub_gl_stats.errors++;
+        return NULL;
+    }
+    return &contexts[currentContext - 1];
+}
+
+static int stub_attachment_index(GLenum attachment) {
+    switch (attachment) {
+        case GL_COLOR_ATTACHMENT0: return 0;
+        case GL_DEPTH_ATTACHMENT: return 1;
+        case GL_DEPTH_STENCIL_ATTACHMENT: return 2;
+        default: return -1;
+    }
+}
+
+void stub_gl_set_texture_format(GLuint texture, GLint internalformat) {
+    if (texture < STUB_MAX_TEXTURES) textureFormats[texture] = internalformat;
+}
+
+int stub_gl_framebuffer_count(EGLContext context) {
+    intptr_t index = (intptr_t)context - 1;
+    if (index < 0 || index >= STUB_MAX_CONTEXTS || !contexts[index].alive) return 0;
+    int count = 0;
+    for (int i = 0; i < STUB_MAX_FRAMEBUFFERS; i++) {
+        count += contexts[index].framebufferLive[i];
+    }
+    return count;
+}
+
+GLuint stub_gl_framebuffer_attachment(GLuint framebuffer, GLenum attachment) {
+    stub_context_t *ctx = stub_current();
+    int index = stub_attachment_index(attachment);
+    if (!ctx || index < 0 || framebuffer >= STUB_MAX_FRAMEBUFFERS) return 0;
+    return ctx->attachments[framebuffer][index];
+}
+
+void stub_gl_reset_stats(void) {
+    free(stub_gl_stats.lastShaderSource);
+    memset(&stub_gl_stats, 0, sizeof(stub_gl_stats));
+}
+
+// EGL
+
+EGLContext eglCreateContext(EGLDisplay dpy, EGLConfig config, EGLContext share_context, const EGLint *attrib_list) {
+    for (int i = 0; i < STUB_MAX_CONTEXTS; i++) {
+        if (!contexts[i].alive) {
+            memset(&contexts[i], 0, sizeof(contexts[i]));
+            contexts[i].alive = true;
+            return (EGLContext)(intptr_t)(i + 1);
+        }
+    }
+    return EGL_NO_CONTEXT;
+}
+
+EGLBoolean eglDestroyContext(EGLDisplay dpy, EGLContext ctx) {
+    intptr_t index = (intptr_t)ctx - 1;
+    if (index < 0 || index >= STUB_MAX_CONTEXTS || !contexts[index].alive) return EGL_FALSE;
+    // Its framebuffers go with it; the slot (and handle) may be handed out again
+    contexts[index].alive = false;
+    if (currentContext == index + 1) currentContext = 0;
+    return EGL_TRUE;
+}
+
+EGLBoolean eglMakeCurrent(EGLDisplay dpy, EGLSurface draw, EGLSurface read, EGLContext ctx) {
+    intptr_t index = (intptr_t)ctx - 1;
+    if (ctx != EGL_NO_CONTEXT && (index < 0 || index >= STUB_MAX_CONTEXTS || !contexts[index].alive)) return EGL_FALSE;
+    currentContext = ctx == EGL_NO_CONTEXT ? 0 : (int)index + 1;
+    return EGL_TRUE;
+}
+
+EGLContext eglGetCurrentContext(void) {
+    return (EGLContext)(intptr_t)currentContext;
+}
+
+// GL
+
+void glGenFramebuffers(GLsizei n, GLuint *framebuffers) {
+    stub_context_t *ctx = stub_current();
+    for (GLsizei i = 0; i < n; i++) {
+        framebuffers[i] = 0;
+        for (GLuint name = 1; ctx && name < STUB_MAX_FRAMEBUFFERS; name++) {
+            if (!ctx->framebufferLive[name]) {
+                ctx->framebufferLive[name] = true;
+                memset(ctx->attachments[name], 0, sizeof(ctx->attachments[name]));
+                framebuffers[i] = name;
+                stub_gl_stats.framebuffersGenerated++;
+                break;
+            }
+        }
+    }
+}
+
+void glDeleteFramebuffers(GLsizei n, const GLuint *framebuffers) {
+    stub_context_t *ctx = stub_current();
+    for (GLsizei i = 0; ctx && i < n; i++) {
+        GLuint name = framebuffers[i];
+        if (name == 0 || name >= STUB_MAX_FRAMEBUFFERS) continue;
+        if (!ctx->framebufferLive[name]) {
+            stub_gl_stats.errors++;
+            continue;
+        }
+        ctx->framebufferLive[name] = false;
+        if (ctx->drawFramebuffer == name) ctx->drawFramebuffer = 0;
+        if (ctx->readFramebuffer == name) ctx->readFramebuffer = 0;
+    }
+}
+
+void glBindFramebuffer(GLenum target, GLuint framebuffer) {
+    stub_context_t *ctx = stub_current();
+    if (!ctx) return;
+    if (framebuffer && (framebuffer >= STUB_MAX_FRAMEBUFFERS || !ctx->framebufferLive[framebuffer])) {
+        // Not a name this context generated, GL_INVALID_OPERATION on ES
+        stub_gl_stats.errors++;
+        return;
+    }
+    if (target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER) ctx->drawFramebuffer = framebuffer;
+    if (target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER) ctx->readFramebuffer = framebuffer;
+}
+
+void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
+    stub_context_t *ctx = stub_current();
+    int index = stub_attachment_index(attachment);
+    GLuint bound = ctx ? (target == GL_READ_FRAMEBUFFER ? ctx->readFramebuffer : ctx->drawFramebuffer) : 0;
+    if (!ctx || index < 0 || bound == 0) {
+        stub_gl_stats.errors++;
+        return;
+    }
+    ctx->attachments[bound][index] = texture;
+}
+
+GLenum glCheckFramebufferStatus(GLenum target) {
+    stub_context_t *ctx = stub_current();
+    GLuint bound = ctx ? (target == GL_READ_FRAMEBUFFER ? ctx->readFramebuffer : ctx->drawFramebuffer) : 0;
+    if (!bound) return GL_FRAMEBUFFER_COMPLETE;
+    bool any = false;
+    for (int i = 0; i < 3; i++) {
+        GLuint texture = ctx->attachments[bound][i];
+        if (!texture) continue;
+        // Luminance stands in for a format that can't be rendered to
+        if (texture >= STUB_MAX_TEXTURES || !textureFormats[texture] || textureFormats[texture] == GL_LUMINANCE) {
+            return GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT;
+        }
+        any = true;
+    }
+    return any ? GL_FRAMEBUFFER_COMPLETE : GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT;
+}
+
+void glBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) {
+    stub_context_t *ctx = stub_current();
+    if (!ctx) return;
+    if (ctx->scissor) stub_gl_stats.errors++; // the copy would be clipped
+    stub_gl_stats.blits++;
+    stub_gl_stats.lastBlitMask = mask;
+    stub_gl_stats.lastBlitDst[0] = dstX0;
+    stub_gl_stats.lastBlitDst[1] = dstY0;
+    stub_gl_stats.lastBlitDst[2] = dstX1;
+    stub_gl_stats.lastBlitDst[3] = dstY1;
+}
+
+void glGetIntegerv(GLenum pname, GLint *data) {
+    stub_context_t *ctx = stub_current();
+    if (!ctx) return;
+    switch (pname) {
+        case GL_DRAW_FRAMEBUFFER_BINDING: *data = ctx->drawFramebuffer; break;
+        case GL_READ_FRAMEBUFFER_BINDING: *data = ctx->readFramebuffer; break;
+        case GL_TEXTURE_BINDING_2D: *data = ctx->texture2D; break;
+        case GL_MAX_TEXTURE_SIZE: *data = 16384; break;
+        default: *data = 0; break;
+    }
+}
+
+void glBindTexture(GLenum target, GLuint texture) {
+    stub_context_t *ctx = stub_current();
+    if (ctx && target == GL_TEXTURE_2D) ctx->texture2D = texture;
+}
+
+GLboolean glIsEnabled(GLenum cap) {
+    stub_context_t *ctx = stub_current();
+    return ctx && cap == GL_SCISSOR_TEST && ctx->scissor;
+}
+
+void glEnable(GLenum cap) {
+    stub_context_t *ctx = stub_current();
+    if (ctx && cap == GL_SCISSOR_TEST) ctx->scissor = true;
+}
+
+void glDisable(GLenum cap) {
+    stub_context_t *ctx = stub_current();
+    if (ctx && cap == GL_SCISSOR_TEST) ctx->scissor = false;
+}
+
+void glGetTexLevelParameteriv(GLenum target, GLint level, GLenum pname, GLint *params) {
+    stub_context_t *ctx = stub_current();
+    *params = 0;
+    if (ctx && pname == GL_TEXTURE_INTERNAL_FORMAT && ctx->texture2D < STUB_MAX_TEXTURES) {
+        *params = textureFormats[ctx->texture2D];
+    }
+}
+
+void glDeleteTextures(GLsizei n, const GLuint *textures) {
+    for (GLsizei i = 0; i < n; i++) {
+        if (textures[i] < STUB_MAX_TEXTURES) textureFormats[textures[i]] = 0;
+    }
+}
+
+void glCopyTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint x, GLint y, GLsizei width, GLsizei height) {
+    stub_gl_stats.copyTexSubImageCalls++;
+}
+
+void glShaderSource(GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length) {
+    size_t total = 0;
+    for (GLsizei i = 0; i < count; i++) {
+        total += length && length[i] >= 0 ? (size_t)length[i] : strlen(string[i]);
+    }
+    free(stub_gl_stats.lastShaderSource);
+    stub_gl_stats.lastShaderSource = malloc(total + 1);
+    size_t offset = 0;
+    for (GLsizei i = 0; i < count; i++) {
+        size_t part = length && length[i] >= 0 ? (size_t)length[i] : strlen(string[i]);
+        memcpy(stub_gl_stats.lastShaderSource + offset, string[i], part);
+        offset += part;
+    }
+    stub_gl_stats.lastShaderSource[offset] = '\0';
+}
+
+// Entry points that only need to exist
+void glClearDepthf(GLfloat d) {}
+void glVertexAttrib4fv(GLuint index, const GLfloat *v) {}
+void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels) {}
+void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels) {}
+void glTexParameterfv(GLenum target, GLenum pname, const GLfloat *params) {}
+void glReadBuffer(GLenum src) {}
@@ -0,0 +1,31 @@
+#pragma once
+
+#define GL_GLEXT_PROTOTYPES
+#include <stdbool.h>
+#include <EGL/egl.h>
+#include "GL/gl.h"
+#include "GL/glext.h"
+
+// A stub GL/EGL driver for host tests. It implements the entry points the
+// wrappers under test call, tracks framebuffer objects per context the way a
+// driver would, and counts misuse (calls without a current context, binding a
+// framebuffer name the current context doesn't own) as errors.
+
+// Texture formats are shared by all contexts; unknown textures have none
+void stub_gl_set_texture_format(GLuint texture, GLint internalformat);
+// Live framebuffer objects owned by a context
+int stub_gl_framebuffer_count(EGLContext context);
+GLuint stub_gl_framebuffer_attachment(GLuint framebuffer, GLenum attachment);
+
+typedef struct {
+    int errors;
+    int framebuffersGenerated;
+    int blits;
+    GLbitfield lastBlitMask;
+    GLint lastBlitDst[4];
+    int copyTexSubImageCalls; // forwarded to the driver's own copy
+    char *lastShaderSource;
+} stub_gl_stats_t;
+
+extern stub_gl_stats_t stub_gl_stats;
+void stub_gl_reset_stats(void);
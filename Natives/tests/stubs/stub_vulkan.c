@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <vulkan/vulkan.h>
+
+// A stub Vulkan driver for host tests without lavapipe. It implements what
+// the pipeline cache wrapper and its test call. Pipeline caches hold one key
+// per shader compiled into them behind the standard header, so their data
+// grows, persists and merges like a real driver's.
+
+#define STUB_VENDOR_ID 0x10005
+#define STUB_DEVICE_ID 1
+#define STUB_HEADER_SIZE (16 + VK_UUID_SIZE)
+#define STUB_MAX_KEYS 64
+
+static const uint8_t stubUUID[VK_UUID_SIZE] = "stub-vulkan-uuid";
+
+typedef struct {
+    uint32_t keys[STUB_MAX_KEYS];
+    uint32_t count;
+} stub_cache_t;
+
+typedef struct {
+    uint32_t key;
+} stub_module_t;
+
+static int stubInstance, stubPhysicalDevice;
+
+static void stub_cache_add(stub_cache_t *cache, uint32_t key) {
+    for (uint32_t i = 0; i < cache->count; i++) {
+        if (cache->keys[i] == key) return;
+    }
+    if (cache->count < STUB_MAX_KEYS) cache->keys[cache->count++] = key;
+}
+
+static VkResult stub_vkCreateInstance(const VkInstanceCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkInstance *pInstance) {
+    *pInstance = (VkInstance)&stubInstance;
+    return VK_SUCCESS;
+}
+
+static void stub_vkDestroyInstance(VkInstance instance, const VkAllocationCallbacks *pAllocator) {
+}
+
+static VkResult stub_vkEnumeratePhysicalDevices(VkInstance instance, uint32_t *pPhysicalDeviceCount, VkPhysicalDevice *pPhysicalDevices) {
+    if (pPhysicalDevices && *pPhysicalDeviceCount > 0) {
+        pPhysicalDevices[0] = (VkPhysicalDevice)&stubPhysicalDevice;
+    }
+    *pPhysicalDeviceCount = 1;
+    return VK_SUCCESS;
+}
+
+static void stub_vkGetPhysicalDeviceProperties(VkPhysicalDevice physicalDevice, VkPhysicalDeviceProperties *pProperties) {
+    memset(pProperties, 0, sizeof(*pProperties));
+    pProperties->apiVersion = VK_API_VERSION_1_0;
+    pProperties->vendorID = STUB_VENDOR_ID;
+    pProperties->deviceID = STUB_DEVICE_ID;
+    pProperties->deviceType = VK_PHYSICAL_DEVICE_TYPE_CPU;
+    strcpy(pProperties->deviceName, "stub");
+    memcpy(pProperties->pipelineCacheUUID, stubUUID, VK_UUID_SIZE);
+}
+
+static VkResult stub_vkCreateDevice(VkPhysicalDevice physicalDevice, const VkDeviceCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkDevice *pDevice) {
+    *pDevice = malloc(1);
+    return VK_SUCCESS;
+}
+
+static void stub_vkDestroyDevice(VkDevice device, const VkAllocationCallbacks *pAllocator) {
+    free(device);
+}
+
+static VkResult stub_vkCreateShaderModule(VkDevice device, const VkShaderModuleCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkShaderModule *pShaderModule) {
+    // FNV-1a of the code
+    uint32_t key = 2166136261u;
+    const uint8_t *code = (const uint8_t *)pCreateInfo->pCode;
+    for (size_t i = 0; i < pCreateInfo->codeSize; i++) {
+        key = (key ^ code[i]) * 16777619u;
+    }
+    stub_module_t *module = malloc(sizeof(stub_module_t));
+    module->key = key;
+    *pShaderModule = (VkShaderModule)module;
+    return VK_SUCCESS;
+}
+
+static void stub_vkDestroyShaderModule(VkDevice device, VkShaderModule shaderModule, const VkAllocationCallbacks *pAllocator) {
+    free((void *)shaderModule);
+}
+
+static VkResult stub_vkCreatePipelineLayout(VkDevice device, const VkPipelineLayoutCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkPipelineLayout *pPipelineLayout) {
+    *pPipelineLayout = (VkPipelineLayout)malloc(1);
+    return VK_SUCCESS;
+}
+
+static void stub_vkDestroyPipelineLayout(VkDevice device, VkPipelineLayout pipelineLayout, const VkAllocationCallbacks *pAllocator) {
+    free((void *)pipelineLayout);
+}
+
+static VkResult stub_vkCreateComputePipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkComputePipelineCreateInfo *pCreateInfos, const VkAllocationCallbacks *pAllocator, VkPipeline *pPipelines) {
+    for (uint32_t i = 0; i < createInfoCount; i++) {
+        if (pipelineCache) {
+            stub_cache_add((stub_cache_t *)pipelineCache, ((stub_module_t *)pCreateInfos[i].stage.module)->key);
+        }
+        pPipelines[i] = (VkPipeline)malloc(1);
+    }
+    return VK_SUCCESS;
+}
+
+static VkResult stub_vkCreateGraphicsPipelines(VkDevice device, VkPipelineCache pipelineCache, uint32_t createInfoCount, const VkGraphicsPipelineCreateInfo *pCreateInfos, const VkAllocationCallbacks *pAllocator, VkPipeline *pPipelines) {
+    for (uint32_t i = 0; i < createInfoCount; i++) {
+        for (uint32_t j = 0; pipelineCache && j < pCreateInfos[i].stageCount; j++) {
+            stub_cache_add((stub_cache_t *)pipelineCache, ((stub_module_t *)pCreateInfos[i].pStages[j].module)->key);
+        }
+        pPipelines[i] = (VkPipeline)malloc(1);
+    }
+    return VK_SUCCESS;
+}
+
+static void stub_vkDestroyPipeline(VkDevice device, VkPipeline pipeline, const VkAllocationCallbacks *pAllocator) {
+    free((void *)pipeline);
+}
+
+static VkResult stub_vkCreatePipelineCache(VkDevice device, const VkPipelineCacheCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator, VkPipelineCache *pPipelineCache) {
+    stub_cache_t *cache = calloc(1, sizeof(stub_cache_t));
+    const uint32_t *data = pCreateInfo->pInitialData;
+    size_t size = pCreateInfo->initialDataSize;
+    // Data of another device is ignored, as the spec asks of drivers
+    if (data && size >= STUB_HEADER_SIZE && data[0] == STUB_HEADER_SIZE &&
+        data[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE && data[2] == STUB_VENDOR_ID &&
+        data[3] == STUB_DEVICE_ID && !memcmp(&data[4], stubUUID, VK_UUID_SIZE)) {
+        size_t count = (size - STUB_HEADER_SIZE) / sizeof(uint32_t);
+        for (size_t i = 0; i < count; i++) {
+            stub_cache_add(cache, data[STUB_HEADER_SIZE / sizeof(uint32_t) + i]);
+        }
+    }
+    *pPipelineCache = (VkPipelineCache)cache;
+    return VK_SUCCESS;
+}
+
+static void stub_vkDestroyPipelineCache(VkDevice device, VkPipelineCache pipelineCache, const VkAllocationCallbacks *pAllocator) {
+    free((void *)pipelineCache);
+}
+
+static VkResult stub_vkGetPipelineCacheData(VkDevice device, VkPipelineCache pipelineCache, size_t *pDataSize, void *pData) {
+    stub_cache_t *cache = (stub_cache_t *)pipelineCache;
+    size_t size = STUB_HEADER_SIZE + cache->count * sizeof(uint32_t);
+    if (!pData) {
+        *pDataSize = size;
+        return VK_SUCCESS;
+    }
+    if (*pDataSize < size) {
+        *pDataSize = 0;
+        return VK_INCOMPLETE;
+    }
+    uint32_t *data = pData;
+    data[0] = STUB_HEADER_SIZE;
+    data[1] = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+    data[2] = STUB_VENDOR_ID;
+    data[3] = STUB_DEVICE_ID;
+    memcpy(&data[4], stubUUID, VK_UUID_SIZE);
+    memcpy((char *)pData + STUB_HEADER_SIZE, cache->keys, cache->count * sizeof(uint32_t));
+    *pDataSize = size;
+    return VK_SUCCESS;
+}
+
+static VkResult stub_vkMergePipelineCaches(VkDevice device, VkPipelineCache dstCache, uint32_t srcCacheCount, const VkPipelineCache *pSrcCaches) {
+    for (uint32_t i = 0; i < srcCacheCount; i++) {
+        stub_cache_t *src = (stub_cache_t *)pSrcCaches[i];
+        for (uint32_t j = 0; j < src->count; j++) {
+            stub_cache_add((stub_cache_t *)dstCache, src->keys[j]);
+        }
+    }
+    return VK_SUCCESS;
+}
+
+#define STUB_PROC(name) {#name, (PFN_vkVoidFunction)stub_##name}
+static const struct {
+    const char *name;
+    PFN_vkVoidFunction func;
+} stubProcs[] = {
+    STUB_PROC(vkCreateInstance),
+    STUB_PROC(vkDestroyInstance),
+    STUB_PROC(vkEnumeratePhysicalDevices),
+    STUB_PROC(vkGetPhysicalDeviceProperties),
+    STUB_PROC(vkCreateDevice),
+    STUB_PROC(vkDestroyDevice),
+    STUB_PROC(vkCreateShaderModule),
+    STUB_PROC(vkDestroyShaderModule),
+    STUB_PROC(vkCreatePipelineLayout),
+    STUB_PROC(vkDestroyPipelineLayout),
+    STUB_PROC(vkCreateComputePipelines),
+    STUB_PROC(vkCreateGraphicsPipelines),
+    STUB_PROC(vkDestroyPipeline),
+    STUB_PROC(vkCreatePipelineCache),
+    STUB_PROC(vkDestroyPipelineCache),
+    STUB_PROC(vkGetPipelineCacheData),
+    STUB_PROC(vkMergePipelineCaches),
+    {"vkGetInstanceProcAddr", (PFN_vkVoidFunction)vkGetInstanceProcAddr},
+    {"vkGetDeviceProcAddr", (PFN_vkVoidFunction)vkGetDeviceProcAddr}
+};
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetInstanceProcAddr(VkInstance instance, const char *pName) {
+    for (size_t i = 0; i < sizeof(stubProcs) / sizeof(*stubProcs); i++) {
+        if (!strcmp(stubProcs[i].name, pName)) return stubProcs[i].func;
+    }
+    return NULL;
+}
+
+VKAPI_ATTR PFN_vkVoidFunction VKAPI_CALL vkGetDeviceProcAddr(VkDevice device, const char *pName) {
+    return vkGetInstanceProcAddr(VK_NULL_HANDLE, pName);
+}
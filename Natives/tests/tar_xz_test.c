@@ -0,0 +1,195 @@
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fixtures.h"
+#include "tar_xz.h"
+#include "test.h"
+
+typedef struct {
+    int begun, ended;
+    int stopAfter;
+} extract_counts_t;
+
+static void on_file_begin(void *context, const char *name, uint64_t size) {
+    ((extract_counts_t *)context)->begun++;
+}
+
+static bool on_file_end(void *context, const char *name) {
+    extract_counts_t *counts = context;
+    return ++counts->ended != counts->stopAfter;
+}
+
+static bool extract(const fixture_tar_entry_t *entries, int count, const char *outDir, extract_counts_t *counts, char *error) {
+    char archive[PATH_MAX];
+    snprintf(archive, sizeof(archive), "%s.tar.xz", outDir);
+    CHECK(fixture_write_tar_xz(archive, entries, count));
+    tar_xz_callbacks_t callbacks = {
+        .context = counts,
+        .fileBegin = on_file_begin,
+        .fileEnd = on_file_end
+    };
+    bool ok = tar_xz_extract(archive, outDir, &callbacks, error, 512);
+    unlink(archive);
+    return ok;
+}
+
+static bool exists(const char *dir, const char *name) {
+    char path[PATH_MAX];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    return lstat(path, &st) == 0;
+}
+
+static void test_runtime_layout(const char *root) {
+    char out[PATH_MAX], path[PATH_MAX], target[PATH_MAX];
+    snprintf(out, sizeof(out), "%s/runtime", root);
+    char longName[200];
+    snprintf(longName, sizeof(longName), "./%s/%s", "legal/java.base/a-directory-name-long-enough-to-need-the-prefix-field",
+        "and-a-file-name-that-is-long-as-well-to-go-past-one-hundred.txt");
+    fixture_tar_entry_t entries[] = {
+        {"./", '5'},
+        {"./bin/", '5'},
+        {"./bin/java", '0', NULL, "\x7f" "ELF", 4},
+        {"./lib/server/libjvm.so", '0', NULL, "jvm", 3},
+        {"./lib/libjsig.so", '2', "server/libjsig.so"},
+        {"./lib/server/libjsig.so", '2', "../libjsig-real.so"},
+        {"./lib/./empty", '0', NULL, "", 0},
+        {"./release", '0', NULL, "JAVA_VERSION=\"17.0.8\"\n", 22},
+        {longName, '0', NULL, "license", 7},
+        {"./dev/null", '3'}
+    };
+    extract_counts_t counts = {0};
+    char error[512];
+    CHECK(extract(entries, sizeof(entries) / sizeof(*entries), out, &counts, error));
+    CHECK_EQ_INT(counts.begun, 5);
+    CHECK_EQ_INT(counts.ended, 5);
+    CHECK(exists(out, "bin/java"));
+    CHECK(exists(out, "lib/empty"));
+    CHECK(exists(out, longName + 2));
+    CHECK(!exists(out, "dev/null"));
+
+    snprintf(path, sizeof(path), "%s/lib/libjsig.so", out);
+    ssize_t length = readlink(path, target, sizeof(target) - 1);
+    CHECK(length > 0);
+    target[length > 0 ? length : 0] = '\0';
+    CHECK(!strcmp(target, "server/libjsig.so"));
+
+    size_t size;
+    snprintf(path, sizeof(path), "%s/release", out);
+    FILE *release = fopen(path, "r");
+    CHECK(release != NULL);
+    if (release) {
+        char line[64] = "";
+        size = fread(line, 1, sizeof(line) - 1, release);
+        line[size] = '\0';
+        CHECK(!strcmp(line, "JAVA_VERSION=\"17.0.8\"\n"));
+        fclose(release);
+    }
+}
+
+// Each archive must fail without creating anything next to the destination
+static void expect_rejected(const char *root, const char *label, const fixture_tar_entry_t *entries, int count) {
+    char out[PATH_MAX], sibling[PATH_MAX];
+    snprintf(out, sizeof(out), "%s/%s/dest", root, label);
+    snprintf(sibling, sizeof(sibling), "%s/%s", root, label);
+    mkdir(sibling, 0755);
+    extract_counts_t counts = {0};
+    char error[512];
+    bool ok = extract(entries, count, out, &counts, error);
+    if (ok) fprintf(stderr, "%s: extraction should have failed\n", label);
+    CHECK(!ok);
+    CHECK(error[0] != '\0');
+    CHECK(!exists(sibling, "victim"));
+    CHECK(!exists(root, "victim"));
+}
+
+static void test_escapes(const char *root) {
+    fixture_tar_entry_t dotdotLast[] = {{"a/..", '5'}, {"a/../../victim", '0', NULL, "x", 1}};
+    expect_rejected(root, "dotdot-last", dotdotLast, 1);
+    expect_rejected(root, "dotdot-middle", dotdotLast + 1, 1);
+    fixture_tar_entry_t parent[] = {{"../victim", '0', NULL, "x", 1}};
+    expect_rejected(root, "parent", parent, 1);
+    char absolute[PATH_MAX];
+    snprintf(absolute, sizeof(absolute), "%s/victim", root);
+    fixture_tar_entry_t absoluteEntry[] = {{absolute, '0', NULL, "x", 1}};
+    expect_rejected(root, "absolute", absoluteEntry, 1);
+
+    // Symlinks out of the destination, then a write through them
+    fixture_tar_entry_t linkRoot[] = {{"link", '2', "/"}, {"link/victim", '0', NULL, "x", 1}};
+    expect_rejected(root, "link-root", linkRoot, 2);
+    fixture_tar_entry_t linkUp[] = {{"lib/link", '2', "../.."}, {"lib/link/victim", '0', NULL, "x", 1}};
+    expect_rejected(root, "link-up", linkUp, 2);
+    fixture_tar_entry_t linkDeep[] = {{"lib/link", '2', "../../../victim"}};
+    expect_rejected(root, "link-deep", linkDeep, 1);
+    // Lexically inside, but ".." after a name could be taken out by another link
+    fixture_tar_entry_t linkThrough[] = {{"self", '2', "."}, {"link", '2', "self/.."}};
+    expect_rejected(root, "link-through", linkThrough, 2);
+}
+
+static void test_existing_symlinks(const char *root) {
+    // Left behind in the destination (or raced in): never followed
+    char out[PATH_MAX], link[PATH_MAX], outside[PATH_MAX];
+    snprintf(outside, sizeof(outside), "%s/outside", root);
+    mkdir(outside, 0755);
+    snprintf(out, sizeof(out), "%s/existing", root);
+    mkdir(out, 0755);
+    snprintf(link, sizeof(link), "%s/dir", out);
+    CHECK(symlink(outside, link) == 0);
+    snprintf(link, sizeof(link), "%s/file", out);
+    char victim[PATH_MAX];
+    snprintf(victim, sizeof(victim), "%s/victim", outside);
+    CHECK(symlink(victim, link) == 0);
+
+    extract_counts_t counts = {0};
+    char error[512];
+    fixture_tar_entry_t throughDir[] = {{"dir/victim", '0', NULL, "x", 1}};
+    CHECK(!extract(throughDir, 1, out, &counts, error));
+    fixture_tar_entry_t throughFile[] = {{"file", '0', NULL, "x", 1}};
+    CHECK(!extract(throughFile, 1, out, &counts, error));
+    CHECK(!exists(outside, "victim"));
+}
+
+static void test_stop_and_truncation(const char *root) {
+    char out[PATH_MAX], archive[PATH_MAX];
+    fixture_tar_entry_t entries[] = {
+        {"a", '0', NULL, "1", 1},
+        {"b", '0', NULL, "2", 1},
+        {"c", '0', NULL, "3", 1}
+    };
+    snprintf(out, sizeof(out), "%s/stopped", root);
+    extract_counts_t counts = {.stopAfter = 2};
+    char error[512];
+    CHECK(!extract(entries, 3, out, &counts, error));
+    CHECK(error[0] == '\0');
+    CHECK(!exists(out, "c"));
+
+    // Cut the compressed stream in half
+    snprintf(out, sizeof(out), "%s/truncated", root);
+    snprintf(archive, sizeof(archive), "%s.tar.xz", out);
+    char data[300000];
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = (char)(i * 2654435761u >> 13);
+    fixture_tar_entry_t big[] = {{"big", '0', NULL, data, sizeof(data)}};
+    CHECK(fixture_write_tar_xz(archive, big, 1));
+    struct stat st;
+    stat(archive, &st);
+    CHECK(truncate(archive, st.st_size / 2) == 0);
+    tar_xz_callbacks_t callbacks = {0};
+    CHECK(!tar_xz_extract(archive, out, &callbacks, error, sizeof(error)));
+    CHECK(error[0] != '\0');
+}
+
+int main(void) {
+    char *root = fixture_temp_dir("tar_xz_test");
+    CHECK(root != NULL);
+    if (!root) return TEST_RESULT();
+    test_runtime_layout(root);
+    test_escapes(root);
+    test_existing_symlinks(root);
+    test_stop_and_truncation(root);
+    fixture_remove_tree(root);
+    free(root);
+    return TEST_RESULT();
+}
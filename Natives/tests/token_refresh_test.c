@@ -0,0 +1,184 @@
+#include "test.h"
+#include "token_refresh.h"
+
+// The scheduler's policy on a virtual clock, with a fake login that fails
+// where and as often as a test asks.
+
+#define DAY 86400.0
+#define HOUR 3600.0
+
+// What an account keeps between launches
+typedef struct {
+    double expiresAt;
+    int tokenVersion;
+} account_t;
+
+typedef struct {
+    // Attempts left that fail at the profile check, after a new token was issued
+    int failures;
+    int attempts;
+    // Seconds each request takes
+    double latency;
+    double expiresIn;
+} fake_login_t;
+
+// Runs the login chain like MicrosoftAuthenticator does, only storing the new
+// expiry once the profile check went through. Returns the time it finished.
+static double fake_refresh(fake_login_t *login, account_t *account, double now, bool *success) {
+    login->attempts++;
+    // OAuth, XBL and XSTS before the Minecraft token is requested
+    now += 3 * login->latency;
+    double requestedAt = now;
+    now += login->latency;
+    double expiresAt = token_refresh_expiry(requestedAt, login->expiresIn);
+    // Then the profile check
+    now += login->latency;
+    *success = login->failures == 0;
+    if (*success) {
+        account->expiresAt = expiresAt;
+        account->tokenVersion++;
+    } else {
+        login->failures--;
+    }
+    return now;
+}
+
+// Follows the scheduler until the plan says to wait past until or the token
+// expired. Returns the time of the last step.
+static double run(token_refresh_t *state, fake_login_t *login, account_t *account, double now, double until,
+    token_refresh_action_t *last) {
+    for (int steps = 0; steps < 10000; steps++) {
+        double attemptAt = 0;
+        *last = token_refresh_plan(state, now, account->expiresAt, &attemptAt);
+        if (*last == TOKEN_REFRESH_EXPIRED) return now;
+        if (*last == TOKEN_REFRESH_LATER) {
+            CHECK(attemptAt > now);
+            if (attemptAt > until) return now;
+            now = attemptAt;
+            continue;
+        }
+        bool success;
+        now = fake_refresh(login, account, now, &success);
+        token_refresh_finished(state, now, success);
+    }
+    CHECK(false);
+    return now;
+}
+
+static void test_lead_time(void) {
+    token_refresh_t state;
+    token_refresh_init(&state);
+    account_t account = {.expiresAt = DAY};
+    double attemptAt = 0;
+    CHECK_EQ_INT(token_refresh_plan(&state, 0, account.expiresAt, &attemptAt), TOKEN_REFRESH_LATER);
+    CHECK(attemptAt == DAY - 6 * HOUR);
+    CHECK(token_refresh_next_attempt(&state, account.expiresAt) == DAY - 6 * HOUR);
+    CHECK_EQ_INT(token_refresh_plan(&state, DAY - 6 * HOUR - 1, account.expiresAt, &attemptAt), TOKEN_REFRESH_LATER);
+    CHECK_EQ_INT(token_refresh_plan(&state, DAY - 6 * HOUR, account.expiresAt, &attemptAt), TOKEN_REFRESH_NOW);
+    // Coming back from the background late still refreshes in time
+    CHECK_EQ_INT(token_refresh_plan(&state, DAY - 1, account.expiresAt, &attemptAt), TOKEN_REFRESH_NOW);
+    CHECK_EQ_INT(token_refresh_plan(&state, DAY, account.expiresAt, &attemptAt), TOKEN_REFRESH_EXPIRED);
+
+    // A week of days, every refresh lands 6 hours before the expiry it replaces
+    fake_login_t login = {.latency = 0.5, .expiresIn = DAY};
+    token_refresh_action_t last;
+    double previousExpiry = account.expiresAt;
+    double now = 0;
+    for (int day = 0; day < 7; day++) {
+        now = run(&state, &login, &account, now, now + 1, &last);
+        CHECK_EQ_INT(last, TOKEN_REFRESH_LATER);
+        // Jump to the attempt
+        double attemptAt = token_refresh_next_attempt(&state, account.expiresAt);
+        CHECK(attemptAt == previousExpiry - 6 * HOUR);
+        now = run(&state, &login, &account, attemptAt, attemptAt, &last);
+        CHECK_EQ_INT(login.attempts, day + 1);
+        // The new lifetime counts from the Minecraft token request
+        CHECK(account.expiresAt == attemptAt + 1.5 + DAY);
+        previousExpiry = account.expiresAt;
+    }
+    CHECK_EQ_INT(account.tokenVersion, 7);
+    CHECK_EQ_INT(state.failureCount, 0);
+}
+
+static void test_backoff(void) {
+    token_refresh_t state;
+    token_refresh_init(&state);
+    const double expected[] = {60, 120, 240, 480, 960, 1920, 3600, 3600, 3600};
+    double now = 1000;
+    for (int i = 0; i < 9; i++) {
+        double delay = token_refresh_finished(&state, now, false);
+        CHECK(delay == expected[i]);
+        CHECK(state.retryAt == now + expected[i]);
+        // The next attempt waits out the delay even with the lead time long past
+        CHECK(token_refresh_next_attempt(&state, now + HOUR) == now + expected[i]);
+        now += delay;
+    }
+    // Long failure streaks stay at the cap
+    for (int i = 0; i < 100; i++) token_refresh_finished(&state, now, false);
+    CHECK(token_refresh_finished(&state, now, false) == 3600);
+    CHECK_EQ_INT(state.failureCount, 110);
+
+    // One success starts over
+    CHECK(token_refresh_finished(&state, now, true) == 0);
+    CHECK_EQ_INT(state.failureCount, 0);
+    CHECK(state.retryAt == 0);
+    CHECK(token_refresh_finished(&state, now, false) == 60);
+
+    // So does switching accounts
+    token_refresh_reset(&state);
+    CHECK(token_refresh_next_attempt(&state, DAY) == DAY - 6 * HOUR);
+
+    // Other limits the scheduler was configured with
+    state.minRetryDelay = 10;
+    state.maxRetryDelay = 50;
+    CHECK(token_refresh_finished(&state, 0, false) == 10);
+    CHECK(token_refresh_finished(&state, 0, false) == 20);
+    CHECK(token_refresh_finished(&state, 0, false) == 40);
+    CHECK(token_refresh_finished(&state, 0, false) == 50);
+}
+
+static void test_failed_refreshes(void) {
+    token_refresh_t state;
+    token_refresh_init(&state);
+    account_t account = {.expiresAt = DAY};
+    token_refresh_action_t last;
+
+    // Twelve failures keep the old expiry, and the retries back off from the
+    // lead time until the token runs out
+    fake_login_t login = {.failures = 12, .latency = 1, .expiresIn = DAY};
+    double now = run(&state, &login, &account, 0, 2 * DAY, &last);
+    CHECK_EQ_INT(last, TOKEN_REFRESH_EXPIRED);
+    CHECK(account.expiresAt == DAY);
+    CHECK_EQ_INT(account.tokenVersion, 0);
+    CHECK(now >= DAY);
+    // 18:00 plus 1, 2, 4, 8, 16, 32 minutes, then hourly up to midnight
+    CHECK_EQ_INT(login.attempts, 11);
+    CHECK_EQ_INT(state.failureCount, 11);
+
+    // The foreground login goes through on its own path; the scheduler picks
+    // the new expiry up without the old backoff. Over two days one failure is
+    // retried a minute later, then the next day's refresh is on time.
+    token_refresh_reset(&state);
+    login.failures = 1;
+    login.attempts = 0;
+    double loginAt = now;
+    account.expiresAt = loginAt + DAY;
+    now = run(&state, &login, &account, now, loginAt + 2 * DAY - 1, &last);
+    CHECK_EQ_INT(login.attempts, 3);
+    CHECK_EQ_INT(account.tokenVersion, 2);
+    CHECK(account.expiresAt > loginAt + 2 * DAY);
+    CHECK_EQ_INT(last, TOKEN_REFRESH_LATER);
+    CHECK_EQ_INT(state.failureCount, 0);
+
+    // A response without expires_in is good for a day
+    CHECK(token_refresh_expiry(100, 0) == 100 + DAY);
+    CHECK(token_refresh_expiry(100, -5) == 100 + DAY);
+    CHECK(token_refresh_expiry(100, 3600) == 100 + HOUR);
+}
+
+int main(void) {
+    test_lead_time();
+    test_backoff();
+    test_failed_refreshes();
+    return TEST_RESULT();
+}
@@ -0,0 +1,199 @@
+#include <dlfcn.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <vulkan/vulkan.h>
+
+#include "fixtures.h"
+#include "test.h"
+
+// The pipeline cache wrapper around the Vulkan loader with lavapipe, or the
+// stub driver given as argument, in place of MoltenVK: resolved through the
+// wrapper's exports the way LWJGL does it, across several device lifetimes
+// sharing one cache file.
+
+static PFN_vkGetInstanceProcAddr gipa;
+static PFN_vkGetDeviceProcAddr gdpa;
+static VkInstance instance;
+static VkPhysicalDevice physicalDevice;
+static char cachePath[4096];
+
+// An empty compute shader, local size 1x1x1
+static const uint32_t emptyCompute[] = {
+    0x07230203, 0x00010000, 0, 5, 0,
+    0x00020011, 1,                          // OpCapability Shader
+    0x0003000E, 0, 1,                       // OpMemoryModel Logical GLSL450
+    0x0005000F, 5, 3, 0x6E69616D, 0,        // OpEntryPoint GLCompute %3 "main"
+    0x00060010, 3, 17, 1, 1, 1,             // OpExecutionMode %3 LocalSize 1 1 1
+    0x00020013, 1,                          // %1 = OpTypeVoid
+    0x00030021, 2, 1,                       // %2 = OpTypeFunction %1
+    0x00050036, 1, 3, 0, 2,                 // %3 = OpFunction %1 None %2
+    0x000200F8, 4,                          // %4 = OpLabel
+    0x000100FD,                             // OpReturn
+    0x00010038                              // OpFunctionEnd
+};
+
+#define DEVICE_PROC(device, name) ((PFN_##name)gdpa(device, #name))
+
+static VkDevice create_device(PFN_vkGetInstanceProcAddr getInstanceProcAddr) {
+    float priority = 1;
+    VkDeviceQueueCreateInfo queue = {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+        .queueCount = 1,
+        .pQueuePriorities = &priority
+    };
+    VkDeviceCreateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .queueCreateInfoCount = 1,
+        .pQueueCreateInfos = &queue
+    };
+    PFN_vkCreateDevice createDevice = (PFN_vkCreateDevice)getInstanceProcAddr(instance, "vkCreateDevice");
+    VkDevice device = VK_NULL_HANDLE;
+    CHECK(createDevice(physicalDevice, &info, NULL, &device) == VK_SUCCESS);
+    return device;
+}
+
+// Creates a compute pipeline in cache, the wrapper's if VK_NULL_HANDLE
+static void create_pipeline(VkDevice device, VkPipelineCache cache) {
+    VkShaderModuleCreateInfo moduleInfo = {
+        .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+        .codeSize = sizeof(emptyCompute),
+        .pCode = emptyCompute
+    };
+    VkShaderModule module;
+    CHECK(DEVICE_PROC(device, vkCreateShaderModule)(device, &moduleInfo, NULL, &module) == VK_SUCCESS);
+    VkPipelineLayoutCreateInfo layoutInfo = {.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    VkPipelineLayout layout;
+    CHECK(DEVICE_PROC(device, vkCreatePipelineLayout)(device, &layoutInfo, NULL, &layout) == VK_SUCCESS);
+    VkComputePipelineCreateInfo info = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = module,
+            .pName = "main"
+        },
+        .layout = layout
+    };
+    VkPipeline pipeline;
+    CHECK(DEVICE_PROC(device, vkCreateComputePipelines)(device, cache, 1, &info, NULL, &pipeline) == VK_SUCCESS);
+    DEVICE_PROC(device, vkDestroyPipeline)(device, pipeline, NULL);
+    DEVICE_PROC(device, vkDestroyPipelineLayout)(device, layout, NULL);
+    DEVICE_PROC(device, vkDestroyShaderModule)(device, module, NULL);
+}
+
+static size_t cache_size(VkDevice device, VkPipelineCache cache) {
+    size_t size = 0;
+    CHECK(DEVICE_PROC(device, vkGetPipelineCacheData)(device, cache, &size, NULL) == VK_SUCCESS);
+    return size;
+}
+
+static size_t file_size(void) {
+    struct stat st;
+    return stat(cachePath, &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+int main(int argc, char **argv) {
+    const char *driver = argc > 1 ? argv[1] : "libvulkan.so.1";
+    void *loader = dlopen(driver, RTLD_NOW | RTLD_LOCAL);
+    if (!loader) {
+        fprintf(stderr, "No Vulkan loader, skipping\n");
+        return TEST_SKIPPED;
+    }
+    PFN_vkGetInstanceProcAddr loaderGipa = (PFN_vkGetInstanceProcAddr)dlsym(loader, "vkGetInstanceProcAddr");
+    char *temp = fixture_temp_dir("vk_pipeline_cache");
+    snprintf(cachePath, sizeof(cachePath), "%s/vk_pipeline_cache.bin", temp);
+    setenv("AMETHYST_VK_DRIVER", driver, 1);
+    setenv("AMETHYST_VK_PIPELINE_CACHE", cachePath, 1);
+    void *wrapper = dlopen(VKPC_LIBRARY, RTLD_NOW | RTLD_LOCAL);
+    CHECK(wrapper != NULL);
+    if (!wrapper) return TEST_RESULT();
+    gipa = (PFN_vkGetInstanceProcAddr)dlsym(wrapper, "vkGetInstanceProcAddr");
+    gdpa = (PFN_vkGetDeviceProcAddr)dlsym(wrapper, "vkGetDeviceProcAddr");
+
+    // Lavapipe, or whatever the loader finds, created without the wrapper
+    VkApplicationInfo app = {.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO, .apiVersion = VK_API_VERSION_1_0};
+    VkInstanceCreateInfo instanceInfo = {.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO, .pApplicationInfo = &app};
+    PFN_vkCreateInstance createInstance = (PFN_vkCreateInstance)loaderGipa(NULL, "vkCreateInstance");
+    uint32_t count = 1;
+    if (!createInstance || createInstance(&instanceInfo, NULL, &instance) != VK_SUCCESS ||
+        ((PFN_vkEnumeratePhysicalDevices)loaderGipa(instance, "vkEnumeratePhysicalDevices"))(instance, &count, &physicalDevice) < 0 ||
+        count == 0) {
+        fprintf(stderr, "No Vulkan device, skipping\n");
+        return TEST_SKIPPED;
+    }
+
+    // A device the wrapper never saw an instance for: its vkGetDeviceProcAddr
+    // falls back to the driver's export
+    VkDevice device = create_device(loaderGipa);
+    CHECK(gdpa(device, "vkCreateComputePipelines") != NULL);
+    create_pipeline(device, VK_NULL_HANDLE);
+    DEVICE_PROC(device, vkDestroyDevice)(device, NULL);
+    ((PFN_vkDestroyInstance)loaderGipa(instance, "vkDestroyInstance"))(instance, NULL);
+    CHECK(file_size() == 0);
+
+    // From here on through the wrapper, like LWJGL
+    createInstance = (PFN_vkCreateInstance)gipa(NULL, "vkCreateInstance");
+    CHECK(createInstance(&instanceInfo, NULL, &instance) == VK_SUCCESS);
+    count = 1;
+    ((PFN_vkEnumeratePhysicalDevices)gipa(instance, "vkEnumeratePhysicalDevices"))(instance, &count, &physicalDevice);
+    VkPhysicalDeviceProperties props;
+    ((PFN_vkGetPhysicalDeviceProperties)gipa(instance, "vkGetPhysicalDeviceProperties"))(physicalDevice, &props);
+    VkPipelineCache (*getPipelineCache)(VkDevice) = (VkPipelineCache (*)(VkDevice))gipa(instance, "amethyst_vkGetPipelineCache");
+    CHECK(getPipelineCache != NULL);
+
+    // Pipelines without a cache of their own land in the wrapper's, saved when the device goes
+    device = create_device(gipa);
+    VkPipelineCache cache = getPipelineCache(device);
+    CHECK(cache != VK_NULL_HANDLE);
+    create_pipeline(device, VK_NULL_HANDLE);
+    size_t firstSize = cache_size(device, cache);
+    DEVICE_PROC(device, vkDestroyDevice)(device, NULL);
+    size_t length;
+    uint32_t *header = (uint32_t *)fixture_read_path(cachePath, &length);
+    CHECK(header && length == firstSize && length >= 16 + VK_UUID_SIZE);
+    CHECK(header && header[2] == props.vendorID && header[3] == props.deviceID);
+    CHECK(header && !memcmp(&header[4], props.pipelineCacheUUID, VK_UUID_SIZE));
+
+    // The next device starts from the file, a caller-owned cache is merged
+    // into the wrapper's when destroyed
+    device = create_device(gipa);
+    cache = getPipelineCache(device);
+    CHECK(cache_size(device, cache) == firstSize);
+    VkPipelineCacheCreateInfo cacheInfo = {.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+    VkPipelineCache own;
+    CHECK(DEVICE_PROC(device, vkCreatePipelineCache)(device, &cacheInfo, NULL, &own) == VK_SUCCESS);
+    create_pipeline(device, own);
+    DEVICE_PROC(device, vkDestroyPipelineCache)(device, own, NULL);
+    CHECK(cache_size(device, cache) >= firstSize);
+    DEVICE_PROC(device, vkDestroyDevice)(device, NULL);
+    CHECK(file_size() >= firstSize);
+
+    // A file written for another device is discarded, and not rewritten
+    // while nothing new was compiled
+    header[3] ^= 0xffff;
+    FILE *file = fopen(cachePath, "wb");
+    fwrite(header, 1, length, file);
+    fclose(file);
+    device = create_device(gipa);
+    cache = getPipelineCache(device);
+    CHECK(cache_size(device, cache) <= firstSize);
+    DEVICE_PROC(device, vkDestroyDevice)(device, NULL);
+    uint32_t *unchanged = (uint32_t *)fixture_read_path(cachePath, &length);
+    CHECK(unchanged && unchanged[3] == header[3]);
+    free(unchanged);
+
+    // Once something is compiled again, the file is for this device
+    device = create_device(gipa);
+    create_pipeline(device, VK_NULL_HANDLE);
+    DEVICE_PROC(device, vkDestroyDevice)(device, NULL);
+    free(header);
+    header = (uint32_t *)fixture_read_path(cachePath, &length);
+    CHECK(header && header[3] == props.deviceID);
+    free(header);
+
+    ((PFN_vkDestroyInstance)gipa(instance, "vkDestroyInstance"))(instance, NULL);
+    fixture_remove_tree(temp);
+    free(temp);
+    return TEST_RESULT();
+}
@@ -0,0 +1,48 @@
+#include <math.h>
+
+#include "token_refresh.h"
+
+void token_refresh_init(token_refresh_t *state) {
+    *state = (token_refresh_t){
+        .leadTime = 6 * 3600,
+        .minRetryDelay = 60,
+        .maxRetryDelay = 3600
+    };
+}
+
+void token_refresh_reset(token_refresh_t *state) {
+    state->failureCount = 0;
+    state->retryAt = 0;
+}
+
+double token_refresh_next_attempt(const token_refresh_t *state, double expiresAt) {
+    return fmax(expiresAt - state->leadTime, state->retryAt);
+}
+
+token_refresh_action_t token_refresh_plan(const token_refresh_t *state, double now, double expiresAt, double *attemptAt) {
+    if (now >= expiresAt) {
+        return TOKEN_REFRESH_EXPIRED;
+    }
+    double next = token_refresh_next_attempt(state, expiresAt);
+    if (now >= next) {
+        return TOKEN_REFRESH_NOW;
+    }
+    *attemptAt = next;
+    return TOKEN_REFRESH_LATER;
+}
+
+double token_refresh_finished(token_refresh_t *state, double now, bool success) {
+    if (success) {
+        token_refresh_reset(state);
+        return 0;
+    }
+    state->failureCount++;
+    unsigned doublings = state->failureCount - 1 < 16 ? state->failureCount - 1 : 16;
+    double delay = fmin(state->minRetryDelay * ldexp(1, doublings), state->maxRetryDelay);
+    state->retryAt = now + delay;
+    return delay;
+}
+
+double token_refresh_expiry(double requestedAt, double expiresIn) {
+    return requestedAt + (expiresIn > 0 ? expiresIn : 86400);
+}
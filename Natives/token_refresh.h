@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+
+// When to renew a Minecraft token ahead of its expiry, with exponential
+// backoff after failed attempts. Times are seconds on the caller's clock.
+
+typedef struct {
+    // Seconds before expiry at which a refresh is attempted
+    double leadTime;
+    double minRetryDelay, maxRetryDelay;
+    unsigned failureCount;
+    double retryAt;
+} token_refresh_t;
+
+typedef enum {
+    // Expired already, the next launch refreshes in the foreground
+    TOKEN_REFRESH_EXPIRED,
+    TOKEN_REFRESH_NOW,
+    TOKEN_REFRESH_LATER
+} token_refresh_action_t;
+
+// Minecraft tokens last a day: starts 6 hours ahead, retries after 1, 2, 4...
+// minutes up to an hour
+void token_refresh_init(token_refresh_t *state);
+// Forgets the backoff, e.g. when another account is selected
+void token_refresh_reset(token_refresh_t *state);
+
+double token_refresh_next_attempt(const token_refresh_t *state, double expiresAt);
+// For LATER, sets *attemptAt to when to check again
+token_refresh_action_t token_refresh_plan(const token_refresh_t *state, double now, double expiresAt, double *attemptAt);
+// Records the outcome of an attempt, returns the delay before the next one (0 after a success)
+double token_refresh_finished(token_refresh_t *state, double now, bool success);
+
+// Expiry of a token requested at requestedAt, to be stored with the token once
+// the whole login went through; a day if the response didn't say
+double token_refresh_expiry(double requestedAt, double expiresIn);
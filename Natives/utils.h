@@ -3,6 +3,7 @@
 #import <UIKit/UIKit.h>
 
 #include <stdbool.h>
+#include <sys/stat.h>
 #include "environ.h"
 #include "jni.h"
 
@@ -65,6 +66,8 @@ void init_hookUIKitConstructor();
 void init_setupMultiDir();
 
 BOOL PLPatchMachOPlatformForFile(const char *path);
+BOOL PLPatchedIndexContains(const char *path, const struct stat *st);
+void PLPatchedIndexAdd(const char *path, const struct stat *st);
 
 UIViewController* currentVC();
 void openLink(UIViewController* sender, NSURL* link);